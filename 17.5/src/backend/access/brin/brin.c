@@ -2905,6 +2905,10 @@ _brin_parallel_build_main(dsm_segment *seg, shm_toc *toc)
 	sharedsort = shm_toc_lookup(toc, PARALLEL_KEY_TUPLESORT, false);
 	tuplesort_attach_shared(sharedsort, seg);
 
+	/* Throttle our part of a concurrent build like the leader's */
+	if (brinshared->isconcurrent)
+		index_concurrent_cost_delay_begin();
+
 	/* Prepare to track buffer usage during parallel execution */
 	InstrStartParallelQuery();
 
@@ -2918,6 +2922,9 @@ _brin_parallel_build_main(dsm_segment *seg, shm_toc *toc)
 	_brin_parallel_scan_and_build(buildstate, brinshared, sharedsort,
 								  heapRel, indexRel, sortmem, false);
 
+	if (brinshared->isconcurrent)
+		index_concurrent_cost_delay_end();
+
 	/* Report WAL/buffer usage during parallel execution */
 	bufferusage = shm_toc_lookup(toc, PARALLEL_KEY_BUFFER_USAGE, false);
 	walusage = shm_toc_lookup(toc, PARALLEL_KEY_WAL_USAGE, false);
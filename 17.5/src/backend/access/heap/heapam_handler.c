@@ -34,6 +34,7 @@
 #include "catalog/storage.h"
 #include "catalog/storage_xlog.h"
 #include "commands/progress.h"
+#include "commands/vacuum.h"
 #include "executor/executor.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -1383,6 +1384,14 @@ heapam_index_build_range_scan(Relation heapRelation,
 		{
 			Page		page = BufferGetPage(hscan->rs_cbuf);
 
+			/*
+			 * Throttle concurrent builds; see index_concurrently_build.  Other
+			 * builds, e.g. by VACUUM FULL or CLUSTER, are not to be slowed
+			 * down here.
+			 */
+			if (indexInfo->ii_Concurrent)
+				vacuum_delay_point();
+
 			LockBuffer(hscan->rs_cbuf, BUFFER_LOCK_SHARE);
 			heap_get_root_tuples(page, root_offsets);
 			LockBuffer(hscan->rs_cbuf, BUFFER_LOCK_UNLOCK);
@@ -1769,6 +1778,7 @@ heapam_index_validate_scan(Relation heapRelation,
 	ItemPointer indexcursor = NULL;
 	ItemPointerData decoded;
 	bool		tuplesort_empty = false;
+	bool		report_progress;
 
 	/*
 	 * sanity checks
@@ -1804,8 +1814,17 @@ heapam_index_validate_scan(Relation heapRelation,
 								 false);	/* syncscan not OK */
 	hscan = (HeapScanDesc) scan;
 
-	pgstat_progress_update_param(PROGRESS_SCAN_BLOCKS_TOTAL,
-								 hscan->rs_nblocks);
+	/*
+	 * In a parallel validate_index(), each participant scans just one range
+	 * of blocks at a time, and the TIDs supplied by the caller start at that
+	 * range.  Progress is then reported by the caller, not here.
+	 */
+	report_progress = (state->numblocks == InvalidBlockNumber);
+	if (report_progress)
+		pgstat_progress_update_param(PROGRESS_SCAN_BLOCKS_TOTAL,
+									 hscan->rs_nblocks);
+	else
+		heap_setscanlimits(scan, state->startblock, state->numblocks);
 
 	/*
 	 * Scan all tuples matching the snapshot.
@@ -1820,8 +1839,9 @@ heapam_index_validate_scan(Relation heapRelation,
 
 		state->htups += 1;
 
-		if ((previous_blkno == InvalidBlockNumber) ||
-			(hscan->rs_cblock != previous_blkno))
+		if (report_progress &&
+			((previous_blkno == InvalidBlockNumber) ||
+			 (hscan->rs_cblock != previous_blkno)))
 		{
 			pgstat_progress_update_param(PROGRESS_SCAN_BLOCKS_DONE,
 										 hscan->rs_cblock);
@@ -1846,6 +1866,9 @@ heapam_index_validate_scan(Relation heapRelation,
 		{
 			Page		page = BufferGetPage(hscan->rs_cbuf);
 
+			/* Throttle concurrent builds; see validate_index */
+			vacuum_delay_point();
+
 			LockBuffer(hscan->rs_cbuf, BUFFER_LOCK_SHARE);
 			heap_get_root_tuples(page, root_offsets);
 			LockBuffer(hscan->rs_cbuf, BUFFER_LOCK_UNLOCK);
@@ -1880,9 +1903,6 @@ heapam_index_validate_scan(Relation heapRelation,
 			   (!indexcursor ||
 				ItemPointerCompare(indexcursor, &rootTuple) < 0))
 		{
-			Datum		ts_val;
-			bool		ts_isnull;
-
 			if (indexcursor)
 			{
 				/*
@@ -1892,15 +1912,9 @@ heapam_index_validate_scan(Relation heapRelation,
 					in_index[ItemPointerGetOffsetNumber(indexcursor) - 1] = true;
 			}
 
-			tuplesort_empty = !tuplesort_getdatum(state->tuplesort, true,
-												  false, &ts_val, &ts_isnull,
-												  NULL);
-			Assert(tuplesort_empty || !ts_isnull);
+			tuplesort_empty = !validate_index_next_tid(state, &decoded);
 			if (!tuplesort_empty)
-			{
-				itemptr_decode(&decoded, DatumGetInt64(ts_val));
 				indexcursor = &decoded;
-			}
 			else
 			{
 				/* Be tidy */
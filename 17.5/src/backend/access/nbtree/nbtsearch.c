@@ -18,17 +18,23 @@
 #include "access/nbtree.h"
 #include "access/relscan.h"
 #include "access/xact.h"
+#include "common/int.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "storage/predicate.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
+#include "utils/uuid.h"
 
 
 static void _bt_drop_lock_and_maybe_pin(IndexScanDesc scan, BTScanPos sp);
 static OffsetNumber _bt_binsrch(Relation rel, BTScanInsert key, Buffer buf);
 static int	_bt_binsrch_posting(BTScanInsert key, Page page,
 								OffsetNumber offnum);
+static inline int32 _bt_fastcmp(ScanKey scankey, Datum datum);
+static inline int32 _bt_compare_prefix(Relation rel, BTScanInsert key,
+									   Page page, OffsetNumber offnum,
+									   AttrNumber *cmpcol);
 static bool _bt_readpage(IndexScanDesc scan, ScanDirection dir,
 						 OffsetNumber offnum, bool firstPage);
 static void _bt_saveitem(BTScanOpaque so, int itemIndex,
@@ -342,6 +348,8 @@ _bt_binsrch(Relation rel,
 	BTPageOpaque opaque;
 	OffsetNumber low,
 				high;
+	AttrNumber	lowcmpcol,
+				highcmpcol;
 	int32		result,
 				cmpval;
 
@@ -382,18 +390,33 @@ _bt_binsrch(Relation rel,
 
 	cmpval = key->nextkey ? 0 : 1;	/* select comparison value */
 
+	/*
+	 * Track how many leading key attributes are known to be equal to the
+	 * scan key at each bound.  Every tuple between the bounds must share the
+	 * smaller of the two prefixes, so those attributes needn't be compared
+	 * again (see _bt_compare_prefix).
+	 */
+	lowcmpcol = highcmpcol = 1;
+
 	while (high > low)
 	{
 		OffsetNumber mid = low + ((high - low) / 2);
+		AttrNumber	cmpcol = Min(lowcmpcol, highcmpcol);
 
 		/* We have low <= mid < high, so mid points at a real slot */
 
-		result = _bt_compare(rel, key, page, mid);
+		result = _bt_compare_prefix(rel, key, page, mid, &cmpcol);
 
 		if (result >= cmpval)
+		{
 			low = mid + 1;
+			lowcmpcol = cmpcol;
+		}
 		else
+		{
 			high = mid;
+			highcmpcol = cmpcol;
+		}
 	}
 
 	/*
@@ -473,6 +496,8 @@ _bt_binsrch_insert(Relation rel, BTInsertState insertstate)
 	OffsetNumber low,
 				high,
 				stricthigh;
+	AttrNumber	lowcmpcol,
+				highcmpcol;
 	int32		result,
 				cmpval;
 
@@ -522,19 +547,31 @@ _bt_binsrch_insert(Relation rel, BTInsertState insertstate)
 
 	cmpval = 1;					/* !nextkey comparison value */
 
+	/*
+	 * Equal key prefixes are tracked just like in _bt_binsrch.  Cached bounds
+	 * don't remember their prefixes, so a restarted search begins from the
+	 * first attribute.
+	 */
+	lowcmpcol = highcmpcol = 1;
+
 	while (high > low)
 	{
 		OffsetNumber mid = low + ((high - low) / 2);
+		AttrNumber	cmpcol = Min(lowcmpcol, highcmpcol);
 
 		/* We have low <= mid < high, so mid points at a real slot */
 
-		result = _bt_compare(rel, key, page, mid);
+		result = _bt_compare_prefix(rel, key, page, mid, &cmpcol);
 
 		if (result >= cmpval)
+		{
 			low = mid + 1;
+			lowcmpcol = cmpcol;
+		}
 		else
 		{
 			high = mid;
+			highcmpcol = cmpcol;
 			if (result != 0)
 				stricthigh = high;
 		}
@@ -683,6 +720,69 @@ _bt_compare(Relation rel,
 			BTScanInsert key,
 			Page page,
 			OffsetNumber offnum)
+{
+	AttrNumber	cmpcol = 1;
+
+	return _bt_compare_prefix(rel, key, page, offnum, &cmpcol);
+}
+
+/*
+ *	_bt_fastcmp() -- Inline equivalent of scankey's sk_func.
+ *
+ * Only used for insertion scankeys whose SK_BT_FASTCMP_MASK bits were set by
+ * _bt_fastcmp_flags().  Like sk_func, compares the index datum (left) to the
+ * scankey's non-NULL argument (right), so the result's sign matches what the
+ * support function would have returned.
+ */
+static inline int32
+_bt_fastcmp(ScanKey scankey, Datum datum)
+{
+	Datum		arg = scankey->sk_argument;
+
+	switch ((scankey->sk_flags & SK_BT_FASTCMP_MASK) >> SK_BT_FASTCMP_SHIFT)
+	{
+		case BT_FASTCMP_INT16:
+			return pg_cmp_s16(DatumGetInt16(datum), DatumGetInt16(arg));
+		case BT_FASTCMP_INT32:
+			return pg_cmp_s32(DatumGetInt32(datum), DatumGetInt32(arg));
+		case BT_FASTCMP_INT64:
+			return pg_cmp_s64(DatumGetInt64(datum), DatumGetInt64(arg));
+		case BT_FASTCMP_UINT32:
+			return pg_cmp_u32(DatumGetObjectId(datum), DatumGetObjectId(arg));
+		case BT_FASTCMP_UUID:
+			return memcmp(DatumGetUUIDP(datum)->data,
+						  DatumGetUUIDP(arg)->data, UUID_LEN);
+	}
+
+	pg_unreachable();
+	return 0;
+}
+
+/*----------
+ *	_bt_compare_prefix() -- _bt_compare() that can skip a known-equal prefix.
+ *
+ * On entry, *cmpcol is the first key attribute that caller needs compared;
+ * caller guarantees that attributes before it are equal to the scankey's.
+ * On exit, *cmpcol is set to the attribute that decided the comparison, or
+ * to one past the last compared attribute when they were all found equal.
+ * In other words, the tuple's first (*cmpcol - 1) attributes are equal to
+ * the scankey's on exit.
+ *
+ * Binary search callers use this to implement "dynamic prefix truncation".
+ * Once both of the current search bounds are known to share some prefix
+ * with the scankey, every tuple between them must share that same prefix,
+ * so the search only needs to compare the remaining attributes.  This saves
+ * many comparator calls on pages whose tuples have long runs of equal
+ * leading attributes (e.g. a tenant identifier followed by other keys),
+ * without requiring any change to the on-disk representation.
+ *----------
+ */
+static pg_attribute_always_inline int32
+_bt_compare_prefix(Relation rel,
+				   BTScanInsert key,
+				   Page page,
+				   OffsetNumber offnum,
+				   AttrNumber *cmpcol)
 {
 	TupleDesc	itupdesc = RelationGetDescr(rel);
 	BTPageOpaque opaque = BTPageGetOpaque(page);
@@ -696,13 +796,17 @@ _bt_compare(Relation rel,
 	Assert(_bt_check_natts(rel, key->heapkeyspace, page, offnum));
 	Assert(key->keysz <= IndexRelationGetNumberOfKeyAttributes(rel));
 	Assert(key->heapkeyspace || key->scantid == NULL);
+	Assert(*cmpcol >= 1);
 
 	/*
 	 * Force result ">" if target item is first data item on an internal page
-	 * --- see NOTE above.
+	 * --- see NOTE above.  Nothing is known about its attributes.
 	 */
 	if (!P_ISLEAF(opaque) && offnum == P_FIRSTDATAKEY(opaque))
+	{
+		*cmpcol = 1;
 		return 1;
+	}
 
 	itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
 	ntupatts = BTreeTupleGetNAtts(itup, rel);
@@ -722,8 +826,8 @@ _bt_compare(Relation rel,
 	ncmpkey = Min(ntupatts, key->keysz);
 	Assert(key->heapkeyspace || ncmpkey == key->keysz);
 	Assert(!BTreeTupleIsPosting(itup) || key->allequalimage);
-	scankey = key->scankeys;
-	for (int i = 1; i <= ncmpkey; i++)
+	scankey = key->scankeys + (*cmpcol - 1);
+	for (int i = *cmpcol; i <= ncmpkey; i++)
 	{
 		Datum		datum;
 		bool		isNull;
@@ -756,10 +860,13 @@ _bt_compare(Relation rel,
 			 * to flip the sign of the comparison result.  (Unless it's a DESC
 			 * column, in which case we *don't* flip the sign.)
 			 */
-			result = DatumGetInt32(FunctionCall2Coll(&scankey->sk_func,
-													 scankey->sk_collation,
-													 datum,
-													 scankey->sk_argument));
+			if (scankey->sk_flags & SK_BT_FASTCMP_MASK)
+				result = _bt_fastcmp(scankey, datum);
+			else
+				result = DatumGetInt32(FunctionCall2Coll(&scankey->sk_func,
+														 scankey->sk_collation,
+														 datum,
+														 scankey->sk_argument));
 
 			if (!(scankey->sk_flags & SK_BT_DESC))
 				INVERT_COMPARE_RESULT(result);
@@ -767,11 +874,21 @@ _bt_compare(Relation rel,
 
 		/* if the keys are unequal, return the difference */
 		if (result != 0)
+		{
+			*cmpcol = i;
 			return result;
+		}
 
 		scankey++;
 	}
 
+	/*
+	 * Report every compared attribute as equal.  (A caller-supplied prefix
+	 * that reaches past ncmpkey can only happen with a truncated pivot tuple
+	 * between two bounds; reporting the shorter prefix is conservative.)
+	 */
+	*cmpcol = ncmpkey + 1;
+
 	/*
 	 * All non-truncated attributes (other than heap TID) were found to be
 	 * equal.  Treat truncated attributes as minus infinity when scankey has a
@@ -1279,7 +1396,8 @@ _bt_first(IndexScanDesc scan, ScanDirection dir)
 
 				procinfo = index_getprocinfo(rel, cur->sk_attno, BTORDER_PROC);
 				ScanKeyEntryInitializeWithInfo(inskey.scankeys + i,
-											   cur->sk_flags,
+											   cur->sk_flags |
+											   _bt_fastcmp_flags(procinfo->fn_oid),
 											   cur->sk_attno,
 											   InvalidStrategy,
 											   cur->sk_subtype,
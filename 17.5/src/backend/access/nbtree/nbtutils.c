@@ -25,6 +25,7 @@
 #include "miscadmin.h"
 #include "utils/array.h"
 #include "utils/datum.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
@@ -191,6 +192,7 @@ _bt_mkscankey(Relation rel, IndexTuple itup)
 			null = true;
 		}
 		flags = (null ? SK_ISNULL : 0) | (indoption[i] << SK_BT_INDOPTION_SHIFT);
+		flags |= _bt_fastcmp_flags(procinfo->fn_oid);
 		ScanKeyEntryInitializeWithInfo(&skey[i],
 									   flags,
 									   (AttrNumber) (i + 1),
@@ -214,6 +216,48 @@ _bt_mkscankey(Relation rel, IndexTuple itup)
 	return key;
 }
 
+/*
+ * _bt_fastcmp_flags() -- Get insertion scankey sk_flags for a comparator.
+ *
+ * Returns the SK_BT_FASTCMP_MASK bits that allow _bt_compare() to inline the
+ * comparison performed by btree support function 1 cmpproc, or 0 when the
+ * function must be called through fmgr.  Only same-type comparators whose
+ * behavior doesn't depend on collation are recognized.
+ */
+int
+_bt_fastcmp_flags(Oid cmpproc)
+{
+	int			kind;
+
+	switch (cmpproc)
+	{
+		case F_BTINT2CMP:
+			kind = BT_FASTCMP_INT16;
+			break;
+		case F_BTINT4CMP:
+		case F_DATE_CMP:
+			kind = BT_FASTCMP_INT32;
+			break;
+		case F_BTINT8CMP:
+		case F_TIME_CMP:
+		case F_TIMESTAMP_CMP:
+		case F_TIMESTAMPTZ_CMP:
+			kind = BT_FASTCMP_INT64;
+			break;
+		case F_BTOIDCMP:
+			kind = BT_FASTCMP_UINT32;
+			break;
+		case F_UUID_CMP:
+			kind = BT_FASTCMP_UUID;
+			break;
+		default:
+			kind = BT_FASTCMP_NONE;
+			break;
+	}
+
+	return kind << SK_BT_FASTCMP_SHIFT;
+}
+
 /*
  * free a retracement stack made by _bt_search.
  */
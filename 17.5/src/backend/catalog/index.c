@@ -24,8 +24,10 @@
 #include <unistd.h>
 
 #include "access/amapi.h"
+#include "access/gist_private.h"
 #include "access/heapam.h"
 #include "access/multixact.h"
+#include "access/parallel.h"
 #include "access/relscan.h"
 #include "access/tableam.h"
 #include "access/toast_compression.h"
@@ -55,8 +57,11 @@
 #include "commands/event_trigger.h"
 #include "commands/progress.h"
 #include "commands/tablecmds.h"
+#include "commands/tablespace.h"
 #include "commands/trigger.h"
+#include "commands/vacuum.h"
 #include "executor/executor.h"
+#include "executor/instrument.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
@@ -64,10 +69,14 @@
 #include "parser/parser.h"
 #include "pgstat.h"
 #include "rewrite/rewriteManip.h"
+#include "storage/buffile.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
 #include "storage/predicate.h"
+#include "storage/sharedfileset.h"
 #include "storage/smgr.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"
 #include "utils/builtins.h"
 #include "utils/fmgroids.h"
 #include "utils/guc.h"
@@ -85,6 +94,17 @@ Oid			binary_upgrade_next_index_pg_class_oid = InvalidOid;
 RelFileNumber binary_upgrade_next_index_pg_class_relfilenumber =
 InvalidRelFileNumber;
 
+/* GUC parameters */
+double		concurrent_index_cost_delay = 0;
+int			concurrent_index_cost_limit = -1;
+
+/* Cost-based delay state saved by index_concurrent_cost_delay_begin() */
+static bool saved_cost_delay_valid = false;
+static double saved_vacuum_cost_delay;
+static int	saved_vacuum_cost_limit;
+static bool saved_VacuumCostActive;
+static int	saved_VacuumCostBalance;
+
 /*
  * Pointer-free representation of variables used when reindexing system
  * catalogs; we use this to propagate those values to parallel workers.
@@ -97,6 +117,62 @@ typedef struct
 	Oid			pendingReindexedIndexes[FLEXIBLE_ARRAY_MEMBER];
 } SerializedReindexState;
 
+/* Magic numbers for parallel validate_index() state sharing */
+#define PARALLEL_KEY_VALIDATE_SHARED	UINT64CONST(0xC000000000000001)
+#define PARALLEL_KEY_SNAPSHOT			UINT64CONST(0xC000000000000002)
+#define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xC000000000000003)
+#define PARALLEL_KEY_WAL_USAGE			UINT64CONST(0xC000000000000004)
+#define PARALLEL_KEY_BUFFER_USAGE		UINT64CONST(0xC000000000000005)
+
+/*
+ * A parallel validate_index() divides the table into chunks of at least
+ * VALIDATE_MIN_CHUNK_BLOCKS blocks, using at most VALIDATE_MAX_CHUNKS chunks.
+ */
+#define VALIDATE_MIN_CHUNK_BLOCKS	64
+#define VALIDATE_MAX_CHUNKS			8192
+
+/* Number of encoded TIDs in each block of the shared TID file */
+#define VALIDATE_TIDS_PER_BLOCK		(BLCKSZ / sizeof(int64))
+
+/*
+ * Status for a parallel validate_index().
+ *
+ * The leader writes the sorted index TIDs to a shared temporary file, noting
+ * where the TIDs of each chunk of heap blocks begin.  Each participant then
+ * claims chunks one at a time, and merges the heap tuples of that chunk
+ * against the TIDs read from the file, starting at the chunk's first TID.
+ */
+typedef struct ValidateIndexShared
+{
+	/*
+	 * These fields are not modified during the scan.  They primarily exist
+	 * for the benefit of worker processes that need to open the relations.
+	 */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	BlockNumber nblocks;		/* number of heap blocks to scan */
+	BlockNumber chunkblocks;	/* number of heap blocks per chunk */
+	uint32		nchunks;
+
+	/* Shared temporary file holding the sorted TIDs */
+	SharedFileSet fileset;
+
+	/*
+	 * mutex protects all fields below.
+	 *
+	 * These fields contain status information of interest to the leader,
+	 * which adds the statistics to its own when all participants are done.
+	 */
+	slock_t		mutex;
+	uint32		nextchunk;		/* next chunk to be claimed */
+	BlockNumber blocksdone;
+	double		htups;
+	double		tups_inserted;
+
+	/* Position in the TID file of each chunk's first TID */
+	uint64		chunkstart[FLEXIBLE_ARRAY_MEMBER];
+} ValidateIndexShared;
+
 /* non-export function prototypes */
 static bool relationHasPrimaryKey(Relation rel);
 static TupleDesc ConstructTupleDescriptor(Relation heapRelation,
@@ -126,6 +202,17 @@ static void IndexCheckExclusion(Relation heapRelation,
 								Relation indexRelation,
 								IndexInfo *indexInfo);
 static bool validate_index_callback(ItemPointer itemptr, void *opaque);
+static void validate_index_parallel(Relation heapRelation,
+									Relation indexRelation,
+									IndexInfo *indexInfo,
+									Snapshot snapshot,
+									ValidateIndexState *state,
+									int request);
+static void validate_index_parallel_scan(ValidateIndexShared *shared,
+										 Relation heapRelation,
+										 Relation indexRelation,
+										 Snapshot snapshot,
+										 bool progress);
 static bool ReindexIsCurrentlyProcessingIndex(Oid indexOid);
 static void SetReindexProcessing(Oid heapOid, Oid indexOid);
 static void ResetReindexProcessing(void);
@@ -1518,8 +1605,20 @@ index_concurrently_build(Oid heapRelationId,
 	indexInfo->ii_Concurrent = true;
 	indexInfo->ii_BrokenHotChain = false;
 
-	/* Now build the index */
-	index_build(heapRel, indexRelation, indexInfo, false, true);
+	/*
+	 * Now build the index.  Unlike a plain build, this one may be throttled
+	 * using concurrent_index_cost_delay, since it doesn't block writers.
+	 */
+	index_concurrent_cost_delay_begin();
+	PG_TRY();
+	{
+		index_build(heapRel, indexRelation, indexInfo, false, true);
+	}
+	PG_FINALLY();
+	{
+		index_concurrent_cost_delay_end();
+	}
+	PG_END_TRY();
 
 	/* Roll back any GUC changes executed by index functions */
 	AtEOXact_GUC(false, save_nestlevel);
@@ -2958,12 +3057,15 @@ index_build(Relation heapRelation,
 
 	/*
 	 * Determine worker process details for parallel CREATE INDEX.  Currently,
-	 * only btree and BRIN have support for parallel builds.
+	 * only btree, BRIN, GIN and GiST have support for parallel builds.  GiST
+	 * supports them only for its sorted build method.
 	 *
 	 * Note that planner considers parallel safety for us.
 	 */
 	if (parallel && IsNormalProcessingMode() &&
-		indexRelation->rd_indam->amcanbuildparallel)
+		indexRelation->rd_indam->amcanbuildparallel &&
+		(indexRelation->rd_rel->relam != GIST_AM_OID ||
+		 gistCanBuildSorted(indexRelation)))
 		indexInfo->ii_ParallelWorkers =
 			plan_create_index_workers(RelationGetRelid(heapRelation),
 									  RelationGetRelid(indexRelation));
@@ -3264,6 +3366,16 @@ IndexCheckExclusion(Relation heapRelation,
  * to see which tuples are missing from the index.  Thus we will ensure that
  * all tuples valid according to the reference snapshot are in the index.
  *
+ * For heap tables and index AMs that support parallel builds, the table scan
+ * can be done in parallel: the sorted TIDs are then written to a shared
+ * temporary file, and each participant merges a range of heap blocks at a
+ * time against the corresponding part of that file.  The index scan and the
+ * sort are still done by the leader alone.
+ *
+ * Both the index scan and the table scan can be throttled using the
+ * concurrent_index_cost_delay and concurrent_index_cost_limit settings,
+ * trading a longer build for less I/O impact on concurrent sessions.
+ *
  * Building a unique index this way is tricky: we might try to insert a
  * tuple that is already dead or is in process of being deleted, and we
  * mustn't have a uniqueness failure against an updated version of the same
@@ -3296,6 +3408,7 @@ validate_index(Oid heapId, Oid indexId, Snapshot snapshot)
 	Oid			save_userid;
 	int			save_sec_context;
 	int			save_nestlevel;
+	int			nworkers = 0;
 
 	{
 		const int	progress_index[] = {
@@ -3361,45 +3474,76 @@ validate_index(Oid heapId, Oid indexId, Snapshot snapshot)
 											InvalidOid, false,
 											maintenance_work_mem,
 											NULL, TUPLESORT_NONE);
+	state.tidfile = NULL;
+	state.startblock = 0;
+	state.numblocks = InvalidBlockNumber;
 	state.htups = state.itups = state.tups_inserted = 0;
 
-	/* ambulkdelete updates progress metrics */
-	(void) index_bulk_delete(&ivinfo, NULL,
-							 validate_index_callback, (void *) &state);
+	/*
+	 * Determine worker process details for the table scan.  Parallelism is
+	 * only supported for heap tables, since the chunked scan relies on heap
+	 * scan limits, and only for btree indexes.  Supporting parallel builds
+	 * doesn't make an index AM safe for index_insert() calls from parallel
+	 * workers: BRIN, for example, may request autosummarization work from
+	 * there.
+	 */
+	if (heapRelation->rd_tableam == GetHeapamTableAmRoutine() &&
+		indexRelation->rd_rel->relam == BTREE_AM_OID)
+		nworkers = plan_create_index_workers(RelationGetRelid(heapRelation),
+											 RelationGetRelid(indexRelation));
 
-	/* Execute the sort */
+	index_concurrent_cost_delay_begin();
+	PG_TRY();
 	{
-		const int	progress_index[] = {
-			PROGRESS_CREATEIDX_PHASE,
-			PROGRESS_SCAN_BLOCKS_DONE,
-			PROGRESS_SCAN_BLOCKS_TOTAL
-		};
-		const int64 progress_vals[] = {
-			PROGRESS_CREATEIDX_PHASE_VALIDATE_SORT,
-			0, 0
-		};
+		/* ambulkdelete updates progress metrics */
+		(void) index_bulk_delete(&ivinfo, NULL,
+								 validate_index_callback, (void *) &state);
 
-		pgstat_progress_update_multi_param(3, progress_index, progress_vals);
-	}
-	tuplesort_performsort(state.tuplesort);
+		/* Execute the sort */
+		{
+			const int	progress_index[] = {
+				PROGRESS_CREATEIDX_PHASE,
+				PROGRESS_SCAN_BLOCKS_DONE,
+				PROGRESS_SCAN_BLOCKS_TOTAL
+			};
+			const int64 progress_vals[] = {
+				PROGRESS_CREATEIDX_PHASE_VALIDATE_SORT,
+				0, 0
+			};
+
+			pgstat_progress_update_multi_param(3, progress_index, progress_vals);
+		}
+		tuplesort_performsort(state.tuplesort);
 
-	/*
-	 * Now scan the heap and "merge" it with the index
-	 */
-	pgstat_progress_update_param(PROGRESS_CREATEIDX_PHASE,
-								 PROGRESS_CREATEIDX_PHASE_VALIDATE_TABLESCAN);
-	table_index_validate_scan(heapRelation,
-							  indexRelation,
-							  indexInfo,
-							  snapshot,
-							  &state);
+		/*
+		 * Now scan the heap and "merge" it with the index
+		 */
+		pgstat_progress_update_param(PROGRESS_CREATEIDX_PHASE,
+									 PROGRESS_CREATEIDX_PHASE_VALIDATE_TABLESCAN);
+		if (nworkers > 0)
+			validate_index_parallel(heapRelation, indexRelation, indexInfo,
+									snapshot, &state, nworkers);
+		else
+		{
+			table_index_validate_scan(heapRelation,
+									  indexRelation,
+									  indexInfo,
+									  snapshot,
+									  &state);
+
+			/* Make sure to release resources cached in indexInfo (if needed). */
+			index_insert_cleanup(indexRelation, indexInfo);
+		}
+	}
+	PG_FINALLY();
+	{
+		index_concurrent_cost_delay_end();
+	}
+	PG_END_TRY();
 
 	/* Done with tuplesort object */
 	tuplesort_end(state.tuplesort);
 
-	/* Make sure to release resources cached in indexInfo (if needed). */
-	index_insert_cleanup(indexRelation, indexInfo);
-
 	elog(DEBUG2,
 		 "validate_index found %.0f heap tuples, %.0f index tuples; inserted %.0f missing tuples",
 		 state.htups, state.itups, state.tups_inserted);
@@ -3415,6 +3559,416 @@ validate_index(Oid heapId, Oid indexId, Snapshot snapshot)
 	table_close(heapRelation, NoLock);
 }
 
+/*
+ * validate_index_parallel - scan the heap in parallel for validate_index
+ *
+ * state's tuplesort must already have been sorted.  Its contents are
+ * consumed here, and the statistics of all participants are added to state.
+ *
+ * request is the target number of parallel worker processes to launch.  The
+ * leader always participates in the scan, so this works even when no worker
+ * can be launched.
+ */
+static void
+validate_index_parallel(Relation heapRelation, Relation indexRelation,
+						IndexInfo *indexInfo, Snapshot snapshot,
+						ValidateIndexState *state,
+						int request)
+{
+	ParallelContext *pcxt;
+	Size		estshared;
+	Size		estsnap;
+	ValidateIndexShared *shared;
+	char	   *sharedsnapshot;
+	WalUsage   *walusage;
+	BufferUsage *bufferusage;
+	BufFile    *tidfile;
+	BlockNumber nblocks;
+	BlockNumber chunkblocks;
+	uint32		nchunks;
+	uint32		curchunk;
+	uint64		ntids;
+	int			querylen;
+	int			i;
+
+	/*
+	 * Any tuple visible to the reference snapshot must be in a block that
+	 * exists by now, so there's no need to look at blocks added later.
+	 */
+	nblocks = RelationGetNumberOfBlocks(heapRelation);
+	chunkblocks = Max(VALIDATE_MIN_CHUNK_BLOCKS,
+					  (nblocks + VALIDATE_MAX_CHUNKS - 1) / VALIDATE_MAX_CHUNKS);
+	nchunks = (nblocks + chunkblocks - 1) / chunkblocks;
+
+	EnterParallelMode();
+	Assert(request > 0);
+	pcxt = CreateParallelContext("postgres", "validate_index_parallel_main",
+								 request);
+
+	estshared = add_size(offsetof(ValidateIndexShared, chunkstart),
+						 mul_size(nchunks + 1, sizeof(uint64)));
+	shm_toc_estimate_chunk(&pcxt->estimator, estshared);
+	estsnap = EstimateSnapshotSpace(snapshot);
+	shm_toc_estimate_chunk(&pcxt->estimator, estsnap);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	/* Estimate space for WalUsage and BufferUsage, as for a parallel build */
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(sizeof(BufferUsage), pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+
+	/* Finally, estimate PARALLEL_KEY_QUERY_TEXT space */
+	if (debug_query_string)
+	{
+		querylen = strlen(debug_query_string);
+		shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+	else
+		querylen = 0;			/* keep compiler quiet */
+
+	/* Everyone's had a chance to ask for space, so now create the DSM */
+	InitializeParallelDSM(pcxt);
+
+	/* If no DSM segment was available, back out (do serial scan) */
+	if (pcxt->seg == NULL)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+
+		table_index_validate_scan(heapRelation, indexRelation, indexInfo,
+								  snapshot, state);
+		index_insert_cleanup(indexRelation, indexInfo);
+		return;
+	}
+
+	shared = (ValidateIndexShared *) shm_toc_allocate(pcxt->toc, estshared);
+	shared->heaprelid = RelationGetRelid(heapRelation);
+	shared->indexrelid = RelationGetRelid(indexRelation);
+	shared->nblocks = nblocks;
+	shared->chunkblocks = chunkblocks;
+	shared->nchunks = nchunks;
+	SpinLockInit(&shared->mutex);
+	shared->nextchunk = 0;
+	shared->blocksdone = 0;
+	shared->htups = 0;
+	shared->tups_inserted = 0;
+
+	/*
+	 * Write the sorted TIDs to the shared file, remembering where each chunk
+	 * starts.  A chunk's TIDs can be found at its start position even if
+	 * there are none, since it's then the start position of a later chunk.
+	 */
+	PrepareTempTablespaces();
+	SharedFileSetInit(&shared->fileset, pcxt->seg);
+	tidfile = BufFileCreateFileSet(&shared->fileset.fs, "tids");
+	ntids = 0;
+	curchunk = 0;
+	for (;;)
+	{
+		Datum		ts_val;
+		bool		ts_isnull;
+		int64		encoded;
+		uint32		chunk;
+
+		if (!tuplesort_getdatum(state->tuplesort, true, false,
+								&ts_val, &ts_isnull, NULL))
+			break;
+		Assert(!ts_isnull);
+		encoded = DatumGetInt64(ts_val);
+
+		/* the block number is stored in the upper bits; see itemptr_encode */
+		chunk = Min((BlockNumber) (encoded >> 16) / chunkblocks, nchunks);
+		while (curchunk <= chunk)
+			shared->chunkstart[curchunk++] = ntids;
+
+		BufFileWrite(tidfile, &encoded, sizeof(int64));
+		ntids++;
+	}
+	while (curchunk <= nchunks)
+		shared->chunkstart[curchunk++] = ntids;
+	BufFileExportFileSet(tidfile);
+	BufFileClose(tidfile);
+
+	sharedsnapshot = shm_toc_allocate(pcxt->toc, estsnap);
+	SerializeSnapshot(snapshot, sharedsnapshot);
+
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_VALIDATE_SHARED, shared);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_SNAPSHOT, sharedsnapshot);
+
+	/* Store query string for workers */
+	if (debug_query_string)
+	{
+		char	   *sharedquery;
+
+		sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+		memcpy(sharedquery, debug_query_string, querylen + 1);
+		shm_toc_insert(pcxt->toc, PARALLEL_KEY_QUERY_TEXT, sharedquery);
+	}
+
+	/*
+	 * Allocate space for each worker's WalUsage and BufferUsage; no need to
+	 * initialize.
+	 */
+	walusage = shm_toc_allocate(pcxt->toc,
+								mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_WAL_USAGE, walusage);
+	bufferusage = shm_toc_allocate(pcxt->toc,
+								   mul_size(sizeof(BufferUsage), pcxt->nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_BUFFER_USAGE, bufferusage);
+
+	LaunchParallelWorkers(pcxt);
+
+	pgstat_progress_update_param(PROGRESS_SCAN_BLOCKS_TOTAL, nblocks);
+
+	/* Join the scan ourselves */
+	validate_index_parallel_scan(shared, heapRelation, indexRelation,
+								 snapshot, true);
+
+	/* Wait for the workers to finish their last chunks */
+	WaitForParallelWorkersToFinish(pcxt);
+
+	/*
+	 * Next, accumulate WAL usage.  (This must wait for the workers to finish,
+	 * or we might get incomplete data.)
+	 */
+	for (i = 0; i < pcxt->nworkers_launched; i++)
+		InstrAccumParallelQuery(&bufferusage[i], &walusage[i]);
+
+	pgstat_progress_update_param(PROGRESS_SCAN_BLOCKS_DONE, nblocks);
+
+	state->htups += shared->htups;
+	state->tups_inserted += shared->tups_inserted;
+
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+}
+
+/*
+ * validate_index_parallel_scan - claim and scan chunks until there are none
+ *
+ * Each chunk is merged against the sorted TIDs using the table AM's
+ * validate scan, with state limiting the scan to the chunk's blocks.
+ */
+static void
+validate_index_parallel_scan(ValidateIndexShared *shared,
+							 Relation heapRelation, Relation indexRelation,
+							 Snapshot snapshot, bool progress)
+{
+	ValidateIndexState state;
+	IndexInfo  *indexInfo;
+
+	indexInfo = BuildIndexInfo(indexRelation);
+	indexInfo->ii_Concurrent = true;
+
+	state.tuplesort = NULL;
+	state.tidfile = BufFileOpenFileSet(&shared->fileset.fs, "tids",
+									   O_RDONLY, false);
+	state.htups = state.itups = state.tups_inserted = 0;
+
+	for (;;)
+	{
+		uint32		chunk;
+		uint64		first;
+		BlockNumber blocksdone;
+
+		SpinLockAcquire(&shared->mutex);
+		chunk = shared->nextchunk;
+		if (chunk < shared->nchunks)
+			shared->nextchunk++;
+		SpinLockRelease(&shared->mutex);
+
+		if (chunk >= shared->nchunks)
+			break;
+
+		state.startblock = chunk * shared->chunkblocks;
+		state.numblocks = Min(shared->chunkblocks,
+							  shared->nblocks - state.startblock);
+
+		/* Position the TID file at the chunk's first TID */
+		first = shared->chunkstart[chunk];
+		if (BufFileSeekBlock(state.tidfile,
+							 first / VALIDATE_TIDS_PER_BLOCK) != 0 ||
+			BufFileSeek(state.tidfile, 0,
+						(first % VALIDATE_TIDS_PER_BLOCK) * sizeof(int64),
+						SEEK_CUR) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek to TID %llu in temporary file for index \"%s\"",
+							(unsigned long long) first,
+							RelationGetRelationName(indexRelation))));
+
+		table_index_validate_scan(heapRelation,
+								  indexRelation,
+								  indexInfo,
+								  snapshot,
+								  &state);
+
+		SpinLockAcquire(&shared->mutex);
+		shared->blocksdone += state.numblocks;
+		blocksdone = shared->blocksdone;
+		SpinLockRelease(&shared->mutex);
+
+		if (progress)
+			pgstat_progress_update_param(PROGRESS_SCAN_BLOCKS_DONE,
+										 blocksdone);
+	}
+
+	BufFileClose(state.tidfile);
+
+	/* Make sure to release resources cached in indexInfo (if needed). */
+	index_insert_cleanup(indexRelation, indexInfo);
+
+	SpinLockAcquire(&shared->mutex);
+	shared->htups += state.htups;
+	shared->tups_inserted += state.tups_inserted;
+	SpinLockRelease(&shared->mutex);
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+validate_index_parallel_main(dsm_segment *seg, shm_toc *toc)
+{
+	char	   *sharedquery;
+	ValidateIndexShared *shared;
+	Relation	heapRel;
+	Relation	indexRel;
+	Snapshot	snapshot;
+	WalUsage   *walusage;
+	BufferUsage *bufferusage;
+
+	/*
+	 * The only possible status flag that can be set to the parallel worker is
+	 * PROC_IN_SAFE_IC.
+	 */
+	Assert((MyProc->statusFlags == 0) ||
+		   (MyProc->statusFlags == PROC_IN_SAFE_IC));
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_KEY_QUERY_TEXT, true);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	/* Look up shared state, and attach to the TID file's fileset */
+	shared = shm_toc_lookup(toc, PARALLEL_KEY_VALIDATE_SHARED, false);
+	SharedFileSetAttach(&shared->fileset, seg);
+
+	/* Open relations using lock modes known to be obtained by index.c */
+	heapRel = table_open(shared->heaprelid, ShareUpdateExclusiveLock);
+	indexRel = index_open(shared->indexrelid, RowExclusiveLock);
+
+	/* Use the leader's reference snapshot */
+	snapshot = RestoreSnapshot(shm_toc_lookup(toc, PARALLEL_KEY_SNAPSHOT,
+											  false));
+	snapshot = RegisterSnapshot(snapshot);
+
+	/* Prepare to track buffer usage during parallel execution */
+	InstrStartParallelQuery();
+
+	index_concurrent_cost_delay_begin();
+	validate_index_parallel_scan(shared, heapRel, indexRel, snapshot, false);
+	index_concurrent_cost_delay_end();
+
+	/* Report WAL/buffer usage during parallel execution */
+	bufferusage = shm_toc_lookup(toc, PARALLEL_KEY_BUFFER_USAGE, false);
+	walusage = shm_toc_lookup(toc, PARALLEL_KEY_WAL_USAGE, false);
+	InstrEndParallelQuery(&bufferusage[ParallelWorkerNumber],
+						  &walusage[ParallelWorkerNumber]);
+
+	UnregisterSnapshot(snapshot);
+	index_close(indexRel, RowExclusiveLock);
+	table_close(heapRel, ShareUpdateExclusiveLock);
+}
+
+/*
+ * validate_index_next_tid - fetch the next index TID for a validate scan
+ *
+ * Returns false when there are no more TIDs.  The TIDs are read from the
+ * tuplesort, or from the shared TID file in a parallel validate_index().
+ */
+bool
+validate_index_next_tid(ValidateIndexState *state, ItemPointer tid)
+{
+	int64		encoded;
+
+	if (state->tidfile != NULL)
+	{
+		if (BufFileReadMaybeEOF(state->tidfile, &encoded, sizeof(int64),
+								true) == 0)
+			return false;
+	}
+	else
+	{
+		Datum		ts_val;
+		bool		ts_isnull;
+
+		if (!tuplesort_getdatum(state->tuplesort, true, false,
+								&ts_val, &ts_isnull, NULL))
+			return false;
+		Assert(!ts_isnull);
+		encoded = DatumGetInt64(ts_val);
+	}
+
+	itemptr_decode(tid, encoded);
+	return true;
+}
+
+/*
+ * index_concurrent_cost_delay_begin - start throttling a concurrent build
+ *
+ * CREATE INDEX CONCURRENTLY and REINDEX CONCURRENTLY let other sessions keep
+ * writing to the table, so it can be preferable for them to take longer
+ * rather than compete for I/O.  When concurrent_index_cost_delay is set, we
+ * enable VACUUM's cost-based delay machinery for the duration of the build,
+ * with vacuum_delay_point() being called for each heap block scanned (that
+ * is, each block counted in pg_stat_progress_create_index) and by index AMs
+ * while scanning the index.  Each process, including parallel workers,
+ * keeps its own cost balance.
+ *
+ * The cost-based delay settings in effect before are saved, and restored by
+ * index_concurrent_cost_delay_end().  Callers must make sure that that is
+ * called, even on error.
+ */
+void
+index_concurrent_cost_delay_begin(void)
+{
+	Assert(!saved_cost_delay_valid);
+	saved_vacuum_cost_delay = vacuum_cost_delay;
+	saved_vacuum_cost_limit = vacuum_cost_limit;
+	saved_VacuumCostActive = VacuumCostActive;
+	saved_VacuumCostBalance = VacuumCostBalance;
+	saved_cost_delay_valid = true;
+
+	vacuum_cost_delay = concurrent_index_cost_delay;
+	vacuum_cost_limit = (concurrent_index_cost_limit > 0) ?
+		concurrent_index_cost_limit : VacuumCostLimit;
+	VacuumCostBalance = 0;
+	VacuumCostActive = (vacuum_cost_delay > 0);
+}
+
+/*
+ * index_concurrent_cost_delay_end - stop throttling a concurrent build
+ */
+void
+index_concurrent_cost_delay_end(void)
+{
+	if (!saved_cost_delay_valid)
+		return;
+
+	vacuum_cost_delay = saved_vacuum_cost_delay;
+	vacuum_cost_limit = saved_vacuum_cost_limit;
+	VacuumCostActive = saved_VacuumCostActive;
+	VacuumCostBalance = saved_VacuumCostBalance;
+	saved_cost_delay_valid = false;
+}
+
 /*
  * validate_index_callback - bulkdelete callback to collect the index TIDs
  */
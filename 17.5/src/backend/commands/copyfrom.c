@@ -395,6 +395,7 @@ CopyMultiInsertBufferFlush(CopyMultiInsertInfo *miinfo,
 		bool		line_buf_valid = cstate->line_buf_valid;
 		uint64		save_cur_lineno = cstate->cur_lineno;
 		MemoryContext oldcontext;
+		bool		indexesdone = false;
 
 		Assert(buffer->bistate != NULL);
 
@@ -417,13 +418,24 @@ CopyMultiInsertBufferFlush(CopyMultiInsertInfo *miinfo,
 						   buffer->bistate);
 		MemoryContextSwitchTo(oldcontext);
 
+		/*
+		 * If there are any indexes, try to update them for the whole batch at
+		 * once.  That inserts btree entries in key order, which is much
+		 * cheaper than inserting them in arrival order if keys are random.
+		 */
+		if (resultRelInfo->ri_NumIndices > 0)
+			indexesdone = ExecInsertIndexTuplesBatch(resultRelInfo,
+													 slots, nused, estate,
+													 buffer->linenos,
+													 &cstate->cur_lineno);
+
 		for (i = 0; i < nused; i++)
 		{
 			/*
-			 * If there are any indexes, update them for all the inserted
-			 * tuples, and run AFTER ROW INSERT triggers.
+			 * If there are any indexes not yet taken care of, update them for
+			 * all the inserted tuples, and run AFTER ROW INSERT triggers.
 			 */
-			if (resultRelInfo->ri_NumIndices > 0)
+			if (resultRelInfo->ri_NumIndices > 0 && !indexesdone)
 			{
 				List	   *recheckIndexes;
 
@@ -439,8 +451,8 @@ CopyMultiInsertBufferFlush(CopyMultiInsertInfo *miinfo,
 			}
 
 			/*
-			 * There's no indexes, but see if we need to run AFTER ROW INSERT
-			 * triggers anyway.
+			 * There's no indexes left to update, but see if we need to run
+			 * AFTER ROW INSERT triggers anyway.
 			 */
 			else if (resultRelInfo->ri_TrigDesc != NULL &&
 					 (resultRelInfo->ri_TrigDesc->trig_insert_after_row ||
@@ -114,6 +114,8 @@ static void show_grouping_set_keys(PlanState *planstate,
 								   List *ancestors, ExplainState *es);
 static void show_group_keys(GroupState *gstate, List *ancestors,
 							ExplainState *es);
+static void show_repartition_keys(RepartitionState *rstate, List *ancestors,
+								  ExplainState *es);
 static void show_sort_group_keys(PlanState *planstate, const char *qlabel,
 								 int nkeys, int nPresortedKeys, AttrNumber *keycols,
 								 Oid *sortOperators, Oid *collations, bool *nullsFirst,
@@ -129,10 +131,19 @@ static void show_hash_info(HashState *hashstate, ExplainState *es);
 static void show_memoize_info(MemoizeState *mstate, List *ancestors,
 							  ExplainState *es);
 static void show_hashagg_info(AggState *aggstate, ExplainState *es);
+static void show_setop_info(SetOpState *setopstate, ExplainState *es);
+static void show_recursive_union_info(RecursiveUnionState *rustate,
+									  ExplainState *es);
+static void show_tuple_queue_info(TupleQueueInstrumentation *worker_instr,
+								  TupleQueueInstrumentation *leader_instr,
+								  ExplainState *es);
+static void show_temp_compression(int64 writtenKb, int64 compressedKb,
+								  ExplainState *es);
 static void show_tidbitmap_info(BitmapHeapScanState *planstate,
 								ExplainState *es);
 static void show_instrumentation_count(const char *qlabel, int which,
 									   PlanState *planstate, ExplainState *es);
+static void show_bloom_filter_count(HashJoinState *hjstate, ExplainState *es);
 static void show_foreignscan_info(ForeignScanState *fsstate, ExplainState *es);
 static const char *explain_get_index_name(Oid indexId);
 static bool peek_buffer_usage(ExplainState *es, const BufferUsage *usage);
@@ -1034,6 +1045,9 @@ ExplainPrintJIT(ExplainState *es, int jit_flags, JitInstrumentation *ji)
 		es->indent++;
 
 		ExplainPropertyInteger("Functions", NULL, ji->created_functions, es);
+		if (ji->cached_deform_functions > 0)
+			ExplainPropertyInteger("Cached Deform Functions", NULL,
+								   ji->cached_deform_functions, es);
 
 		ExplainIndentText(es);
 		appendStringInfo(es->str, "Options: %s %s, %s %s, %s %s, %s %s\n",
@@ -1060,6 +1074,8 @@ ExplainPrintJIT(ExplainState *es, int jit_flags, JitInstrumentation *ji)
 	else
 	{
 		ExplainPropertyInteger("Functions", NULL, ji->created_functions, es);
+		ExplainPropertyInteger("Cached Deform Functions", NULL,
+							   ji->cached_deform_functions, es);
 
 		ExplainOpenGroup("Options", "Options", true, es);
 		ExplainPropertyBool("Inlining", jit_flags & PGJIT_INLINE, es);
@@ -1534,6 +1550,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		case T_Memoize:
 			pname = sname = "Memoize";
 			break;
+		case T_Repartition:
+			pname = sname = "Repartition";
+			break;
 		case T_Sort:
 			pname = sname = "Sort";
 			break;
@@ -2048,6 +2067,14 @@ ExplainNode(PlanState *planstate, List *ancestors,
 
 				if (gather->single_copy || es->format != EXPLAIN_FORMAT_TEXT)
 					ExplainPropertyBool("Single Copy", gather->single_copy, es);
+
+				if (es->analyze && es->verbose)
+				{
+					GatherState *gstate = (GatherState *) planstate;
+
+					show_tuple_queue_info(&gstate->worker_queue_instr,
+										  &gstate->leader_queue_instr, es);
+				}
 			}
 			break;
 		case T_GatherMerge:
@@ -2069,6 +2096,14 @@ ExplainNode(PlanState *planstate, List *ancestors,
 					ExplainPropertyInteger("Workers Launched", NULL,
 										   nworkers, es);
 				}
+
+				if (es->analyze && es->verbose)
+				{
+					GatherMergeState *gmstate = (GatherMergeState *) planstate;
+
+					show_tuple_queue_info(&gmstate->worker_queue_instr,
+										  &gmstate->leader_queue_instr, es);
+				}
 			}
 			break;
 		case T_FunctionScan:
@@ -2196,6 +2231,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 2,
 										   planstate, es);
+			if (((Hash *) innerPlan(plan))->filterBloom)
+				show_bloom_filter_count(castNode(HashJoinState, planstate),
+										es);
 			break;
 		case T_Agg:
 			show_agg_keys(castNode(AggState, planstate), ancestors, es);
@@ -2249,10 +2287,21 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		case T_Hash:
 			show_hash_info(castNode(HashState, planstate), es);
 			break;
+		case T_SetOp:
+			show_setop_info(castNode(SetOpState, planstate), es);
+			break;
+		case T_RecursiveUnion:
+			show_recursive_union_info(castNode(RecursiveUnionState,
+											   planstate), es);
+			break;
 		case T_Memoize:
 			show_memoize_info(castNode(MemoizeState, planstate), ancestors,
 							  es);
 			break;
+		case T_Repartition:
+			show_repartition_keys(castNode(RepartitionState, planstate),
+								  ancestors, es);
+			break;
 		default:
 			break;
 	}
@@ -2750,6 +2799,34 @@ show_group_keys(GroupState *gstate, List *ancestors,
 	ancestors = list_delete_first(ancestors);
 }
 
+/*
+ * Show the hash keys, or the sort keys in range mode, for a Repartition node.
+ */
+static void
+show_repartition_keys(RepartitionState *rstate, List *ancestors,
+					  ExplainState *es)
+{
+	Repartition *plan = (Repartition *) rstate->ps.plan;
+
+	if (plan->numSortCols > 0)
+	{
+		show_sort_group_keys((PlanState *) rstate, "Sort Key",
+							 plan->numSortCols, 0, plan->sortColIdx,
+							 plan->sortOperators, plan->collations,
+							 plan->nullsFirst,
+							 ancestors, es);
+		return;
+	}
+
+	/* The key columns refer to the tlist of the child plan */
+	ancestors = lcons(plan, ancestors);
+	show_sort_group_keys(outerPlanState(rstate), "Hash Key",
+						 plan->numCols, 0, plan->hashColIdx,
+						 NULL, NULL, NULL,
+						 ancestors, es);
+	ancestors = list_delete_first(ancestors);
+}
+
 /*
  * Common code to show sort/group keys, which are represented in plan nodes
  * as arrays of targetlist indexes.  If it's a sort key rather than a group
@@ -2963,14 +3040,19 @@ show_sort_info(SortState *sortstate, ExplainState *es)
 		if (es->format == EXPLAIN_FORMAT_TEXT)
 		{
 			ExplainIndentText(es);
-			appendStringInfo(es->str, "Sort Method: %s  %s: " INT64_FORMAT "kB\n",
+			appendStringInfo(es->str, "Sort Method: %s  %s: " INT64_FORMAT "kB",
 							 sortMethod, spaceType, spaceUsed);
+			show_temp_compression(stats.tempWritten,
+								  stats.tempWrittenCompressed, es);
+			appendStringInfoChar(es->str, '\n');
 		}
 		else
 		{
 			ExplainPropertyText("Sort Method", sortMethod, es);
 			ExplainPropertyInteger("Sort Space Used", "kB", spaceUsed, es);
 			ExplainPropertyText("Sort Space Type", spaceType, es);
+			show_temp_compression(stats.tempWritten,
+								  stats.tempWrittenCompressed, es);
 		}
 	}
 
@@ -3008,14 +3090,19 @@ show_sort_info(SortState *sortstate, ExplainState *es)
 			{
 				ExplainIndentText(es);
 				appendStringInfo(es->str,
-								 "Sort Method: %s  %s: " INT64_FORMAT "kB\n",
+								 "Sort Method: %s  %s: " INT64_FORMAT "kB",
 								 sortMethod, spaceType, spaceUsed);
+				show_temp_compression(sinstrument->tempWritten,
+									  sinstrument->tempWrittenCompressed, es);
+				appendStringInfoChar(es->str, '\n');
 			}
 			else
 			{
 				ExplainPropertyText("Sort Method", sortMethod, es);
 				ExplainPropertyInteger("Sort Space Used", "kB", spaceUsed, es);
 				ExplainPropertyText("Sort Space Type", spaceType, es);
+				show_temp_compression(sinstrument->tempWritten,
+									  sinstrument->tempWrittenCompressed, es);
 			}
 
 			if (es->workers_state)
@@ -3277,6 +3364,13 @@ show_hash_info(HashState *hashstate, ExplainState *es)
 											  worker_hi->nbatch_original);
 			hinstrument.space_peak = Max(hinstrument.space_peak,
 										 worker_hi->space_peak);
+			hinstrument.nbatch_chunked = Max(hinstrument.nbatch_chunked,
+											 worker_hi->nbatch_chunked);
+			hinstrument.temp_written = Max(hinstrument.temp_written,
+										   worker_hi->temp_written);
+			hinstrument.temp_written_compressed =
+				Max(hinstrument.temp_written_compressed,
+					worker_hi->temp_written_compressed);
 		}
 	}
 
@@ -3296,26 +3390,47 @@ show_hash_info(HashState *hashstate, ExplainState *es)
 								   hinstrument.nbatch_original, es);
 			ExplainPropertyUInteger("Peak Memory Usage", "kB",
 									spacePeakKb, es);
+			ExplainPropertyInteger("Chunked Batches", NULL,
+								   hinstrument.nbatch_chunked, es);
+			show_temp_compression(BYTES_TO_KILOBYTES(hinstrument.temp_written),
+								  BYTES_TO_KILOBYTES(hinstrument.temp_written_compressed),
+								  es);
 		}
 		else if (hinstrument.nbatch_original != hinstrument.nbatch ||
 				 hinstrument.nbuckets_original != hinstrument.nbuckets)
 		{
 			ExplainIndentText(es);
 			appendStringInfo(es->str,
-							 "Buckets: %d (originally %d)  Batches: %d (originally %d)  Memory Usage: " UINT64_FORMAT "kB\n",
+							 "Buckets: %d (originally %d)  Batches: %d (originally %d)  Memory Usage: " UINT64_FORMAT "kB",
 							 hinstrument.nbuckets,
 							 hinstrument.nbuckets_original,
 							 hinstrument.nbatch,
 							 hinstrument.nbatch_original,
 							 spacePeakKb);
+			show_temp_compression(BYTES_TO_KILOBYTES(hinstrument.temp_written),
+								  BYTES_TO_KILOBYTES(hinstrument.temp_written_compressed),
+								  es);
+			appendStringInfoChar(es->str, '\n');
 		}
 		else
 		{
 			ExplainIndentText(es);
 			appendStringInfo(es->str,
-							 "Buckets: %d  Batches: %d  Memory Usage: " UINT64_FORMAT "kB\n",
+							 "Buckets: %d  Batches: %d  Memory Usage: " UINT64_FORMAT "kB",
 							 hinstrument.nbuckets, hinstrument.nbatch,
 							 spacePeakKb);
+			show_temp_compression(BYTES_TO_KILOBYTES(hinstrument.temp_written),
+								  BYTES_TO_KILOBYTES(hinstrument.temp_written_compressed),
+								  es);
+			appendStringInfoChar(es->str, '\n');
+		}
+
+		if (es->format == EXPLAIN_FORMAT_TEXT &&
+			hinstrument.nbatch_chunked > 0)
+		{
+			ExplainIndentText(es);
+			appendStringInfo(es->str, "Chunked Batches: %d\n",
+							 hinstrument.nbatch_chunked);
 		}
 	}
 }
@@ -3376,7 +3491,7 @@ show_memoize_info(MemoizeState *mstate, List *ancestors, ExplainState *es)
 	if (!es->analyze)
 		return;
 
-	if (mstate->stats.cache_misses > 0)
+	if (mstate->stats.cache_misses > 0 || mstate->stats.shared_hits > 0)
 	{
 		/*
 		 * mem_peak is only set when we freed memory, so we must use mem_used
@@ -3390,6 +3505,8 @@ show_memoize_info(MemoizeState *mstate, List *ancestors, ExplainState *es)
 		if (es->format != EXPLAIN_FORMAT_TEXT)
 		{
 			ExplainPropertyInteger("Cache Hits", NULL, mstate->stats.cache_hits, es);
+			if (mstate->shared_cache_used)
+				ExplainPropertyInteger("Shared Cache Hits", NULL, mstate->stats.shared_hits, es);
 			ExplainPropertyInteger("Cache Misses", NULL, mstate->stats.cache_misses, es);
 			ExplainPropertyInteger("Cache Evictions", NULL, mstate->stats.cache_evictions, es);
 			ExplainPropertyInteger("Cache Overflows", NULL, mstate->stats.cache_overflows, es);
@@ -3398,9 +3515,13 @@ show_memoize_info(MemoizeState *mstate, List *ancestors, ExplainState *es)
 		else
 		{
 			ExplainIndentText(es);
+			appendStringInfo(es->str, "Hits: " UINT64_FORMAT "  ",
+							 mstate->stats.cache_hits);
+			if (mstate->shared_cache_used)
+				appendStringInfo(es->str, "Shared Hits: " UINT64_FORMAT "  ",
+								 mstate->stats.shared_hits);
 			appendStringInfo(es->str,
-							 "Hits: " UINT64_FORMAT "  Misses: " UINT64_FORMAT "  Evictions: " UINT64_FORMAT "  Overflows: " UINT64_FORMAT "  Memory Usage: " INT64_FORMAT "kB\n",
-							 mstate->stats.cache_hits,
+							 "Misses: " UINT64_FORMAT "  Evictions: " UINT64_FORMAT "  Overflows: " UINT64_FORMAT "  Memory Usage: " INT64_FORMAT "kB\n",
 							 mstate->stats.cache_misses,
 							 mstate->stats.cache_evictions,
 							 mstate->stats.cache_overflows,
@@ -3420,9 +3541,10 @@ show_memoize_info(MemoizeState *mstate, List *ancestors, ExplainState *es)
 
 		/*
 		 * Skip workers that didn't do any work.  We needn't bother checking
-		 * for cache hits as a miss will always occur before a cache hit.
+		 * for cache hits as a miss will always occur before a cache hit, but
+		 * a worker may have found everything in the shared cache.
 		 */
-		if (si->cache_misses == 0)
+		if (si->cache_misses == 0 && si->shared_hits == 0)
 			continue;
 
 		if (es->workers_state)
@@ -3439,9 +3561,14 @@ show_memoize_info(MemoizeState *mstate, List *ancestors, ExplainState *es)
 		if (es->format == EXPLAIN_FORMAT_TEXT)
 		{
 			ExplainIndentText(es);
+			appendStringInfo(es->str, "Hits: " UINT64_FORMAT "  ",
+							 si->cache_hits);
+			if (mstate->shared_cache_used)
+				appendStringInfo(es->str, "Shared Hits: " UINT64_FORMAT "  ",
+								 si->shared_hits);
 			appendStringInfo(es->str,
-							 "Hits: " UINT64_FORMAT "  Misses: " UINT64_FORMAT "  Evictions: " UINT64_FORMAT "  Overflows: " UINT64_FORMAT "  Memory Usage: " INT64_FORMAT "kB\n",
-							 si->cache_hits, si->cache_misses,
+							 "Misses: " UINT64_FORMAT "  Evictions: " UINT64_FORMAT "  Overflows: " UINT64_FORMAT "  Memory Usage: " INT64_FORMAT "kB\n",
+							 si->cache_misses,
 							 si->cache_evictions, si->cache_overflows,
 							 memPeakKb);
 		}
@@ -3449,6 +3576,9 @@ show_memoize_info(MemoizeState *mstate, List *ancestors, ExplainState *es)
 		{
 			ExplainPropertyInteger("Cache Hits", NULL,
 								   si->cache_hits, es);
+			if (mstate->shared_cache_used)
+				ExplainPropertyInteger("Shared Cache Hits", NULL,
+									   si->shared_hits, es);
 			ExplainPropertyInteger("Cache Misses", NULL,
 								   si->cache_misses, es);
 			ExplainPropertyInteger("Cache Evictions", NULL,
@@ -3464,6 +3594,113 @@ show_memoize_info(MemoizeState *mstate, List *ancestors, ExplainState *es)
 	}
 }
 
+/*
+ * Show information on hashed SetOp memory usage and batches.
+ */
+static void
+show_setop_info(SetOpState *setopstate, ExplainState *es)
+{
+	SetOp	   *setop = (SetOp *) setopstate->ps.plan;
+	int64		memPeakKb = BYTES_TO_KILOBYTES(setopstate->hash_mem_peak);
+
+	if (setop->strategy != SETOP_HASHED || !es->analyze ||
+		setopstate->hash_mem_peak == 0)
+		return;
+
+	if (es->format != EXPLAIN_FORMAT_TEXT)
+	{
+		ExplainPropertyInteger("HashSetOp Batches", NULL,
+							   setopstate->hash_batches_used, es);
+		ExplainPropertyInteger("Peak Memory Usage", "kB", memPeakKb, es);
+		ExplainPropertyInteger("Disk Usage", "kB",
+							   setopstate->hash_disk_used, es);
+		show_temp_compression(setopstate->hash_temp_written,
+							  setopstate->hash_temp_written_compressed, es);
+	}
+	else
+	{
+		ExplainIndentText(es);
+		appendStringInfo(es->str, "Batches: %d  Memory Usage: " INT64_FORMAT "kB",
+						 setopstate->hash_batches_used, memPeakKb);
+
+		/* Only display disk usage if we spilled to disk */
+		if (setopstate->hash_batches_used > 1)
+		{
+			appendStringInfo(es->str, "  Disk Usage: " UINT64_FORMAT "kB",
+							 setopstate->hash_disk_used);
+			show_temp_compression(setopstate->hash_temp_written,
+								  setopstate->hash_temp_written_compressed,
+								  es);
+		}
+		appendStringInfoChar(es->str, '\n');
+	}
+}
+
+/*
+ * Show how many partitions a RecursiveUnion set tuples aside in, if its hash
+ * table filled up.
+ */
+static void
+show_recursive_union_info(RecursiveUnionState *rustate, ExplainState *es)
+{
+	if (!es->analyze || rustate->hash_spill_partitions == 0)
+		return;
+
+	ExplainPropertyInteger("Spill Partitions", NULL,
+						   rustate->hash_spill_partitions, es);
+}
+
+/*
+ * Show the traffic through the tuple queues of a Gather or Gather Merge,
+ * and how often the workers waited for the leader to make room in a full
+ * queue, and the leader for the workers to fill an empty one.
+ */
+static void
+show_tuple_queue_info(TupleQueueInstrumentation *worker_instr,
+					  TupleQueueInstrumentation *leader_instr,
+					  ExplainState *es)
+{
+	double		full_ms = INSTR_TIME_GET_MILLISEC(worker_instr->wait_time);
+	double		empty_ms = INSTR_TIME_GET_MILLISEC(leader_instr->wait_time);
+
+	if (worker_instr->nmessages == 0 && leader_instr->nwaits == 0)
+		return;
+
+	if (es->format != EXPLAIN_FORMAT_TEXT)
+	{
+		ExplainPropertyInteger("Queue Tuples", NULL, worker_instr->ntuples, es);
+		ExplainPropertyInteger("Queue Messages", NULL,
+							   worker_instr->nmessages, es);
+		ExplainPropertyInteger("Queue Full Waits", NULL,
+							   worker_instr->nwaits, es);
+		ExplainPropertyInteger("Queue Empty Waits", NULL,
+							   leader_instr->nwaits, es);
+		if (es->timing)
+		{
+			ExplainPropertyFloat("Queue Full Wait Time", "ms", full_ms, 3, es);
+			ExplainPropertyFloat("Queue Empty Wait Time", "ms", empty_ms, 3,
+								 es);
+		}
+	}
+	else
+	{
+		ExplainIndentText(es);
+		appendStringInfo(es->str,
+						 "Tuple Queues: tuples=" INT64_FORMAT " messages=" INT64_FORMAT "\n",
+						 worker_instr->ntuples, worker_instr->nmessages);
+		ExplainIndentText(es);
+		appendStringInfo(es->str, "Queue Waits: full=" INT64_FORMAT,
+						 worker_instr->nwaits);
+		if (es->timing)
+			appendStringInfo(es->str, " (%.3f ms)", full_ms);
+		appendStringInfo(es->str, " empty=" INT64_FORMAT,
+						 leader_instr->nwaits);
+		if (es->timing)
+			appendStringInfo(es->str, " (%.3f ms)", empty_ms);
+		appendStringInfoChar(es->str, '\n');
+	}
+}
+
 /*
  * Show information on hash aggregate memory usage and batches.
  */
@@ -3495,6 +3732,8 @@ show_hashagg_info(AggState *aggstate, ExplainState *es)
 			ExplainPropertyInteger("Peak Memory Usage", "kB", memPeakKb, es);
 			ExplainPropertyInteger("Disk Usage", "kB",
 								   aggstate->hash_disk_used, es);
+			show_temp_compression(aggstate->hash_temp_written,
+								  aggstate->hash_temp_written_compressed, es);
 		}
 	}
 	else
@@ -3530,6 +3769,9 @@ show_hashagg_info(AggState *aggstate, ExplainState *es)
 			{
 				appendStringInfo(es->str, "  Disk Usage: " UINT64_FORMAT "kB",
 								 aggstate->hash_disk_used);
+				show_temp_compression(aggstate->hash_temp_written,
+									  aggstate->hash_temp_written_compressed,
+									  es);
 			}
 		}
 
@@ -3566,8 +3808,13 @@ show_hashagg_info(AggState *aggstate, ExplainState *es)
 
 				/* Only display disk usage if we spilled to disk */
 				if (hash_batches_used > 1)
+				{
 					appendStringInfo(es->str, "  Disk Usage: " UINT64_FORMAT "kB",
 									 hash_disk_used);
+					show_temp_compression(sinstrument->hash_temp_written,
+										  sinstrument->hash_temp_written_compressed,
+										  es);
+				}
 				appendStringInfoChar(es->str, '\n');
 			}
 			else
@@ -3577,6 +3824,9 @@ show_hashagg_info(AggState *aggstate, ExplainState *es)
 				ExplainPropertyInteger("Peak Memory Usage", "kB", memPeakKb,
 									   es);
 				ExplainPropertyInteger("Disk Usage", "kB", hash_disk_used, es);
+				show_temp_compression(sinstrument->hash_temp_written,
+									  sinstrument->hash_temp_written_compressed,
+									  es);
 			}
 
 			if (es->workers_state)
@@ -3585,6 +3835,31 @@ show_hashagg_info(AggState *aggstate, ExplainState *es)
 	}
 }
 
+/*
+ * Show how much data a sort, hash aggregation or hash join wrote to
+ * temporary files, and how much that was after compression.  The sizes are
+ * only tracked for compressed temporary files, so nothing is shown unless
+ * temp_file_compression was in use.  In text format, this is appended to the
+ * current line.
+ */
+static void
+show_temp_compression(int64 writtenKb, int64 compressedKb, ExplainState *es)
+{
+	if (compressedKb <= 0)
+		return;
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+		appendStringInfo(es->str,
+						 "  Temp Written: " INT64_FORMAT "kB  Compressed: " INT64_FORMAT "kB",
+						 writtenKb, compressedKb);
+	else
+	{
+		ExplainPropertyInteger("Temp Written", "kB", writtenKb, es);
+		ExplainPropertyInteger("Temp Written Compressed", "kB", compressedKb,
+							   es);
+	}
+}
+
 /*
  * If it's EXPLAIN ANALYZE, show exact/lossy pages for a BitmapHeapScan node
  */
@@ -3644,6 +3919,34 @@ show_instrumentation_count(const char *qlabel, int which,
 	}
 }
 
+/*
+ * Show the number of outer tuples a HashJoin discarded using its Hash node's
+ * bloom filter, like show_instrumentation_count().
+ */
+static void
+show_bloom_filter_count(HashJoinState *hjstate, ExplainState *es)
+{
+	PlanState  *planstate = &hjstate->js.ps;
+	double		nfiltered = hjstate->hj_BloomFiltered;
+	double		nloops;
+
+	if (!es->analyze || !planstate->instrument)
+		return;
+
+	nloops = planstate->instrument->nloops;
+
+	/* In text mode, suppress zero counts; they're not interesting enough */
+	if (nfiltered > 0 || es->format != EXPLAIN_FORMAT_TEXT)
+	{
+		if (nloops > 0)
+			ExplainPropertyFloat("Rows Removed by Bloom Filter", NULL,
+								 nfiltered / nloops, 0, es);
+		else
+			ExplainPropertyFloat("Rows Removed by Bloom Filter", NULL,
+								 0.0, 0, es);
+	}
+}
+
 /*
  * Show extra information for a ForeignScan node.
  */
@@ -876,6 +876,13 @@ ExecCheck(ExprState *state, ExprContext *econtext)
 static void
 ExecReadyExpr(ExprState *state)
 {
+	/* start out interpreted, and only JIT compile if evaluated often */
+	if (jit_defer_compile_expr(state))
+	{
+		ExecReadyDeferredJitExpr(state);
+		return;
+	}
+
 	if (jit_compile_expr(state))
 		return;
 
@@ -4095,6 +4102,119 @@ ExecBuildGroupingEqual(TupleDesc ldesc, TupleDesc rdesc,
 	return state;
 }
 
+/*
+ * Build an ExprState that computes a combined 32-bit hash value over the
+ * given attributes of the expression context's outer tuple.  The hash of
+ * each column is combined with the previous result in the same way as
+ * execGrouping.c always did, i.e. by rotating the intermediate value left
+ * one bit and XORing in the column's hash value; NULLs hash to zero.
+ * Evaluating the hash this way, rather than by calling the hash functions
+ * in a C loop, allows the hashing to be JIT compiled.
+ *
+ * This is used by tuple hash tables (hashed Agg, SetOp, RecursiveUnion and
+ * hashed SubPlans) and by Repartition.  Memoize and Hash Join hash their
+ * keys with their own code, and sort comparators are never JIT compiled:
+ * tuplesort relies on SortSupport instead.
+ *
+ * desc: tuple descriptor of the to-be-hashed tuples
+ * ops: the slot ops for the to-be-hashed tuples
+ * hashfunctions: FmgrInfos for the hash functions to use, one per column
+ * collations: collations to pass to the hash functions
+ * numCols: the number of attributes to be hashed
+ * keyColIdx: array of attribute column numbers
+ * parent: parent executor node
+ * init_value: initial value to start the hash calculation from
+ */
+ExprState *
+ExecBuildHash32FromAttrs(TupleDesc desc, const TupleTableSlotOps *ops,
+						 FmgrInfo *hashfunctions, Oid *collations,
+						 int numCols, AttrNumber *keyColIdx,
+						 PlanState *parent, uint32 init_value)
+{
+	ExprState  *state = makeNode(ExprState);
+	ExprEvalStep scratch = {0};
+	int			maxatt = -1;
+
+	Assert(numCols > 0);
+
+	state->expr = NULL;
+	state->flags = 0;
+	state->parent = parent;
+
+	/* compute max needed attribute */
+	for (int natt = 0; natt < numCols; natt++)
+	{
+		int			attno = keyColIdx[natt];
+
+		if (attno > maxatt)
+			maxatt = attno;
+	}
+	Assert(maxatt >= 0);
+
+	/* push deform step */
+	scratch.opcode = EEOP_OUTER_FETCHSOME;
+	scratch.d.fetch.last_var = maxatt;
+	scratch.d.fetch.fixed = false;
+	scratch.d.fetch.known_desc = desc;
+	scratch.d.fetch.kind = ops;
+	if (ExecComputeSlotInfo(state, &scratch))
+		ExprEvalPushStep(state, &scratch);
+
+	/* a zero seed doesn't change the result of the first column's hash */
+	if (init_value != 0)
+	{
+		scratch.opcode = EEOP_HASHDATUM_SET_INITVAL;
+		scratch.d.hashdatum_initvalue.init_value = UInt32GetDatum(init_value);
+		scratch.resvalue = &state->resvalue;
+		scratch.resnull = &state->resnull;
+		ExprEvalPushStep(state, &scratch);
+	}
+
+	for (int natt = 0; natt < numCols; natt++)
+	{
+		int			attno = keyColIdx[natt];
+		Form_pg_attribute att = TupleDescAttr(desc, attno - 1);
+		FmgrInfo   *finfo;
+		FunctionCallInfo fcinfo;
+
+		finfo = palloc0(sizeof(FmgrInfo));
+		fcinfo = palloc0(SizeForFunctionCallInfo(1));
+		fmgr_info(hashfunctions[natt].fn_oid, finfo);
+		fmgr_info_set_expr(NULL, finfo);
+		InitFunctionCallInfoData(*fcinfo, finfo, 1,
+								 collations[natt], NULL, NULL);
+
+		/* fetch the column into the hash function's argument */
+		scratch.opcode = EEOP_OUTER_VAR;
+		scratch.d.var.attnum = attno - 1;
+		scratch.d.var.vartype = att->atttypid;
+		scratch.resvalue = &fcinfo->args[0].value;
+		scratch.resnull = &fcinfo->args[0].isnull;
+		ExprEvalPushStep(state, &scratch);
+
+		/* hash it, and combine with the previous columns' hash */
+		if (natt == 0 && init_value == 0)
+			scratch.opcode = EEOP_HASHDATUM_FIRST;
+		else
+			scratch.opcode = EEOP_HASHDATUM_NEXT32;
+		scratch.d.hashdatum.finfo = finfo;
+		scratch.d.hashdatum.fcinfo_data = fcinfo;
+		scratch.d.hashdatum.fn_addr = finfo->fn_addr;
+		scratch.resvalue = &state->resvalue;
+		scratch.resnull = &state->resnull;
+		ExprEvalPushStep(state, &scratch);
+	}
+
+	scratch.resvalue = NULL;
+	scratch.resnull = NULL;
+	scratch.opcode = EEOP_DONE;
+	ExprEvalPushStep(state, &scratch);
+
+	ExecReadyExpr(state);
+
+	return state;
+}
+
 /*
  * Build equality expression that can be evaluated using ExecQual(), returning
  * true if the expression context's inner/outer tuples are equal.  Datums in
@@ -37,6 +37,10 @@
  * ExecReadyInterpretedExpr will choose to implement certain simple
  * opcode patterns using special fast-path routines (ExecJust*).
  *
+ * With deferred JIT compilation (see jit_defer_evaluations), expressions are
+ * first prepared for interpretation, and only handed to the JIT provider
+ * once they have been evaluated often enough to make that pay off.
+ *
  * Complex or uncommon instructions are not implemented in-line in
  * ExecInterpExpr(), rather we call out to a helper function appearing later
  * in this file.  For one reason, there'd not be a noticeable performance
@@ -62,10 +66,12 @@
 #include "executor/execExpr.h"
 #include "executor/nodeSubplan.h"
 #include "funcapi.h"
+#include "jit/jit.h"
 #include "miscadmin.h"
 #include "nodes/miscnodes.h"
 #include "nodes/nodeFuncs.h"
 #include "pgstat.h"
+#include "port/pg_bitutils.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/date.h"
@@ -76,6 +82,7 @@
 #include "utils/jsonpath.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/resowner.h"
 #include "utils/timestamp.h"
 #include "utils/typcache.h"
 #include "utils/xml.h"
@@ -142,6 +149,9 @@ static ExprEvalOpLookup reverse_dispatch_table[EEOP_LAST];
 
 
 static Datum ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull);
+static Datum ExecInterpExprDeferredJit(ExprState *state, ExprContext *econtext,
+									   bool *isnull);
+static void ExecCompileDeferredJitExprs(EState *estate);
 static void ExecInitInterpreter(void);
 
 /* support functions */
@@ -382,6 +392,90 @@ ExecReadyInterpretedExpr(ExprState *state)
 	state->evalfunc_private = (void *) ExecInterpExpr;
 }
 
+/*
+ * Prepare ExprState for interpreted execution, and for JIT compilation once
+ * it has been evaluated jit_defer_evaluations times.
+ *
+ * Expressions handled by the fast-path evalfuncs are left alone, as JIT
+ * compiling them doesn't gain anything.
+ */
+void
+ExecReadyDeferredJitExpr(ExprState *state)
+{
+	EState	   *estate = state->parent->state;
+	MemoryContext oldcontext;
+
+	ExecReadyInterpretedExpr(state);
+
+	if (state->evalfunc_private != (void *) ExecInterpExpr)
+		return;
+
+	state->jit_countdown = jit_defer_evaluations;
+	state->evalfunc_private = (void *) ExecInterpExprDeferredJit;
+
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+	if (estate->es_jit_deferred == NIL)
+		estate->es_jit_owner = CurrentResourceOwner;
+	estate->es_jit_deferred = lappend(estate->es_jit_deferred, state);
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * JIT compile the expressions whose compilation has been deferred, once the
+ * first of them has become hot.
+ *
+ * Compiling each expression on its own would emit a separate module for
+ * each, so all the deferred expressions of the query that have been
+ * evaluated at all so far are compiled together, into the query's JIT
+ * context.  Those that haven't been evaluated yet stay interpreted, and
+ * are considered again when one of them becomes hot in turn.
+ */
+static void
+ExecCompileDeferredJitExprs(EState *estate)
+{
+	MemoryContext oldcontext;
+	ResourceOwner oldowner;
+	List	   *pending = NIL;
+
+	/*
+	 * Memory allocated for the compiled expressions has to live as long as
+	 * the expressions, not just the current tuple.  And the JIT context must
+	 * not go away before the query does, even if we are executing within a
+	 * subtransaction at this point.
+	 */
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+	oldowner = CurrentResourceOwner;
+	CurrentResourceOwner = estate->es_jit_owner;
+
+	PG_TRY();
+	{
+		foreach_ptr(ExprState, state, estate->es_jit_deferred)
+		{
+			if (state->jit_countdown >= jit_defer_evaluations &&
+				state->jit_countdown > 0)
+			{
+				pending = lappend(pending, state);
+				continue;
+			}
+
+			/* in case compilation isn't possible, don't try again */
+			state->evalfunc = ExecInterpExpr;
+			state->evalfunc_private = (void *) ExecInterpExpr;
+			(void) jit_compile_expr(state);
+		}
+	}
+	PG_FINALLY();
+	{
+		CurrentResourceOwner = oldowner;
+	}
+	PG_END_TRY();
+
+	list_free(estate->es_jit_deferred);
+	estate->es_jit_deferred = pending;
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
 
 /*
  * Evaluate expression identified by "state" in the execution context
@@ -427,6 +521,9 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_FUNCEXPR_STRICT,
 		&&CASE_EEOP_FUNCEXPR_FUSAGE,
 		&&CASE_EEOP_FUNCEXPR_STRICT_FUSAGE,
+		&&CASE_EEOP_HASHDATUM_SET_INITVAL,
+		&&CASE_EEOP_HASHDATUM_FIRST,
+		&&CASE_EEOP_HASHDATUM_NEXT32,
 		&&CASE_EEOP_BOOL_AND_STEP_FIRST,
 		&&CASE_EEOP_BOOL_AND_STEP,
 		&&CASE_EEOP_BOOL_AND_STEP_LAST,
@@ -785,6 +882,50 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		EEO_CASE(EEOP_HASHDATUM_SET_INITVAL)
+		{
+			*op->resvalue = op->d.hashdatum_initvalue.init_value;
+			*op->resnull = false;
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_HASHDATUM_FIRST)
+		{
+			FunctionCallInfo fcinfo = op->d.hashdatum.fcinfo_data;
+
+			/* NULL datums hash to zero */
+			if (fcinfo->args[0].isnull)
+				*op->resvalue = (Datum) 0;
+			else
+			{
+				fcinfo->isnull = false;
+				*op->resvalue = UInt32GetDatum(DatumGetUInt32(op->d.hashdatum.fn_addr(fcinfo)));
+			}
+			*op->resnull = false;
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_HASHDATUM_NEXT32)
+		{
+			FunctionCallInfo fcinfo = op->d.hashdatum.fcinfo_data;
+			uint32		hashvalue;
+
+			/* combine successive hash values by rotating */
+			hashvalue = pg_rotate_left32(DatumGetUInt32(*op->resvalue), 1);
+
+			if (!fcinfo->args[0].isnull)
+			{
+				fcinfo->isnull = false;
+				hashvalue ^= DatumGetUInt32(op->d.hashdatum.fn_addr(fcinfo));
+			}
+			*op->resvalue = UInt32GetDatum(hashvalue);
+			*op->resnull = false;
+
+			EEO_NEXT();
+		}
+
 		/*
 		 * If any of its clauses is FALSE, an AND's result is FALSE regardless
 		 * of the states of the rest of the clauses, so we can stop evaluating
@@ -1927,6 +2068,22 @@ ExecInterpExprStillValid(ExprState *state, ExprContext *econtext, bool *isNull)
 	return state->evalfunc(state, econtext, isNull);
 }
 
+/*
+ * Evaluate an expression whose JIT compilation has been deferred, and
+ * compile it once the countdown set up by ExecReadyDeferredJitExpr() ends.
+ */
+static Datum
+ExecInterpExprDeferredJit(ExprState *state, ExprContext *econtext, bool *isNull)
+{
+	if (--state->jit_countdown <= 0)
+	{
+		ExecCompileDeferredJitExprs(state->parent->state);
+		return state->evalfunc(state, econtext, isNull);
+	}
+
+	return ExecInterpExpr(state, econtext, isNull);
+}
+
 /*
  * Check that an expression is still valid in the face of potential schema
  * changes since the plan has been created.
@@ -41,6 +41,7 @@ static inline TupleHashEntry LookupTupleHashEntry_internal(TupleHashTable hashta
 #define SH_SCOPE extern
 #define SH_STORE_HASH
 #define SH_GET_HASH(tb, a) a->hash
+#define SH_USE_TAGS
 #define SH_DEFINE
 #include "lib/simplehash.h"
 
@@ -230,6 +231,18 @@ BuildTupleHashTableExt(PlanState *parent,
 													keyColIdx, eqfuncoids, collations,
 													allow_jit ? parent : NULL);
 
+	/* build expression computing the hash value for all columns */
+	if (numCols > 0)
+		hashtable->tab_hash_expr = ExecBuildHash32FromAttrs(inputDesc, NULL,
+															hashfunctions,
+															collations,
+															numCols,
+															keyColIdx,
+															allow_jit ? parent : NULL,
+															hashtable->hash_iv);
+	else
+		hashtable->tab_hash_expr = NULL;
+
 	/*
 	 * While not pretty, it's ok to not shut down this context, but instead
 	 * rely on the containing memory context being reset, as
@@ -437,6 +450,24 @@ TupleHashTableHash_internal(struct tuplehash_hash *tb,
 		/* Process the current input tuple for the table */
 		slot = hashtable->inputslot;
 		hashfunctions = hashtable->in_hash_funcs;
+
+		/*
+		 * If the input is hashed with the table's own hash functions, use the
+		 * precomputed (and possibly JIT compiled) hash expression.
+		 */
+		if (hashfunctions == hashtable->tab_hash_funcs &&
+			hashtable->tab_hash_expr != NULL)
+		{
+			ExprContext *econtext = hashtable->exprcontext;
+			bool		isnull;
+
+			econtext->ecxt_outertuple = slot;
+			hashkey = DatumGetUInt32(ExecEvalExpr(hashtable->tab_hash_expr,
+												  econtext, &isnull));
+			Assert(!isnull);
+
+			return murmurhash32(hashkey);
+		}
 	}
 	else
 	{
@@ -7,7 +7,8 @@
  * ExecInsertIndexTuples() is the main entry point.  It's called after
  * inserting a tuple to the heap, and it inserts corresponding index tuples
  * into all indexes.  At the same time, it enforces any unique and
- * exclusion constraints:
+ * exclusion constraints.  ExecInsertIndexTuplesBatch() does the same for a
+ * batch of newly-inserted tuples, see below:
  *
  * Unique Indexes
  * --------------
@@ -107,14 +108,18 @@
 #include "postgres.h"
 
 #include "access/genam.h"
+#include "access/nbtree.h"
 #include "access/relscan.h"
 #include "access/tableam.h"
 #include "access/xact.h"
 #include "catalog/index.h"
+#include "catalog/pg_am_d.h"
+#include "common/int.h"
 #include "executor/executor.h"
 #include "nodes/nodeFuncs.h"
 #include "storage/lmgr.h"
 #include "utils/snapmgr.h"
+#include "utils/sortsupport.h"
 
 /* waitMode argument to check_exclusion_or_unique_constraint() */
 typedef enum
@@ -142,6 +147,17 @@ static bool index_unchanged_by_update(ResultRelInfo *resultRelInfo,
 static bool index_expression_changed_walker(Node *node,
 											Bitmapset *allUpdatedCols);
 
+/* State for sorting a batch of index entries; see index_batch_cmp() */
+typedef struct IndexBatchSortState
+{
+	SortSupport ssup;			/* one per key column */
+	int			nkeys;
+	Datum	   *values;			/* values of slot i start at i * INDEX_MAX_KEYS */
+	bool	   *isnull;
+} IndexBatchSortState;
+
+static int	index_batch_cmp(const void *a, const void *b, void *arg);
+
 /* ----------------------------------------------------------------
  *		ExecOpenIndices
  *
@@ -506,6 +522,295 @@ ExecInsertIndexTuples(ResultRelInfo *resultRelInfo,
 	return result;
 }
 
+/* ----------------------------------------------------------------
+ *		ExecInsertIndexTuplesBatch
+ *
+ *		This routine inserts index tuples for a batch of tuples that
+ *		were just inserted into the heap, as if ExecInsertIndexTuples()
+ *		were called for each of them (not as part of an UPDATE and not
+ *		for a speculative insertion).
+ *
+ *		Unique indexes are handled first, tuple by tuple in heap order,
+ *		so that if the batch violates unique constraints, the one
+ *		reported is the same as with ExecInsertIndexTuples().  The other
+ *		indexes are then processed one index at a time, and the entries
+ *		for a btree index are inserted in index key order.  Within a
+ *		batch, entries landing on the same leaf page are then added one
+ *		after another.  (An error raised while inserting into a
+ *		non-unique index, such as an over-long key, may therefore be
+ *		reported for a later tuple than with ExecInsertIndexTuples(), or
+ *		instead of a unique violation by a later tuple.)
+ *
+ *		Deferred unique constraints and exclusion constraints require
+ *		per-tuple rechecks, so if the relation has any, nothing is done
+ *		and false is returned; the caller must then fall back to
+ *		ExecInsertIndexTuples().  Otherwise returns true, and there is
+ *		never anything to recheck.
+ *
+ *		If rownos isn't NULL, *currowno is set to rownos[i] before doing
+ *		any work for slots[i], so that the caller can report which row
+ *		an error occurred for.
+ * ----------------------------------------------------------------
+ */
+bool
+ExecInsertIndexTuplesBatch(ResultRelInfo *resultRelInfo,
+						   TupleTableSlot **slots, int nslots,
+						   EState *estate,
+						   const uint64 *rownos, uint64 *currowno)
+{
+	int			i;
+	int			numIndices;
+	RelationPtr relationDescs;
+	Relation	heapRelation;
+	IndexInfo **indexInfoArray;
+	ExprContext *econtext;
+	MemoryContext oldcontext;
+	Datum	   *values;
+	bool	   *isnull;
+	int		   *order;
+
+	numIndices = resultRelInfo->ri_NumIndices;
+	relationDescs = resultRelInfo->ri_IndexRelationDescs;
+	indexInfoArray = resultRelInfo->ri_IndexRelationInfo;
+	heapRelation = resultRelInfo->ri_RelationDesc;
+
+	/* Check that no index needs per-tuple rechecks */
+	for (i = 0; i < numIndices; i++)
+	{
+		Relation	indexRelation = relationDescs[i];
+
+		if (indexRelation == NULL || !indexInfoArray[i]->ii_ReadyForInserts)
+			continue;
+		if (indexInfoArray[i]->ii_ExclusionOps != NULL ||
+			(indexRelation->rd_index->indisunique &&
+			 !indexRelation->rd_index->indimmediate))
+			return false;
+	}
+
+	/*
+	 * We will use the EState's per-tuple context for evaluating predicates
+	 * and index expressions, and for the batch's workspace.  The caller must
+	 * not reset it until we're done, since the index values of all the slots
+	 * are kept until they've been inserted.
+	 */
+	econtext = GetPerTupleExprContext(estate);
+	oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	values = palloc(sizeof(Datum) * INDEX_MAX_KEYS * nslots);
+	isnull = palloc(sizeof(bool) * INDEX_MAX_KEYS * nslots);
+	order = palloc(sizeof(int) * nslots);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/*
+	 * Insert into the unique indexes tuple by tuple, in heap order.  For an
+	 * immediate-mode unique index, we just tell the index AM to throw error
+	 * if not unique, as in ExecInsertIndexTuples().
+	 */
+	for (int j = 0; j < nslots; j++)
+	{
+		TupleTableSlot *slot = slots[j];
+
+		Assert(ItemPointerIsValid(&slot->tts_tid));
+		Assert(slot->tts_tableOid == RelationGetRelid(heapRelation));
+
+		if (rownos)
+			*currowno = rownos[j];
+
+		econtext->ecxt_scantuple = slot;
+
+		for (i = 0; i < numIndices; i++)
+		{
+			Relation	indexRelation = relationDescs[i];
+			IndexInfo  *indexInfo;
+
+			if (indexRelation == NULL ||
+				!indexRelation->rd_index->indisunique)
+				continue;
+
+			indexInfo = indexInfoArray[i];
+
+			/* If the index is marked as read-only, ignore it */
+			if (!indexInfo->ii_ReadyForInserts)
+				continue;
+
+			/* Check for partial index */
+			if (indexInfo->ii_Predicate != NIL)
+			{
+				ExprState  *predicate = indexInfo->ii_PredicateState;
+
+				/* If predicate state not set up yet, create it */
+				if (predicate == NULL)
+				{
+					predicate = ExecPrepareQual(indexInfo->ii_Predicate, estate);
+					indexInfo->ii_PredicateState = predicate;
+				}
+
+				/* Skip this index-update if the predicate isn't satisfied */
+				if (!ExecQual(predicate, econtext))
+					continue;
+			}
+
+			FormIndexDatum(indexInfo, slot, estate, values, isnull);
+
+			(void) index_insert(indexRelation,
+								values,
+								isnull,
+								&slot->tts_tid,
+								heapRelation,
+								UNIQUE_CHECK_YES,
+								false,
+								indexInfo);
+		}
+	}
+
+	/* Then the other indexes, one at a time */
+	for (i = 0; i < numIndices; i++)
+	{
+		Relation	indexRelation = relationDescs[i];
+		IndexInfo  *indexInfo;
+		ExprState  *predicate = NULL;
+		int			ninsert = 0;
+		int			j;
+
+		if (indexRelation == NULL || indexRelation->rd_index->indisunique)
+			continue;
+
+		indexInfo = indexInfoArray[i];
+
+		/* If the index is marked as read-only, ignore it */
+		if (!indexInfo->ii_ReadyForInserts)
+			continue;
+
+		/* If predicate state not set up yet, create it */
+		if (indexInfo->ii_Predicate != NIL)
+		{
+			predicate = indexInfo->ii_PredicateState;
+			if (predicate == NULL)
+			{
+				predicate = ExecPrepareQual(indexInfo->ii_Predicate, estate);
+				indexInfo->ii_PredicateState = predicate;
+			}
+		}
+
+		/* Form the index values of all slots that are to be inserted */
+		for (j = 0; j < nslots; j++)
+		{
+			TupleTableSlot *slot = slots[j];
+
+			Assert(ItemPointerIsValid(&slot->tts_tid));
+			Assert(slot->tts_tableOid == RelationGetRelid(heapRelation));
+
+			if (rownos)
+				*currowno = rownos[j];
+
+			econtext->ecxt_scantuple = slot;
+
+			/* Skip this index-update if the predicate isn't satisfied */
+			if (predicate != NULL && !ExecQual(predicate, econtext))
+				continue;
+
+			FormIndexDatum(indexInfo,
+						   slot,
+						   estate,
+						   &values[j * INDEX_MAX_KEYS],
+						   &isnull[j * INDEX_MAX_KEYS]);
+			order[ninsert++] = j;
+		}
+
+		/*
+		 * Sort btree entries by key.  Other index AMs get the entries in the
+		 * order of the slots.
+		 */
+		if (indexRelation->rd_rel->relam == BTREE_AM_OID && ninsert > 1)
+		{
+			IndexBatchSortState sortstate;
+			int			nkeys = IndexRelationGetNumberOfKeyAttributes(indexRelation);
+
+			oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+			sortstate.ssup = palloc0(sizeof(SortSupportData) * nkeys);
+			sortstate.nkeys = nkeys;
+			sortstate.values = values;
+			sortstate.isnull = isnull;
+
+			for (j = 0; j < nkeys; j++)
+			{
+				SortSupport sortKey = &sortstate.ssup[j];
+				int16		indoption = indexRelation->rd_indoption[j];
+
+				sortKey->ssup_cxt = CurrentMemoryContext;
+				sortKey->ssup_collation = indexRelation->rd_indcollation[j];
+				sortKey->ssup_nulls_first =
+					(indoption & INDOPTION_NULLS_FIRST) != 0;
+				sortKey->ssup_attno = j + 1;
+				sortKey->abbreviate = false;
+
+				PrepareSortSupportFromIndexRel(indexRelation,
+											   (indoption & INDOPTION_DESC) != 0 ?
+											   BTGreaterStrategyNumber :
+											   BTLessStrategyNumber,
+											   sortKey);
+			}
+
+			qsort_arg(order, ninsert, sizeof(int), index_batch_cmp, &sortstate);
+
+			MemoryContextSwitchTo(oldcontext);
+		}
+
+		for (j = 0; j < ninsert; j++)
+		{
+			int			slotno = order[j];
+
+			if (rownos)
+				*currowno = rownos[slotno];
+
+			(void) index_insert(indexRelation,
+								&values[slotno * INDEX_MAX_KEYS],
+								&isnull[slotno * INDEX_MAX_KEYS],
+								&slots[slotno]->tts_tid,
+								heapRelation,
+								UNIQUE_CHECK_NO,
+								false,
+								indexInfo);
+		}
+	}
+
+	return true;
+}
+
+/*
+ * qsort_arg comparator for ExecInsertIndexTuplesBatch()
+ *
+ * Ties are broken by slot number, so that equal keys are inserted in the
+ * order the tuples were added to the heap.
+ */
+static int
+index_batch_cmp(const void *a, const void *b, void *arg)
+{
+	IndexBatchSortState *state = (IndexBatchSortState *) arg;
+	int			slota = *(const int *) a;
+	int			slotb = *(const int *) b;
+	int			k;
+
+	for (k = 0; k < state->nkeys; k++)
+	{
+		int			off_a = slota * INDEX_MAX_KEYS + k;
+		int			off_b = slotb * INDEX_MAX_KEYS + k;
+		int			compare;
+
+		compare = ApplySortComparator(state->values[off_a],
+									  state->isnull[off_a],
+									  state->values[off_b],
+									  state->isnull[off_b],
+									  &state->ssup[k]);
+		if (compare != 0)
+			return compare;
+	}
+
+	return pg_cmp_s32(slota, slotb);
+}
+
 /* ----------------------------------------------------------------
  *		ExecCheckIndexConstraints
  *
@@ -36,6 +36,7 @@
 #include "executor/nodeIndexonlyscan.h"
 #include "executor/nodeIndexscan.h"
 #include "executor/nodeMemoize.h"
+#include "executor/nodeRepartition.h"
 #include "executor/nodeSeqscan.h"
 #include "executor/nodeSort.h"
 #include "executor/nodeSubplan.h"
@@ -64,6 +65,7 @@
 #define PARALLEL_KEY_QUERY_TEXT		UINT64CONST(0xE000000000000008)
 #define PARALLEL_KEY_JIT_INSTRUMENTATION UINT64CONST(0xE000000000000009)
 #define PARALLEL_KEY_WAL_USAGE			UINT64CONST(0xE00000000000000A)
+#define PARALLEL_KEY_TUPLE_QUEUE_INSTRUMENTATION UINT64CONST(0xE00000000000000B)
 
 #define PARALLEL_TUPLE_QUEUE_SIZE		65536
 
@@ -276,6 +278,11 @@ ExecParallelEstimate(PlanState *planstate, ExecParallelEstimateContext *e)
 				ExecHashJoinEstimate((HashJoinState *) planstate,
 									 e->pcxt);
 			break;
+		case T_RepartitionState:
+			if (planstate->plan->parallel_aware)
+				ExecRepartitionEstimate((RepartitionState *) planstate,
+										e->pcxt);
+			break;
 		case T_HashState:
 			/* even when not parallel-aware, for EXPLAIN ANALYZE */
 			ExecHashEstimate((HashState *) planstate, e->pcxt);
@@ -293,7 +300,7 @@ ExecParallelEstimate(PlanState *planstate, ExecParallelEstimateContext *e)
 			ExecAggEstimate((AggState *) planstate, e->pcxt);
 			break;
 		case T_MemoizeState:
-			/* even when not parallel-aware, for EXPLAIN ANALYZE */
+			/* even when not parallel-aware, for EXPLAIN ANALYZE and sharing */
 			ExecMemoizeEstimate((MemoizeState *) planstate, e->pcxt);
 			break;
 		default:
@@ -500,6 +507,11 @@ ExecParallelInitializeDSM(PlanState *planstate,
 				ExecHashJoinInitializeDSM((HashJoinState *) planstate,
 										  d->pcxt);
 			break;
+		case T_RepartitionState:
+			if (planstate->plan->parallel_aware)
+				ExecRepartitionInitializeDSM((RepartitionState *) planstate,
+											 d->pcxt);
+			break;
 		case T_HashState:
 			/* even when not parallel-aware, for EXPLAIN ANALYZE */
 			ExecHashInitializeDSM((HashState *) planstate, d->pcxt);
@@ -517,7 +529,7 @@ ExecParallelInitializeDSM(PlanState *planstate,
 			ExecAggInitializeDSM((AggState *) planstate, d->pcxt);
 			break;
 		case T_MemoizeState:
-			/* even when not parallel-aware, for EXPLAIN ANALYZE */
+			/* even when not parallel-aware, for EXPLAIN ANALYZE and sharing */
 			ExecMemoizeInitializeDSM((MemoizeState *) planstate, d->pcxt);
 			break;
 		default:
@@ -600,6 +612,7 @@ ExecInitParallelPlan(PlanState *planstate, EState *estate,
 	WalUsage   *walusage_space;
 	SharedExecutorInstrumentation *instrumentation = NULL;
 	SharedJitInstrumentation *jit_instrumentation = NULL;
+	TupleQueueInstrumentation *tqueue_instrumentation = NULL;
 	int			pstmt_len;
 	int			paramlistinfo_len;
 	int			instrumentation_len = 0;
@@ -714,6 +727,12 @@ ExecInitParallelPlan(PlanState *planstate, EState *estate,
 			shm_toc_estimate_chunk(&pcxt->estimator, jit_instrumentation_len);
 			shm_toc_estimate_keys(&pcxt->estimator, 1);
 		}
+
+		/* Estimate space for tuple queue instrumentation. */
+		shm_toc_estimate_chunk(&pcxt->estimator,
+							   mul_size(sizeof(TupleQueueInstrumentation),
+										pcxt->nworkers));
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
 	}
 
 	/* Estimate space for DSA area. */
@@ -812,6 +831,16 @@ ExecInitParallelPlan(PlanState *planstate, EState *estate,
 						   jit_instrumentation);
 			pei->jit_instrumentation = jit_instrumentation;
 		}
+
+		tqueue_instrumentation =
+			shm_toc_allocate(pcxt->toc,
+							 mul_size(sizeof(TupleQueueInstrumentation),
+									  pcxt->nworkers));
+		memset(tqueue_instrumentation, 0,
+			   sizeof(TupleQueueInstrumentation) * pcxt->nworkers);
+		shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLE_QUEUE_INSTRUMENTATION,
+					   tqueue_instrumentation);
+		pei->tqueue_instrumentation = tqueue_instrumentation;
 	}
 
 	/*
@@ -923,6 +952,11 @@ ExecParallelReinitialize(PlanState *planstate,
 	pei->reader = NULL;
 	pei->finished = false;
 
+	/* The last batch of workers' queue statistics were collected already. */
+	if (pei->tqueue_instrumentation != NULL)
+		memset(pei->tqueue_instrumentation, 0,
+			   sizeof(TupleQueueInstrumentation) * pei->pcxt->nworkers);
+
 	fpes = shm_toc_lookup(pei->pcxt->toc, PARALLEL_KEY_EXECUTOR_FIXED, false);
 
 	/* Free any serialized parameters from the last round. */
@@ -1000,10 +1034,18 @@ ExecParallelReInitializeDSM(PlanState *planstate,
 				ExecHashJoinReInitializeDSM((HashJoinState *) planstate,
 											pcxt);
 			break;
+		case T_RepartitionState:
+			if (planstate->plan->parallel_aware)
+				ExecRepartitionReInitializeDSM((RepartitionState *) planstate,
+											   pcxt);
+			break;
+		case T_MemoizeState:
+			/* even when not parallel-aware, for the shared cache */
+			ExecMemoizeReInitializeDSM((MemoizeState *) planstate, pcxt);
+			break;
 		case T_HashState:
 		case T_SortState:
 		case T_IncrementalSortState:
-		case T_MemoizeState:
 			/* these nodes have DSM state, but no reinitialization is required */
 			break;
 
@@ -1125,7 +1167,7 @@ ExecParallelRetrieveJitInstrumentation(PlanState *planstate,
 
 /*
  * Finish parallel execution.  We wait for parallel workers to finish, and
- * accumulate their buffer/WAL usage.
+ * accumulate their buffer/WAL usage and tuple queue statistics.
  */
 void
 ExecParallelFinish(ParallelExecutorInfo *pei)
@@ -1171,6 +1213,13 @@ ExecParallelFinish(ParallelExecutorInfo *pei)
 	for (i = 0; i < nworkers; i++)
 		InstrAccumParallelQuery(&pei->buffer_usage[i], &pei->wal_usage[i]);
 
+	if (pei->tqueue_instrumentation != NULL)
+	{
+		for (i = 0; i < nworkers; i++)
+			TupleQueueInstrAdd(&pei->tqueue_totals,
+							   &pei->tqueue_instrumentation[i]);
+	}
+
 	pei->finished = true;
 }
 
@@ -1221,12 +1270,19 @@ ExecParallelGetReceiver(dsm_segment *seg, shm_toc *toc)
 {
 	char	   *mqspace;
 	shm_mq	   *mq;
+	TupleQueueInstrumentation *instr;
 
 	mqspace = shm_toc_lookup(toc, PARALLEL_KEY_TUPLE_QUEUE, false);
 	mqspace += ParallelWorkerNumber * PARALLEL_TUPLE_QUEUE_SIZE;
 	mq = (shm_mq *) mqspace;
 	shm_mq_set_sender(mq, MyProc);
-	return CreateTupleQueueDestReceiver(shm_mq_attach(mq, seg, NULL));
+
+	/* Statistics are only collected for EXPLAIN ANALYZE */
+	instr = shm_toc_lookup(toc, PARALLEL_KEY_TUPLE_QUEUE_INSTRUMENTATION, true);
+	if (instr != NULL)
+		instr += ParallelWorkerNumber;
+
+	return CreateTupleQueueDestReceiver(shm_mq_attach(mq, seg, NULL), instr);
 }
 
 /*
@@ -1351,6 +1407,11 @@ ExecParallelInitializeWorker(PlanState *planstate, ParallelWorkerContext *pwcxt)
 				ExecHashJoinInitializeWorker((HashJoinState *) planstate,
 											 pwcxt);
 			break;
+		case T_RepartitionState:
+			if (planstate->plan->parallel_aware)
+				ExecRepartitionInitializeWorker((RepartitionState *) planstate,
+												pwcxt);
+			break;
 		case T_HashState:
 			/* even when not parallel-aware, for EXPLAIN ANALYZE */
 			ExecHashInitializeWorker((HashState *) planstate, pwcxt);
@@ -1369,7 +1430,7 @@ ExecParallelInitializeWorker(PlanState *planstate, ParallelWorkerContext *pwcxt)
 			ExecAggInitializeWorker((AggState *) planstate, pwcxt);
 			break;
 		case T_MemoizeState:
-			/* even when not parallel-aware, for EXPLAIN ANALYZE */
+			/* even when not parallel-aware, for EXPLAIN ANALYZE and sharing */
 			ExecMemoizeInitializeWorker((MemoizeState *) planstate, pwcxt);
 			break;
 		default:
@@ -102,6 +102,7 @@
 #include "executor/nodeNestloop.h"
 #include "executor/nodeProjectSet.h"
 #include "executor/nodeRecursiveunion.h"
+#include "executor/nodeRepartition.h"
 #include "executor/nodeResult.h"
 #include "executor/nodeSamplescan.h"
 #include "executor/nodeSeqscan.h"
@@ -332,6 +333,11 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 												   eflags);
 			break;
 
+		case T_Repartition:
+			result = (PlanState *) ExecInitRepartition((Repartition *) node,
+													   estate, eflags);
+			break;
+
 		case T_Group:
 			result = (PlanState *) ExecInitGroup((Group *) node,
 												 estate, eflags);
@@ -713,6 +719,10 @@ ExecEndNode(PlanState *node)
 			ExecEndMemoize((MemoizeState *) node);
 			break;
 
+		case T_RepartitionState:
+			ExecEndRepartition((RepartitionState *) node);
+			break;
+
 		case T_GroupState:
 			ExecEndGroup((GroupState *) node);
 			break;
@@ -812,6 +822,12 @@ ExecShutdownNode_walker(PlanState *node, void *context)
 		case T_HashJoinState:
 			ExecShutdownHashJoin((HashJoinState *) node);
 			break;
+		case T_MemoizeState:
+			ExecShutdownMemoize((MemoizeState *) node);
+			break;
+		case T_RepartitionState:
+			ExecShutdownRepartition((RepartitionState *) node);
+			break;
 		default:
 			break;
 	}
@@ -161,6 +161,8 @@ CreateExecutorState(void)
 
 	estate->es_jit_flags = 0;
 	estate->es_jit = NULL;
+	estate->es_jit_deferred = NIL;
+	estate->es_jit_owner = NULL;
 
 	/*
 	 * Return the executor state structure
@@ -289,3 +289,14 @@ WalUsageAccumDiff(WalUsage *dst, const WalUsage *add, const WalUsage *sub)
 	dst->wal_records += add->wal_records - sub->wal_records;
 	dst->wal_fpi += add->wal_fpi - sub->wal_fpi;
 }
+
+/* add the statistics of one tuple queue to another */
+void
+TupleQueueInstrAdd(TupleQueueInstrumentation *dst,
+				   const TupleQueueInstrumentation *add)
+{
+	dst->ntuples += add->ntuples;
+	dst->nmessages += add->nmessages;
+	dst->nwaits += add->nwaits;
+	INSTR_TIME_ADD(dst->wait_time, add->wait_time);
+}
@@ -405,12 +405,6 @@ static void build_hash_tables(AggState *aggstate);
 static void build_hash_table(AggState *aggstate, int setno, long nbuckets);
 static void hashagg_recompile_expressions(AggState *aggstate, bool minslot,
 										  bool nullcheck);
-static long hash_choose_num_buckets(double hashentrysize,
-									long ngroups, Size memory);
-static int	hash_choose_num_partitions(double input_groups,
-									   double hashentrysize,
-									   int used_bits,
-									   int *log2_npartitions);
 static void initialize_hash_entry(AggState *aggstate,
 								  TupleHashTable hashtable,
 								  TupleHashEntry entry);
@@ -1945,9 +1939,19 @@ hash_agg_update_metrics(AggState *aggstate, bool from_tape, int npartitions)
 	if (aggstate->hash_tapeset != NULL)
 	{
 		uint64		disk_used = LogicalTapeSetBlocks(aggstate->hash_tapeset) * (BLCKSZ / 1024);
+		int64		rawBytes;
+		int64		storedBytes;
 
 		if (aggstate->hash_disk_used < disk_used)
 			aggstate->hash_disk_used = disk_used;
+
+		LogicalTapeSetCompressionStats(aggstate->hash_tapeset,
+									   &rawBytes, &storedBytes);
+		if (aggstate->hash_temp_written < rawBytes / 1024)
+		{
+			aggstate->hash_temp_written = rawBytes / 1024;
+			aggstate->hash_temp_written_compressed = storedBytes / 1024;
+		}
 	}
 
 	/* update hashentrysize estimate based on contents */
@@ -1962,7 +1966,7 @@ hash_agg_update_metrics(AggState *aggstate, bool from_tape, int npartitions)
 /*
  * Choose a reasonable number of buckets for the initial hash table size.
  */
-static long
+long
 hash_choose_num_buckets(double hashentrysize, long ngroups, Size memory)
 {
 	long		max_nbuckets;
@@ -1987,7 +1991,7 @@ hash_choose_num_buckets(double hashentrysize, long ngroups, Size memory)
  * always be a power of two. If log2_npartitions is non-NULL, set
  * *log2_npartitions to the log2() of the number of partitions.
  */
-static int
+int
 hash_choose_num_partitions(double input_groups, double hashentrysize,
 						   int used_bits, int *log2_npartitions)
 {
@@ -4321,6 +4325,8 @@ ExecEndAgg(AggState *node)
 		si = &node->shared_info->sinstrument[ParallelWorkerNumber];
 		si->hash_batches_used = node->hash_batches_used;
 		si->hash_disk_used = node->hash_disk_used;
+		si->hash_temp_written = node->hash_temp_written;
+		si->hash_temp_written_compressed = node->hash_temp_written_compressed;
 		si->hash_mem_peak = node->hash_mem_peak;
 	}
 
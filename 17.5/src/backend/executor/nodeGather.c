@@ -202,9 +202,15 @@ ExecGather(PlanState *pstate)
 			node->nextreader = 0;
 		}
 
-		/* Run plan locally if no workers or enabled and not single-copy. */
+		/*
+		 * Run plan locally if no workers, or if enabled, not single-copy, and
+		 * there are few enough workers that reading their tuples won't keep
+		 * the leader busy.
+		 */
 		node->need_to_scan_locally = (node->nreaders == 0)
-			|| (!gather->single_copy && parallel_leader_participation);
+			|| (!gather->single_copy && parallel_leader_participation &&
+				(parallel_leader_max_workers < 0 ||
+				 node->nreaders <= parallel_leader_max_workers));
 		node->initialized = true;
 	}
 
@@ -375,8 +381,23 @@ gather_readnext(GatherState *gatherstate)
 				return NULL;
 
 			/* Nothing to do except wait for developments. */
-			(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, 0,
-							 WAIT_EVENT_EXECUTE_GATHER);
+			if (gatherstate->ps.instrument != NULL)
+			{
+				instr_time	start_time;
+				instr_time	end_time;
+
+				INSTR_TIME_SET_CURRENT(start_time);
+				(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, 0,
+								 WAIT_EVENT_EXECUTE_GATHER);
+				INSTR_TIME_SET_CURRENT(end_time);
+
+				gatherstate->leader_queue_instr.nwaits++;
+				INSTR_TIME_ACCUM_DIFF(gatherstate->leader_queue_instr.wait_time,
+									  end_time, start_time);
+			}
+			else
+				(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, 0,
+								 WAIT_EVENT_EXECUTE_GATHER);
 			ResetLatch(MyLatch);
 			nvisited = 0;
 		}
@@ -412,9 +433,10 @@ ExecShutdownGather(GatherState *node)
 {
 	ExecShutdownGatherWorkers(node);
 
-	/* Now destroy the parallel context. */
+	/* Now destroy the parallel context, keeping the queue statistics. */
 	if (node->pei != NULL)
 	{
+		TupleQueueInstrAdd(&node->worker_queue_instr, &node->pei->tqueue_totals);
 		ExecParallelCleanup(node->pei);
 		node->pei = NULL;
 	}
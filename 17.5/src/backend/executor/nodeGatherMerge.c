@@ -242,8 +242,14 @@ ExecGatherMerge(PlanState *pstate)
 			}
 		}
 
-		/* allow leader to participate if enabled or no choice */
-		if (parallel_leader_participation || node->nreaders == 0)
+		/*
+		 * allow leader to participate if enabled and there are few enough
+		 * workers, or no choice
+		 */
+		if ((parallel_leader_participation &&
+			 (parallel_leader_max_workers < 0 ||
+			  node->nreaders <= parallel_leader_max_workers)) ||
+			node->nreaders == 0)
 			node->need_to_scan_locally = true;
 		node->initialized = true;
 	}
@@ -298,9 +304,10 @@ ExecShutdownGatherMerge(GatherMergeState *node)
 {
 	ExecShutdownGatherMergeWorkers(node);
 
-	/* Now destroy the parallel context. */
+	/* Now destroy the parallel context, keeping the queue statistics. */
 	if (node->pei != NULL)
 	{
+		TupleQueueInstrAdd(&node->worker_queue_instr, &node->pei->tqueue_totals);
 		ExecParallelCleanup(node->pei);
 		node->pei = NULL;
 	}
@@ -722,7 +729,26 @@ gm_readnext_tuple(GatherMergeState *gm_state, int nreader, bool nowait,
 	 * there.
 	 */
 	reader = gm_state->reader[nreader - 1];
-	tup = TupleQueueReaderNext(reader, nowait, done);
+	if (nowait || gm_state->ps.instrument == NULL)
+		tup = TupleQueueReaderNext(reader, nowait, done);
+	else
+	{
+		/* We're collecting statistics, so time any wait for the worker. */
+		tup = TupleQueueReaderNext(reader, true, done);
+		if (tup == NULL && !*done)
+		{
+			instr_time	start_time;
+			instr_time	end_time;
+
+			INSTR_TIME_SET_CURRENT(start_time);
+			tup = TupleQueueReaderNext(reader, false, done);
+			INSTR_TIME_SET_CURRENT(end_time);
+
+			gm_state->leader_queue_instr.nwaits++;
+			INSTR_TIME_ACCUM_DIFF(gm_state->leader_queue_instr.wait_time,
+								  end_time, start_time);
+		}
+	}
 
 	/*
 	 * Since we'll be buffering these across multiple calls, we need to make a
@@ -34,9 +34,12 @@
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
+#include "lib/bloomfilter.h"
 #include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
 #include "port/atomics.h"
 #include "port/pg_bitutils.h"
+#include "utils/datum.h"
 #include "utils/dynahash.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -45,6 +48,7 @@
 
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
 static void ExecHashIncreaseNumBuckets(HashJoinTable hashtable);
+static void ExecHashSetBucketTagShift(HashJoinTable hashtable);
 static void ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable);
 static void ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable);
 static void ExecHashBuildSkewHash(HashJoinTable hashtable, Hash *node,
@@ -60,6 +64,7 @@ static HashJoinTuple ExecParallelHashTupleAlloc(HashJoinTable hashtable,
 												size_t size,
 												dsa_pointer *shared);
 static void MultiExecPrivateHash(HashState *node);
+static void ExecHashFilterAddValue(HashState *node, ExprContext *econtext);
 static void MultiExecParallelHash(HashState *node);
 static inline HashJoinTuple ExecParallelHashFirstTuple(HashJoinTable hashtable,
 													   int bucketno);
@@ -156,6 +161,23 @@ MultiExecPrivateHash(HashState *node)
 	hashkeys = node->hashkeys;
 	econtext = node->ps.ps_ExprContext;
 
+	node->filterHasValues = false;
+
+	/*
+	 * If asked to, summarize the inner hash values in a bloom filter.  It
+	 * goes in hashCxt, so that it goes away with the hash table.  Like the
+	 * skew table's bookkeeping, it isn't counted against hash_mem.
+	 */
+	node->filterBloom = NULL;
+	if (((Hash *) node->ps.plan)->filterBloom)
+	{
+		MemoryContext oldcxt = MemoryContextSwitchTo(hashtable->hashCxt);
+
+		node->filterBloom = bloom_create((int64) Max(node->ps.plan->plan_rows, 1.0),
+										 work_mem, 0);
+		MemoryContextSwitchTo(oldcxt);
+	}
+
 	/*
 	 * Get all tuples from the node below the Hash node and insert into the
 	 * hash table (or temp files).
@@ -173,6 +195,13 @@ MultiExecPrivateHash(HashState *node)
 		{
 			int			bucketNumber;
 
+			if (node->filterKey)
+				ExecHashFilterAddValue(node, econtext);
+			if (node->filterBloom)
+				bloom_add_element(node->filterBloom,
+								  (unsigned char *) &hashvalue,
+								  sizeof(hashvalue));
+
 			bucketNumber = ExecHashGetSkewBucket(hashtable, hashvalue);
 			if (bucketNumber != INVALID_SKEW_BUCKET_NO)
 			{
@@ -195,7 +224,7 @@ MultiExecPrivateHash(HashState *node)
 		ExecHashIncreaseNumBuckets(hashtable);
 
 	/* Account for the buckets in spaceUsed (reported in EXPLAIN ANALYZE) */
-	hashtable->spaceUsed += hashtable->nbuckets * sizeof(HashJoinTuple);
+	hashtable->spaceUsed += hashtable->nbuckets * HJ_PRIVATE_BUCKET_SIZE;
 	if (hashtable->spaceUsed > hashtable->spacePeak)
 		hashtable->spacePeak = hashtable->spaceUsed;
 
@@ -350,6 +379,64 @@ MultiExecParallelHash(HashState *node)
 		   BarrierPhase(build_barrier) == PHJ_BUILD_FREE);
 }
 
+/*
+ * ExecHashFilterAddValue
+ *		widen the range of runtime filter key values seen so far, if needed
+ *
+ * econtext holds the inner tuple being inserted.  NULLs never match, so they
+ * are ignored.
+ */
+static void
+ExecHashFilterAddValue(HashState *node, ExprContext *econtext)
+{
+	Datum		value;
+	bool		isnull;
+	MemoryContext oldcxt;
+
+	value = ExecEvalExprSwitchContext(node->filterKey, econtext, &isnull);
+	if (isnull)
+		return;
+
+	if (node->filterHasValues)
+	{
+		bool		newmin = ApplySortComparator(value, false,
+												 node->filterMin, false,
+												 &node->filterSortSupport) < 0;
+		bool		newmax = ApplySortComparator(value, false,
+												 node->filterMax, false,
+												 &node->filterSortSupport) > 0;
+
+		if (!newmin && !newmax)
+			return;
+
+		oldcxt = MemoryContextSwitchTo(node->hashtable->hashCxt);
+		if (newmin)
+		{
+			if (!node->filterTypByVal)
+				pfree(DatumGetPointer(node->filterMin));
+			node->filterMin = datumCopy(value, node->filterTypByVal,
+										node->filterTypLen);
+		}
+		if (newmax)
+		{
+			if (!node->filterTypByVal)
+				pfree(DatumGetPointer(node->filterMax));
+			node->filterMax = datumCopy(value, node->filterTypByVal,
+										node->filterTypLen);
+		}
+	}
+	else
+	{
+		oldcxt = MemoryContextSwitchTo(node->hashtable->hashCxt);
+		node->filterMin = datumCopy(value, node->filterTypByVal,
+									node->filterTypLen);
+		node->filterMax = datumCopy(value, node->filterTypByVal,
+									node->filterTypLen);
+		node->filterHasValues = true;
+	}
+	MemoryContextSwitchTo(oldcxt);
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitHash
  *
@@ -400,6 +487,22 @@ ExecInitHash(Hash *node, EState *estate, int eflags)
 	hashstate->hashkeys =
 		ExecInitExprList(node->hashkeys, (PlanState *) hashstate);
 
+	/* set up to track the range of the runtime filter key, if any */
+	if (node->filterKeyNo >= 0)
+	{
+		Node	   *filterKey = list_nth(node->hashkeys, node->filterKeyNo);
+
+		hashstate->filterKey = list_nth(hashstate->hashkeys,
+										node->filterKeyNo);
+		hashstate->filterSortSupport.ssup_cxt = CurrentMemoryContext;
+		hashstate->filterSortSupport.ssup_collation = node->filterCollation;
+		PrepareSortSupportFromOrderingOp(node->filterSortOp,
+										 &hashstate->filterSortSupport);
+		get_typlenbyval(exprType(filterKey),
+						&hashstate->filterTypLen,
+						&hashstate->filterTypByVal);
+	}
+
 	return hashstate;
 }
 
@@ -487,6 +590,7 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	hashtable->log2_nbuckets = log2_nbuckets;
 	hashtable->log2_nbuckets_optimal = log2_nbuckets;
 	hashtable->buckets.unshared = NULL;
+	hashtable->bucketTags = NULL;
 	hashtable->keepNulls = keepNulls;
 	hashtable->skewEnabled = false;
 	hashtable->skewBucket = NULL;
@@ -494,6 +598,7 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	hashtable->nSkewBuckets = 0;
 	hashtable->skewBucketNums = NULL;
 	hashtable->nbatch = nbatch;
+	ExecHashSetBucketTagShift(hashtable);
 	hashtable->curbatch = 0;
 	hashtable->nbatch_original = nbatch;
 	hashtable->nbatch_outstart = nbatch;
@@ -503,6 +608,17 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	hashtable->skewTuples = 0;
 	hashtable->innerBatchFile = NULL;
 	hashtable->outerBatchFile = NULL;
+	hashtable->chunked = false;
+	hashtable->morechunks = false;
+	hashtable->curchunk = 0;
+	hashtable->chunkOffset = 0;
+	hashtable->chunkFileno = 0;
+	hashtable->outerMatched = NULL;
+	hashtable->outerMatchedLen = 0;
+	hashtable->nextOuterTupleNo = 0;
+	hashtable->nbatch_chunked = 0;
+	hashtable->tempWritten = 0;
+	hashtable->tempWrittenCompressed = 0;
 	hashtable->spaceUsed = 0;
 	hashtable->spacePeak = 0;
 	hashtable->spaceAllowed = space_allowed;
@@ -645,6 +761,7 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 		MemoryContextSwitchTo(hashtable->batchCxt);
 
 		hashtable->buckets.unshared = palloc0_array(HashJoinTuple, nbuckets);
+		hashtable->bucketTags = palloc0_array(uint8, nbuckets);
 
 		/*
 		 * Set up for skew optimization, if possible and there's a need for
@@ -885,18 +1002,18 @@ ExecHashTableDestroy(HashJoinTable hashtable)
 	int			i;
 
 	/*
-	 * Make sure all the temp files are closed.  We skip batch 0, since it
-	 * can't have any temp files (and the arrays might not even exist if
-	 * nbatch is only 1).  Parallel hash joins don't use these files.
+	 * Make sure all the temp files are closed.  Batch 0 has temp files only
+	 * if it was processed in chunks, but the arrays exist whenever nbatch is
+	 * more than 1.  Parallel hash joins don't use these files.
 	 */
 	if (hashtable->innerBatchFile != NULL)
 	{
-		for (i = 1; i < hashtable->nbatch; i++)
+		for (i = 0; i < hashtable->nbatch; i++)
 		{
 			if (hashtable->innerBatchFile[i])
-				BufFileClose(hashtable->innerBatchFile[i]);
+				ExecHashCloseBatchFile(hashtable, hashtable->innerBatchFile[i]);
 			if (hashtable->outerBatchFile[i])
-				BufFileClose(hashtable->outerBatchFile[i]);
+				ExecHashCloseBatchFile(hashtable, hashtable->outerBatchFile[i]);
 		}
 	}
 
@@ -907,6 +1024,57 @@ ExecHashTableDestroy(HashJoinTable hashtable)
 	pfree(hashtable);
 }
 
+/*
+ * ExecHashCloseBatchFile
+ *		close a batch file of an unshared hash table
+ *
+ * The amount of data written to the file is added to the hash table's
+ * statistics first.
+ */
+void
+ExecHashCloseBatchFile(HashJoinTable hashtable, BufFile *file)
+{
+	int64		rawBytes;
+	int64		storedBytes;
+
+	BufFileCompressionStats(file, &rawBytes, &storedBytes);
+	hashtable->tempWritten += rawBytes;
+	hashtable->tempWrittenCompressed += storedBytes;
+
+	BufFileClose(file);
+}
+
+/*
+ * ExecHashDominantHashSpace
+ *		space taken by the in-memory tuples with the given hash value
+ */
+static Size
+ExecHashDominantHashSpace(HashJoinTable hashtable, uint32 hashvalue)
+{
+	Size		space = 0;
+
+	for (HashMemoryChunk chunk = hashtable->chunks; chunk != NULL;
+		 chunk = chunk->next.unshared)
+	{
+		size_t		idx = 0;
+
+		while (idx < chunk->used)
+		{
+			HashJoinTuple hashTuple = (HashJoinTuple) (HASH_CHUNK_DATA(chunk) + idx);
+			int			hashTupleSize = (HJTUPLE_OVERHEAD +
+										 HJTUPLE_MINTUPLE(hashTuple)->t_len);
+
+			if (hashTuple->hashvalue == hashvalue)
+				space += hashTupleSize;
+			idx += MAXALIGN(hashTupleSize);
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	return space;
+}
+
 /*
  * ExecHashIncreaseNumBatches
  *		increase the original number of batches in order to reduce
@@ -921,6 +1089,8 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	long		ninmemory;
 	long		nfreed;
 	HashMemoryChunk oldchunks;
+	uint32		candidate = 0;
+	long		votes = 0;
 
 	/* do nothing if we've decided to shut off growth */
 	if (!hashtable->growEnabled)
@@ -978,8 +1148,13 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 		hashtable->buckets.unshared =
 			repalloc_array(hashtable->buckets.unshared,
 						   HashJoinTuple, hashtable->nbuckets);
+		hashtable->bucketTags =
+			repalloc_array(hashtable->bucketTags,
+						   uint8, hashtable->nbuckets);
 	}
 
+	ExecHashSetBucketTagShift(hashtable);
+
 	/*
 	 * We will scan through the chunks directly, so that we can reset the
 	 * buckets now and not have to keep track which tuples in the buckets have
@@ -987,6 +1162,8 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	 */
 	memset(hashtable->buckets.unshared, 0,
 		   sizeof(HashJoinTuple) * hashtable->nbuckets);
+	memset(hashtable->bucketTags, 0,
+		   sizeof(uint8) * hashtable->nbuckets);
 	oldchunks = hashtable->chunks;
 	hashtable->chunks = NULL;
 
@@ -1022,6 +1199,22 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 				/* and add it back to the appropriate bucket */
 				copyTuple->next.unshared = hashtable->buckets.unshared[bucketno];
 				hashtable->buckets.unshared[bucketno] = copyTuple;
+				hashtable->bucketTags[bucketno] |=
+					HJ_BUCKET_TAG(hashtable, copyTuple->hashvalue);
+
+				/*
+				 * Track the hash value that the majority of the kept tuples
+				 * have, if any (Boyer-Moore majority vote).
+				 */
+				if (votes == 0)
+				{
+					candidate = copyTuple->hashvalue;
+					votes = 1;
+				}
+				else if (copyTuple->hashvalue == candidate)
+					votes++;
+				else
+					votes--;
 			}
 			else
 			{
@@ -1058,10 +1251,21 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	 * further expansion of nbatch.  This situation implies that we have
 	 * enough tuples of identical hashvalues to overflow spaceAllowed.
 	 * Increasing nbatch will not fix it since there's no way to subdivide the
-	 * group any more finely. We have to just gut it out and hope the server
-	 * has enough RAM.
-	 */
-	if (nfreed == 0 || nfreed == ninmemory)
+	 * group any more finely.  Instead, a batch that still doesn't fit is
+	 * joined in chunks; see ExecHashTableChunkFull().
+	 *
+	 * Likewise if a single hash value, which the MCV-based skew optimization
+	 * did not catch, takes more than half of spaceAllowed by itself.  A
+	 * doubling then splits only the remaining tuples, so it frees less than
+	 * half of the space, and it takes more and more doublings (each doubling
+	 * the number of batch files) before the batch stops overflowing, only
+	 * for the batch to fill up with that one value again.  We only check the
+	 * hash value that the majority of the kept tuples have, if any.
+	 */
+	if (nfreed == 0 || nfreed == ninmemory ||
+		(votes > 0 &&
+		 ExecHashDominantHashSpace(hashtable, candidate) >
+		 hashtable->spaceAllowed / 2))
 	{
 		hashtable->growEnabled = false;
 #ifdef HJDEBUG
@@ -1481,6 +1685,7 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 
 	hashtable->nbuckets = hashtable->nbuckets_optimal;
 	hashtable->log2_nbuckets = hashtable->log2_nbuckets_optimal;
+	ExecHashSetBucketTagShift(hashtable);
 
 	Assert(hashtable->nbuckets > 1);
 	Assert(hashtable->nbuckets <= (INT_MAX / 2));
@@ -1495,9 +1700,14 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 	hashtable->buckets.unshared =
 		repalloc_array(hashtable->buckets.unshared,
 					   HashJoinTuple, hashtable->nbuckets);
+	hashtable->bucketTags =
+		repalloc_array(hashtable->bucketTags,
+					   uint8, hashtable->nbuckets);
 
 	memset(hashtable->buckets.unshared, 0,
 		   hashtable->nbuckets * sizeof(HashJoinTuple));
+	memset(hashtable->bucketTags, 0,
+		   hashtable->nbuckets * sizeof(uint8));
 
 	/* scan through all tuples in all chunks to rebuild the hash table */
 	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
@@ -1517,6 +1727,8 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 			/* add the tuple to the proper bucket */
 			hashTuple->next.unshared = hashtable->buckets.unshared[bucketno];
 			hashtable->buckets.unshared[bucketno] = hashTuple;
+			hashtable->bucketTags[bucketno] |=
+				HJ_BUCKET_TAG(hashtable, hashTuple->hashvalue);
 
 			/* advance index past the tuple */
 			idx += MAXALIGN(HJTUPLE_OVERHEAD +
@@ -1641,9 +1853,31 @@ ExecHashTableInsert(HashJoinTable hashtable,
 							  &bucketno, &batchno);
 
 	/*
-	 * decide whether to put the tuple in the hash table or a temp file
+	 * While building the first batch, once it has been decided that batch 0
+	 * must be processed in chunks, its remaining tuples go to a temp file of
+	 * their own, to be loaded after the first chunk has been joined.  Later
+	 * chunks are loaded from that file, so their tuples must go straight
+	 * into the table; ExecHashJoinLoadChunk already stops at a full chunk.
 	 */
-	if (batchno == hashtable->curbatch)
+	if (batchno == 0 && hashtable->curbatch == 0 &&
+		hashtable->curchunk == 0 &&
+		(hashtable->chunked ||
+		 ExecHashTableChunkFull(hashtable, tuple->t_len)))
+	{
+		if (!hashtable->chunked)
+		{
+			hashtable->chunked = true;
+			hashtable->morechunks = true;
+			hashtable->chunkFileno = 0;
+			hashtable->chunkOffset = 0;
+			hashtable->nbatch_chunked++;
+		}
+		ExecHashJoinSaveTuple(tuple,
+							  hashvalue,
+							  &hashtable->innerBatchFile[0],
+							  hashtable);
+	}
+	else if (batchno == hashtable->curbatch)
 	{
 		/*
 		 * put the tuple in hash table
@@ -1670,6 +1904,7 @@ ExecHashTableInsert(HashJoinTable hashtable,
 		/* Push it onto the front of the bucket's list */
 		hashTuple->next.unshared = hashtable->buckets.unshared[bucketno];
 		hashtable->buckets.unshared[bucketno] = hashTuple;
+		hashtable->bucketTags[bucketno] |= HJ_BUCKET_TAG(hashtable, hashvalue);
 
 		/*
 		 * Increase the (optimal) number of buckets if we just exceeded the
@@ -1693,7 +1928,7 @@ ExecHashTableInsert(HashJoinTable hashtable,
 		if (hashtable->spaceUsed > hashtable->spacePeak)
 			hashtable->spacePeak = hashtable->spaceUsed;
 		if (hashtable->spaceUsed +
-			hashtable->nbuckets_optimal * sizeof(HashJoinTuple)
+			hashtable->nbuckets_optimal * HJ_PRIVATE_BUCKET_SIZE
 			> hashtable->spaceAllowed)
 			ExecHashIncreaseNumBatches(hashtable);
 	}
@@ -1713,6 +1948,26 @@ ExecHashTableInsert(HashJoinTable hashtable,
 		heap_free_minimal_tuple(tuple);
 }
 
+/*
+ * ExecHashTableChunkFull
+ *		would adding a tuple of the given length overflow a hash table that
+ *		cannot grow nbatch any more?
+ *
+ * Once nbatch increases have been disabled, the caller has to process the
+ * current batch in chunks instead of exceeding spaceAllowed.  We never
+ * report an empty table as full, so that each chunk makes progress.
+ */
+bool
+ExecHashTableChunkFull(HashJoinTable hashtable, Size tupleLen)
+{
+	if (hashtable->growEnabled || hashtable->spaceUsed == 0)
+		return false;
+
+	return hashtable->spaceUsed + HJTUPLE_OVERHEAD + tupleLen +
+		hashtable->nbuckets_optimal * HJ_PRIVATE_BUCKET_SIZE >
+		hashtable->spaceAllowed;
+}
+
 /*
  * ExecParallelHashTableInsert
  *		insert a tuple into a shared hash table or shared batch tuplestore
@@ -1957,6 +2212,21 @@ ExecHashGetBucketAndBatch(HashJoinTable hashtable,
 	}
 }
 
+/*
+ * ExecHashSetBucketTagShift
+ *		Place the bucket tag bits above the bucket and batch number bits
+ *
+ * Must be called whenever nbuckets or nbatch changes, and the tags rebuilt.
+ */
+static void
+ExecHashSetBucketTagShift(HashJoinTable hashtable)
+{
+	int			shift;
+
+	shift = hashtable->log2_nbuckets + my_log2(hashtable->nbatch);
+	hashtable->bucketTagShift = Min(shift, HJ_BUCKET_TAG_MAX_SHIFT);
+}
+
 /*
  * ExecScanHashBucket
  *		scan a hash bucket for matches to the current outer tuple
@@ -1987,8 +2257,11 @@ ExecScanHashBucket(HashJoinState *hjstate,
 		hashTuple = hashTuple->next.unshared;
 	else if (hjstate->hj_CurSkewBucketNo != INVALID_SKEW_BUCKET_NO)
 		hashTuple = hashtable->skewBucket[hjstate->hj_CurSkewBucketNo]->tuples;
-	else
+	else if (hashtable->bucketTags[hjstate->hj_CurBucketNo] &
+			 HJ_BUCKET_TAG(hashtable, hashvalue))
 		hashTuple = hashtable->buckets.unshared[hjstate->hj_CurBucketNo];
+	else
+		return false;			/* no tuple in the bucket can match */
 
 	while (hashTuple != NULL)
 	{
@@ -2317,6 +2590,7 @@ ExecHashTableReset(HashJoinTable hashtable)
 
 	/* Reallocate and reinitialize the hash bucket headers. */
 	hashtable->buckets.unshared = palloc0_array(HashJoinTuple, nbuckets);
+	hashtable->bucketTags = palloc0_array(uint8, nbuckets);
 
 	hashtable->spaceUsed = 0;
 
@@ -2678,6 +2952,8 @@ ExecHashRemoveNextSkewBucket(HashJoinTable hashtable)
 
 			copyTuple->next.unshared = hashtable->buckets.unshared[bucketno];
 			hashtable->buckets.unshared[bucketno] = copyTuple;
+			hashtable->bucketTags[bucketno] |=
+				HJ_BUCKET_TAG(hashtable, hashvalue);
 
 			/* We have reduced skew space, but overall space doesn't change */
 			hashtable->spaceUsedSkew -= tupleSize;
@@ -2867,6 +3143,13 @@ ExecHashAccumInstrumentation(HashInstrumentation *instrument,
 									  hashtable->nbatch_original);
 	instrument->space_peak = Max(instrument->space_peak,
 								 hashtable->spacePeak);
+	instrument->nbatch_chunked = Max(instrument->nbatch_chunked,
+									 hashtable->nbatch_chunked);
+	instrument->temp_written = Max(instrument->temp_written,
+								   hashtable->tempWritten);
+	instrument->temp_written_compressed =
+		Max(instrument->temp_written_compressed,
+			hashtable->tempWrittenCompressed);
 }
 
 /*
@@ -47,13 +47,26 @@
  * batch files. Then it checks every batch to ensure it will fit in the space
  * budget for the query.
  *
- * In both parallel and serial hash join, the executor currently makes a best
- * effort. If a particular batch will not fit in memory, it tries doubling the
- * number of batches. If after a batch increase, there is a batch which
- * retained all or none of its tuples, the executor disables growth in the
- * number of batches globally. After growth is disabled, all batches that would
- * have previously triggered an increase in the number of batches instead
- * exceed the space allowed.
+ * In both parallel and serial hash join, if a particular batch will not fit
+ * in memory, the executor tries doubling the number of batches. If after a
+ * batch increase, there is a batch which retained all or none of its tuples,
+ * or in which a single hash value takes more than half of the space allowed,
+ * the executor disables growth in the number of batches globally, since the
+ * batch is dominated by a few hash values that cannot be split up by further
+ * doubling.
+ *
+ * After growth is disabled, serial hash join processes any batch that does
+ * not fit in memory in chunks, block-nested-loop style: it loads as much of
+ * the inner batch as fits in the space allowed, joins the whole outer batch
+ * against that chunk, and then repeats with the next chunk of the inner batch,
+ * rescanning the outer batch each time.  If the first batch overflows, its
+ * outer tuples are saved to a batch file during the first chunk, so that they
+ * can be rescanned too.  Outer tuples that found a match in an earlier chunk
+ * are remembered in a bitmap, so that semi-joins emit them only once and
+ * anti-joins and left/full outer joins emit null-extended tuples only for
+ * outer tuples that did not match in any chunk.  Parallel hash join does not
+ * do this; its batches that would have previously triggered an increase in the
+ * number of batches instead exceed the space allowed.
  *
  * PARALLELISM
  *
@@ -168,6 +181,7 @@
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
+#include "lib/bloomfilter.h"
 #include "miscadmin.h"
 #include "utils/sharedtuplestore.h"
 #include "utils/wait_event.h"
@@ -188,9 +202,21 @@
 /* Returns true if doing null-fill on inner relation */
 #define HJ_FILL_INNER(hjstate)	((hjstate)->hj_NullOuterTupleSlot != NULL)
 
+/*
+ * Number of outer tuples fetched ahead, so that their hash buckets can be
+ * prefetched together, when probing a large private hash table; and the size
+ * of hash table (in bytes) from which on that is worth the cost of copying
+ * the outer tuples.  Smaller hash tables are likely to stay in CPU cache.
+ */
+#define HJ_PROBE_BATCH_SIZE		16
+#define HJ_PROBE_BATCH_MIN_SPACE	(1024 * 1024)
+
 static TupleTableSlot *ExecHashJoinOuterGetTuple(PlanState *outerNode,
 												 HashJoinState *hjstate,
 												 uint32 *hashvalue);
+static TupleTableSlot *ExecHashJoinOuterGetBatchedTuple(PlanState *outerNode,
+														HashJoinState *hjstate,
+														uint32 *hashvalue);
 static TupleTableSlot *ExecParallelHashJoinOuterGetTuple(PlanState *outerNode,
 														 HashJoinState *hjstate,
 														 uint32 *hashvalue);
@@ -198,7 +224,14 @@ static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 												 BufFile *file,
 												 uint32 *hashvalue,
 												 TupleTableSlot *tupleSlot);
+static void ExecHashJoinSetFilterParams(HashJoinState *hjstate,
+										HashState *hashNode);
 static bool ExecHashJoinNewBatch(HashJoinState *hjstate);
+static void ExecHashJoinLoadChunk(HashJoinState *hjstate, int batchno);
+static void ExecHashJoinSetOuterMatched(HashJoinTable hashtable,
+										uint64 tupleno);
+static inline bool ExecHashJoinOuterMatched(HashJoinTable hashtable,
+											uint64 tupleno);
 static bool ExecParallelHashJoinNewBatch(HashJoinState *hjstate);
 static void ExecParallelHashJoinPartitionOuter(HashJoinState *hjstate);
 
@@ -312,7 +345,8 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				}
 				else if (HJ_FILL_OUTER(node) ||
 						 (outerNode->plan->startup_cost < hashNode->ps.plan->total_cost &&
-						  !node->hj_OuterNotEmpty))
+						  !node->hj_OuterNotEmpty &&
+						  ((HashJoin *) node->js.ps.plan)->filterMinParam < 0))
 				{
 					node->hj_FirstOuterTupleSlot = ExecProcNode(outerNode);
 					if (TupIsNull(node->hj_FirstOuterTupleSlot))
@@ -345,6 +379,23 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				hashNode->hashtable = hashtable;
 				(void) MultiExecProcNode((PlanState *) hashNode);
 
+				/*
+				 * If the outer side can prune its partitions using the range
+				 * of inner key values, pass that range on before we fetch
+				 * any outer tuples.
+				 */
+				if (((HashJoin *) node->js.ps.plan)->filterMinParam >= 0)
+					ExecHashJoinSetFilterParams(node, hashNode);
+
+				/*
+				 * If the hash table is too large to stay in CPU cache, probe
+				 * it with batches of outer tuples, so that the cache misses
+				 * for their buckets overlap instead of stalling each probe.
+				 */
+				node->hj_ProbeBatched =
+					(node->hj_ProbeSlots != NULL &&
+					 hashtable->spacePeak >= HJ_PROBE_BATCH_MIN_SPACE);
+
 				/*
 				 * If the inner relation is completely empty, and we're not
 				 * doing a left outer join, we can quit without scanning the
@@ -429,6 +480,10 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 					outerTupleSlot =
 						ExecParallelHashJoinOuterGetTuple(outerNode, node,
 														  &hashvalue);
+				else if (node->hj_ProbeBatched)
+					outerTupleSlot =
+						ExecHashJoinOuterGetBatchedTuple(outerNode, node,
+														 &hashvalue);
 				else
 					outerTupleSlot =
 						ExecHashJoinOuterGetTuple(outerNode, node, &hashvalue);
@@ -484,13 +539,22 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 					node->hj_CurSkewBucketNo == INVALID_SKEW_BUCKET_NO)
 				{
 					bool		shouldFree;
-					MinimalTuple mintuple = ExecFetchSlotMinimalTuple(outerTupleSlot,
-																	  &shouldFree);
+					MinimalTuple mintuple;
+
+					/*
+					 * When rescanning the outer batch for a later chunk, the
+					 * tuple has already been moved to its batch file during
+					 * the first chunk.
+					 */
+					if (hashtable->curchunk > 0)
+						continue;
 
 					/*
 					 * Need to postpone this outer tuple to a later batch.
 					 * Save it in the corresponding outer-batch file.
 					 */
+					mintuple = ExecFetchSlotMinimalTuple(outerTupleSlot,
+														 &shouldFree);
 					Assert(parallel_state == NULL);
 					Assert(batchno > hashtable->curbatch);
 					ExecHashJoinSaveTuple(mintuple, hashvalue,
@@ -504,6 +568,48 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 					continue;
 				}
 
+				/*
+				 * If the current batch is processed in chunks, number the
+				 * outer tuple so that we can remember across chunks whether
+				 * it found a match.  During the first chunk of batch 0, the
+				 * tuple also has to be saved so that later chunks can rescan
+				 * it.  (Tuples matching a skew bucket are only joined during
+				 * the first chunk of batch 0, since the whole skew hashtable
+				 * is in memory then.)
+				 */
+				node->hj_OuterChunked = false;
+				if (hashtable->chunked &&
+					node->hj_CurSkewBucketNo == INVALID_SKEW_BUCKET_NO)
+				{
+					Assert(parallel_state == NULL);
+					if (hashtable->curbatch == 0 && hashtable->curchunk == 0)
+					{
+						bool		shouldFree;
+						MinimalTuple mintuple = ExecFetchSlotMinimalTuple(outerTupleSlot,
+																		  &shouldFree);
+
+						ExecHashJoinSaveTuple(mintuple, hashvalue,
+											  &hashtable->outerBatchFile[0],
+											  hashtable);
+
+						if (shouldFree)
+							heap_free_minimal_tuple(mintuple);
+					}
+
+					node->hj_OuterChunked = true;
+					node->hj_CurOuterTupleNo = hashtable->nextOuterTupleNo++;
+
+					/*
+					 * A semi- or anti-join is done with an outer tuple once
+					 * it has found a match in an earlier chunk.
+					 */
+					if ((node->js.jointype == JOIN_SEMI ||
+						 node->js.jointype == JOIN_ANTI) &&
+						ExecHashJoinOuterMatched(hashtable,
+												 node->hj_CurOuterTupleNo))
+						continue;
+				}
+
 				/* OK, let's scan the bucket for matches */
 				node->hj_JoinState = HJ_SCAN_BUCKET;
 
@@ -549,6 +655,10 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				{
 					node->hj_MatchedOuter = true;
 
+					/* Remember the match for the remaining chunks, if any */
+					if (node->hj_OuterChunked)
+						ExecHashJoinSetOuterMatched(hashtable,
+													node->hj_CurOuterTupleNo);
 
 					/*
 					 * This is really only needed if HJ_FILL_INNER(node), but
@@ -602,6 +712,17 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				if (!node->hj_MatchedOuter &&
 					HJ_FILL_OUTER(node))
 				{
+					/*
+					 * In a batch processed in chunks, the outer tuple might
+					 * still match in a later chunk, or might have matched in
+					 * an earlier one.  Only the last chunk decides.
+					 */
+					if (node->hj_OuterChunked &&
+						(hashtable->morechunks ||
+						 ExecHashJoinOuterMatched(hashtable,
+												  node->hj_CurOuterTupleNo)))
+						break;
+
 					/*
 					 * Generate a fake join tuple with nulls for the inner
 					 * tuple, and return it if it passes the non-join quals.
@@ -769,6 +890,23 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_OuterTupleSlot = ExecInitExtraTupleSlot(estate, outerDesc,
 														ops);
 
+	/*
+	 * A parallel-oblivious join may probe its private hash table with
+	 * batches of outer tuples, which need slots of their own.  Whether it
+	 * actually does is decided once the hash table has been built.
+	 */
+	if (!node->join.plan.parallel_aware)
+	{
+		hjstate->hj_ProbeSlots = palloc_array(TupleTableSlot *,
+											  HJ_PROBE_BATCH_SIZE);
+		hjstate->hj_ProbeHashValues = palloc_array(uint32,
+												   HJ_PROBE_BATCH_SIZE);
+		for (int i = 0; i < HJ_PROBE_BATCH_SIZE; i++)
+			hjstate->hj_ProbeSlots[i] =
+				ExecInitExtraTupleSlot(estate, outerDesc,
+									   &TTSOpsMinimalTuple);
+	}
+
 	/*
 	 * detect whether we need only consider the first matching inner tuple
 	 */
@@ -845,6 +983,13 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_JoinState = HJ_BUILD_HASHTABLE;
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
+	hjstate->hj_OuterChunked = false;
+	hjstate->hj_CurOuterTupleNo = 0;
+	hjstate->hj_ProbeBatched = false;
+	hjstate->hj_ProbeCount = 0;
+	hjstate->hj_ProbeNext = 0;
+	hjstate->hj_ProbeDone = false;
+	hjstate->hj_BloomFiltered = 0;
 
 	return hjstate;
 }
@@ -895,8 +1040,11 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 	int			curbatch = hashtable->curbatch;
 	TupleTableSlot *slot;
 
-	if (curbatch == 0)			/* if it is the first pass */
+	if (curbatch == 0 && hashtable->curchunk == 0)	/* if it is the first pass */
 	{
+		bloom_filter *bloom = castNode(HashState,
+									   innerPlanState(hjstate))->filterBloom;
+
 		/*
 		 * Check to see if first outer tuple was already fetched by
 		 * ExecHashJoin() and not used yet.
@@ -924,12 +1072,24 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 				/* remember outer relation is not empty for possible rescan */
 				hjstate->hj_OuterNotEmpty = true;
 
-				return slot;
+				/*
+				 * If the inner side's bloom filter says that no inner tuple
+				 * has this hash value, the tuple can't have a match.  The
+				 * planner only asks for the filter when such tuples needn't
+				 * be returned, so drop it before it is probed for or written
+				 * to a batch file.
+				 */
+				if (bloom == NULL ||
+					!bloom_lacks_element(bloom, (unsigned char *) hashvalue,
+										 sizeof(uint32)))
+					return slot;
+
+				hjstate->hj_BloomFiltered += 1;
 			}
 
 			/*
-			 * That tuple couldn't match because of a NULL, so discard it and
-			 * continue with the next one.
+			 * That tuple couldn't match, because of a NULL or per the bloom
+			 * filter, so discard it and continue with the next one.
 			 */
 			slot = ExecProcNode(outerNode);
 		}
@@ -957,6 +1117,87 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 	return NULL;
 }
 
+/*
+ * ExecHashJoinOuterGetBatchedTuple
+ *
+ *		get the next outer tuple for a parallel oblivious hashjoin that
+ *		probes its hash table in batches.
+ *
+ * Whenever the previous batch of outer tuples has been used up, we fetch up
+ * to HJ_PROBE_BATCH_SIZE tuples of the current hashjoin batch ahead using
+ * ExecHashJoinOuterGetTuple, copying them into slots of our own, and prefetch
+ * the bucket tags and bucket headers for all of them.  Then, for the tuples
+ * whose tag says the bucket might contain a match, we prefetch the first
+ * tuple of the bucket.  By the time each outer tuple is actually probed, its
+ * bucket is hopefully in cache.  The tuples are returned in their original
+ * order, so this is transparent to the rest of the join.
+ */
+static TupleTableSlot *
+ExecHashJoinOuterGetBatchedTuple(PlanState *outerNode,
+								 HashJoinState *hjstate,
+								 uint32 *hashvalue)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	int			i;
+
+	if (hjstate->hj_ProbeNext >= hjstate->hj_ProbeCount)
+	{
+		int			bucketnos[HJ_PROBE_BATCH_SIZE];
+		int			batchno;
+
+		hjstate->hj_ProbeCount = 0;
+		hjstate->hj_ProbeNext = 0;
+
+		/* Fetch the next batch of outer tuples, unless there are no more */
+		while (!hjstate->hj_ProbeDone &&
+			   hjstate->hj_ProbeCount < HJ_PROBE_BATCH_SIZE)
+		{
+			TupleTableSlot *slot;
+
+			i = hjstate->hj_ProbeCount;
+			slot = ExecHashJoinOuterGetTuple(outerNode, hjstate,
+											 &hjstate->hj_ProbeHashValues[i]);
+			if (TupIsNull(slot))
+			{
+				hjstate->hj_ProbeDone = true;
+				break;
+			}
+			ExecCopySlot(hjstate->hj_ProbeSlots[i], slot);
+			hjstate->hj_ProbeCount++;
+		}
+
+		if (hjstate->hj_ProbeCount == 0)
+		{
+			/* End of this hashjoin batch; start afresh for the next one */
+			hjstate->hj_ProbeDone = false;
+			return NULL;
+		}
+
+		/* Prefetch the tags and headers of their buckets */
+		for (i = 0; i < hjstate->hj_ProbeCount; i++)
+		{
+			ExecHashGetBucketAndBatch(hashtable, hjstate->hj_ProbeHashValues[i],
+									  &bucketnos[i], &batchno);
+			pg_prefetch_mem(&hashtable->bucketTags[bucketnos[i]]);
+			pg_prefetch_mem(&hashtable->buckets.unshared[bucketnos[i]]);
+		}
+
+		/* Prefetch the first tuple of each bucket that might match */
+		for (i = 0; i < hjstate->hj_ProbeCount; i++)
+		{
+			int			bucketno = bucketnos[i];
+
+			if (hashtable->bucketTags[bucketno] &
+				HJ_BUCKET_TAG(hashtable, hjstate->hj_ProbeHashValues[i]))
+				pg_prefetch_mem(hashtable->buckets.unshared[bucketno]);
+		}
+	}
+
+	i = hjstate->hj_ProbeNext++;
+	*hashvalue = hjstate->hj_ProbeHashValues[i];
+	return hjstate->hj_ProbeSlots[i];
+}
+
 /*
  * ExecHashJoinOuterGetTuple variant for the parallel case.
  */
@@ -1033,13 +1274,60 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 	HashJoinTable hashtable = hjstate->hj_HashTable;
 	int			nbatch;
 	int			curbatch;
-	BufFile    *innerFile;
-	TupleTableSlot *slot;
-	uint32		hashvalue;
 
 	nbatch = hashtable->nbatch;
 	curbatch = hashtable->curbatch;
 
+	if (hashtable->chunked)
+	{
+		if (hashtable->morechunks)
+		{
+			/*
+			 * Stay on the current batch, and join the next chunk of its inner
+			 * side against the whole outer batch once more.
+			 */
+			if (curbatch == 0 && hashtable->curchunk == 0)
+			{
+				/* See below */
+				hashtable->skewEnabled = false;
+				hashtable->skewBucket = NULL;
+				hashtable->skewBucketNums = NULL;
+				hashtable->nSkewBuckets = 0;
+				hashtable->spaceUsedSkew = 0;
+			}
+
+			hashtable->curchunk++;
+			hashtable->nextOuterTupleNo = 0;
+
+			ExecHashTableReset(hashtable);
+			ExecHashJoinLoadChunk(hjstate, curbatch);
+
+			if (hashtable->outerBatchFile[curbatch] != NULL &&
+				BufFileSeek(hashtable->outerBatchFile[curbatch], 0, 0, SEEK_SET))
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not rewind hash-join temporary file")));
+
+			return true;
+		}
+
+		/*
+		 * That was the last chunk of the batch.  The outer batch file is not
+		 * needed any more, even for batch 0.
+		 */
+		if (hashtable->outerBatchFile[curbatch])
+			ExecHashCloseBatchFile(hashtable, hashtable->outerBatchFile[curbatch]);
+		hashtable->outerBatchFile[curbatch] = NULL;
+
+		hashtable->chunked = false;
+		hashtable->curchunk = 0;
+		hashtable->nextOuterTupleNo = 0;
+		if (hashtable->outerMatched)
+			pfree(hashtable->outerMatched);
+		hashtable->outerMatched = NULL;
+		hashtable->outerMatchedLen = 0;
+	}
+
 	if (curbatch > 0)
 	{
 		/*
@@ -1047,7 +1335,7 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 		 * away to free disk space.
 		 */
 		if (hashtable->outerBatchFile[curbatch])
-			BufFileClose(hashtable->outerBatchFile[curbatch]);
+			ExecHashCloseBatchFile(hashtable, hashtable->outerBatchFile[curbatch]);
 		hashtable->outerBatchFile[curbatch] = NULL;
 	}
 	else						/* we just finished the first batch */
@@ -1103,10 +1391,10 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 		/* We can ignore this batch. */
 		/* Release associated temp files right away. */
 		if (hashtable->innerBatchFile[curbatch])
-			BufFileClose(hashtable->innerBatchFile[curbatch]);
+			ExecHashCloseBatchFile(hashtable, hashtable->innerBatchFile[curbatch]);
 		hashtable->innerBatchFile[curbatch] = NULL;
 		if (hashtable->outerBatchFile[curbatch])
-			BufFileClose(hashtable->outerBatchFile[curbatch]);
+			ExecHashCloseBatchFile(hashtable, hashtable->outerBatchFile[curbatch]);
 		hashtable->outerBatchFile[curbatch] = NULL;
 		curbatch++;
 	}
@@ -1117,51 +1405,153 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 	hashtable->curbatch = curbatch;
 
 	/*
-	 * Reload the hash table with the new inner batch (which could be empty)
+	 * Reload the hash table with the new inner batch (which could be empty),
+	 * or with as much of it as fits.
 	 */
 	ExecHashTableReset(hashtable);
 
-	innerFile = hashtable->innerBatchFile[curbatch];
+	hashtable->chunkFileno = 0;
+	hashtable->chunkOffset = 0;
+	ExecHashJoinLoadChunk(hjstate, curbatch);
 
-	if (innerFile != NULL)
+	/*
+	 * Rewind outer batch file (if present), so that we can start reading it.
+	 */
+	if (hashtable->outerBatchFile[curbatch] != NULL)
 	{
-		if (BufFileSeek(innerFile, 0, 0, SEEK_SET))
+		if (BufFileSeek(hashtable->outerBatchFile[curbatch], 0, 0, SEEK_SET))
 			ereport(ERROR,
 					(errcode_for_file_access(),
 					 errmsg("could not rewind hash-join temporary file")));
+	}
+
+	return true;
+}
 
-		while ((slot = ExecHashJoinGetSavedTuple(hjstate,
-												 innerFile,
-												 &hashvalue,
-												 hjstate->hj_HashTupleSlot)))
+/*
+ * ExecHashJoinLoadChunk
+ *		load the next chunk of an inner batch into the (empty) hash table
+ *
+ * Reading starts at the position remembered in hashtable->chunkFileno and
+ * chunkOffset.  If nbatch increases have been disabled and the next tuple
+ * would overflow the hash table, we stop there, remember the position of
+ * that tuple for the next chunk, and mark the batch as chunked.  Otherwise
+ * the whole rest of the batch is loaded, and the inner batch file is no
+ * longer needed.
+ */
+static void
+ExecHashJoinLoadChunk(HashJoinState *hjstate, int batchno)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	BufFile    *innerFile = hashtable->innerBatchFile[batchno];
+	TupleTableSlot *slot;
+	uint32		hashvalue;
+	int			fileno;
+	off_t		offset;
+
+	hashtable->morechunks = false;
+
+	if (innerFile == NULL)
+		return;
+
+	if (BufFileSeek(innerFile, hashtable->chunkFileno, hashtable->chunkOffset,
+					SEEK_SET))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not rewind hash-join temporary file")));
+
+	for (;;)
+	{
+		bool		shouldFree;
+		MinimalTuple tuple;
+
+		BufFileTell(innerFile, &fileno, &offset);
+		slot = ExecHashJoinGetSavedTuple(hjstate,
+										 innerFile,
+										 &hashvalue,
+										 hjstate->hj_HashTupleSlot);
+		if (slot == NULL)
+			break;
+
+		tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+		if (ExecHashTableChunkFull(hashtable, tuple->t_len))
 		{
-			/*
-			 * NOTE: some tuples may be sent to future batches.  Also, it is
-			 * possible for hashtable->nbatch to be increased here!
-			 */
-			ExecHashTableInsert(hashtable, slot, hashvalue);
+			/* Leave this tuple and the rest for the next chunk */
+			if (!hashtable->chunked)
+			{
+				hashtable->chunked = true;
+				hashtable->nbatch_chunked++;
+			}
+			hashtable->morechunks = true;
+			hashtable->chunkFileno = fileno;
+			hashtable->chunkOffset = offset;
+			if (shouldFree)
+				heap_free_minimal_tuple(tuple);
+			return;
 		}
+		if (shouldFree)
+			heap_free_minimal_tuple(tuple);
 
 		/*
-		 * after we build the hash table, the inner batch file is no longer
-		 * needed
+		 * NOTE: some tuples may be sent to future batches.  Also, it is
+		 * possible for hashtable->nbatch to be increased here!
 		 */
-		BufFileClose(innerFile);
-		hashtable->innerBatchFile[curbatch] = NULL;
+		ExecHashTableInsert(hashtable, slot, hashvalue);
 	}
 
 	/*
-	 * Rewind outer batch file (if present), so that we can start reading it.
+	 * after we build the hash table from the last chunk, the inner batch file
+	 * is no longer needed
 	 */
-	if (hashtable->outerBatchFile[curbatch] != NULL)
+	ExecHashCloseBatchFile(hashtable, innerFile);
+	hashtable->innerBatchFile[batchno] = NULL;
+}
+
+/*
+ * ExecHashJoinSetOuterMatched
+ *		remember that the given outer tuple of a chunked batch has a match
+ *
+ * The bitmap lives in the spill context, and is enlarged as needed; its size
+ * is one bit per outer tuple of the batch.
+ */
+static void
+ExecHashJoinSetOuterMatched(HashJoinTable hashtable, uint64 tupleno)
+{
+	Size		byteno = tupleno / BITS_PER_BYTE;
+
+	if (byteno >= hashtable->outerMatchedLen)
 	{
-		if (BufFileSeek(hashtable->outerBatchFile[curbatch], 0, 0, SEEK_SET))
-			ereport(ERROR,
-					(errcode_for_file_access(),
-					 errmsg("could not rewind hash-join temporary file")));
+		Size		newlen = Max(hashtable->outerMatchedLen, 1024);
+
+		while (newlen <= byteno)
+			newlen *= 2;
+
+		if (hashtable->outerMatched == NULL)
+			hashtable->outerMatched =
+				MemoryContextAllocZero(hashtable->spillCxt, newlen);
+		else
+			hashtable->outerMatched = repalloc0(hashtable->outerMatched,
+												hashtable->outerMatchedLen,
+												newlen);
+		hashtable->outerMatchedLen = newlen;
 	}
 
-	return true;
+	hashtable->outerMatched[byteno] |= 1 << (tupleno % BITS_PER_BYTE);
+}
+
+/*
+ * ExecHashJoinOuterMatched
+ *		did the given outer tuple of a chunked batch match in any chunk so far?
+ */
+static inline bool
+ExecHashJoinOuterMatched(HashJoinTable hashtable, uint64 tupleno)
+{
+	Size		byteno = tupleno / BITS_PER_BYTE;
+
+	if (byteno >= hashtable->outerMatchedLen)
+		return false;
+
+	return (hashtable->outerMatched[byteno] & (1 << (tupleno % BITS_PER_BYTE))) != 0;
 }
 
 /*
@@ -1335,7 +1725,7 @@ ExecHashJoinSaveTuple(MinimalTuple tuple, uint32 hashvalue,
 	{
 		MemoryContext oldctx = MemoryContextSwitchTo(hashtable->spillCxt);
 
-		file = BufFileCreateTemp(false);
+		file = BufFileCreateCompressTemp(false);
 		*fileptr = file;
 
 		MemoryContextSwitchTo(oldctx);
@@ -1391,6 +1781,31 @@ ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 }
 
 
+/*
+ * ExecHashJoinSetFilterParams
+ *		publish the range of inner key values found by the Hash node
+ *
+ * The outer Append prunes its partitions using these parameters the first
+ * time it is executed.  If the inner side produced no non-null keys, both
+ * are set to NULL, which makes the pruning discard every partition.
+ */
+static void
+ExecHashJoinSetFilterParams(HashJoinState *hjstate, HashState *hashNode)
+{
+	HashJoin   *node = (HashJoin *) hjstate->js.ps.plan;
+	ParamExecData *prm;
+
+	prm = &hjstate->js.ps.state->es_param_exec_vals[node->filterMinParam];
+	prm->execPlan = NULL;
+	prm->value = hashNode->filterMin;
+	prm->isnull = !hashNode->filterHasValues;
+
+	prm = &hjstate->js.ps.state->es_param_exec_vals[node->filterMaxParam];
+	prm->execPlan = NULL;
+	prm->value = hashNode->filterMax;
+	prm->isnull = !hashNode->filterHasValues;
+}
+
 void
 ExecReScanHashJoin(HashJoinState *node)
 {
@@ -1436,6 +1851,7 @@ ExecReScanHashJoin(HashJoinState *node)
 		{
 			/* must destroy and rebuild hash table */
 			HashState  *hashNode = castNode(HashState, innerPlan);
+			HashJoin   *hj = (HashJoin *) node->js.ps.plan;
 
 			Assert(hashNode->hashtable == node->hj_HashTable);
 			/* accumulate stats from old hash table, if wanted */
@@ -1459,6 +1875,18 @@ ExecReScanHashJoin(HashJoinState *node)
 			 */
 			if (innerPlan->chgParam == NULL)
 				ExecReScan(innerPlan);
+
+			/*
+			 * The new hash table may cover a different range of keys, so
+			 * make the outer side prune its partitions again.
+			 */
+			if (hj->filterMinParam >= 0)
+			{
+				outerPlan->chgParam = bms_add_member(outerPlan->chgParam,
+													 hj->filterMinParam);
+				outerPlan->chgParam = bms_add_member(outerPlan->chgParam,
+													 hj->filterMaxParam);
+			}
 		}
 	}
 
@@ -1471,6 +1899,11 @@ ExecReScanHashJoin(HashJoinState *node)
 	node->hj_MatchedOuter = false;
 	node->hj_FirstOuterTupleSlot = NULL;
 
+	/* Forget any outer tuples fetched ahead */
+	node->hj_ProbeCount = 0;
+	node->hj_ProbeNext = 0;
+	node->hj_ProbeDone = false;
+
 	/*
 	 * if chgParam of subnode is not null then plan will be re-scanned by
 	 * first ExecProcNode.
@@ -50,6 +50,29 @@
  * demanding, then that may allow us to start putting useful entries back into
  * the cache again.
  *
+ * When the Memoize node runs below a Gather or Gather Merge, each parallel
+ * participant executes the parameterized subplan for its own share of the
+ * outer rows, so without further measures every participant would have to
+ * build up the same cache entries on its own.  If enable_shared_memoize is
+ * set, we therefore also maintain a second level cache in the query's
+ * dynamic shared memory area, which is a dshash table keyed by the binary
+ * image of the cache key's MinimalTuple.  Whenever a participant completes
+ * a cache entry, it publishes a copy of the entry's tuples in the shared
+ * cache, and on a miss in the local cache we consult the shared cache before
+ * rescanning the subplan.  Tuples found in the shared cache are returned
+ * directly from there; the shared entry is pinned until the scan is over, so
+ * that it can't be evicted in the meantime.  Only complete entries are ever
+ * shared.  Eviction from the shared cache follows an approximate LRU scheme:
+ * each entry records the value of a shared clock when it was last used, and
+ * once the shared cache exceeds its memory budget, a single participant
+ * removes all unpinned entries that have not been used since the midpoint
+ * between the oldest remaining entry and the current clock.  The node's
+ * memory budget is split evenly between its local cache and the shared
+ * cache, as the planner assumed in cost_memoize_rescan().  The shared cache
+ * can only be used if the subplan's results depend on no parameters other
+ * than the cache key, as otherwise participants might see different results
+ * for the same key.
+ *
  *
  * INTERFACE ROUTINES
  *		ExecMemoize			- lookup cache, exec subplan when not found
@@ -59,7 +82,9 @@
  *
  *		ExecMemoizeEstimate		estimates DSM space needed for parallel plan
  *		ExecMemoizeInitializeDSM initialize DSM for parallel plan
+ *		ExecMemoizeReInitializeDSM reinitialize DSM for fresh scan
  *		ExecMemoizeInitializeWorker attach to DSM info in parallel worker
+ *		ExecShutdownMemoize		detach from the shared cache
  *		ExecMemoizeRetrieveInstrumentation get instrumentation from worker
  *-------------------------------------------------------------------------
  */
@@ -69,8 +94,11 @@
 #include "common/hashfn.h"
 #include "executor/executor.h"
 #include "executor/nodeMemoize.h"
+#include "lib/dshash.h"
 #include "lib/ilist.h"
 #include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/lwlock.h"
 #include "utils/datum.h"
 #include "utils/lsyscache.h"
 
@@ -81,6 +109,15 @@
 #define MEMO_CACHE_BYPASS_MODE		4	/* Bypass mode.  Just read from our
 										 * subplan without caching anything */
 #define MEMO_END_OF_SCAN			5	/* Ready for rescan */
+#define MEMO_SHARED_FETCH_NEXT_TUPLE	6	/* Get another tuple from the
+											 * shared cache */
+
+/*
+ * DSM key for the shared cache.  The plan_node_id itself is already used as
+ * the key for the node's instrumentation data.
+ */
+#define PARALLEL_KEY_MEMOIZE_CACHE(plan_node_id) \
+	(UINT64CONST(0xD000000000000000) | (uint64) (plan_node_id))
 
 
 /* Helper macros for memory accounting */
@@ -122,6 +159,59 @@ typedef struct MemoizeEntry
 	bool		complete;		/* Did we read the outer plan to completion? */
 } MemoizeEntry;
 
+/*
+ * SharedMemoizeKey
+ *		Hash key of the shared cache.  The key data is the binary image of a
+ *		local cache entry's key->params.  Keys stored in the hash table point
+ *		to a copy of it in the DSA area, while search keys point to the
+ *		backend-local copy.
+ */
+typedef struct SharedMemoizeKey
+{
+	uint32		hash;			/* hash of the key data */
+	uint32		len;			/* length of the key data */
+	dsa_pointer data;			/* key data, for keys stored in the table */
+	const char *local;			/* key data, for search keys */
+} SharedMemoizeKey;
+
+/*
+ * SharedMemoizeEntry
+ *		An entry of the shared cache.  The entry's tuples are stored back to
+ *		back in a single chunk, each one starting at a MAXALIGN'd offset.
+ */
+typedef struct SharedMemoizeEntry
+{
+	SharedMemoizeKey key;		/* Hash key for hash table lookups */
+	dsa_pointer tuples;			/* cached MinimalTuples, or InvalidDsaPointer
+								 * if there are none */
+	Size		tuples_len;		/* length of the 'tuples' chunk */
+	uint32		ntuples;		/* number of cached tuples */
+	pg_atomic_uint64 last_used; /* shared clock value of the last access */
+	pg_atomic_uint32 refcount;	/* number of scans returning the tuples */
+} SharedMemoizeEntry;
+
+/*
+ * SharedMemoizeCache
+ *		Control data of the shared cache, stored in the DSM segment.
+ */
+typedef struct SharedMemoizeCache
+{
+	dshash_table_handle handle; /* handle of the shared hash table */
+	uint64		mem_limit;		/* memory limit in bytes for the cache */
+	pg_atomic_uint64 mem_used;	/* bytes of memory used by cache */
+	pg_atomic_uint64 clock;		/* advanced on every access of an entry */
+	pg_atomic_flag evicting;	/* set while someone is evicting entries */
+	uint64		oldest_used;	/* lower bound of all entries' last_used,
+								 * protected by 'evicting' */
+} SharedMemoizeCache;
+
+/* Memory consumed by a shared cache entry */
+#define SHARED_ENTRY_MEMORY_BYTES(e)	(sizeof(SharedMemoizeEntry) + \
+										 (e)->key.len + (e)->tuples_len)
+
+/* GUC parameter */
+bool		enable_shared_memoize = false;
+
 
 #define SH_PREFIX memoize
 #define SH_ELEMENT_TYPE MemoizeEntry
@@ -693,6 +783,351 @@ cache_store_tuple(MemoizeState *mstate, TupleTableSlot *slot)
 	return true;
 }
 
+/*
+ * shared_cache_key_data
+ *		Return a pointer to the key data of 'key'.
+ */
+static inline const char *
+shared_cache_key_data(const SharedMemoizeKey *key, dsa_area *area)
+{
+	if (key->local != NULL)
+		return key->local;
+
+	return (const char *) dsa_get_address(area, key->data);
+}
+
+/*
+ * SharedMemoizeKey_compare
+ *		Compare function for the shared cache's dshash table.  'arg' is the
+ *		dsa_area the cache is stored in.
+ */
+static int
+SharedMemoizeKey_compare(const void *a, const void *b, size_t size, void *arg)
+{
+	const SharedMemoizeKey *k1 = (const SharedMemoizeKey *) a;
+	const SharedMemoizeKey *k2 = (const SharedMemoizeKey *) b;
+	dsa_area   *area = (dsa_area *) arg;
+
+	if (k1->hash != k2->hash || k1->len != k2->len)
+		return 1;
+
+	return memcmp(shared_cache_key_data(k1, area),
+				  shared_cache_key_data(k2, area),
+				  k1->len);
+}
+
+/*
+ * SharedMemoizeKey_hash
+ *		Hash function for the shared cache's dshash table.  The hash value
+ *		has already been computed when the key was set up.
+ */
+static dshash_hash
+SharedMemoizeKey_hash(const void *v, size_t size, void *arg)
+{
+	return ((const SharedMemoizeKey *) v)->hash;
+}
+
+/*
+ * SharedMemoizeKey_copy
+ *		Copy function for the shared cache's dshash table.  Keys stored in
+ *		the table must not point into backend-local memory.
+ */
+static void
+SharedMemoizeKey_copy(void *dest, const void *src, size_t size, void *arg)
+{
+	SharedMemoizeKey *key = (SharedMemoizeKey *) dest;
+
+	memcpy(dest, src, size);
+	key->local = NULL;
+}
+
+static const dshash_parameters shared_memoize_params = {
+	sizeof(SharedMemoizeKey),
+	sizeof(SharedMemoizeEntry),
+	SharedMemoizeKey_compare,
+	SharedMemoizeKey_hash,
+	SharedMemoizeKey_copy,
+	LWTRANCHE_PARALLEL_MEMOIZE
+};
+
+/*
+ * shared_cache_init_key
+ *		Set up 'key' as a search key for the local cache key 'params'.
+ */
+static void
+shared_cache_init_key(SharedMemoizeKey *key, MinimalTuple params)
+{
+	key->hash = hash_bytes((const unsigned char *) params, params->t_len);
+	key->len = params->t_len;
+	key->data = InvalidDsaPointer;
+	key->local = (const char *) params;
+}
+
+/*
+ * shared_cache_free_entry
+ *		Free the DSA memory used by the shared cache entry 'entry', which the
+ *		caller is about to delete from the hash table.
+ */
+static void
+shared_cache_free_entry(MemoizeState *mstate, SharedMemoizeEntry *entry)
+{
+	pg_atomic_sub_fetch_u64(&mstate->shared_cache->mem_used,
+							SHARED_ENTRY_MEMORY_BYTES(entry));
+
+	dsa_free(mstate->shared_area, entry->key.data);
+	if (DsaPointerIsValid(entry->tuples))
+		dsa_free(mstate->shared_area, entry->tuples);
+}
+
+/*
+ * shared_cache_reduce_memory
+ *		Evict less recently used entries from the shared cache until its
+ *		memory consumption is comfortably below the limit again.
+ *
+ * Only one participant evicts entries at a time; if someone else is already
+ * doing it, we just return.  Each pass over the hash table removes all
+ * entries that were last used in the older half of the range between
+ * oldest_used and the current value of the clock, except those that are
+ * pinned by a scan that is still returning their tuples.  If that leaves us
+ * above the limit even once all entries have been considered, we give up
+ * until next time.
+ */
+static void
+shared_cache_reduce_memory(MemoizeState *mstate)
+{
+	SharedMemoizeCache *cache = mstate->shared_cache;
+	uint64		target = cache->mem_limit - cache->mem_limit / 10;
+
+	if (!pg_atomic_test_set_flag(&cache->evicting))
+		return;
+
+	while (pg_atomic_read_u64(&cache->mem_used) > target)
+	{
+		uint64		clock = pg_atomic_read_u64(&cache->clock);
+		uint64		horizon;
+		dshash_seq_status status;
+		SharedMemoizeEntry *entry;
+
+		horizon = cache->oldest_used + (clock - cache->oldest_used) / 2 + 1;
+
+		dshash_seq_init(&status, mstate->shared_hash, true);
+		while ((entry = dshash_seq_next(&status)) != NULL)
+		{
+			if (pg_atomic_read_u64(&entry->last_used) < horizon &&
+				pg_atomic_read_u32(&entry->refcount) == 0)
+			{
+				shared_cache_free_entry(mstate, entry);
+				dshash_delete_current(&status);
+			}
+		}
+		dshash_seq_term(&status);
+
+		cache->oldest_used = horizon;
+
+		if (horizon > clock)
+			break;
+	}
+
+	pg_atomic_clear_flag(&cache->evicting);
+}
+
+/*
+ * shared_cache_fetch
+ *		Look for the current parameters in the shared cache.  If found, pin
+ *		the shared entry and set up to return its tuples, and return true.
+ *
+ * 'entry' is the local cache entry for the parameters that cache_lookup()
+ * returned, or NULL if it failed to make room for one.  As we don't copy
+ * the shared entry's tuples into the local cache, a local entry is removed
+ * again on a hit.
+ */
+static bool
+shared_cache_fetch(MemoizeState *mstate, MemoizeEntry *entry)
+{
+	SharedMemoizeKey key;
+	SharedMemoizeEntry *sentry;
+	MinimalTuple params;
+
+	Assert(mstate->shared_entry == NULL);
+
+	if (entry != NULL)
+		params = entry->key->params;
+	else
+	{
+		ExprContext *econtext = mstate->ss.ps.ps_ExprContext;
+		MemoryContext oldcontext;
+
+		/* cache_lookup() has left the current parameters in probeslot */
+		oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+		params = ExecCopySlotMinimalTuple(mstate->probeslot);
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	shared_cache_init_key(&key, params);
+
+	sentry = dshash_find(mstate->shared_hash, &key, false);
+	if (sentry == NULL)
+		return false;
+
+	/* Pin the entry; the evicting participant checks this under its lock */
+	pg_atomic_fetch_add_u32(&sentry->refcount, 1);
+	pg_atomic_write_u64(&sentry->last_used,
+						pg_atomic_fetch_add_u64(&mstate->shared_cache->clock, 1));
+
+	mstate->shared_entry = sentry;
+	mstate->shared_ntuples = sentry->ntuples;
+	if (sentry->ntuples > 0)
+		mstate->shared_next_tuple =
+			dsa_get_address(mstate->shared_area, sentry->tuples);
+	else
+		mstate->shared_next_tuple = NULL;
+	dshash_release_lock(mstate->shared_hash, sentry);
+
+	if (entry != NULL)
+		remove_cache_entry(mstate, entry);
+
+	return true;
+}
+
+/*
+ * shared_cache_unpin
+ *		Unpin the shared entry we've been returning tuples from, if any.
+ */
+static void
+shared_cache_unpin(MemoizeState *mstate)
+{
+	if (mstate->shared_entry == NULL)
+		return;
+
+	pg_atomic_fetch_sub_u32(&mstate->shared_entry->refcount, 1);
+	mstate->shared_entry = NULL;
+	mstate->shared_next_tuple = NULL;
+	mstate->shared_ntuples = 0;
+}
+
+/*
+ * shared_cache_next_tuple
+ *		Return the next tuple of the pinned shared entry, or NULL if there are
+ *		no more, in which case the entry is unpinned.
+ */
+static TupleTableSlot *
+shared_cache_next_tuple(MemoizeState *mstate)
+{
+	TupleTableSlot *slot = mstate->ss.ps.ps_ResultTupleSlot;
+	MinimalTuple mtup;
+
+	if (mstate->shared_ntuples == 0)
+	{
+		shared_cache_unpin(mstate);
+		return NULL;
+	}
+
+	mtup = (MinimalTuple) mstate->shared_next_tuple;
+	mstate->shared_next_tuple += MAXALIGN(mtup->t_len);
+	mstate->shared_ntuples--;
+
+	ExecStoreMinimalTuple(mtup, slot, false);
+
+	return slot;
+}
+
+/*
+ * shared_cache_publish
+ *		Make a copy of the complete local cache entry 'entry' in the shared
+ *		cache, unless some other participant has already done so.
+ */
+static void
+shared_cache_publish(MemoizeState *mstate, MemoizeEntry *entry)
+{
+	SharedMemoizeCache *cache = mstate->shared_cache;
+	dsa_area   *area = mstate->shared_area;
+	MinimalTuple params = entry->key->params;
+	SharedMemoizeKey key;
+	SharedMemoizeEntry *sentry;
+	MemoizeTuple *tuple;
+	dsa_pointer tuples = InvalidDsaPointer;
+	Size		tuples_len = 0;
+	uint32		ntuples = 0;
+	uint64		mem_used;
+	bool		found;
+
+	Assert(entry->complete);
+
+	shared_cache_init_key(&key, params);
+
+	/* Don't bother copying the tuples if the entry is already there */
+	sentry = dshash_find(mstate->shared_hash, &key, false);
+	if (sentry != NULL)
+	{
+		dshash_release_lock(mstate->shared_hash, sentry);
+		return;
+	}
+
+	for (tuple = entry->tuplehead; tuple != NULL; tuple = tuple->next)
+	{
+		tuples_len += MAXALIGN(tuple->mintuple->t_len);
+		ntuples++;
+	}
+
+	/* Entries that would take up most of the shared cache aren't worth it */
+	if (tuples_len > cache->mem_limit / 4)
+		return;
+
+	/*
+	 * Copy the key and the tuples into the DSA area before inserting the
+	 * entry, so that we don't hold the partition lock while allocating.
+	 * Failing to allocate the memory is not an error; the entry just won't be
+	 * shared.
+	 */
+	key.data = dsa_allocate_extended(area, key.len, DSA_ALLOC_NO_OOM);
+	if (!DsaPointerIsValid(key.data))
+		return;
+	memcpy(dsa_get_address(area, key.data), params, key.len);
+
+	if (tuples_len > 0)
+	{
+		char	   *ptr;
+
+		tuples = dsa_allocate_extended(area, tuples_len, DSA_ALLOC_NO_OOM);
+		if (!DsaPointerIsValid(tuples))
+		{
+			dsa_free(area, key.data);
+			return;
+		}
+
+		ptr = dsa_get_address(area, tuples);
+		for (tuple = entry->tuplehead; tuple != NULL; tuple = tuple->next)
+		{
+			memcpy(ptr, tuple->mintuple, tuple->mintuple->t_len);
+			ptr += MAXALIGN(tuple->mintuple->t_len);
+		}
+	}
+
+	sentry = dshash_find_or_insert(mstate->shared_hash, &key, &found);
+	if (found)
+	{
+		/* Somebody beat us to it */
+		dshash_release_lock(mstate->shared_hash, sentry);
+		dsa_free(area, key.data);
+		if (DsaPointerIsValid(tuples))
+			dsa_free(area, tuples);
+		return;
+	}
+
+	sentry->tuples = tuples;
+	sentry->tuples_len = tuples_len;
+	sentry->ntuples = ntuples;
+	pg_atomic_init_u64(&sentry->last_used,
+					   pg_atomic_fetch_add_u64(&cache->clock, 1));
+	pg_atomic_init_u32(&sentry->refcount, 0);
+	mem_used = pg_atomic_add_fetch_u64(&cache->mem_used,
+									   SHARED_ENTRY_MEMORY_BYTES(sentry));
+	dshash_release_lock(mstate->shared_hash, sentry);
+
+	if (mem_used > cache->mem_limit)
+		shared_cache_reduce_memory(mstate);
+}
+
 static TupleTableSlot *
 ExecMemoize(PlanState *pstate)
 {
@@ -739,6 +1174,21 @@ ExecMemoize(PlanState *pstate)
 				/* see if we've got anything cached for the current parameters */
 				entry = cache_lookup(node, &found);
 
+				/*
+				 * If not, another parallel participant may have cached them
+				 * already.
+				 */
+				if (node->shared_hash != NULL && !(found && entry->complete) &&
+					shared_cache_fetch(node, entry))
+				{
+					node->stats.shared_hits += 1;	/* stats update */
+
+					slot = shared_cache_next_tuple(node);
+					node->mstatus = TupIsNull(slot) ?
+						MEMO_END_OF_SCAN : MEMO_SHARED_FETCH_NEXT_TUPLE;
+					return slot;
+				}
+
 				if (found && entry->complete)
 				{
 					node->stats.cache_hits += 1;	/* stats update */
@@ -797,8 +1247,13 @@ ExecMemoize(PlanState *pstate)
 					 * scan.
 					 */
 					if (likely(entry))
+					{
 						entry->complete = true;
 
+						if (node->shared_hash != NULL)
+							shared_cache_publish(node, entry);
+					}
+
 					node->mstatus = MEMO_END_OF_SCAN;
 					return NULL;
 				}
@@ -829,8 +1284,13 @@ ExecMemoize(PlanState *pstate)
 					 * cache lookups to work even when the scan has not been
 					 * executed to completion.
 					 */
+					/* cache_store_tuple may have moved the entry */
+					entry = node->entry;
 					entry->complete = node->singlerow;
 					node->mstatus = MEMO_FILLING_CACHE;
+
+					if (entry->complete && node->shared_hash != NULL)
+						shared_cache_publish(node, entry);
 				}
 
 				slot = node->ss.ps.ps_ResultTupleSlot;
@@ -861,6 +1321,18 @@ ExecMemoize(PlanState *pstate)
 				return slot;
 			}
 
+		case MEMO_SHARED_FETCH_NEXT_TUPLE:
+			{
+				/* We shouldn't be in this state if this is not set */
+				Assert(node->shared_entry != NULL);
+
+				slot = shared_cache_next_tuple(node);
+				if (TupIsNull(slot))
+					node->mstatus = MEMO_END_OF_SCAN;
+
+				return slot;
+			}
+
 		case MEMO_FILLING_CACHE:
 			{
 				TupleTableSlot *outerslot;
@@ -881,6 +1353,10 @@ ExecMemoize(PlanState *pstate)
 					/* No more tuples.  Mark it as complete */
 					entry->complete = true;
 					node->mstatus = MEMO_END_OF_SCAN;
+
+					if (node->shared_hash != NULL)
+						shared_cache_publish(node, entry);
+
 					return NULL;
 				}
 
@@ -1073,6 +1549,15 @@ ExecInitMemoize(Memoize *node, EState *estate, int eflags)
 	 */
 	mstate->hashtable = NULL;
 
+	/* The shared cache, if any, is set up with the parallel DSM */
+	mstate->shared_cache = NULL;
+	mstate->shared_hash = NULL;
+	mstate->shared_area = NULL;
+	mstate->shared_cache_used = false;
+	mstate->shared_entry = NULL;
+	mstate->shared_next_tuple = NULL;
+	mstate->shared_ntuples = 0;
+
 	return mstate;
 }
 
@@ -1127,6 +1612,9 @@ ExecEndMemoize(MemoizeState *node)
 		memcpy(si, &node->stats, sizeof(MemoizeInstrumentation));
 	}
 
+	/* Detach from the shared cache, unless ExecShutdownMemoize did already */
+	ExecShutdownMemoize(node);
+
 	/* Remove the cache context */
 	MemoryContextDelete(node->tableContext);
 
@@ -1147,6 +1635,7 @@ ExecReScanMemoize(MemoizeState *node)
 	/* nullify pointers used for the last scan */
 	node->entry = NULL;
 	node->last_tuple = NULL;
+	shared_cache_unpin(node);
 
 	/*
 	 * if chgParam of subnode is not null then plan will be re-scanned by
@@ -1180,10 +1669,25 @@ ExecEstimateCacheEntryOverheadBytes(double ntuples)
  * ----------------------------------------------------------------
  */
 
+/*
+ * Can the participants of a parallel plan share their cache entries?  That
+ * is only the case if the results of the subplan depend on the cache key
+ * alone.
+ */
+static bool
+ExecMemoizeUseSharedCache(MemoizeState *node, ParallelContext *pcxt)
+{
+	Plan	   *outerNode = outerPlan(node->ss.ps.plan);
+
+	return enable_shared_memoize && pcxt->nworkers > 0 &&
+		bms_is_subset(outerNode->extParam, node->keyparamids);
+}
+
  /* ----------------------------------------------------------------
   *		ExecMemoizeEstimate
   *
-  *		Estimate space required to propagate memoize statistics.
+  *		Estimate space required to propagate memoize statistics and
+  *		for the shared cache.
   * ----------------------------------------------------------------
   */
 void
@@ -1191,6 +1695,12 @@ ExecMemoizeEstimate(MemoizeState *node, ParallelContext *pcxt)
 {
 	Size		size;
 
+	if (ExecMemoizeUseSharedCache(node, pcxt))
+	{
+		shm_toc_estimate_chunk(&pcxt->estimator, sizeof(SharedMemoizeCache));
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+
 	/* don't need this if not instrumenting or no workers */
 	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
 		return;
@@ -1204,14 +1714,44 @@ ExecMemoizeEstimate(MemoizeState *node, ParallelContext *pcxt)
 /* ----------------------------------------------------------------
  *		ExecMemoizeInitializeDSM
  *
- *		Initialize DSM space for memoize statistics.
+ *		Initialize DSM space for memoize statistics and create the
+ *		shared cache.
  * ----------------------------------------------------------------
  */
 void
 ExecMemoizeInitializeDSM(MemoizeState *node, ParallelContext *pcxt)
 {
+	dsa_area   *area = node->ss.ps.state->es_query_dsa;
 	Size		size;
 
+	if (area != NULL && ExecMemoizeUseSharedCache(node, pcxt))
+	{
+		SharedMemoizeCache *cache;
+
+		/* Detach from the cache of an earlier execution of the Gather */
+		ExecShutdownMemoize(node);
+
+		/* Split our memory budget between the local and the shared cache */
+		node->mem_limit = get_hash_memory_limit() / 2;
+
+		cache = shm_toc_allocate(pcxt->toc, sizeof(SharedMemoizeCache));
+		cache->mem_limit = get_hash_memory_limit() / 2;
+		pg_atomic_init_u64(&cache->mem_used, 0);
+		pg_atomic_init_u64(&cache->clock, 0);
+		pg_atomic_init_flag(&cache->evicting);
+		cache->oldest_used = 0;
+
+		node->shared_area = area;
+		node->shared_hash = dshash_create(area, &shared_memoize_params, area);
+		cache->handle = dshash_get_hash_table_handle(node->shared_hash);
+		node->shared_cache = cache;
+		node->shared_cache_used = true;
+
+		shm_toc_insert(pcxt->toc,
+					   PARALLEL_KEY_MEMOIZE_CACHE(node->ss.ps.plan->plan_node_id),
+					   cache);
+	}
+
 	/* don't need this if not instrumenting or no workers */
 	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
 		return;
@@ -1226,17 +1766,84 @@ ExecMemoizeInitializeDSM(MemoizeState *node, ParallelContext *pcxt)
 				   node->shared_info);
 }
 
+/* ----------------------------------------------------------------
+ *		ExecMemoizeReInitializeDSM
+ *
+ *		Empty the shared cache before a fresh scan.
+ * ----------------------------------------------------------------
+ */
+void
+ExecMemoizeReInitializeDSM(MemoizeState *node, ParallelContext *pcxt)
+{
+	dshash_seq_status status;
+	SharedMemoizeEntry *entry;
+
+	if (node->shared_hash == NULL)
+		return;
+
+	/* The workers are gone, so no one else can have pinned an entry */
+	shared_cache_unpin(node);
+
+	dshash_seq_init(&status, node->shared_hash, true);
+	while ((entry = dshash_seq_next(&status)) != NULL)
+	{
+		shared_cache_free_entry(node, entry);
+		dshash_delete_current(&status);
+	}
+	dshash_seq_term(&status);
+
+	node->shared_cache->oldest_used = pg_atomic_read_u64(&node->shared_cache->clock);
+}
+
 /* ----------------------------------------------------------------
  *		ExecMemoizeInitializeWorker
  *
- *		Attach worker to DSM space for memoize statistics.
+ *		Attach worker to DSM space for memoize statistics and to the
+ *		shared cache.
  * ----------------------------------------------------------------
  */
 void
 ExecMemoizeInitializeWorker(MemoizeState *node, ParallelWorkerContext *pwcxt)
 {
-	node->shared_info =
-		shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
+	int			plan_node_id = node->ss.ps.plan->plan_node_id;
+	SharedMemoizeCache *cache;
+
+	node->shared_info = shm_toc_lookup(pwcxt->toc, plan_node_id, true);
+
+	cache = shm_toc_lookup(pwcxt->toc,
+						   PARALLEL_KEY_MEMOIZE_CACHE(plan_node_id), true);
+	if (cache != NULL)
+	{
+		dsa_area   *area = node->ss.ps.state->es_query_dsa;
+
+		node->shared_area = area;
+		node->shared_hash = dshash_attach(area, &shared_memoize_params,
+										  cache->handle, area);
+		node->shared_cache = cache;
+		node->shared_cache_used = true;
+		node->mem_limit = get_hash_memory_limit() / 2;
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecShutdownMemoize
+ *
+ *		Detach from the shared cache.  This must happen before the
+ *		DSA area it lives in goes away, so we can't wait for
+ *		ExecEndMemoize.
+ * ----------------------------------------------------------------
+ */
+void
+ExecShutdownMemoize(MemoizeState *node)
+{
+	if (node->shared_hash != NULL)
+	{
+		shared_cache_unpin(node);
+		dshash_detach(node->shared_hash);
+		node->shared_hash = NULL;
+		node->shared_cache = NULL;
+		node->shared_area = NULL;
+	}
 }
 
 /* ----------------------------------------------------------------
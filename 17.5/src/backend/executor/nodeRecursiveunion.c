@@ -6,6 +6,19 @@
  * To implement UNION (without ALL), we need a hashtable that stores tuples
  * already seen.  The hash key is computed from the grouping columns.
  *
+ * The hashtable must not grow beyond hash_mem.  Once it is full, we keep
+ * using it to discard tuples it already holds, but any other tuple is set
+ * aside in one of several partitions chosen by hash value, as in nodeAgg.c.
+ * Each partition also remembers the tuples admitted to it so far.  When a
+ * generation of the recursion (or the non-recursive term) is complete, the
+ * set-aside tuples of each partition are checked against its admitted
+ * tuples, one partition at a time in a separate hash table, and the new ones
+ * are added to the next working table and returned.  So tuples that arrive
+ * after the table fills come out at the end of their generation rather than
+ * immediately, which doesn't matter since UNION promises no order.  Each
+ * check reads the partition's admitted tuples again, so a spilled recursion
+ * costs more per generation than one that fits, but it stays within memory.
+ *
  *
  * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -19,11 +32,20 @@
 #include "postgres.h"
 
 #include "executor/executor.h"
+#include "executor/nodeAgg.h"
 #include "executor/nodeRecursiveunion.h"
 #include "miscadmin.h"
 #include "utils/memutils.h"
 
 
+static bool recursive_union_admit(RecursiveUnionState *rustate,
+								  TupleTableSlot *slot);
+static void recursive_union_enter_spill_mode(RecursiveUnionState *rustate);
+static bool recursive_union_decide(RecursiveUnionState *rustate,
+								   Tuplestorestate *target);
+static TupleTableSlot *recursive_union_next_decided(RecursiveUnionState *rustate);
+static void recursive_union_reset_spill(RecursiveUnionState *rustate);
+
 
 /*
  * Initialize the hash table to empty.
@@ -33,10 +55,24 @@ build_hash_table(RecursiveUnionState *rustate)
 {
 	RecursiveUnion *node = (RecursiveUnion *) rustate->ps.plan;
 	TupleDesc	desc = ExecGetResultType(outerPlanState(rustate));
+	Size		hashentrysize;
+	long		nbuckets;
 
 	Assert(node->numCols > 0);
 	Assert(node->numGroups > 0);
 
+	/*
+	 * Decide how much memory the table may use before spilling, and don't
+	 * make the initial table bigger than that.
+	 */
+	hashentrysize = hash_agg_entry_size(0, node->plan.plan_width, 0);
+	hash_agg_set_limits(hashentrysize, node->numGroups, 0,
+						&rustate->hash_mem_limit,
+						&rustate->hash_ngroups_limit,
+						NULL);
+	nbuckets = hash_choose_num_buckets(hashentrysize, node->numGroups,
+									   rustate->hash_mem_limit);
+
 	rustate->hashtable = BuildTupleHashTableExt(&rustate->ps,
 												desc,
 												node->numCols,
@@ -44,7 +80,7 @@ build_hash_table(RecursiveUnionState *rustate)
 												rustate->eqfuncoids,
 												rustate->hashfunctions,
 												node->dupCollations,
-												node->numGroups,
+												nbuckets,
 												0,
 												rustate->ps.state->es_query_cxt,
 												rustate->tableContext,
@@ -52,6 +88,209 @@ build_hash_table(RecursiveUnionState *rustate)
 												false);
 }
 
+/*
+ * Check a tuple against the tuples already returned.  Returns true if it is
+ * new and should be returned now, false if it is a duplicate or has been set
+ * aside for recursive_union_decide().
+ */
+static bool
+recursive_union_admit(RecursiveUnionState *rustate, TupleTableSlot *slot)
+{
+	bool		isnew;
+	uint32		hash;
+	int			partition;
+	Tuplestorestate *pending;
+
+	if (!rustate->hash_spill_mode)
+	{
+		/* Find or build hashtable entry for this tuple's group */
+		LookupTupleHashEntry(rustate->hashtable, slot, &isnew, NULL);
+		/* Must reset temp context after each hashtable lookup */
+		MemoryContextReset(rustate->tempContext);
+
+		if (isnew)
+		{
+			Size		meta_mem;
+			Size		hashkey_mem;
+
+			/* Stop adding groups once the table has reached its limits */
+			rustate->hash_ngroups_current++;
+			meta_mem = rustate->hashtable->hashtab->size * sizeof(TupleHashEntryData);
+			hashkey_mem = MemoryContextMemAllocated(rustate->tableContext, true);
+			if (meta_mem + hashkey_mem > rustate->hash_mem_limit ||
+				rustate->hash_ngroups_current > rustate->hash_ngroups_limit)
+				recursive_union_enter_spill_mode(rustate);
+		}
+		return isnew;
+	}
+
+	/* Discard the tuple if the hashtable has it, else set it aside */
+	if (LookupTupleHashEntry(rustate->hashtable, slot, NULL, &hash) != NULL)
+	{
+		MemoryContextReset(rustate->tempContext);
+		return false;
+	}
+	MemoryContextReset(rustate->tempContext);
+
+	partition = hash >> rustate->hash_spill_shift;
+	pending = rustate->hash_pending[partition];
+	if (pending == NULL)
+	{
+		MemoryContext oldcontext;
+		int			spill_mem = Max(work_mem / rustate->hash_npartitions, 64);
+
+		oldcontext = MemoryContextSwitchTo(rustate->ps.state->es_query_cxt);
+		pending = tuplestore_begin_heap(false, false, spill_mem);
+		rustate->hash_pending[partition] = pending;
+		rustate->hash_seen[partition] =
+			tuplestore_begin_heap(false, false, spill_mem);
+		rustate->hash_spill_partitions++;
+		MemoryContextSwitchTo(oldcontext);
+	}
+	tuplestore_puttupleslot(pending, slot);
+
+	return false;
+}
+
+/*
+ * Stop adding new groups to the hash table, and set up the partitions that
+ * tuples not in it will go to instead.
+ */
+static void
+recursive_union_enter_spill_mode(RecursiveUnionState *rustate)
+{
+	RecursiveUnion *node = (RecursiveUnion *) rustate->ps.plan;
+	MemoryContext oldcontext;
+	int			partition_bits;
+
+	Assert(!rustate->hash_spill_mode);
+
+	rustate->hash_spill_mode = true;
+	rustate->hash_npartitions =
+		hash_choose_num_partitions(node->numGroups,
+								   hash_agg_entry_size(0, node->plan.plan_width, 0),
+								   0, &partition_bits);
+	Assert(partition_bits > 0);
+	rustate->hash_spill_shift = 32 - partition_bits;
+
+	oldcontext = MemoryContextSwitchTo(rustate->ps.state->es_query_cxt);
+	rustate->hash_seen = palloc0(sizeof(Tuplestorestate *) *
+								 rustate->hash_npartitions);
+	rustate->hash_pending = palloc0(sizeof(Tuplestorestate *) *
+									rustate->hash_npartitions);
+	rustate->spill_output = tuplestore_begin_heap(false, false, work_mem);
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Check the tuples set aside since the last call against the tuples admitted
+ * earlier, partition by partition.  The new ones are added to the target
+ * tuplestore and to spill_output to be returned.  Returns true if there were
+ * any.
+ */
+static bool
+recursive_union_decide(RecursiveUnionState *rustate, Tuplestorestate *target)
+{
+	TupleTableSlot *slot = rustate->spill_slot;
+	bool		admitted = false;
+
+	if (!rustate->hash_spill_mode)
+		return false;
+
+	for (int i = 0; i < rustate->hash_npartitions; i++)
+	{
+		Tuplestorestate *pending = rustate->hash_pending[i];
+		Tuplestorestate *seen = rustate->hash_seen[i];
+		bool		isnew;
+
+		if (pending == NULL || tuplestore_tuple_count(pending) == 0)
+			continue;
+
+		CHECK_FOR_INTERRUPTS();
+
+		/* Load the partition's admitted tuples ... */
+		MemoryContextReset(rustate->spillContext);
+		ResetTupleHashTable(rustate->spilltable);
+		tuplestore_rescan(seen);
+		while (tuplestore_gettupleslot(seen, true, false, slot))
+		{
+			LookupTupleHashEntry(rustate->spilltable, slot, &isnew, NULL);
+			MemoryContextReset(rustate->tempContext);
+		}
+
+		/* ... and admit whichever set-aside tuples aren't among them */
+		while (tuplestore_gettupleslot(pending, true, false, slot))
+		{
+			LookupTupleHashEntry(rustate->spilltable, slot, &isnew, NULL);
+			MemoryContextReset(rustate->tempContext);
+			if (!isnew)
+				continue;
+
+			tuplestore_puttupleslot(seen, slot);
+			tuplestore_puttupleslot(target, slot);
+			tuplestore_puttupleslot(rustate->spill_output, slot);
+			admitted = true;
+		}
+		tuplestore_clear(pending);
+	}
+
+	ExecClearTuple(slot);
+	MemoryContextReset(rustate->spillContext);
+	ResetTupleHashTable(rustate->spilltable);
+
+	rustate->spill_returning = admitted;
+	return admitted;
+}
+
+/*
+ * Return the next tuple admitted by recursive_union_decide(), or NULL once
+ * they have all been returned.
+ */
+static TupleTableSlot *
+recursive_union_next_decided(RecursiveUnionState *rustate)
+{
+	TupleTableSlot *slot = rustate->spill_slot;
+
+	if (tuplestore_gettupleslot(rustate->spill_output, true, false, slot))
+		return slot;
+
+	tuplestore_clear(rustate->spill_output);
+	rustate->spill_returning = false;
+	return NULL;
+}
+
+/*
+ * Release the spill partitions, and start adding groups to the (empty) hash
+ * table again.
+ */
+static void
+recursive_union_reset_spill(RecursiveUnionState *rustate)
+{
+	if (rustate->hash_spill_mode)
+	{
+		for (int i = 0; i < rustate->hash_npartitions; i++)
+		{
+			if (rustate->hash_pending[i] != NULL)
+			{
+				tuplestore_end(rustate->hash_pending[i]);
+				tuplestore_end(rustate->hash_seen[i]);
+			}
+		}
+		pfree(rustate->hash_pending);
+		pfree(rustate->hash_seen);
+		tuplestore_end(rustate->spill_output);
+	}
+
+	rustate->hash_spill_mode = false;
+	rustate->hash_npartitions = 0;
+	rustate->hash_pending = NULL;
+	rustate->hash_seen = NULL;
+	rustate->spill_output = NULL;
+	rustate->spill_returning = false;
+	rustate->inner_done = false;
+	rustate->hash_ngroups_current = 0;
+}
+
 
 /* ----------------------------------------------------------------
  *		ExecRecursiveUnion(node)
@@ -79,10 +318,17 @@ ExecRecursiveUnion(PlanState *pstate)
 	PlanState  *innerPlan = innerPlanState(node);
 	RecursiveUnion *plan = (RecursiveUnion *) node->ps.plan;
 	TupleTableSlot *slot;
-	bool		isnew;
 
 	CHECK_FOR_INTERRUPTS();
 
+	/* Return any set-aside tuples that turned out to be new */
+	if (node->spill_returning)
+	{
+		slot = recursive_union_next_decided(node);
+		if (!TupIsNull(slot))
+			return slot;
+	}
+
 	/* 1. Evaluate non-recursive term */
 	if (!node->recursing)
 	{
@@ -91,30 +337,46 @@ ExecRecursiveUnion(PlanState *pstate)
 			slot = ExecProcNode(outerPlan);
 			if (TupIsNull(slot))
 				break;
-			if (plan->numCols > 0)
-			{
-				/* Find or build hashtable entry for this tuple's group */
-				LookupTupleHashEntry(node->hashtable, slot, &isnew, NULL);
-				/* Must reset temp context after each hashtable lookup */
-				MemoryContextReset(node->tempContext);
-				/* Ignore tuple if already seen */
-				if (!isnew)
-					continue;
-			}
+			/* Ignore tuple if already seen, or if we can't tell yet */
+			if (plan->numCols > 0 && !recursive_union_admit(node, slot))
+				continue;
 			/* Each non-duplicate tuple goes to the working table ... */
 			tuplestore_puttupleslot(node->working_table, slot);
 			/* ... and to the caller */
 			return slot;
 		}
 		node->recursing = true;
+
+		/* Settle any tuples we couldn't tell about */
+		if (recursive_union_decide(node, node->working_table))
+			return recursive_union_next_decided(node);
 	}
 
 	/* 2. Execute recursive term */
 	for (;;)
 	{
-		slot = ExecProcNode(innerPlan);
+		if (node->inner_done)
+			slot = NULL;
+		else
+			slot = ExecProcNode(innerPlan);
 		if (TupIsNull(slot))
 		{
+			/*
+			 * Settle any tuples of this generation that we couldn't tell
+			 * about, returning the new ones before moving on.  Don't run
+			 * the recursive term again when we come back here.
+			 */
+			if (!node->inner_done)
+			{
+				node->inner_done = true;
+				if (recursive_union_decide(node, node->intermediate_table))
+				{
+					node->intermediate_empty = false;
+					return recursive_union_next_decided(node);
+				}
+			}
+			node->inner_done = false;
+
 			/* Done if there's nothing in the intermediate table */
 			if (node->intermediate_empty)
 				break;
@@ -138,16 +400,9 @@ ExecRecursiveUnion(PlanState *pstate)
 			continue;
 		}
 
-		if (plan->numCols > 0)
-		{
-			/* Find or build hashtable entry for this tuple's group */
-			LookupTupleHashEntry(node->hashtable, slot, &isnew, NULL);
-			/* Must reset temp context after each hashtable lookup */
-			MemoryContextReset(node->tempContext);
-			/* Ignore tuple if already seen */
-			if (!isnew)
-				continue;
-		}
+		/* Ignore tuple if already seen, or if we can't tell yet */
+		if (plan->numCols > 0 && !recursive_union_admit(node, slot))
+			continue;
 
 		/* Else, tuple is good; stash it in intermediate table ... */
 		node->intermediate_empty = false;
@@ -185,6 +440,21 @@ ExecInitRecursiveUnion(RecursiveUnion *node, EState *estate, int eflags)
 	rustate->hashtable = NULL;
 	rustate->tempContext = NULL;
 	rustate->tableContext = NULL;
+	rustate->hash_mem_limit = 0;
+	rustate->hash_ngroups_limit = 0;
+	rustate->hash_ngroups_current = 0;
+	rustate->hash_spill_mode = false;
+	rustate->hash_npartitions = 0;
+	rustate->hash_spill_shift = 0;
+	rustate->hash_spill_partitions = 0;
+	rustate->hash_seen = NULL;
+	rustate->hash_pending = NULL;
+	rustate->spilltable = NULL;
+	rustate->spillContext = NULL;
+	rustate->spill_output = NULL;
+	rustate->spill_slot = NULL;
+	rustate->spill_returning = false;
+	rustate->inner_done = false;
 
 	/* initialize processing state */
 	rustate->recursing = false;
@@ -196,7 +466,8 @@ ExecInitRecursiveUnion(RecursiveUnion *node, EState *estate, int eflags)
 	 * If hashing, we need a per-tuple memory context for comparisons, and a
 	 * longer-lived context to store the hash table.  The table can't just be
 	 * kept in the per-query context because we want to be able to throw it
-	 * away when rescanning.
+	 * away when rescanning.  Likewise for the table used to check one spill
+	 * partition at a time.
 	 */
 	if (node->numCols > 0)
 	{
@@ -208,6 +479,10 @@ ExecInitRecursiveUnion(RecursiveUnion *node, EState *estate, int eflags)
 			AllocSetContextCreate(CurrentMemoryContext,
 								  "RecursiveUnion hash table",
 								  ALLOCSET_DEFAULT_SIZES);
+		rustate->spillContext =
+			AllocSetContextCreate(CurrentMemoryContext,
+								  "RecursiveUnion spill hash table",
+								  ALLOCSET_DEFAULT_SIZES);
 	}
 
 	/*
@@ -248,15 +523,33 @@ ExecInitRecursiveUnion(RecursiveUnion *node, EState *estate, int eflags)
 
 	/*
 	 * If hashing, precompute fmgr lookup data for inner loop, and create the
-	 * hash table.
+	 * hash tables and a slot for reading back spilled tuples.
 	 */
 	if (node->numCols > 0)
 	{
+		TupleDesc	desc = ExecGetResultType(outerPlanState(rustate));
+
 		execTuplesHashPrepare(node->numCols,
 							  node->dupOperators,
 							  &rustate->eqfuncoids,
 							  &rustate->hashfunctions);
 		build_hash_table(rustate);
+
+		rustate->spilltable = BuildTupleHashTableExt(&rustate->ps,
+													 desc,
+													 node->numCols,
+													 node->dupColIdx,
+													 rustate->eqfuncoids,
+													 rustate->hashfunctions,
+													 node->dupCollations,
+													 256,
+													 0,
+													 estate->es_query_cxt,
+													 rustate->spillContext,
+													 rustate->tempContext,
+													 false);
+		rustate->spill_slot = ExecInitExtraTupleSlot(estate, desc,
+													 &TTSOpsMinimalTuple);
 	}
 
 	return rustate;
@@ -274,12 +567,15 @@ ExecEndRecursiveUnion(RecursiveUnionState *node)
 	/* Release tuplestores */
 	tuplestore_end(node->working_table);
 	tuplestore_end(node->intermediate_table);
+	recursive_union_reset_spill(node);
 
-	/* free subsidiary stuff including hashtable */
+	/* free subsidiary stuff including hashtables */
 	if (node->tempContext)
 		MemoryContextDelete(node->tempContext);
 	if (node->tableContext)
 		MemoryContextDelete(node->tableContext);
+	if (node->spillContext)
+		MemoryContextDelete(node->spillContext);
 
 	/*
 	 * close down subplans
@@ -323,6 +619,9 @@ ExecReScanRecursiveUnion(RecursiveUnionState *node)
 	if (plan->numCols > 0)
 		ResetTupleHashTable(node->hashtable);
 
+	/* and forget any spilled tuples */
+	recursive_union_reset_spill(node);
+
 	/* reset processing state */
 	node->recursing = false;
 	node->intermediate_empty = true;
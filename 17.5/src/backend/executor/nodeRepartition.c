@@ -0,0 +1,846 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeRepartition.c
+ *	  Routines to redistribute tuples among the participants of a
+ *	  parallel plan.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeRepartition.c
+ *
+ * A Repartition node sits below a Gather or Gather Merge node, and makes
+ * sure that all tuples with equal values in its hash key columns are
+ * returned by the same participant.  Plan nodes above it, such as a
+ * WindowAgg whose PARTITION BY clause includes the hash key, can then work
+ * on complete groups of rows within each participant, whereas with a plain
+ * partial scan each participant would see an arbitrary subset of them.
+ *
+ * The redistribution happens in two phases.  First, each participant runs
+ * its share of the subplan to completion and writes each tuple to one of
+ * several shared tuplestores, chosen by hashing the key columns.  Once all
+ * participants are done with that, each participant claims whole
+ * tuplestores one at a time and returns their tuples.  There is one
+ * tuplestore per planned participant, but since they are claimed on
+ * demand, it doesn't matter if fewer participants turn up.  This means the
+ * node doesn't produce any tuples before the subplan is exhausted, but it
+ * avoids the deadlocks that participants sending tuples directly to each
+ * other over bounded queues would be prone to.
+ *
+ * Participants that attach after the first phase is over don't run the
+ * subplan at all: since it must be parallel-aware, the others have already
+ * consumed all of its tuples.  This is the same reasoning as for late
+ * arrivals in a Parallel Hash build.
+ *
+ * In range mode, used for ORDER BY, the tuples are distributed among
+ * ranges of the first sort column instead, with the range bounds taken from
+ * the column's histogram at plan time.  The participants then claim ranges
+ * and sort them as the workers of one parallel tuplesort per range, whose
+ * Sharedsort lives in the DSM segment too.  There are several ranges per
+ * planned participant, so that participants that finish early can help with
+ * the rest.  Once all ranges are sorted, a single participant, the one
+ * elected by the barrier, takes over the sorted run of each range in turn
+ * and returns the tuples of all ranges in order, while the others return
+ * nothing.  A plain Gather above thus receives the tuples in sort order
+ * through one tuple queue, without having to merge anything.
+ *
+ * Outside of a parallel query, the node just passes through the tuples of
+ * its subplan, sorting them all in range mode.
+ *
+ * Partition-wise parallel joins are not supported.  They would need both
+ * join inputs redistributed by compatible hash functions, and the matching
+ * partitions of both sides claimed by the same participant, whereas each
+ * Repartition node claims its partitions on its own.  The join above would
+ * also have to be rebuilt for each partition a participant claims.
+ *
+ *-------------------------------------------------------------------------
+ */
+/*
+ * INTERFACE ROUTINES
+ *		ExecRepartition			- return the next tuple of our partitions
+ *		ExecInitRepartition		- initialize node and subnodes
+ *		ExecEndRepartition		- shutdown node and subnodes
+ *		ExecReScanRepartition	- rescan the repartition node
+ *
+ *		ExecRepartitionEstimate		estimates DSM space needed for parallel plan
+ *		ExecRepartitionInitializeDSM initialize DSM for parallel plan
+ *		ExecRepartitionReInitializeDSM reinitialize DSM for fresh scan
+ *		ExecRepartitionInitializeWorker attach to DSM info in parallel worker
+ *		ExecShutdownRepartition	detach from the shared state
+ */
+#include "postgres.h"
+
+#include "access/parallel.h"
+#include "common/hashfn.h"
+#include "executor/executor.h"
+#include "executor/nodeRepartition.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/barrier.h"
+#include "utils/lsyscache.h"
+#include "utils/sharedtuplestore.h"
+#include "utils/sortsupport.h"
+#include "utils/tuplesort.h"
+#include "utils/wait_event.h"
+
+/* Phases of RepartitionShared->barrier */
+#define REPART_PHASE_WRITE		0	/* writing out the subplan's tuples */
+#define REPART_PHASE_READ		1	/* reading back whole partitions */
+#define REPART_PHASE_EMIT		2	/* in range mode, returning the ranges */
+
+#define RepartitionIsRanged(plan)	((plan)->numSortCols > 0)
+
+/*
+ * Shared state of a Repartition node, stored in the DSM segment under the
+ * plan_node_id.  The shared tuplestores follow the fixed part, each taking
+ * up sts_size bytes.  In range mode, they are followed by the Sharedsort of
+ * each range, each taking up sortshared_size bytes.
+ */
+typedef struct RepartitionShared
+{
+	Barrier		barrier;		/* for waiting until all tuples are written */
+	SharedFileSet fileset;		/* space for the tuplestores' files */
+	pg_atomic_uint32 next_part; /* next partition to be claimed */
+	int			nparts;			/* number of partitions */
+	int			nparticipants;	/* number of planned participants */
+	Size		sts_size;		/* space for each tuplestore */
+	Size		sortshared_size;	/* space for each Sharedsort, or 0 */
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} RepartitionShared;
+
+#define RepartitionSharedTuplestore(shared, i) \
+	((SharedTuplestore *) ((shared)->data + (i) * (shared)->sts_size))
+#define RepartitionSharedSort(shared, i) \
+	((Sharedsort *) ((shared)->data + (shared)->nparts * (shared)->sts_size + \
+					 (i) * (shared)->sortshared_size))
+
+static int	ExecRepartitionNumParts(Repartition *plan, int nparticipants);
+static int	ExecRepartitionFindRange(RepartitionState *node,
+									 TupleTableSlot *slot);
+static void ExecRepartitionWritePartitions(RepartitionState *node);
+static void ExecRepartitionWrite(RepartitionState *node);
+static bool ExecRepartitionSortRanges(RepartitionState *node);
+static Tuplesortstate *ExecRepartitionBeginSort(RepartitionState *node,
+												SortCoordinate coordinate);
+static void ExecRepartitionInitRanges(RepartitionState *node);
+static void ExecRepartitionInitTuplestores(RepartitionState *node,
+										   RepartitionShared *shared);
+static void ExecRepartitionResetShared(RepartitionState *node,
+									   RepartitionShared *shared);
+
+
+/*
+ * Return the number of partitions to use for the given number of planned
+ * participants.
+ */
+static int
+ExecRepartitionNumParts(Repartition *plan, int nparticipants)
+{
+	if (RepartitionIsRanged(plan))
+		return Min(list_length(plan->rangeBounds) + 1,
+				   nparticipants * REPARTITION_RANGES_PER_PARTICIPANT);
+
+	return nparticipants;
+}
+
+/*
+ * Find the range that the tuple in the slot belongs to, by binary search
+ * over the bounds.  A range includes its upper bound, so that all tuples
+ * with equal sort keys end up in the same range.
+ */
+static int
+ExecRepartitionFindRange(RepartitionState *node, TupleTableSlot *slot)
+{
+	Repartition *plan = (Repartition *) node->ps.plan;
+	Datum		datum;
+	bool		isnull;
+	int			lo = 0;
+	int			hi = node->nparts - 1;
+
+	datum = slot_getattr(slot, plan->sortColIdx[0], &isnull);
+
+	/* find the first bound that doesn't sort before the datum */
+	while (lo < hi)
+	{
+		int			mid = (lo + hi) / 2;
+
+		if (ApplySortComparator(node->range_bounds[mid], false,
+								datum, isnull,
+								node->range_sortkey) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+
+/*
+ * Run the subplan to completion, distributing its tuples among the
+ * partitions.
+ */
+static void
+ExecRepartitionWritePartitions(RepartitionState *node)
+{
+	PlanState  *outerNode = outerPlanState(node);
+	ExprContext *econtext = node->ps.ps_ExprContext;
+
+	for (;;)
+	{
+		TupleTableSlot *slot;
+		MinimalTuple tuple;
+		bool		shouldFree;
+		int			part;
+
+		slot = ExecProcNode(outerNode);
+		if (TupIsNull(slot))
+			break;
+
+		if (node->range_sortkey != NULL)
+			part = ExecRepartitionFindRange(node, slot);
+		else
+		{
+			bool		isnull;
+			uint32		hashvalue;
+
+			ResetExprContext(econtext);
+			econtext->ecxt_outertuple = slot;
+			hashvalue = DatumGetUInt32(ExecEvalExprSwitchContext(node->hash_expr,
+																 econtext,
+																 &isnull));
+			Assert(!isnull);
+			part = murmurhash32(hashvalue) % node->nparts;
+		}
+
+		tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+		sts_puttuple(node->accessors[part], NULL, tuple);
+		if (shouldFree)
+			heap_free_minimal_tuple(tuple);
+	}
+
+	for (int i = 0; i < node->nparts; i++)
+		sts_end_write(node->accessors[i]);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRepartitionWrite
+ *
+ *		Write out the subplan's tuples, and wait until the other
+ *		participants have done so too.  Unless we arrived too late for
+ *		that, in which case there's nothing to do.
+ * ----------------------------------------------------------------
+ */
+static void
+ExecRepartitionWrite(RepartitionState *node)
+{
+	RepartitionShared *shared = node->shared;
+
+	if (BarrierAttach(&shared->barrier) == REPART_PHASE_WRITE)
+	{
+		ExecRepartitionWritePartitions(node);
+
+		/* Wait for the other participants to finish writing */
+		BarrierArriveAndWait(&shared->barrier,
+							 WAIT_EVENT_REPARTITION_WRITE);
+	}
+
+	/* We won't need the barrier again */
+	BarrierDetach(&shared->barrier);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRepartitionSortRanges
+ *
+ *		In range mode, write out the subplan's tuples, then help with
+ *		sorting the ranges, and wait until all of them are sorted.
+ *		Participants that arrive too late for a phase skip it.
+ *
+ *		Returns true if we have been elected to return the tuples of all
+ *		ranges.
+ * ----------------------------------------------------------------
+ */
+static bool
+ExecRepartitionSortRanges(RepartitionState *node)
+{
+	RepartitionShared *shared = node->shared;
+	bool		elected = false;
+	int			phase;
+
+	phase = BarrierAttach(&shared->barrier);
+
+	if (phase == REPART_PHASE_WRITE)
+	{
+		ExecRepartitionWritePartitions(node);
+
+		/* Wait for the other participants to finish writing */
+		BarrierArriveAndWait(&shared->barrier,
+							 WAIT_EVENT_REPARTITION_WRITE);
+		phase = REPART_PHASE_READ;
+	}
+
+	if (phase == REPART_PHASE_READ)
+	{
+		for (;;)
+		{
+			SortCoordinateData coordinate;
+			Tuplesortstate *tuplesortstate;
+			TupleTableSlot *slot = node->ps.ps_ResultTupleSlot;
+			MinimalTuple tuple;
+			uint32		part;
+
+			/* Claim the next range, if any are left */
+			part = pg_atomic_fetch_add_u32(&shared->next_part, 1);
+			if (part >= shared->nparts)
+				break;
+
+			/* Sort it as the only worker of the range's parallel sort */
+			coordinate.isWorker = true;
+			coordinate.nParticipants = -1;
+			coordinate.sharedsort = RepartitionSharedSort(shared, part);
+			tuplesortstate = ExecRepartitionBeginSort(node, &coordinate);
+
+			sts_begin_parallel_scan(node->accessors[part]);
+			while ((tuple = sts_parallel_scan_next(node->accessors[part],
+												   NULL)) != NULL)
+			{
+				ExecStoreMinimalTuple(tuple, slot, false);
+				tuplesort_puttupleslot(tuplesortstate, slot);
+			}
+			sts_end_parallel_scan(node->accessors[part]);
+
+			tuplesort_performsort(tuplesortstate);
+			tuplesort_end(tuplesortstate);
+		}
+		ExecClearTuple(node->ps.ps_ResultTupleSlot);
+
+		/* Wait for the other participants to finish sorting */
+		elected = BarrierArriveAndWait(&shared->barrier,
+									   WAIT_EVENT_REPARTITION_SORT);
+		Assert(BarrierPhase(&shared->barrier) == REPART_PHASE_EMIT);
+	}
+
+	/* We won't need the barrier again */
+	BarrierDetach(&shared->barrier);
+
+	return elected;
+}
+
+/*
+ * Begin sorting in range mode, with the given coordinate if sorting a range
+ * in parallel.
+ */
+static Tuplesortstate *
+ExecRepartitionBeginSort(RepartitionState *node, SortCoordinate coordinate)
+{
+	Repartition *plan = (Repartition *) node->ps.plan;
+
+	return tuplesort_begin_heap(ExecGetResultType(outerPlanState(node)),
+								plan->numSortCols,
+								plan->sortColIdx,
+								plan->sortOperators,
+								plan->collations,
+								plan->nullsFirst,
+								work_mem,
+								coordinate,
+								TUPLESORT_NONE);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRepartition
+ *
+ *		Returns the tuples of the partitions this participant has
+ *		claimed, or in range mode the tuples of all ranges if this
+ *		participant has been elected to return them.  On the first call,
+ *		writes out the subplan's tuples first.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecRepartition(PlanState *pstate)
+{
+	RepartitionState *node = castNode(RepartitionState, pstate);
+	RepartitionShared *shared = node->shared;
+	TupleTableSlot *slot = node->ps.ps_ResultTupleSlot;
+
+	CHECK_FOR_INTERRUPTS();
+
+	/*
+	 * If not running in parallel, there's nobody to repartition with.  In
+	 * range mode, we still need to sort, though.
+	 */
+	if (shared == NULL)
+	{
+		if (!RepartitionIsRanged((Repartition *) node->ps.plan))
+			return ExecProcNode(outerPlanState(node));
+
+		if (!node->written)
+		{
+			Tuplesortstate *tuplesortstate = ExecRepartitionBeginSort(node,
+																	  NULL);
+
+			for (;;)
+			{
+				TupleTableSlot *outerslot;
+
+				outerslot = ExecProcNode(outerPlanState(node));
+				if (TupIsNull(outerslot))
+					break;
+				tuplesort_puttupleslot(tuplesortstate, outerslot);
+			}
+			tuplesort_performsort(tuplesortstate);
+			node->tuplesortstate = tuplesortstate;
+			node->written = true;
+		}
+
+		(void) tuplesort_gettupleslot((Tuplesortstate *) node->tuplesortstate,
+									  true, false, slot, NULL);
+		return slot;
+	}
+
+	/*
+	 * In range mode, sort all ranges in parallel first.  Then, if we are the
+	 * participant elected to return them, read each sorted range in turn as
+	 * the leader of its parallel sort.
+	 */
+	if (node->range_sortkey != NULL)
+	{
+		if (!node->written)
+		{
+			if (ExecRepartitionSortRanges(node))
+				node->next_range = 0;
+			else
+				node->next_range = shared->nparts;
+			node->written = true;
+		}
+
+		for (;;)
+		{
+			if (node->tuplesortstate == NULL)
+			{
+				SortCoordinateData coordinate;
+				Tuplesortstate *tuplesortstate;
+
+				if (node->next_range >= shared->nparts)
+					return ExecClearTuple(slot);
+
+				coordinate.isWorker = false;
+				coordinate.nParticipants = 1;
+				coordinate.sharedsort = RepartitionSharedSort(shared,
+															  node->next_range);
+				tuplesortstate = ExecRepartitionBeginSort(node, &coordinate);
+				tuplesort_performsort(tuplesortstate);
+				node->tuplesortstate = tuplesortstate;
+			}
+
+			if (tuplesort_gettupleslot((Tuplesortstate *) node->tuplesortstate,
+									   true, false, slot, NULL))
+				return slot;
+
+			tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+			node->tuplesortstate = NULL;
+			node->next_range++;
+		}
+	}
+
+	if (!node->written)
+	{
+		ExecRepartitionWrite(node);
+		node->written = true;
+	}
+
+	for (;;)
+	{
+		MinimalTuple tuple;
+
+		if (node->curpart < 0)
+		{
+			uint32		part;
+
+			/* Claim the next partition, if any are left */
+			part = pg_atomic_fetch_add_u32(&shared->next_part, 1);
+			if (part >= shared->nparts)
+				return ExecClearTuple(slot);
+
+			node->curpart = part;
+			sts_begin_parallel_scan(node->accessors[part]);
+		}
+
+		tuple = sts_parallel_scan_next(node->accessors[node->curpart], NULL);
+		if (tuple != NULL)
+			return ExecStoreMinimalTuple(tuple, slot, false);
+
+		sts_end_parallel_scan(node->accessors[node->curpart]);
+		node->curpart = -1;
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitRepartition
+ * ----------------------------------------------------------------
+ */
+RepartitionState *
+ExecInitRepartition(Repartition *node, EState *estate, int eflags)
+{
+	RepartitionState *state;
+	PlanState  *outerNode;
+
+	/* check for unsupported flags */
+	Assert(!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)));
+
+	state = makeNode(RepartitionState);
+	state->ps.plan = (Plan *) node;
+	state->ps.state = estate;
+	state->ps.ExecProcNode = ExecRepartition;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * create expression context for node, used to compute hash values
+	 */
+	ExecAssignExprContext(estate, &state->ps);
+
+	outerNode = ExecInitNode(outerPlan(node), estate, eflags);
+	outerPlanState(state) = outerNode;
+
+	/*
+	 * Initialize return slot and type.  No need to initialize projection
+	 * info because this node doesn't do projections.
+	 */
+	ExecInitResultTupleSlotTL(&state->ps, &TTSOpsMinimalTuple);
+	state->ps.ps_ProjInfo = NULL;
+
+	/*
+	 * Look up the hash functions and build the hash expression, unless we're
+	 * distributing by range.  The range bounds are set up along with the
+	 * shared state.
+	 */
+	state->hash_expr = NULL;
+	if (!RepartitionIsRanged(node))
+	{
+		FmgrInfo   *hashfunctions;
+
+		hashfunctions = palloc(node->numCols * sizeof(FmgrInfo));
+		for (int i = 0; i < node->numCols; i++)
+		{
+			Oid			left_hashfn;
+			Oid			right_hashfn;
+
+			if (!get_op_hash_functions(node->hashOperators[i],
+									   &left_hashfn, &right_hashfn))
+				elog(ERROR, "could not find hash function for hash operator %u",
+					 node->hashOperators[i]);
+			fmgr_info(left_hashfn, &hashfunctions[i]);
+		}
+
+		state->hash_expr = ExecBuildHash32FromAttrs(ExecGetResultType(outerNode),
+													ExecGetResultSlotOps(outerNode, NULL),
+													hashfunctions,
+													node->hashCollations,
+													node->numCols,
+													node->hashColIdx,
+													&state->ps,
+													0);
+	}
+
+	/* The shared state is set up with the parallel DSM, if any */
+	state->shared = NULL;
+	state->accessors = NULL;
+	state->accessor_cxt = NULL;
+	state->nparts = 0;
+	state->curpart = -1;
+	state->written = false;
+	state->range_sortkey = NULL;
+	state->range_bounds = NULL;
+	state->tuplesortstate = NULL;
+	state->next_range = 0;
+
+	return state;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndRepartition
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndRepartition(RepartitionState *node)
+{
+	ExecShutdownRepartition(node);
+
+	/*
+	 * shut down the subplan
+	 */
+	ExecEndNode(outerPlanState(node));
+}
+
+/* ----------------------------------------------------------------
+ *		ExecReScanRepartition
+ * ----------------------------------------------------------------
+ */
+void
+ExecReScanRepartition(RepartitionState *node)
+{
+	PlanState  *outerPlan = outerPlanState(node);
+
+	ExecShutdownRepartition(node);
+
+	/*
+	 * If we took part in writing out the previous scan's tuples, the workers
+	 * are gone by now, and we can reset the shared state for the next scan.
+	 * Otherwise it's either untouched or is reset by
+	 * ExecRepartitionReInitializeDSM() before the workers are launched again;
+	 * it's not safe to reset it here in that case, as we might be rescanned
+	 * by the first ExecProcNode() call after the workers were launched.
+	 */
+	if (node->shared != NULL && node->written && !IsParallelWorker())
+		ExecRepartitionResetShared(node, node->shared);
+	node->written = false;
+
+	/*
+	 * if chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (outerPlan->chgParam == NULL)
+		ExecReScan(outerPlan);
+}
+
+/* ----------------------------------------------------------------
+ *						Parallel Query Support
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Set up accessors for all the shared tuplestores, creating them if we're
+ * the leader.  Any accessors from a previous scan are freed.
+ */
+static void
+ExecRepartitionInitTuplestores(RepartitionState *node,
+							   RepartitionShared *shared)
+{
+	int			plan_node_id = node->ps.plan->plan_node_id;
+	int			participant = ParallelWorkerNumber + 1;
+	MemoryContext oldcxt;
+
+	node->shared = shared;
+	node->nparts = shared->nparts;
+
+	if (RepartitionIsRanged((Repartition *) node->ps.plan) &&
+		node->range_sortkey == NULL)
+		ExecRepartitionInitRanges(node);
+
+	if (node->accessor_cxt == NULL)
+		node->accessor_cxt = AllocSetContextCreate(CurrentMemoryContext,
+												   "Repartition accessors",
+												   ALLOCSET_SMALL_SIZES);
+	else
+		MemoryContextReset(node->accessor_cxt);
+	oldcxt = MemoryContextSwitchTo(node->accessor_cxt);
+
+	node->accessors = palloc(shared->nparts *
+							 sizeof(SharedTuplestoreAccessor *));
+
+	for (int i = 0; i < shared->nparts; i++)
+	{
+		SharedTuplestore *sts = RepartitionSharedTuplestore(shared, i);
+
+		if (IsParallelWorker())
+			node->accessors[i] = sts_attach(sts, participant,
+											&shared->fileset);
+		else
+		{
+			char		name[MAXPGPATH];
+
+			snprintf(name, sizeof(name), "r%d.p%d", plan_node_id, i);
+			node->accessors[i] = sts_initialize(sts,
+												shared->nparticipants,
+												participant,
+												0,
+												SHARED_TUPLESTORE_SINGLE_PASS,
+												&shared->fileset,
+												name);
+		}
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * Reset the shared state and tuplestores for a fresh scan.  Must only be
+ * called by the leader while no workers are running.
+ */
+static void
+ExecRepartitionResetShared(RepartitionState *node, RepartitionShared *shared)
+{
+	/* Clear the files written by the previous scan */
+	SharedFileSetDeleteAll(&shared->fileset);
+
+	BarrierInit(&shared->barrier, 0);
+	pg_atomic_write_u32(&shared->next_part, 0);
+
+	for (int i = 0; i < shared->nparts && shared->sortshared_size > 0; i++)
+		tuplesort_reset_shared(RepartitionSharedSort(shared, i));
+
+	ExecRepartitionInitTuplestores(node, shared);
+}
+
+/*
+ * Choose the bounds of node->nparts ranges among the planned bounds, and set
+ * up for comparing tuples to them.
+ *
+ * The planned bounds are histogram bounds, so about the same fraction of the
+ * rows lies between each pair of adjacent ones.  We pick evenly spaced ones.
+ */
+static void
+ExecRepartitionInitRanges(RepartitionState *node)
+{
+	Repartition *plan = (Repartition *) node->ps.plan;
+	int			nbounds = list_length(plan->rangeBounds);
+	SortSupport sortkey;
+
+	sortkey = palloc0(sizeof(SortSupportData));
+	sortkey->ssup_cxt = CurrentMemoryContext;
+	sortkey->ssup_collation = plan->collations[0];
+	sortkey->ssup_nulls_first = plan->nullsFirst[0];
+	sortkey->ssup_attno = plan->sortColIdx[0];
+	PrepareSortSupportFromOrderingOp(plan->sortOperators[0], sortkey);
+
+	node->range_bounds = palloc(node->nparts * sizeof(Datum));
+	for (int i = 0; i < node->nparts - 1; i++)
+	{
+		int			idx = (int) (((int64) (i + 1) * (nbounds - 1)) / node->nparts);
+		Const	   *bound = list_nth_node(Const, plan->rangeBounds, idx);
+
+		node->range_bounds[i] = bound->constvalue;
+	}
+	node->range_sortkey = sortkey;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRepartitionEstimate
+ *
+ *		Estimate space required for the shared state and tuplestores.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRepartitionEstimate(RepartitionState *node, ParallelContext *pcxt)
+{
+	int			nparticipants = pcxt->nworkers + 1;
+	int			nparts;
+	Size		size;
+
+	nparts = ExecRepartitionNumParts((Repartition *) node->ps.plan,
+									 nparticipants);
+	size = mul_size(nparts, MAXALIGN(sts_estimate(nparticipants)));
+	if (RepartitionIsRanged((Repartition *) node->ps.plan))
+		size = add_size(size, mul_size(nparts,
+									   MAXALIGN(tuplesort_estimate_shared(1))));
+	size = add_size(size, offsetof(RepartitionShared, data));
+	shm_toc_estimate_chunk(&pcxt->estimator, size);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRepartitionInitializeDSM
+ *
+ *		Set up the shared state and tuplestores.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRepartitionInitializeDSM(RepartitionState *node, ParallelContext *pcxt)
+{
+	RepartitionShared *shared;
+	int			nparticipants = pcxt->nworkers + 1;
+	int			nparts;
+	Size		sts_size = MAXALIGN(sts_estimate(nparticipants));
+	Size		sortshared_size = 0;
+
+	/* Without a DSM segment, we just run the subplan in the leader */
+	if (pcxt->seg == NULL)
+		return;
+
+	/* In range mode, each range is sorted by a single participant */
+	if (RepartitionIsRanged((Repartition *) node->ps.plan))
+		sortshared_size = MAXALIGN(tuplesort_estimate_shared(1));
+
+	nparts = ExecRepartitionNumParts((Repartition *) node->ps.plan,
+									 nparticipants);
+	shared = shm_toc_allocate(pcxt->toc,
+							  offsetof(RepartitionShared, data) +
+							  nparts * (sts_size + sortshared_size));
+	BarrierInit(&shared->barrier, 0);
+	SharedFileSetInit(&shared->fileset, pcxt->seg);
+	pg_atomic_init_u32(&shared->next_part, 0);
+	shared->nparts = nparts;
+	shared->nparticipants = nparticipants;
+	shared->sts_size = sts_size;
+	shared->sortshared_size = sortshared_size;
+	for (int i = 0; i < nparts && sortshared_size > 0; i++)
+		tuplesort_initialize_shared(RepartitionSharedSort(shared, i), 1,
+									pcxt->seg);
+	shm_toc_insert(pcxt->toc, node->ps.plan->plan_node_id, shared);
+
+	ExecRepartitionInitTuplestores(node, shared);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRepartitionReInitializeDSM
+ *
+ *		Reset the shared state before beginning a fresh scan.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRepartitionReInitializeDSM(RepartitionState *node, ParallelContext *pcxt)
+{
+	RepartitionShared *shared;
+
+	if (pcxt->seg == NULL)
+		return;
+
+	shared = shm_toc_lookup(pcxt->toc, node->ps.plan->plan_node_id, false);
+	ExecRepartitionResetShared(node, shared);
+
+	/* A later rescan of this node mustn't reset the shared state again */
+	node->written = false;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRepartitionInitializeWorker
+ *
+ *		Attach to the shared state and tuplestores.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRepartitionInitializeWorker(RepartitionState *node,
+								ParallelWorkerContext *pwcxt)
+{
+	RepartitionShared *shared;
+
+	shared = shm_toc_lookup(pwcxt->toc, node->ps.plan->plan_node_id, false);
+	SharedFileSetAttach(&shared->fileset, pwcxt->seg);
+	for (int i = 0; i < shared->nparts && shared->sortshared_size > 0; i++)
+		tuplesort_attach_shared(RepartitionSharedSort(shared, i), pwcxt->seg);
+
+	ExecRepartitionInitTuplestores(node, shared);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecShutdownRepartition
+ *
+ *		Stop reading the current partition or range, if any.  The
+ *		remaining shared resources go away with the DSM segment.
+ * ----------------------------------------------------------------
+ */
+void
+ExecShutdownRepartition(RepartitionState *node)
+{
+	/* In range mode, the tuplestores were already read into the sorts */
+	if (node->tuplesortstate != NULL)
+	{
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+		node->tuplesortstate = NULL;
+	}
+	else if (node->curpart >= 0)
+		sts_end_parallel_scan(node->accessors[node->curpart]);
+	node->curpart = -1;
+}
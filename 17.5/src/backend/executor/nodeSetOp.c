@@ -23,6 +23,16 @@
  * We can avoid making hashtable entries for any tuples appearing only in the
  * second input relation, since they cannot result in any output.
  *
+ * If the hash table grows beyond hash_mem, we stop creating new groups, in
+ * the same way as hash aggregation does (see nodeAgg.c).  Tuples that don't
+ * belong to a group already in the table are instead written to one of
+ * several partitions on disk, chosen by their hash value.  Once the input is
+ * exhausted and the groups in memory have been emitted, each partition is
+ * processed in the same way, spilling again recursively if needed.  As all
+ * tuples of a group go to the same partition, and the partitions preserve
+ * the order in which the tuples arrived, the counts come out the same as if
+ * everything had fit in memory.
+ *
  * This node type is not used for UNION or UNION ALL, since those can be
  * implemented more cheaply (there's no need for the junk attribute to
  * identify the source relation).
@@ -45,12 +55,26 @@
 #include "postgres.h"
 
 #include "access/htup_details.h"
+#include "common/hashfn.h"
 #include "executor/executor.h"
+#include "executor/nodeAgg.h"
 #include "executor/nodeSetOp.h"
+#include "lib/hyperloglog.h"
 #include "miscadmin.h"
+#include "utils/logtape.h"
 #include "utils/memutils.h"
 
 
+/*
+ * Buffer sizes for reading and writing spill files, and the precision of the
+ * cardinality estimates for the partitions; see the equivalent HASHAGG_*
+ * definitions in nodeAgg.c.
+ */
+#define SETOP_READ_BUFFER_SIZE BLCKSZ
+#define SETOP_WRITE_BUFFER_SIZE BLCKSZ
+#define SETOP_HLL_BIT_WIDTH 5
+
+
 /*
  * SetOpStatePerGroupData - per-group working state
  *
@@ -67,10 +91,51 @@ typedef struct SetOpStatePerGroupData
 	long		numRight;		/* number of right-input dups in group */
 }			SetOpStatePerGroupData;
 
+/*
+ * Partitioned spill data for one pass over the input, like HashAggSpill.
+ * The high bits of the hash value select the partition, skipping the bits
+ * already used by earlier passes.
+ */
+typedef struct SetOpSpill
+{
+	int			npartitions;	/* number of partitions */
+	LogicalTape **partitions;	/* spill partition tapes */
+	int64	   *ntuples;		/* number of tuples in each partition */
+	uint32		mask;			/* mask to find partition from hash value */
+	int			shift;			/* after masking, shift by this amount */
+	hyperLogLogState *hll_card; /* cardinality estimate for contents */
+} SetOpSpill;
+
+/*
+ * A spilled partition that remains to be processed, like HashAggBatch.
+ */
+typedef struct SetOpBatch
+{
+	int			used_bits;		/* number of bits of hash already used */
+	LogicalTape *input_tape;	/* input partition tape */
+	int64		input_tuples;	/* number of tuples in this batch */
+	double		input_card;		/* estimated group cardinality */
+} SetOpBatch;
+
 
 static TupleTableSlot *setop_retrieve_direct(SetOpState *setopstate);
 static void setop_fill_hash_table(SetOpState *setopstate);
+static bool setop_refill_hash_table(SetOpState *setopstate);
+static void setop_hash_tuple(SetOpState *setopstate, TupleTableSlot *slot,
+							 SetOpBatch *batch, uint32 hash);
 static TupleTableSlot *setop_retrieve_hash_table(SetOpState *setopstate);
+static void setop_check_limits(SetOpState *setopstate, SetOpBatch *batch);
+static void setop_enter_spill_mode(SetOpState *setopstate, SetOpBatch *batch);
+static void setop_update_metrics(SetOpState *setopstate, bool from_tape,
+								 int npartitions);
+static void setop_spill_init(SetOpSpill *spill, LogicalTapeSet *tapeset,
+							 int used_bits, double input_groups,
+							 double hashentrysize);
+static void setop_spill_tuple(SetOpSpill *spill, TupleTableSlot *slot,
+							  uint32 hash);
+static void setop_spill_finish(SetOpState *setopstate);
+static MinimalTuple setop_batch_read(SetOpBatch *batch, uint32 *hashp);
+static void setop_reset_spill_state(SetOpState *setopstate);
 
 
 /*
@@ -122,10 +187,26 @@ build_hash_table(SetOpState *setopstate)
 	SetOp	   *node = (SetOp *) setopstate->ps.plan;
 	ExprContext *econtext = setopstate->ps.ps_ExprContext;
 	TupleDesc	desc = ExecGetResultType(outerPlanState(setopstate));
+	long		nbuckets;
 
 	Assert(node->strategy == SETOP_HASHED);
 	Assert(node->numGroups > 0);
 
+	/*
+	 * Decide how much memory the table may use before spilling, and don't
+	 * make the initial table bigger than that.
+	 */
+	setopstate->hashentrysize =
+		hash_agg_entry_size(0, node->plan.plan_width,
+							sizeof(SetOpStatePerGroupData));
+	hash_agg_set_limits(setopstate->hashentrysize, node->numGroups, 0,
+						&setopstate->hash_mem_limit,
+						&setopstate->hash_ngroups_limit,
+						NULL);
+	nbuckets = hash_choose_num_buckets(setopstate->hashentrysize,
+									   node->numGroups,
+									   setopstate->hash_mem_limit);
+
 	setopstate->hashtable = BuildTupleHashTableExt(&setopstate->ps,
 												   desc,
 												   node->numCols,
@@ -133,7 +214,7 @@ build_hash_table(SetOpState *setopstate)
 												   setopstate->eqfuncoids,
 												   setopstate->hashfunctions,
 												   node->dupCollations,
-												   node->numGroups,
+												   nbuckets,
 												   0,
 												   setopstate->ps.state->es_query_cxt,
 												   setopstate->tableContext,
@@ -338,20 +419,16 @@ setop_retrieve_direct(SetOpState *setopstate)
 static void
 setop_fill_hash_table(SetOpState *setopstate)
 {
-	SetOp	   *node = (SetOp *) setopstate->ps.plan;
+	SetOp	   *node PG_USED_FOR_ASSERTS_ONLY = (SetOp *) setopstate->ps.plan;
 	PlanState  *outerPlan;
-	int			firstFlag;
-	bool		in_first_rel PG_USED_FOR_ASSERTS_ONLY;
-	ExprContext *econtext = setopstate->ps.ps_ExprContext;
 
 	/*
 	 * get state info from node
 	 */
 	outerPlan = outerPlanState(setopstate);
-	firstFlag = node->firstFlag;
 	/* verify planner didn't mess up */
-	Assert(firstFlag == 0 ||
-		   (firstFlag == 1 &&
+	Assert(node->firstFlag == 0 ||
+		   (node->firstFlag == 1 &&
 			(node->cmd == SETOPCMD_INTERSECT ||
 			 node->cmd == SETOPCMD_INTERSECT_ALL)));
 
@@ -359,63 +436,157 @@ setop_fill_hash_table(SetOpState *setopstate)
 	 * Process each outer-plan tuple, and then fetch the next one, until we
 	 * exhaust the outer plan.
 	 */
-	in_first_rel = true;
 	for (;;)
 	{
 		TupleTableSlot *outerslot;
-		int			flag;
-		TupleHashEntryData *entry;
-		bool		isnew;
 
 		outerslot = ExecProcNode(outerPlan);
 		if (TupIsNull(outerslot))
 			break;
 
-		/* Identify whether it's left or right input */
-		flag = fetch_tuple_flag(setopstate, outerslot);
+		setop_hash_tuple(setopstate, outerslot, NULL, 0);
+	}
 
-		if (flag == firstFlag)
-		{
-			/* (still) in first input relation */
-			Assert(in_first_rel);
+	/* turn any spilled partitions into batches for later */
+	if (setopstate->hash_spill != NULL)
+	{
+		int			npartitions = setopstate->hash_spill->npartitions;
 
-			/* Find or build hashtable entry for this tuple's group */
-			entry = LookupTupleHashEntry(setopstate->hashtable, outerslot,
-										 &isnew, NULL);
+		setop_spill_finish(setopstate);
+		setop_update_metrics(setopstate, false, npartitions);
+	}
+	else
+		setop_update_metrics(setopstate, false, 0);
 
-			/* If new tuple group, initialize counts */
-			if (isnew)
-			{
-				entry->additional = (SetOpStatePerGroup)
-					MemoryContextAlloc(setopstate->hashtable->tablecxt,
-									   sizeof(SetOpStatePerGroupData));
-				initialize_counts((SetOpStatePerGroup) entry->additional);
-			}
+	setopstate->table_filled = true;
+	/* Initialize to walk the hash table */
+	ResetTupleHashIterator(setopstate->hashtable, &setopstate->hashiter);
+}
 
-			/* Advance the counts */
-			advance_counts((SetOpStatePerGroup) entry->additional, flag);
-		}
-		else
-		{
-			/* reached second relation */
-			in_first_rel = false;
+/*
+ * Load the next batch of spilled tuples into the hash table, in place of
+ * the groups already emitted.  Returns false if there are no more batches.
+ */
+static bool
+setop_refill_hash_table(SetOpState *setopstate)
+{
+	SetOpBatch *batch;
+	int			npartitions = 0;
 
-			/* For tuples not seen previously, do not make hashtable entry */
-			entry = LookupTupleHashEntry(setopstate->hashtable, outerslot,
-										 NULL, NULL);
+	if (setopstate->hash_batches == NIL)
+		return false;
 
-			/* Advance the counts if entry is already present */
-			if (entry)
-				advance_counts((SetOpStatePerGroup) entry->additional, flag);
-		}
+	/* process the batches in the order they were created */
+	batch = linitial(setopstate->hash_batches);
+	setopstate->hash_batches = list_delete_first(setopstate->hash_batches);
+
+	/* throw away the groups of the previous batch */
+	MemoryContextReset(setopstate->tableContext);
+	ResetTupleHashTable(setopstate->hashtable);
+	setopstate->hash_ngroups_current = 0;
 
-		/* Must reset expression context after each hashtable lookup */
-		ResetExprContext(econtext);
+	hash_agg_set_limits(setopstate->hashentrysize, batch->input_card,
+						batch->used_bits, &setopstate->hash_mem_limit,
+						&setopstate->hash_ngroups_limit, NULL);
+	setopstate->hash_spill_mode = false;
+
+	for (;;)
+	{
+		TupleTableSlot *spillslot = setopstate->hash_spill_rslot;
+		MinimalTuple tuple;
+		uint32		hash;
+
+		CHECK_FOR_INTERRUPTS();
+
+		tuple = setop_batch_read(batch, &hash);
+		if (tuple == NULL)
+			break;
+
+		ExecStoreMinimalTuple(tuple, spillslot, true);
+		setop_hash_tuple(setopstate, spillslot, batch, hash);
 	}
 
-	setopstate->table_filled = true;
-	/* Initialize to walk the hash table */
+	LogicalTapeClose(batch->input_tape);
+
+	if (setopstate->hash_spill != NULL)
+	{
+		npartitions = setopstate->hash_spill->npartitions;
+		setop_spill_finish(setopstate);
+	}
+	setop_update_metrics(setopstate, true, npartitions);
+
+	pfree(batch);
+
+	setopstate->hash_batches_used++;
 	ResetTupleHashIterator(setopstate->hashtable, &setopstate->hashiter);
+
+	return true;
+}
+
+/*
+ * Count one input tuple in the hash table, or spill it if its group is not
+ * in the table and we're not allowed to add new groups.
+ *
+ * 'batch' is the batch the tuple was read from, and 'hash' its hash value as
+ * computed before it was spilled; or NULL if it came from the outer plan.
+ */
+static void
+setop_hash_tuple(SetOpState *setopstate, TupleTableSlot *slot,
+				 SetOpBatch *batch, uint32 hash)
+{
+	SetOp	   *node = (SetOp *) setopstate->ps.plan;
+	TupleHashTable hashtable = setopstate->hashtable;
+	TupleHashEntryData *entry;
+	bool		isnew = false;
+	bool	   *p_isnew;
+	int			flag;
+
+	/* Identify whether it's left or right input */
+	flag = fetch_tuple_flag(setopstate, slot);
+
+	/*
+	 * Tuples from the first input relation create new groups, unless we're
+	 * out of memory.  For tuples of the second relation not seen previously,
+	 * do not make hashtable entry.
+	 */
+	if (flag == node->firstFlag && !setopstate->hash_spill_mode)
+		p_isnew = &isnew;
+	else
+		p_isnew = NULL;
+
+	if (batch != NULL)
+		entry = LookupTupleHashEntryHash(hashtable, slot, p_isnew, hash);
+	else
+		entry = LookupTupleHashEntry(hashtable, slot, p_isnew, &hash);
+
+	if (entry != NULL)
+	{
+		/* If new tuple group, initialize counts */
+		if (isnew)
+		{
+			entry->additional = (SetOpStatePerGroup)
+				MemoryContextAlloc(hashtable->tablecxt,
+								   sizeof(SetOpStatePerGroupData));
+			initialize_counts((SetOpStatePerGroup) entry->additional);
+			setopstate->hash_ngroups_current++;
+			setop_check_limits(setopstate, batch);
+		}
+
+		/* Advance the counts */
+		advance_counts((SetOpStatePerGroup) entry->additional, flag);
+	}
+	else if (setopstate->hash_spill_mode)
+	{
+		/*
+		 * The group may have been spilled, so save the tuple for later, even
+		 * if it's from the second relation.  The order of the tuples is
+		 * preserved, so those from the first relation still come first.
+		 */
+		setop_spill_tuple(setopstate->hash_spill, slot, hash);
+	}
+
+	/* Must reset expression context after each hashtable lookup */
+	ResetExprContext(setopstate->ps.ps_ExprContext);
 }
 
 /*
@@ -445,6 +616,10 @@ setop_retrieve_hash_table(SetOpState *setopstate)
 		entry = ScanTupleHashTable(setopstate->hashtable, &setopstate->hashiter);
 		if (entry == NULL)
 		{
+			/* Move on to the next batch of spilled tuples, if any */
+			if (setop_refill_hash_table(setopstate))
+				continue;
+
 			/* No more entries in hashtable, so done */
 			setopstate->setop_done = true;
 			return NULL;
@@ -470,6 +645,309 @@ setop_retrieve_hash_table(SetOpState *setopstate)
 	return NULL;
 }
 
+/*
+ * After adding a new group to the hash table, check whether we need to stop
+ * adding more and spill instead.
+ */
+static void
+setop_check_limits(SetOpState *setopstate, SetOpBatch *batch)
+{
+	uint64		ngroups = setopstate->hash_ngroups_current;
+	Size		meta_mem;
+	Size		hashkey_mem;
+
+	if (setopstate->hash_spill_mode)
+		return;
+
+	/* the bucket array and the group keys and counts */
+	meta_mem = setopstate->hashtable->hashtab->size * sizeof(TupleHashEntryData);
+	hashkey_mem = MemoryContextMemAllocated(setopstate->tableContext, true);
+
+	/*
+	 * Don't spill unless there's at least one group in the hash table so we
+	 * can be sure to make progress even in edge cases.
+	 */
+	if (ngroups > 0 &&
+		(meta_mem + hashkey_mem > setopstate->hash_mem_limit ||
+		 ngroups > setopstate->hash_ngroups_limit))
+	{
+		setop_enter_spill_mode(setopstate, batch);
+	}
+}
+
+/*
+ * Enter "spill mode", meaning that no new groups are added to the hash table
+ * during the current pass.  Tuples that would create a new group, or that
+ * might belong to one, are instead spilled, and processed later.
+ */
+static void
+setop_enter_spill_mode(SetOpState *setopstate, SetOpBatch *batch)
+{
+	SetOp	   *node = (SetOp *) setopstate->ps.plan;
+
+	Assert(setopstate->hash_spill == NULL);
+
+	setopstate->hash_spill_mode = true;
+
+	if (!setopstate->hash_ever_spilled)
+	{
+		Assert(setopstate->hash_tapeset == NULL);
+		setopstate->hash_ever_spilled = true;
+		setopstate->hash_tapeset = LogicalTapeSetCreate(true, NULL, -1);
+	}
+
+	/*
+	 * When spilling the tuples of a batch again, the new partitions use the
+	 * bits of the hash value that the batch's partition didn't.
+	 */
+	setopstate->hash_spill = palloc(sizeof(SetOpSpill));
+	if (batch != NULL)
+		setop_spill_init(setopstate->hash_spill, setopstate->hash_tapeset,
+						 batch->used_bits, batch->input_card,
+						 setopstate->hashentrysize);
+	else
+		setop_spill_init(setopstate->hash_spill, setopstate->hash_tapeset,
+						 0, node->numGroups, setopstate->hashentrysize);
+}
+
+/*
+ * Update metrics after filling the hash table.
+ *
+ * If reading from the outer plan, from_tape should be false; if reading from
+ * a spilled batch, from_tape should be true.
+ */
+static void
+setop_update_metrics(SetOpState *setopstate, bool from_tape, int npartitions)
+{
+	Size		meta_mem;
+	Size		hashkey_mem;
+	Size		buffer_mem;
+	Size		total_mem;
+
+	meta_mem = setopstate->hashtable->hashtab->size * sizeof(TupleHashEntryData);
+	hashkey_mem = MemoryContextMemAllocated(setopstate->tableContext, true);
+
+	/* memory for read/write tape buffers, if spilled */
+	buffer_mem = npartitions * SETOP_WRITE_BUFFER_SIZE;
+	if (from_tape)
+		buffer_mem += SETOP_READ_BUFFER_SIZE;
+
+	/* update peak mem */
+	total_mem = meta_mem + hashkey_mem + buffer_mem;
+	if (total_mem > setopstate->hash_mem_peak)
+		setopstate->hash_mem_peak = total_mem;
+
+	/* update disk usage */
+	if (setopstate->hash_tapeset != NULL)
+	{
+		uint64		disk_used = LogicalTapeSetBlocks(setopstate->hash_tapeset) * (BLCKSZ / 1024);
+		int64		rawBytes;
+		int64		storedBytes;
+
+		if (setopstate->hash_disk_used < disk_used)
+			setopstate->hash_disk_used = disk_used;
+
+		LogicalTapeSetCompressionStats(setopstate->hash_tapeset,
+									   &rawBytes, &storedBytes);
+		if (setopstate->hash_temp_written < rawBytes / 1024)
+		{
+			setopstate->hash_temp_written = rawBytes / 1024;
+			setopstate->hash_temp_written_compressed = storedBytes / 1024;
+		}
+	}
+}
+
+/*
+ * setop_spill_init
+ *
+ * Choose the number of partitions to create, and initialize them.
+ */
+static void
+setop_spill_init(SetOpSpill *spill, LogicalTapeSet *tapeset, int used_bits,
+				 double input_groups, double hashentrysize)
+{
+	int			npartitions;
+	int			partition_bits;
+
+	npartitions = hash_choose_num_partitions(input_groups, hashentrysize,
+											 used_bits, &partition_bits);
+
+	spill->partitions = palloc0(sizeof(LogicalTape *) * npartitions);
+	spill->ntuples = palloc0(sizeof(int64) * npartitions);
+	spill->hll_card = palloc0(sizeof(hyperLogLogState) * npartitions);
+
+	for (int i = 0; i < npartitions; i++)
+	{
+		spill->partitions[i] = LogicalTapeCreate(tapeset);
+		initHyperLogLog(&spill->hll_card[i], SETOP_HLL_BIT_WIDTH);
+	}
+
+	spill->shift = 32 - used_bits - partition_bits;
+	spill->mask = (npartitions - 1) << spill->shift;
+	spill->npartitions = npartitions;
+}
+
+/*
+ * setop_spill_tuple
+ *
+ * Save a tuple for a later pass in the appropriate partition, along with
+ * its hash value.  The flag column is saved with it.
+ */
+static void
+setop_spill_tuple(SetOpSpill *spill, TupleTableSlot *slot, uint32 hash)
+{
+	int			partition;
+	MinimalTuple tuple;
+	LogicalTape *tape;
+	bool		shouldFree;
+
+	Assert(spill->partitions != NULL);
+
+	tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+
+	partition = (hash & spill->mask) >> spill->shift;
+	spill->ntuples[partition]++;
+
+	/*
+	 * All hash values destined for a given partition have some bits in
+	 * common, which causes bad HLL cardinality estimates. Hash the hash to
+	 * get a more uniform distribution.
+	 */
+	addHyperLogLog(&spill->hll_card[partition], hash_bytes_uint32(hash));
+
+	tape = spill->partitions[partition];
+
+	LogicalTapeWrite(tape, &hash, sizeof(uint32));
+	LogicalTapeWrite(tape, tuple, tuple->t_len);
+
+	if (shouldFree)
+		pfree(tuple);
+}
+
+/*
+ * setop_spill_finish
+ *
+ * Transform the partitions spilled during the current pass into new batches,
+ * and leave spill mode.
+ */
+static void
+setop_spill_finish(SetOpState *setopstate)
+{
+	SetOpSpill *spill = setopstate->hash_spill;
+	int			used_bits = 32 - spill->shift;
+
+	for (int i = 0; i < spill->npartitions; i++)
+	{
+		LogicalTape *tape = spill->partitions[i];
+		SetOpBatch *new_batch;
+
+		/* if the partition is empty, don't create a new batch of work */
+		if (spill->ntuples[i] == 0)
+		{
+			LogicalTapeClose(tape);
+			continue;
+		}
+
+		/* rewinding frees the buffer while not in use */
+		LogicalTapeRewindForRead(tape, SETOP_READ_BUFFER_SIZE);
+
+		new_batch = palloc0(sizeof(SetOpBatch));
+		new_batch->used_bits = used_bits;
+		new_batch->input_tape = tape;
+		new_batch->input_tuples = spill->ntuples[i];
+		new_batch->input_card = estimateHyperLogLog(&spill->hll_card[i]);
+		setopstate->hash_batches = lappend(setopstate->hash_batches, new_batch);
+	}
+
+	for (int i = 0; i < spill->npartitions; i++)
+		freeHyperLogLog(&spill->hll_card[i]);
+	pfree(spill->hll_card);
+	pfree(spill->ntuples);
+	pfree(spill->partitions);
+	pfree(spill);
+
+	setopstate->hash_spill = NULL;
+	setopstate->hash_spill_mode = false;
+}
+
+/*
+ * setop_batch_read
+ *		read the next tuple from a batch's tape.  Return NULL if no more.
+ */
+static MinimalTuple
+setop_batch_read(SetOpBatch *batch, uint32 *hashp)
+{
+	LogicalTape *tape = batch->input_tape;
+	MinimalTuple tuple;
+	uint32		t_len;
+	size_t		nread;
+	uint32		hash;
+
+	nread = LogicalTapeRead(tape, &hash, sizeof(uint32));
+	if (nread == 0)
+		return NULL;
+	if (nread != sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg_internal("unexpected EOF for tape %p: requested %zu bytes, read %zu bytes",
+								 tape, sizeof(uint32), nread)));
+	*hashp = hash;
+
+	nread = LogicalTapeRead(tape, &t_len, sizeof(t_len));
+	if (nread != sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg_internal("unexpected EOF for tape %p: requested %zu bytes, read %zu bytes",
+								 tape, sizeof(uint32), nread)));
+
+	tuple = (MinimalTuple) palloc(t_len);
+	tuple->t_len = t_len;
+
+	nread = LogicalTapeRead(tape,
+							(char *) tuple + sizeof(uint32),
+							t_len - sizeof(uint32));
+	if (nread != t_len - sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg_internal("unexpected EOF for tape %p: requested %zu bytes, read %zu bytes",
+								 tape, t_len - sizeof(uint32), nread)));
+
+	return tuple;
+}
+
+/*
+ * Free resources related to spilling.
+ */
+static void
+setop_reset_spill_state(SetOpState *setopstate)
+{
+	/* free spill partitions of an unfinished pass */
+	if (setopstate->hash_spill != NULL)
+	{
+		SetOpSpill *spill = setopstate->hash_spill;
+
+		pfree(spill->hll_card);
+		pfree(spill->ntuples);
+		pfree(spill->partitions);
+		pfree(spill);
+		setopstate->hash_spill = NULL;
+	}
+
+	/* free batches */
+	list_free_deep(setopstate->hash_batches);
+	setopstate->hash_batches = NIL;
+
+	/* close tape set */
+	if (setopstate->hash_tapeset != NULL)
+	{
+		LogicalTapeSetClose(setopstate->hash_tapeset);
+		setopstate->hash_tapeset = NULL;
+	}
+
+	setopstate->hash_spill_mode = false;
+	setopstate->hash_ngroups_current = 0;
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitSetOp
  *
@@ -502,6 +980,18 @@ ExecInitSetOp(SetOp *node, EState *estate, int eflags)
 	setopstate->grp_firstTuple = NULL;
 	setopstate->hashtable = NULL;
 	setopstate->tableContext = NULL;
+	setopstate->hash_tapeset = NULL;
+	setopstate->hash_spill = NULL;
+	setopstate->hash_spill_rslot = NULL;
+	setopstate->hash_batches = NIL;
+	setopstate->hash_ever_spilled = false;
+	setopstate->hash_spill_mode = false;
+	setopstate->hash_ngroups_current = 0;
+	setopstate->hash_mem_peak = 0;
+	setopstate->hash_disk_used = 0;
+	setopstate->hash_batches_used = 0;
+	setopstate->hash_temp_written = 0;
+	setopstate->hash_temp_written_compressed = 0;
 
 	/*
 	 * create expression context
@@ -562,6 +1052,11 @@ ExecInitSetOp(SetOp *node, EState *estate, int eflags)
 	{
 		build_hash_table(setopstate);
 		setopstate->table_filled = false;
+
+		/* slot for reading back spilled tuples */
+		setopstate->hash_spill_rslot =
+			ExecInitExtraTupleSlot(estate, outerDesc, &TTSOpsMinimalTuple);
+		setopstate->hash_batches_used = 1;
 	}
 	else
 	{
@@ -583,6 +1078,7 @@ void
 ExecEndSetOp(SetOpState *node)
 {
 	/* free subsidiary stuff including hashtable */
+	setop_reset_spill_state(node);
 	if (node->tableContext)
 		MemoryContextDelete(node->tableContext);
 
@@ -611,15 +1107,20 @@ ExecReScanSetOp(SetOpState *node)
 			return;
 
 		/*
-		 * If we do have the hash table and the subplan does not have any
-		 * parameter changes, then we can just rescan the existing hash table;
-		 * no need to build it again.
+		 * If we do have the hash table, it never spilled, and the subplan
+		 * does not have any parameter changes, then we can just rescan the
+		 * existing hash table; no need to build it again.
 		 */
-		if (outerPlan->chgParam == NULL)
+		if (outerPlan->chgParam == NULL && !node->hash_ever_spilled)
 		{
 			ResetTupleHashIterator(node->hashtable, &node->hashiter);
 			return;
 		}
+
+		/* Otherwise forget about any tuples spilled last time */
+		setop_reset_spill_state(node);
+		node->hash_ever_spilled = false;
+		node->hash_batches_used = 1;
 	}
 
 	/* Release first tuple of group, if we have made a copy */
@@ -638,6 +1139,13 @@ ExecReScanSetOp(SetOpState *node)
 	{
 		ResetTupleHashTable(node->hashtable);
 		node->table_filled = false;
+
+		/* a spilled batch may have changed the limits */
+		hash_agg_set_limits(node->hashentrysize,
+							((SetOp *) node->ps.plan)->numGroups, 0,
+							&node->hash_mem_limit,
+							&node->hash_ngroups_limit,
+							NULL);
 	}
 
 	/*
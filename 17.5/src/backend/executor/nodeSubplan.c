@@ -83,7 +83,7 @@ ExecSubPlan(SubPlanState *node,
 	estate->es_direction = ForwardScanDirection;
 
 	/* Select appropriate evaluation strategy */
-	if (subplan->useHashTable)
+	if (subplan->useHashTable && !node->hashfallback)
 		retval = ExecHashSubPlan(node, econtext, isNull);
 	else
 		retval = ExecScanSubPlan(node, econtext, isNull);
@@ -115,8 +115,14 @@ ExecHashSubPlan(SubPlanState *node,
 	 * table.
 	 */
 	if (node->hashtable == NULL || planstate->chgParam != NULL)
+	{
 		buildSubPlanHash(node, econtext);
 
+		/* If the subselect output didn't fit, answer by scanning instead */
+		if (node->hashfallback)
+			return ExecScanSubPlan(node, econtext, isNull);
+	}
+
 	/*
 	 * The result for an empty subplan is always FALSE; no need to evaluate
 	 * lefthand side.
@@ -509,6 +515,7 @@ buildSubPlanHash(SubPlanState *node, ExprContext *econtext)
 	ExprContext *innerecontext = node->innerecontext;
 	MemoryContext oldcontext;
 	long		nbuckets;
+	size_t		hash_mem_limit = get_hash_memory_limit();
 	TupleTableSlot *slot;
 
 	Assert(subplan->subLinkType == ANY_SUBLINK);
@@ -598,6 +605,14 @@ buildSubPlanHash(SubPlanState *node, ExprContext *econtext)
 	/*
 	 * Scan the subplan and load the hash table(s).  Note that when there are
 	 * duplicate rows coming out of the sub-select, only one copy is stored.
+	 *
+	 * The planner only hashes a subplan whose output it expects to fit in
+	 * hash_mem, but the estimate can be badly off.  Since the subplan is
+	 * uncorrelated, the hash tables are just a cache of its output, so
+	 * rather than let them grow without bound we give up on them once they
+	 * exceed hash_mem and evaluate the combining expression by rescanning
+	 * the subplan, as for an unhashed ANY sublink.  The fallback is sticky
+	 * for the rest of the query, since the output is unlikely to shrink.
 	 */
 	for (slot = ExecProcNode(planstate);
 		 !TupIsNull(slot);
@@ -627,6 +642,7 @@ buildSubPlanHash(SubPlanState *node, ExprContext *econtext)
 		/*
 		 * If result contains any nulls, store separately or not at all.
 		 */
+		isnew = false;
 		if (slotNoNulls(slot))
 		{
 			(void) LookupTupleHashEntry(node->hashtable, slot, &isnew, NULL);
@@ -643,6 +659,23 @@ buildSubPlanHash(SubPlanState *node, ExprContext *econtext)
 		 * during ExecProject.
 		 */
 		ResetExprContext(innerecontext);
+
+		if (isnew &&
+			MemoryContextMemAllocated(node->hashtablecxt, true) > hash_mem_limit)
+		{
+			node->hashfallback = true;
+			break;
+		}
+	}
+
+	if (node->hashfallback)
+	{
+		MemoryContextReset(node->hashtablecxt);
+		ResetTupleHashTable(node->hashtable);
+		if (node->hashnulls)
+			ResetTupleHashTable(node->hashnulls);
+		node->havehashrows = false;
+		node->havenullrows = false;
 	}
 
 	/*
@@ -855,6 +888,7 @@ ExecInitSubPlan(SubPlan *subplan, PlanState *parent)
 	sstate->projRight = NULL;
 	sstate->hashtable = NULL;
 	sstate->hashnulls = NULL;
+	sstate->hashfallback = false;
 	sstate->hashtablecxt = NULL;
 	sstate->hashtempcxt = NULL;
 	sstate->innerecontext = NULL;
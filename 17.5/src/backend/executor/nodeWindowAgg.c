@@ -155,6 +155,21 @@ typedef struct WindowStatePerAggData
 
 	int64		transValueCount;	/* number of currently-aggregated rows */
 
+	/*
+	 * Aggregates without an inverse transition function may instead use
+	 * their combine function to cope with a moving frame head, see
+	 * eval_windowaggregates().  In that case, transValue only covers the
+	 * rows from suffixend on, and suffixValues[i] holds the transition value
+	 * for the rows from suffixbase + i up to suffixend.
+	 */
+	Oid			combinefn_oid;	/* InvalidOid if not used */
+	FmgrInfo	combinefn;
+	MemoryContext suffixcontext;	/* holds suffixValues and their data */
+	Datum	   *suffixValues;
+	bool	   *suffixNulls;
+	int64		suffixbase;		/* row that suffixValues[0] starts at */
+	int64		suffixend;		/* first row not covered by suffixValues */
+
 	/* Data local to eval_windowaggregates() */
 	bool		restart;		/* need to restart this agg in this cycle? */
 } WindowStatePerAggData;
@@ -168,6 +183,15 @@ static void advance_windowaggregate(WindowAggState *winstate,
 static bool advance_windowaggregate_base(WindowAggState *winstate,
 										 WindowStatePerFunc perfuncstate,
 										 WindowStatePerAgg peraggstate);
+static void combine_windowaggregate(WindowAggState *winstate,
+									WindowStatePerFunc perfuncstate,
+									WindowStatePerAgg peraggstate,
+									MemoryContext context,
+									Datum *value1, bool *isnull1,
+									Datum value2, bool isnull2);
+static void rebuild_windowaggregate_suffix(WindowAggState *winstate,
+										   WindowStatePerFunc perfuncstate,
+										   WindowStatePerAgg peraggstate);
 static void finalize_windowaggregate(WindowAggState *winstate,
 									 WindowStatePerFunc perfuncstate,
 									 WindowStatePerAgg peraggstate,
@@ -574,6 +598,163 @@ advance_windowaggregate_base(WindowAggState *winstate,
 	return true;
 }
 
+/*
+ * combine_windowaggregate
+ * Merge the transition value value2 into *value1 using the aggregate's
+ * combine function.
+ *
+ * *value1 must be a value we're free to modify, stored in 'context', and the
+ * result is stored there too.  value2 is not modified.
+ */
+static void
+combine_windowaggregate(WindowAggState *winstate,
+						WindowStatePerFunc perfuncstate,
+						WindowStatePerAgg peraggstate,
+						MemoryContext context,
+						Datum *value1, bool *isnull1,
+						Datum value2, bool isnull2)
+{
+	LOCAL_FCINFO(fcinfo, 2);
+	MemoryContext oldContext;
+	Datum		newVal;
+
+	if (peraggstate->combinefn.fn_strict)
+	{
+		/* As in nodeAgg.c, NULL inputs leave the transition value alone */
+		if (isnull2)
+			return;
+
+		/*
+		 * A NULL transition value is replaced by the first non-NULL input if
+		 * that's how the aggregate starts out, else it stays NULL.
+		 */
+		if (*isnull1)
+		{
+			if (peraggstate->initValueIsNull)
+			{
+				oldContext = MemoryContextSwitchTo(context);
+				*value1 = datumCopy(value2,
+									peraggstate->transtypeByVal,
+									peraggstate->transtypeLen);
+				*isnull1 = false;
+				MemoryContextSwitchTo(oldContext);
+			}
+			return;
+		}
+	}
+
+	oldContext = MemoryContextSwitchTo(winstate->tmpcontext->ecxt_per_tuple_memory);
+
+	InitFunctionCallInfoData(*fcinfo, &(peraggstate->combinefn),
+							 2,
+							 perfuncstate->winCollation,
+							 (void *) winstate, NULL);
+	fcinfo->args[0].value = *value1;
+	fcinfo->args[0].isnull = *isnull1;
+	fcinfo->args[1].value = MakeExpandedObjectReadOnly(value2,
+													   isnull2,
+													   peraggstate->transtypeLen);
+	fcinfo->args[1].isnull = isnull2;
+	winstate->curaggcontext = context;
+	newVal = FunctionCallInvoke(fcinfo);
+	winstate->curaggcontext = NULL;
+
+	/*
+	 * If pass-by-ref datatype, must copy the new value into context, unless
+	 * the combinefn returned its first input.  The old value is left for the
+	 * caller to free along with the context.
+	 */
+	if (!peraggstate->transtypeByVal && !fcinfo->isnull &&
+		DatumGetPointer(newVal) != DatumGetPointer(*value1))
+	{
+		MemoryContextSwitchTo(context);
+		newVal = datumCopy(newVal,
+						   peraggstate->transtypeByVal,
+						   peraggstate->transtypeLen);
+	}
+
+	MemoryContextSwitchTo(oldContext);
+	*value1 = newVal;
+	*isnull1 = fcinfo->isnull;
+}
+
+/*
+ * rebuild_windowaggregate_suffix
+ * Make suffixValues cover all the rows from the frame head up to
+ * aggregatedupto, and empty transValue.
+ *
+ * We compute each row's transition value on its own, then fold them together
+ * backwards from the last row with the combine function, so suffixValues[i]
+ * holds the transition value for the rows from frameheadpos + i onwards.
+ * As the frame head advances, eval_windowaggregates() can then simply pick
+ * the suffixValues entry of the new frame head, and combine it with
+ * transValue, which accumulates the rows entering the frame in the meantime
+ * as usual.  Only once the frame head moves beyond suffixend do we need to
+ * rebuild suffixValues, so each row is aggregated and combined a bounded
+ * number of times no matter how wide the frame is.
+ */
+static void
+rebuild_windowaggregate_suffix(WindowAggState *winstate,
+							   WindowStatePerFunc perfuncstate,
+							   WindowStatePerAgg peraggstate)
+{
+	int64		base = winstate->frameheadpos;
+	int64		nrows = winstate->aggregatedupto - base;
+	TupleTableSlot *slot = winstate->temp_slot_1;
+	MemoryContext suffixcontext = peraggstate->suffixcontext;
+	Datum	   *values;
+	bool	   *nulls;
+	MemoryContext oldContext;
+
+	Assert(nrows > 0);
+
+	MemoryContextReset(suffixcontext);
+	values = MemoryContextAllocHuge(suffixcontext, nrows * sizeof(Datum));
+	nulls = MemoryContextAllocHuge(suffixcontext, nrows * sizeof(bool));
+
+	for (int64 i = 0; i < nrows; i++)
+	{
+		if (!window_gettupleslot(winstate->agg_winobj, base + i, slot))
+			elog(ERROR, "could not re-fetch previously fetched frame row");
+
+		/* Aggregate the row on its own */
+		winstate->tmpcontext->ecxt_outertuple = slot;
+		initialize_windowaggregate(winstate, perfuncstate, peraggstate);
+		advance_windowaggregate(winstate, perfuncstate, peraggstate);
+		ResetExprContext(winstate->tmpcontext);
+
+		nulls[i] = peraggstate->transValueIsNull;
+		if (nulls[i])
+			values[i] = (Datum) 0;
+		else
+		{
+			oldContext = MemoryContextSwitchTo(suffixcontext);
+			values[i] = datumCopy(peraggstate->transValue,
+								  peraggstate->transtypeByVal,
+								  peraggstate->transtypeLen);
+			MemoryContextSwitchTo(oldContext);
+		}
+	}
+	ExecClearTuple(slot);
+
+	for (int64 i = nrows - 2; i >= 0; i--)
+	{
+		combine_windowaggregate(winstate, perfuncstate, peraggstate,
+								suffixcontext,
+								&values[i], &nulls[i],
+								values[i + 1], nulls[i + 1]);
+		ResetExprContext(winstate->tmpcontext);
+	}
+
+	peraggstate->suffixValues = values;
+	peraggstate->suffixNulls = nulls;
+	peraggstate->suffixbase = base;
+	peraggstate->suffixend = winstate->aggregatedupto;
+
+	/* All aggregated rows are now covered by suffixValues */
+	initialize_windowaggregate(winstate, perfuncstate, peraggstate);
+}
+
 /*
  * finalize_windowaggregate
  * parallel to finalize_aggregate in nodeAgg.c
@@ -666,6 +847,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	int			wfuncno,
 				numaggs,
 				numaggs_restart,
+				numaggs_combine,
 				i;
 	int64		aggregatedupto_nonrestarted;
 	MemoryContext oldContext;
@@ -710,6 +892,13 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * must perform the aggregation all over again for all tuples within the
 	 * new frame boundaries.
 	 *
+	 * Restarting for every row makes the cost quadratic in the frame size,
+	 * though.  So if an aggregate without an inverse transition function has
+	 * a combine function, we instead keep the transition values of the
+	 * frame's suffixes around, see rebuild_windowaggregate_suffix(), and
+	 * combine the one for the current frame head with the transition value
+	 * of the rows that have entered the frame since.
+	 *
 	 * If there's any exclusion clause, then we may have to aggregate over a
 	 * non-contiguous set of rows, so we punt and recalculate for every row.
 	 * (For some frame end choices, it might be that the frame is always
@@ -781,12 +970,14 @@ eval_windowaggregates(WindowAggState *winstate)
 	 *----------
 	 */
 	numaggs_restart = 0;
+	numaggs_combine = 0;
 	for (i = 0; i < numaggs; i++)
 	{
 		peraggstate = &winstate->peragg[i];
 		if (winstate->currentpos == 0 ||
 			(winstate->aggregatedbase != winstate->frameheadpos &&
-			 !OidIsValid(peraggstate->invtransfn_oid)) ||
+			 !OidIsValid(peraggstate->invtransfn_oid) &&
+			 !OidIsValid(peraggstate->combinefn_oid)) ||
 			(winstate->frameOptions & FRAMEOPTION_EXCLUSION) ||
 			winstate->aggregatedupto <= winstate->frameheadpos)
 		{
@@ -794,7 +985,11 @@ eval_windowaggregates(WindowAggState *winstate)
 			numaggs_restart++;
 		}
 		else
+		{
 			peraggstate->restart = false;
+			if (OidIsValid(peraggstate->combinefn_oid))
+				numaggs_combine++;
+		}
 	}
 
 	/*
@@ -804,7 +999,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * i.e. advance_windowaggregate_base() can return false, in which case
 	 * we'll restart that aggregate below.
 	 */
-	while (numaggs_restart < numaggs &&
+	while (numaggs_restart + numaggs_combine < numaggs &&
 		   winstate->aggregatedbase < winstate->frameheadpos)
 	{
 		/*
@@ -820,14 +1015,16 @@ eval_windowaggregates(WindowAggState *winstate)
 
 		/*
 		 * Perform the inverse transition for each aggregate function in the
-		 * window, unless it has already been marked as needing a restart.
+		 * window, unless it has already been marked as needing a restart or
+		 * uses its combine function instead.
 		 */
 		for (i = 0; i < numaggs; i++)
 		{
 			bool		ok;
 
 			peraggstate = &winstate->peragg[i];
-			if (peraggstate->restart)
+			if (peraggstate->restart ||
+				OidIsValid(peraggstate->combinefn_oid))
 				continue;
 
 			wfuncno = peraggstate->wfuncno;
@@ -885,19 +1082,40 @@ eval_windowaggregates(WindowAggState *winstate)
 			   numaggs_restart == 0 ||
 			   peraggstate->restart);
 
+		wfuncno = peraggstate->wfuncno;
 		if (peraggstate->restart)
 		{
-			wfuncno = peraggstate->wfuncno;
 			initialize_windowaggregate(winstate,
 									   &winstate->perfunc[wfuncno],
 									   peraggstate);
+			if (OidIsValid(peraggstate->combinefn_oid))
+			{
+				MemoryContextReset(peraggstate->suffixcontext);
+				peraggstate->suffixValues = NULL;
+				peraggstate->suffixNulls = NULL;
+				peraggstate->suffixbase = winstate->frameheadpos;
+				peraggstate->suffixend = winstate->frameheadpos;
+			}
 		}
-		else if (!peraggstate->resultValueIsNull)
+		else
 		{
-			if (!peraggstate->resulttypeByVal)
-				pfree(DatumGetPointer(peraggstate->resultValue));
-			peraggstate->resultValue = (Datum) 0;
-			peraggstate->resultValueIsNull = true;
+			if (!peraggstate->resultValueIsNull)
+			{
+				if (!peraggstate->resulttypeByVal)
+					pfree(DatumGetPointer(peraggstate->resultValue));
+				peraggstate->resultValue = (Datum) 0;
+				peraggstate->resultValueIsNull = true;
+			}
+
+			/*
+			 * If the frame head moved past the rows covered by suffixValues,
+			 * transValue contains rows that are no longer in the frame.
+			 */
+			if (OidIsValid(peraggstate->combinefn_oid) &&
+				winstate->frameheadpos > peraggstate->suffixend)
+				rebuild_windowaggregate_suffix(winstate,
+											   &winstate->perfunc[wfuncno],
+											   peraggstate);
 		}
 	}
 
@@ -991,10 +1209,50 @@ next_tuple:
 		wfuncno = peraggstate->wfuncno;
 		result = &econtext->ecxt_aggvalues[wfuncno];
 		isnull = &econtext->ecxt_aggnulls[wfuncno];
-		finalize_windowaggregate(winstate,
-								 &winstate->perfunc[wfuncno],
-								 peraggstate,
-								 result, isnull);
+
+		if (OidIsValid(peraggstate->combinefn_oid) &&
+			winstate->frameheadpos < peraggstate->suffixend)
+		{
+			int64		off = winstate->frameheadpos - peraggstate->suffixbase;
+			Datum		transValue = peraggstate->transValue;
+			bool		transValueIsNull = peraggstate->transValueIsNull;
+			Datum		frameValue = (Datum) 0;
+			bool		frameValueIsNull = peraggstate->suffixNulls[off];
+
+			/*
+			 * The frame consists of the rows covered by the frame head's
+			 * suffixValues entry and those in transValue.  Combine a copy of
+			 * the former with the latter, and finalize that instead.
+			 */
+			oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+			if (!frameValueIsNull)
+				frameValue = datumCopy(peraggstate->suffixValues[off],
+									   peraggstate->transtypeByVal,
+									   peraggstate->transtypeLen);
+			MemoryContextSwitchTo(oldContext);
+
+			combine_windowaggregate(winstate,
+									&winstate->perfunc[wfuncno],
+									peraggstate,
+									econtext->ecxt_per_tuple_memory,
+									&frameValue, &frameValueIsNull,
+									transValue, transValueIsNull);
+			ResetExprContext(winstate->tmpcontext);
+
+			peraggstate->transValue = frameValue;
+			peraggstate->transValueIsNull = frameValueIsNull;
+			finalize_windowaggregate(winstate,
+									 &winstate->perfunc[wfuncno],
+									 peraggstate,
+									 result, isnull);
+			peraggstate->transValue = transValue;
+			peraggstate->transValueIsNull = transValueIsNull;
+		}
+		else
+			finalize_windowaggregate(winstate,
+									 &winstate->perfunc[wfuncno],
+									 peraggstate,
+									 result, isnull);
 
 		/*
 		 * save the result in case next row shares the same frame.
@@ -1357,6 +1615,12 @@ release_partition(WindowAggState *winstate)
 	{
 		if (winstate->peragg[i].aggcontext != winstate->aggcontext)
 			MemoryContextReset(winstate->peragg[i].aggcontext);
+		if (winstate->peragg[i].suffixcontext != NULL)
+		{
+			MemoryContextReset(winstate->peragg[i].suffixcontext);
+			winstate->peragg[i].suffixValues = NULL;
+			winstate->peragg[i].suffixNulls = NULL;
+		}
 	}
 
 	if (winstate->buffer)
@@ -2689,6 +2953,8 @@ ExecEndWindowAgg(WindowAggState *node)
 	{
 		if (node->peragg[i].aggcontext != node->aggcontext)
 			MemoryContextDelete(node->peragg[i].aggcontext);
+		if (node->peragg[i].suffixcontext != NULL)
+			MemoryContextDelete(node->peragg[i].suffixcontext);
 	}
 	MemoryContextDelete(node->partcontext);
 	MemoryContextDelete(node->aggcontext);
@@ -2758,11 +3024,13 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	bool		use_ma_code;
 	Oid			transfn_oid,
 				invtransfn_oid,
+				combinefn_oid,
 				finalfn_oid;
 	bool		finalextra;
 	char		finalmodify;
 	Expr	   *transfnexpr,
 			   *invtransfnexpr,
+			   *combinefnexpr,
 			   *finalfnexpr;
 	Datum		textInitVal;
 	int			i;
@@ -2834,6 +3102,27 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		initvalAttNo = Anum_pg_aggregate_agginitval;
 	}
 
+	/*
+	 * Without an inverse transition function, we'd have to restart the
+	 * aggregation whenever the frame head moves.  If the aggregate has a
+	 * combine function, we can use that instead, as long as the frame is
+	 * contiguous (see eval_windowaggregates).  That involves aggregating some
+	 * rows more than once, so the same restrictions as for moving aggregates
+	 * apply.  We don't try this with INTERNAL transition states, since their
+	 * combine functions may not expect to be called from a WindowAgg.
+	 */
+	if (!use_ma_code &&
+		OidIsValid(aggform->aggcombinefn) &&
+		aggtranstype != INTERNALOID &&
+		!(winstate->frameOptions & (FRAMEOPTION_START_UNBOUNDED_PRECEDING |
+									FRAMEOPTION_EXCLUSION)) &&
+		!contain_volatile_functions((Node *) wfunc) &&
+		!contain_subplans((Node *) wfunc))
+		combinefn_oid = aggform->aggcombinefn;
+	else
+		combinefn_oid = InvalidOid;
+	peraggstate->combinefn_oid = combinefn_oid;
+
 	/*
 	 * ExecInitWindowAgg already checked permission to call aggregate function
 	 * ... but we still need to check the component functions
@@ -2869,6 +3158,16 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 			InvokeFunctionExecuteHook(invtransfn_oid);
 		}
 
+		if (OidIsValid(combinefn_oid))
+		{
+			aclresult = object_aclcheck(ProcedureRelationId, combinefn_oid, aggOwner,
+										ACL_EXECUTE);
+			if (aclresult != ACLCHECK_OK)
+				aclcheck_error(aclresult, OBJECT_FUNCTION,
+							   get_func_name(combinefn_oid));
+			InvokeFunctionExecuteHook(combinefn_oid);
+		}
+
 		if (OidIsValid(finalfn_oid))
 		{
 			aclresult = object_aclcheck(ProcedureRelationId, finalfn_oid, aggOwner,
@@ -2925,6 +3224,23 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		fmgr_info_set_expr((Node *) invtransfnexpr, &peraggstate->invtransfn);
 	}
 
+	if (OidIsValid(combinefn_oid))
+	{
+		/* aggcombinefn always has two arguments of aggtranstype */
+		build_aggregate_transfn_expr(&aggtranstype,
+									 1,
+									 0,
+									 false,
+									 aggtranstype,
+									 wfunc->inputcollid,
+									 combinefn_oid,
+									 InvalidOid,
+									 &combinefnexpr,
+									 NULL);
+		fmgr_info(combinefn_oid, &peraggstate->combinefn);
+		fmgr_info_set_expr((Node *) combinefnexpr, &peraggstate->combinefn);
+	}
+
 	if (OidIsValid(finalfn_oid))
 	{
 		build_aggregate_finalfn_expr(inputTypes,
@@ -3003,8 +3319,11 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	 * make the memory allocation rules for moving aggregates different than
 	 * they have historically been for plain aggregates, but that seems grotty
 	 * and likely to lead to memory leaks.
+	 *
+	 * The same goes for aggregates using their combine function, which also
+	 * need another context for their suffixValues.
 	 */
-	if (OidIsValid(invtransfn_oid))
+	if (OidIsValid(invtransfn_oid) || OidIsValid(combinefn_oid))
 		peraggstate->aggcontext =
 			AllocSetContextCreate(CurrentMemoryContext,
 								  "WindowAgg Per Aggregate",
@@ -3012,6 +3331,18 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	else
 		peraggstate->aggcontext = winstate->aggcontext;
 
+	if (OidIsValid(combinefn_oid))
+		peraggstate->suffixcontext =
+			AllocSetContextCreate(CurrentMemoryContext,
+								  "WindowAgg Per Aggregate Suffixes",
+								  ALLOCSET_DEFAULT_SIZES);
+	else
+		peraggstate->suffixcontext = NULL;
+	peraggstate->suffixValues = NULL;
+	peraggstate->suffixNulls = NULL;
+	peraggstate->suffixbase = 0;
+	peraggstate->suffixend = 0;
+
 	ReleaseSysCache(aggTuple);
 
 	return peraggstate;
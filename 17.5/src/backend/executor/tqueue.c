@@ -8,6 +8,13 @@
  *
  * A TupleQueueReader reads tuples from a shm_mq and returns the tuples.
  *
+ * To cut down the per-message overhead on both sides, small tuples are
+ * collected into batches, and each batch is sent as a single message.  A
+ * message is just a sequence of minimal tuples, each one starting at a
+ * MAXALIGN'd offset, so a message holding a single tuple is simply that
+ * tuple.  The reader hands out the tuples of a message one at a time, in
+ * place.
+ *
  * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -22,15 +29,27 @@
 #include "access/htup_details.h"
 #include "executor/tqueue.h"
 
+/*
+ * Maximum size of a batch of tuples sent as one message.  shm_mq doesn't
+ * make the bytes we write visible to the receiver until at least a quarter
+ * of the ring has been written anyway, so as long as a batch is smaller than
+ * that, batching delays no tuple more than the queue itself would.
+ */
+#define TQUEUE_BATCH_SIZE		8192
+
 /*
  * DestReceiver object's private contents
  *
- * queue is a pointer to data supplied by DestReceiver's caller.
+ * queue and instr are pointers to data supplied by DestReceiver's caller.
  */
 typedef struct TQueueDestReceiver
 {
 	DestReceiver pub;			/* public fields */
 	shm_mq_handle *queue;		/* shm_mq to send to */
+	TupleQueueInstrumentation *instr;	/* statistics to update, or NULL */
+	char	   *batch;			/* tuples not yet sent, or NULL */
+	Size		batch_len;		/* bytes used in batch */
+	int			batch_ntuples;	/* number of tuples in batch */
 } TQueueDestReceiver;
 
 /*
@@ -43,8 +62,71 @@ typedef struct TQueueDestReceiver
 struct TupleQueueReader
 {
 	shm_mq_handle *queue;		/* shm_mq to receive from */
+	char	   *message;		/* last message received */
+	Size		message_len;	/* its length */
+	Size		message_off;	/* offset of next tuple to return from it */
 };
 
+/*
+ * Send one message holding 'ntuples' tuples to the shm_mq.
+ *
+ * If we're collecting statistics, first try without waiting, so that we can
+ * measure how long we wait for the receiver when the queue is full.  After
+ * SHM_MQ_WOULD_BLOCK, shm_mq expects the same message to be sent again, and
+ * continues from where it left off.
+ */
+static shm_mq_result
+tqueueSendMessage(TQueueDestReceiver *tqueue, const void *data, Size nbytes,
+				  int ntuples)
+{
+	TupleQueueInstrumentation *instr = tqueue->instr;
+	shm_mq_result result;
+
+	if (instr == NULL)
+		return shm_mq_send(tqueue->queue, nbytes, data, false, false);
+
+	result = shm_mq_send(tqueue->queue, nbytes, data, true, false);
+	if (result == SHM_MQ_WOULD_BLOCK)
+	{
+		instr_time	start_time;
+		instr_time	end_time;
+
+		INSTR_TIME_SET_CURRENT(start_time);
+		result = shm_mq_send(tqueue->queue, nbytes, data, false, false);
+		INSTR_TIME_SET_CURRENT(end_time);
+
+		instr->nwaits++;
+		INSTR_TIME_ACCUM_DIFF(instr->wait_time, end_time, start_time);
+	}
+
+	if (result == SHM_MQ_SUCCESS)
+	{
+		instr->nmessages++;
+		instr->ntuples += ntuples;
+	}
+
+	return result;
+}
+
+/*
+ * Send the tuples collected in the current batch, if any.
+ */
+static shm_mq_result
+tqueueFlushBatch(TQueueDestReceiver *tqueue)
+{
+	shm_mq_result result;
+
+	if (tqueue->batch_ntuples == 0)
+		return SHM_MQ_SUCCESS;
+
+	result = tqueueSendMessage(tqueue, tqueue->batch, tqueue->batch_len,
+							   tqueue->batch_ntuples);
+	tqueue->batch_len = 0;
+	tqueue->batch_ntuples = 0;
+
+	return result;
+}
+
 /*
  * Receive a tuple from a query, and send it to the designated shm_mq.
  *
@@ -55,12 +137,34 @@ tqueueReceiveSlot(TupleTableSlot *slot, DestReceiver *self)
 {
 	TQueueDestReceiver *tqueue = (TQueueDestReceiver *) self;
 	MinimalTuple tuple;
-	shm_mq_result result;
+	shm_mq_result result = SHM_MQ_SUCCESS;
 	bool		should_free;
+	Size		tuplen;
 
-	/* Send the tuple itself. */
 	tuple = ExecFetchSlotMinimalTuple(slot, &should_free);
-	result = shm_mq_send(tqueue->queue, tuple->t_len, tuple, false, false);
+	tuplen = MAXALIGN(tuple->t_len);
+
+	/* Make room in the batch, if this tuple doesn't fit in what's left. */
+	if (tqueue->batch_len + tuplen > TQUEUE_BATCH_SIZE)
+		result = tqueueFlushBatch(tqueue);
+
+	if (result == SHM_MQ_SUCCESS)
+	{
+		if (tuplen > TQUEUE_BATCH_SIZE)
+		{
+			/* Too big to batch, so send the tuple itself. */
+			result = tqueueSendMessage(tqueue, tuple, tuple->t_len, 1);
+		}
+		else
+		{
+			/* Add it to the batch; the padding is never looked at. */
+			if (tqueue->batch == NULL)
+				tqueue->batch = palloc(TQUEUE_BATCH_SIZE);
+			memcpy(tqueue->batch + tqueue->batch_len, tuple, tuple->t_len);
+			tqueue->batch_len += tuplen;
+			tqueue->batch_ntuples++;
+		}
+	}
 
 	if (should_free)
 		pfree(tuple);
@@ -94,7 +198,18 @@ tqueueShutdownReceiver(DestReceiver *self)
 	TQueueDestReceiver *tqueue = (TQueueDestReceiver *) self;
 
 	if (tqueue->queue != NULL)
+	{
+		shm_mq_result result;
+
+		/* Send any tuples still in the batch */
+		result = tqueueFlushBatch(tqueue);
+		if (result != SHM_MQ_SUCCESS && result != SHM_MQ_DETACHED)
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+					 errmsg("could not send tuple to shared-memory queue")));
+
 		shm_mq_detach(tqueue->queue);
+	}
 	tqueue->queue = NULL;
 }
 
@@ -109,14 +224,20 @@ tqueueDestroyReceiver(DestReceiver *self)
 	/* We probably already detached from queue, but let's be sure */
 	if (tqueue->queue != NULL)
 		shm_mq_detach(tqueue->queue);
+	if (tqueue->batch != NULL)
+		pfree(tqueue->batch);
 	pfree(self);
 }
 
 /*
  * Create a DestReceiver that writes tuples to a tuple queue.
+ *
+ * If instr isn't NULL, statistics about the messages sent and the time spent
+ * waiting for space in the queue are accumulated there.
  */
 DestReceiver *
-CreateTupleQueueDestReceiver(shm_mq_handle *handle)
+CreateTupleQueueDestReceiver(shm_mq_handle *handle,
+							 TupleQueueInstrumentation *instr)
 {
 	TQueueDestReceiver *self;
 
@@ -128,6 +249,7 @@ CreateTupleQueueDestReceiver(shm_mq_handle *handle)
 	self->pub.rDestroy = tqueueDestroyReceiver;
 	self->pub.mydest = DestTupleQueue;
 	self->queue = handle;
+	self->instr = instr;
 
 	return (DestReceiver *) self;
 }
@@ -166,7 +288,9 @@ DestroyTupleQueueReader(TupleQueueReader *reader)
  *
  * The returned tuple, if any, is either in shared memory or a private buffer
  * and should not be freed.  The pointer is invalid after the next call to
- * TupleQueueReaderNext().
+ * TupleQueueReaderNext().  The tuples of a batch are returned one by one
+ * from the message they arrived in, without copying them, and we only ask
+ * shm_mq for another message once the current one has been used up.
  *
  * Even when shm_mq_receive() returns SHM_MQ_WOULD_BLOCK, this can still
  * accumulate bytes from a partially-read message, so it's useful to call
@@ -183,6 +307,16 @@ TupleQueueReaderNext(TupleQueueReader *reader, bool nowait, bool *done)
 	if (done != NULL)
 		*done = false;
 
+	/* Return the next tuple of the current message, if there's one left. */
+	if (reader->message_off < reader->message_len)
+	{
+		tuple = (MinimalTuple) (reader->message + reader->message_off);
+		Assert(reader->message_off + tuple->t_len <= reader->message_len);
+		reader->message_off += MAXALIGN(tuple->t_len);
+
+		return tuple;
+	}
+
 	/* Attempt to read a message. */
 	result = shm_mq_receive(reader->queue, &nbytes, &data, nowait);
 
@@ -201,10 +335,14 @@ TupleQueueReaderNext(TupleQueueReader *reader, bool nowait, bool *done)
 
 	/*
 	 * Return a pointer to the queue memory directly (which had better be
-	 * sufficiently aligned).
+	 * sufficiently aligned).  Any further tuples in the message follow it.
 	 */
 	tuple = (MinimalTuple) data;
-	Assert(tuple->t_len == nbytes);
+	Assert(tuple->t_len <= nbytes);
+
+	reader->message = (char *) data;
+	reader->message_len = nbytes;
+	reader->message_off = MAXALIGN(tuple->t_len);
 
 	return tuple;
 }
@@ -36,6 +36,8 @@ bool		jit_dump_bitcode = false;
 bool		jit_expressions = true;
 bool		jit_profiling_support = false;
 bool		jit_tuple_deforming = true;
+int			jit_deform_cache_size = 256;
+int			jit_defer_evaluations = 0;
 double		jit_above_cost = 100000;
 double		jit_inline_above_cost = 500000;
 double		jit_optimize_above_cost = 500000;
@@ -46,6 +48,7 @@ static bool provider_failed_loading = false;
 
 
 static bool provider_init(void);
+static bool jit_expr_wanted(struct ExprState *state);
 
 
 /*
@@ -149,6 +152,40 @@ jit_release_context(JitContext *context)
  */
 bool
 jit_compile_expr(struct ExprState *state)
+{
+	if (!jit_expr_wanted(state))
+		return false;
+
+	/* this also takes !jit_enabled into account */
+	if (provider_init())
+		return provider.compile_expr(state);
+
+	return false;
+}
+
+/*
+ * Should JIT compilation of an expression be put off until it has been
+ * evaluated jit_defer_evaluations times?
+ *
+ * Returns true if the expression would be JIT compiled by jit_compile_expr(),
+ * and deferred compilation is enabled.  The provider is not loaded here, so
+ * that queries that finish before reaching the threshold don't pay for that
+ * either.
+ */
+bool
+jit_defer_compile_expr(struct ExprState *state)
+{
+	if (jit_defer_evaluations <= 0 || !jit_enabled)
+		return false;
+
+	return jit_expr_wanted(state);
+}
+
+/*
+ * Check whether the plan an expression belongs to asks for JIT compiling it.
+ */
+static bool
+jit_expr_wanted(struct ExprState *state)
 {
 	/*
 	 * We can easily create a one-off context for functions without an
@@ -170,11 +207,7 @@ jit_compile_expr(struct ExprState *state)
 	if (!(state->parent->state->es_jit_flags & PGJIT_EXPR))
 		return false;
 
-	/* this also takes !jit_enabled into account */
-	if (provider_init())
-		return provider.compile_expr(state);
-
-	return false;
+	return true;
 }
 
 /* Aggregate JIT instrumentation information */
@@ -182,6 +215,7 @@ void
 InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add)
 {
 	dst->created_functions += add->created_functions;
+	dst->cached_deform_functions += add->cached_deform_functions;
 	INSTR_TIME_ADD(dst->generation_counter, add->generation_counter);
 	INSTR_TIME_ADD(dst->deform_counter, add->deform_counter);
 	INSTR_TIME_ADD(dst->inlining_counter, add->inlining_counter);
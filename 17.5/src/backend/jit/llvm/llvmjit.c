@@ -115,6 +115,7 @@ static LLVMOrcJITStackRef llvm_opt3_orc;
 
 
 static void llvm_release_context(JitContext *context);
+static void llvm_release_handles(LLVMJitContext *context);
 static void llvm_session_initialize(void);
 static void llvm_shutdown(int code, Datum arg);
 static void llvm_compile_module(LLVMJitContext *context);
@@ -241,6 +242,13 @@ llvm_create_context(int jitFlags)
 
 	llvm_session_initialize();
 
+	/*
+	 * Without any JIT context in use, no generated code can still reference
+	 * cached deform functions, so this is the time to evict them.
+	 */
+	if (llvm_jit_context_in_use_count == 0)
+		llvm_deform_cache_maintain();
+
 	llvm_recreate_llvm_context();
 
 	ResourceOwnerEnlarge(CurrentResourceOwner);
@@ -265,7 +273,6 @@ static void
 llvm_release_context(JitContext *context)
 {
 	LLVMJitContext *llvm_jit_context = (LLVMJitContext *) context;
-	ListCell   *lc;
 
 	/*
 	 * Consider as cleaned up even if we skip doing so below, that way we can
@@ -283,6 +290,62 @@ llvm_release_context(JitContext *context)
 
 	llvm_enter_fatal_on_oom();
 
+	llvm_release_handles(llvm_jit_context);
+
+	llvm_leave_fatal_on_oom();
+
+	if (llvm_jit_context->resowner)
+		ResourceOwnerForgetJIT(llvm_jit_context->resowner, llvm_jit_context);
+}
+
+/*
+ * Create a context for code that is to be kept beyond the end of the current
+ * query, such as cached deform functions.
+ *
+ * Unlike contexts created by llvm_create_context(), the context is not tied
+ * to a resource owner and doesn't count as being in use.  The code emitted
+ * into it stays valid until llvm_reset_persistent_context() is called.
+ */
+LLVMJitContext *
+llvm_create_persistent_context(int jitFlags)
+{
+	LLVMJitContext *context;
+
+	llvm_assert_in_fatal_section();
+
+	llvm_session_initialize();
+
+	context = MemoryContextAllocZero(TopMemoryContext,
+									 sizeof(LLVMJitContext));
+	context->base.flags = jitFlags;
+
+	return context;
+}
+
+/*
+ * Release all code emitted into a context created by
+ * llvm_create_persistent_context().  The context itself can be reused.
+ */
+void
+llvm_reset_persistent_context(LLVMJitContext *context)
+{
+	if (proc_exit_inprogress)
+		return;
+
+	llvm_enter_fatal_on_oom();
+	llvm_release_handles(context);
+	llvm_leave_fatal_on_oom();
+}
+
+/*
+ * Dispose of the pending module of a context and of all the code emitted
+ * for it.
+ */
+static void
+llvm_release_handles(LLVMJitContext *llvm_jit_context)
+{
+	ListCell   *lc;
+
 	if (llvm_jit_context->module)
 	{
 		LLVMDisposeModule(llvm_jit_context->module);
@@ -321,11 +384,6 @@ llvm_release_context(JitContext *context)
 	}
 	list_free(llvm_jit_context->handles);
 	llvm_jit_context->handles = NIL;
-
-	llvm_leave_fatal_on_oom();
-
-	if (llvm_jit_context->resowner)
-		ResourceOwnerForgetJIT(llvm_jit_context->resowner, llvm_jit_context);
 }
 
 /*
@@ -7,6 +7,10 @@
  * knowledge of the tuple descriptor. Fixed column widths, NOT NULLness, etc
  * can be taken advantage of.
  *
+ * As the generated code only depends on the physical layout of the tuple
+ * descriptor, compiled deform functions are cached per backend and reused by
+ * later queries, see llvm_deform_cache_lookup().
+ *
  * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -22,9 +26,66 @@
 
 #include "access/htup_details.h"
 #include "access/tupdesc_details.h"
+#include "common/hashfn.h"
 #include "executor/tuptable.h"
 #include "jit/llvmjit.h"
 #include "jit/llvmjit_emit.h"
+#include "lib/ilist.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+
+/*
+ * Key of the deform function cache.  Apart from the slot type, the number of
+ * attributes to deform and the optimization settings, the generated code
+ * depends on the properties of the descriptor's columns summarized in sig, an
+ * array of DeformCacheAttr.
+ */
+typedef struct DeformCacheKey
+{
+	const TupleTableSlotOps *ops;
+	int			natts;			/* number of attributes to deform */
+	int			jitflags;		/* PGJIT_OPT3 and PGJIT_INLINE bits */
+	int			siglen;			/* length of sig in bytes */
+	char	   *sig;
+} DeformCacheKey;
+
+typedef struct DeformCacheAttr
+{
+	int16		attlen;
+	char		attalign;
+	bool		attbyval;
+	bool		attnotnull;
+	bool		atthasmissing;
+	bool		attisdropped;
+} DeformCacheAttr;
+
+typedef struct DeformCacheEntry
+{
+	DeformCacheKey key;			/* hash key (must be first) */
+	void	   *fn;				/* address of the emitted function */
+	LLVMJitContext *jit_context;	/* context the function was emitted into */
+	uint64		epoch;			/* deform_cache_epoch of the last use */
+	dlist_node	lru_node;		/* position in deform_cache_lru */
+} DeformCacheEntry;
+
+/* the cache, and the memory its keys live in */
+static HTAB *deform_cache = NULL;
+static MemoryContext deform_cache_cxt = NULL;
+
+/* entries, most recently used first */
+static dlist_head deform_cache_lru = DLIST_STATIC_INIT(deform_cache_lru);
+
+/*
+ * Incremented whenever no JIT context is in use.  Code of the contexts in use
+ * can only call entries whose epoch is the current one.
+ */
+static uint64 deform_cache_epoch = 0;
+
+/* context of a compilation that failed with an error, reused by the next */
+static LLVMJitContext *deform_cache_spare_context = NULL;
+
+static void deform_cache_evict(DeformCacheEntry *entry);
 
 
 /*
@@ -775,3 +836,212 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 	return v_deform_fn;
 }
+
+static uint32
+deform_cache_hash(const void *key, Size keysize)
+{
+	const DeformCacheKey *k = (const DeformCacheKey *) key;
+	uint32		h;
+
+	h = hash_bytes((const unsigned char *) k->sig, k->siglen);
+	h = hash_combine(h, hash_bytes_uint32((uint32) k->natts));
+	h = hash_combine(h, hash_bytes_uint32((uint32) k->jitflags));
+	h = hash_combine(h, hash_bytes_uint32((uint32) (uintptr_t) k->ops));
+
+	return h;
+}
+
+static int
+deform_cache_match(const void *key1, const void *key2, Size keysize)
+{
+	const DeformCacheKey *k1 = (const DeformCacheKey *) key1;
+	const DeformCacheKey *k2 = (const DeformCacheKey *) key2;
+
+	if (k1->ops != k2->ops || k1->natts != k2->natts ||
+		k1->jitflags != k2->jitflags || k1->siglen != k2->siglen)
+		return 1;
+
+	return memcmp(k1->sig, k2->sig, k1->siglen);
+}
+
+/*
+ * Return the address of a compiled function deforming natts columns of
+ * tuples described by desc in slots of type ops, or NULL if the caller has
+ * to generate the code itself.  context is the caller's JIT context, whose
+ * instrumentation counts the functions found in the cache.
+ *
+ * Functions are compiled into JIT contexts that outlive the query, so that
+ * repeated queries over the same tables don't pay for deform code generation
+ * again.  They are compiled with the optimization and inlining settings of
+ * the caller's context, and cached separately for each combination of them.
+ * An optimized query thus gets optimized deform code without spending the
+ * time to optimize it again, but as the function is called through its
+ * address, LLVM can't inline it into the expression.  The gain of inlining
+ * the deform step is small compared to optimizing it, which usually is the
+ * largest part of a query's optimization time.
+ *
+ * At most jit_deform_cache_size functions are kept.  When a new function
+ * doesn't fit, the least recently used one that no code in use can call is
+ * evicted.  If there is none, the caller builds its own function.
+ */
+void *
+llvm_deform_cache_lookup(LLVMJitContext *context, TupleDesc desc,
+						 const TupleTableSlotOps *ops, int natts)
+{
+	DeformCacheKey key;
+	DeformCacheAttr *sig;
+	DeformCacheEntry *entry;
+	LLVMJitContext *jit_context;
+	LLVMValueRef v_deform_fn;
+	char	   *funcname;
+	void	   *fn;
+	bool		found;
+
+	if (jit_deform_cache_size <= 0)
+		return NULL;
+
+	/* same as the checks in slot_compile_deform() */
+	if (ops != &TTSOpsHeapTuple && ops != &TTSOpsBufferHeapTuple &&
+		ops != &TTSOpsMinimalTuple)
+		return NULL;
+
+	if (deform_cache == NULL)
+	{
+		HASHCTL		ctl;
+
+		deform_cache_cxt = AllocSetContextCreate(TopMemoryContext,
+												 "LLVM deform cache",
+												 ALLOCSET_SMALL_SIZES);
+
+		ctl.keysize = sizeof(DeformCacheKey);
+		ctl.entrysize = sizeof(DeformCacheEntry);
+		ctl.hash = deform_cache_hash;
+		ctl.match = deform_cache_match;
+		ctl.hcxt = deform_cache_cxt;
+		deform_cache = hash_create("LLVM deform cache", 64, &ctl,
+								   HASH_ELEM | HASH_FUNCTION | HASH_COMPARE |
+								   HASH_CONTEXT);
+	}
+
+	/* zeroed, so that padding doesn't affect hashing and comparisons */
+	sig = palloc0(sizeof(DeformCacheAttr) * desc->natts);
+	for (int attnum = 0; attnum < desc->natts; attnum++)
+	{
+		Form_pg_attribute att = TupleDescAttr(desc, attnum);
+
+		sig[attnum].attlen = att->attlen;
+		sig[attnum].attalign = att->attalign;
+		sig[attnum].attbyval = att->attbyval;
+		sig[attnum].attnotnull = att->attnotnull;
+		sig[attnum].atthasmissing = att->atthasmissing;
+		sig[attnum].attisdropped = att->attisdropped;
+	}
+
+	key.ops = ops;
+	key.natts = natts;
+	key.jitflags = context->base.flags & (PGJIT_OPT3 | PGJIT_INLINE);
+	key.siglen = sizeof(DeformCacheAttr) * desc->natts;
+	key.sig = (char *) sig;
+
+	entry = hash_search(deform_cache, &key, HASH_FIND, NULL);
+	if (entry)
+	{
+		pfree(sig);
+		entry->epoch = deform_cache_epoch;
+		dlist_move_head(&deform_cache_lru, &entry->lru_node);
+		context->base.instr.cached_deform_functions++;
+		return entry->fn;
+	}
+
+	/* make room, unless all entries may be called by code in use */
+	while (hash_get_num_entries(deform_cache) >= jit_deform_cache_size)
+	{
+		DeformCacheEntry *victim;
+
+		victim = dlist_tail_element(DeformCacheEntry, lru_node,
+									&deform_cache_lru);
+		if (victim->epoch == deform_cache_epoch)
+		{
+			pfree(sig);
+			return NULL;
+		}
+		deform_cache_evict(victim);
+	}
+
+	/* reuse the context of a compilation that failed with an error */
+	jit_context = deform_cache_spare_context;
+	if (jit_context == NULL)
+		jit_context = deform_cache_spare_context =
+			llvm_create_persistent_context(PGJIT_PERFORM | PGJIT_DEFORM |
+										   key.jitflags);
+	else
+	{
+		llvm_reset_persistent_context(jit_context);
+		jit_context->base.flags = PGJIT_PERFORM | PGJIT_DEFORM | key.jitflags;
+	}
+
+	v_deform_fn = slot_compile_deform(jit_context, desc, ops, natts);
+	if (v_deform_fn == NULL)
+	{
+		pfree(sig);
+		return NULL;
+	}
+
+	funcname = pstrdup(LLVMGetValueName(v_deform_fn));
+	fn = llvm_get_function(jit_context, funcname);
+	pfree(funcname);
+
+	/* the context now belongs to the entry */
+	deform_cache_spare_context = NULL;
+
+	entry = hash_search(deform_cache, &key, HASH_ENTER, &found);
+	Assert(!found);
+	entry->key.sig = MemoryContextAlloc(deform_cache_cxt, key.siglen);
+	memcpy(entry->key.sig, sig, key.siglen);
+	entry->fn = fn;
+	entry->jit_context = jit_context;
+	entry->epoch = deform_cache_epoch;
+	dlist_push_head(&deform_cache_lru, &entry->lru_node);
+
+	pfree(sig);
+
+	return fn;
+}
+
+/*
+ * Remove an entry from the cache and release the code of its function.
+ */
+static void
+deform_cache_evict(DeformCacheEntry *entry)
+{
+	LLVMJitContext *jit_context = entry->jit_context;
+	char	   *sig = entry->key.sig;
+
+	dlist_delete(&entry->lru_node);
+	if (hash_search(deform_cache, &entry->key, HASH_REMOVE, NULL) == NULL)
+		elog(ERROR, "LLVM deform cache entry not found");
+	pfree(sig);
+
+	llvm_reset_persistent_context(jit_context);
+	pfree(jit_context);
+}
+
+/*
+ * Start a new epoch of the deform cache, and evict the least recently used
+ * functions if jit_deform_cache_size has been lowered.
+ *
+ * Must only be called while no JIT context is in use, as generated code
+ * calls cached functions through their addresses.
+ */
+void
+llvm_deform_cache_maintain(void)
+{
+	if (deform_cache == NULL)
+		return;
+
+	deform_cache_epoch++;
+
+	while (hash_get_num_entries(deform_cache) > Max(jit_deform_cache_size, 0))
+		deform_cache_evict(dlist_tail_element(DeformCacheEntry, lru_node,
+											  &deform_cache_lru));
+}
@@ -308,6 +308,7 @@ llvm_compile_expr(ExprState *state)
 					LLVMBasicBlockRef b_fetch;
 					LLVMValueRef v_nvalid;
 					LLVMValueRef l_jit_deform = NULL;
+					void	   *cached_deform = NULL;
 					const TupleTableSlotOps *tts_ops = NULL;
 
 					b_fetch = l_bb_before_v(opblocks[opno + 1],
@@ -356,16 +357,42 @@ llvm_compile_expr(ExprState *state)
 					if (tts_ops && desc && (context->base.flags & PGJIT_DEFORM))
 					{
 						INSTR_TIME_SET_CURRENT(deform_starttime);
-						l_jit_deform =
-							slot_compile_deform(context, desc,
-												tts_ops,
-												op->d.fetch.last_var);
+
+						/*
+						 * Prefer a deform function compiled by an earlier
+						 * query, otherwise build one in this module.
+						 */
+						cached_deform =
+							llvm_deform_cache_lookup(context, desc, tts_ops,
+													 op->d.fetch.last_var);
+						if (!cached_deform)
+							l_jit_deform =
+								slot_compile_deform(context, desc,
+													tts_ops,
+													op->d.fetch.last_var);
 						INSTR_TIME_SET_CURRENT(deform_endtime);
 						INSTR_TIME_ACCUM_DIFF(context->base.instr.deform_counter,
 											  deform_endtime, deform_starttime);
 					}
 
-					if (l_jit_deform)
+					if (cached_deform)
+					{
+						LLVMTypeRef deform_sig;
+						LLVMTypeRef param_types[1];
+						LLVMValueRef params[1];
+
+						/* call the cached function through its address */
+						param_types[0] = l_ptr(StructTupleTableSlot);
+						deform_sig = LLVMFunctionType(LLVMVoidTypeInContext(lc),
+													  param_types,
+													  lengthof(param_types), 0);
+						params[0] = v_slot;
+
+						l_call(b, deform_sig,
+							   l_ptr_const(cached_deform, l_ptr(deform_sig)),
+							   params, lengthof(params), "");
+					}
+					else if (l_jit_deform)
 					{
 						LLVMValueRef params[1];
 
@@ -668,6 +695,93 @@ llvm_compile_expr(ExprState *state)
 					break;
 				}
 
+			case EEOP_HASHDATUM_SET_INITVAL:
+				{
+					LLVMValueRef v_initvalue;
+
+					v_initvalue = l_sizet_const(op->d.hashdatum_initvalue.init_value);
+
+					LLVMBuildStore(b, v_initvalue, v_resvaluep);
+					LLVMBuildStore(b, l_sbool_const(0), v_resnullp);
+					LLVMBuildBr(b, opblocks[opno + 1]);
+					break;
+				}
+
+			case EEOP_HASHDATUM_FIRST:
+			case EEOP_HASHDATUM_NEXT32:
+				{
+					FunctionCallInfo fcinfo = op->d.hashdatum.fcinfo_data;
+					LLVMValueRef v_fcinfo;
+					LLVMValueRef v_fcinfo_isnull;
+					LLVMValueRef v_argisnull;
+					LLVMValueRef v_prevhash = NULL;
+					LLVMValueRef v_nullhash;
+					LLVMValueRef v_hashvalue;
+					LLVMValueRef v_retval;
+					LLVMBasicBlockRef b_ifnotnull;
+					LLVMBasicBlockRef b_ifnull;
+
+					b_ifnotnull = l_bb_before_v(opblocks[opno + 1],
+												"b.%d.ifnotnull", opno);
+					b_ifnull = l_bb_before_v(opblocks[opno + 1],
+											 "b.%d.ifnull", opno);
+
+					v_fcinfo = l_ptr_const(fcinfo,
+										   l_ptr(StructFunctionCallInfoData));
+
+					if (opcode == EEOP_HASHDATUM_NEXT32)
+					{
+						LLVMValueRef v_tmp1;
+						LLVMValueRef v_tmp2;
+
+						/* rotate the previous hash value left by one bit */
+						v_prevhash = l_load(b, TypeSizeT, v_resvaluep,
+											"prevhash");
+						v_prevhash = LLVMBuildTrunc(b, v_prevhash,
+													LLVMInt32TypeInContext(lc),
+													"");
+						v_tmp1 = LLVMBuildShl(b, v_prevhash, l_int32_const(lc, 1),
+											  "");
+						v_tmp2 = LLVMBuildLShr(b, v_prevhash,
+											   l_int32_const(lc, 31), "");
+						v_prevhash = LLVMBuildOr(b, v_tmp1, v_tmp2,
+												 "rotatedhash");
+						v_nullhash = LLVMBuildZExt(b, v_prevhash, TypeSizeT, "");
+					}
+					else
+						v_nullhash = l_sizet_const(0);
+
+					v_argisnull = l_funcnull(b, v_fcinfo, 0);
+					LLVMBuildCondBr(b,
+									LLVMBuildICmp(b, LLVMIntEQ, v_argisnull,
+												  l_sbool_const(1), ""),
+									b_ifnull,
+									b_ifnotnull);
+
+					/* NULL datums hash to zero */
+					LLVMPositionBuilderAtEnd(b, b_ifnull);
+					LLVMBuildStore(b, v_nullhash, v_resvaluep);
+					LLVMBuildStore(b, l_sbool_const(0), v_resnullp);
+					LLVMBuildBr(b, opblocks[opno + 1]);
+
+					/* call the hash function, and combine the result */
+					LLVMPositionBuilderAtEnd(b, b_ifnotnull);
+					v_retval = BuildV1Call(context, b, mod, fcinfo,
+										   &v_fcinfo_isnull);
+					v_hashvalue = LLVMBuildTrunc(b, v_retval,
+												 LLVMInt32TypeInContext(lc),
+												 "");
+					if (opcode == EEOP_HASHDATUM_NEXT32)
+						v_hashvalue = LLVMBuildXor(b, v_prevhash, v_hashvalue,
+												   "");
+					v_hashvalue = LLVMBuildZExt(b, v_hashvalue, TypeSizeT, "");
+
+					LLVMBuildStore(b, v_hashvalue, v_resvaluep);
+					LLVMBuildStore(b, l_sbool_const(0), v_resnullp);
+					LLVMBuildBr(b, opblocks[opno + 1]);
+					break;
+				}
+
 			case EEOP_FUNCEXPR_FUSAGE:
 				build_EvalXFunc(b, mod, "ExecEvalFuncExprFusage",
 								v_state, op, v_econtext);
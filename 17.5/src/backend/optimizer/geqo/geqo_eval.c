@@ -278,6 +278,7 @@ merge_clump(PlannerInfo *root, List *clumps, Clump *new_clump, int num_gene,
 
 				/* Find and save the cheapest paths for this joinrel */
 				set_cheapest(joinrel);
+				set_grouped_rel_cheapest(joinrel);
 
 				/* Absorb new clump into old */
 				old_clump->joinrel = joinrel;
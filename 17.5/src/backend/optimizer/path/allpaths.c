@@ -40,6 +40,7 @@
 #include "optimizer/paths.h"
 #include "optimizer/plancat.h"
 #include "optimizer/planner.h"
+#include "optimizer/prep.h"
 #include "optimizer/tlist.h"
 #include "parser/parse_clause.h"
 #include "parser/parsetree.h"
@@ -87,10 +88,17 @@ set_rel_pathlist_hook_type set_rel_pathlist_hook = NULL;
 /* Hook for plugins to replace standard_join_search() */
 join_search_hook_type join_search_hook = NULL;
 
+/*
+ * Don't bother with eager aggregation unless it shrinks the aggregated
+ * relation at least by this factor.
+ */
+#define EAGER_AGG_MIN_GROUP_SIZE	2.0
+
 
 static void set_base_rel_consider_startup(PlannerInfo *root);
 static void set_base_rel_sizes(PlannerInfo *root);
 static void set_base_rel_pathlists(PlannerInfo *root);
+static void set_grouped_base_rel_pathlist(PlannerInfo *root);
 static void set_rel_size(PlannerInfo *root, RelOptInfo *rel,
 						 Index rti, RangeTblEntry *rte);
 static void set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel,
@@ -220,6 +228,12 @@ make_one_rel(PlannerInfo *root, List *joinlist)
 	 */
 	set_base_rel_pathlists(root);
 
+	/*
+	 * If the aggregates can be computed before the joins, generate paths
+	 * that partially aggregate the relation they read from.
+	 */
+	set_grouped_base_rel_pathlist(root);
+
 	/*
 	 * Generate access paths for the entire join tree.
 	 */
@@ -352,6 +366,130 @@ set_base_rel_pathlists(PlannerInfo *root)
 	}
 }
 
+/*
+ * set_grouped_base_rel_pathlist
+ *	  Build the grouped rel of the base relation chosen for eager aggregation,
+ *	  with paths that partially aggregate its rows.
+ *
+ * Joins containing the relation will get grouped rels of their own as they
+ * are built from this one (see make_join_rel).
+ */
+static void
+set_grouped_base_rel_pathlist(PlannerInfo *root)
+{
+	RelOptInfo *rel;
+	RelOptInfo *grouped_rel;
+	PathTarget *input_target;
+	List	   *groupClause = root->eager_agg_groupClause;
+	List	   *groupExprs = NIL;
+	ListCell   *groupClauseCell;
+	bool		can_hash = true;
+	bool		can_sort = true;
+	AggClauseCosts agg_costs;
+	Path	   *input_path;
+	int			i;
+
+	if (root->eager_agg_relid == 0)
+		return;
+
+	rel = find_base_rel(root, root->eager_agg_relid);
+	if (IS_DUMMY_REL(rel))
+		return;
+
+	/*
+	 * Without grouping columns of its own, the rel could only be aggregated
+	 * by a plain Agg, which emits a row even for empty input.  That's fine
+	 * if the query has no GROUP BY either, but otherwise the final Agg would
+	 * see that row joined to every row of the other rels, and make groups
+	 * out of them that shouldn't exist.
+	 */
+	if (groupClause == NIL && root->parse->groupClause != NIL)
+		return;
+
+	/*
+	 * The Agg needs its grouping columns labeled in its input.  They're the
+	 * rel's output Vars that aren't used only in aggregates, in the same
+	 * order as setup_eager_aggregation made the SortGroupClauses.
+	 */
+	input_target = copy_pathtarget(rel->reltarget);
+	input_target->sortgrouprefs = (Index *)
+		palloc0(list_length(input_target->exprs) * sizeof(Index));
+	groupClauseCell = list_head(groupClause);
+	i = 0;
+	foreach_node(Var, var, input_target->exprs)
+	{
+		if (!bms_is_member(var->varattno - FirstLowInvalidHeapAttributeNumber,
+						   root->eager_agg_aggonly_attrs))
+		{
+			SortGroupClause *sgc = lfirst_node(SortGroupClause,
+											   groupClauseCell);
+
+			input_target->sortgrouprefs[i] = sgc->tleSortGroupRef;
+			groupExprs = lappend(groupExprs, var);
+			can_hash &= sgc->hashable;
+			can_sort &= OidIsValid(sgc->sortop);
+			groupClauseCell = lnext(groupClause, groupClauseCell);
+		}
+		i++;
+	}
+	Assert(groupClauseCell == NULL);
+
+	grouped_rel = build_grouped_rel(root, rel);
+	set_grouped_rel_size_estimates(root, grouped_rel, rel, groupExprs);
+
+	if (grouped_rel->rows * EAGER_AGG_MIN_GROUP_SIZE > rel->rows)
+		return;
+
+	MemSet(&agg_costs, 0, sizeof(AggClauseCosts));
+	get_agg_clause_costs(root, AGGSPLIT_INITIAL_SERIAL, &agg_costs);
+
+	input_path = (Path *) create_projection_path(root, rel,
+												 rel->cheapest_total_path,
+												 input_target);
+
+	if (groupClause == NIL)
+		add_path(grouped_rel, (Path *)
+				 create_agg_path(root, grouped_rel, input_path,
+								 grouped_rel->reltarget,
+								 AGG_PLAIN, AGGSPLIT_INITIAL_SERIAL,
+								 NIL, NIL, &agg_costs,
+								 grouped_rel->rows));
+	else
+	{
+		if (can_hash)
+			add_path(grouped_rel, (Path *)
+					 create_agg_path(root, grouped_rel, input_path,
+									 grouped_rel->reltarget,
+									 AGG_HASHED, AGGSPLIT_INITIAL_SERIAL,
+									 groupClause, NIL, &agg_costs,
+									 grouped_rel->rows));
+		if (can_sort)
+		{
+			List	   *pathkeys;
+			Path	   *sorted_path = input_path;
+
+			pathkeys = make_pathkeys_for_sortclauses(root, groupClause,
+													 make_tlist_from_pathtarget(input_target));
+			if (!pathkeys_contained_in(pathkeys, sorted_path->pathkeys))
+				sorted_path = (Path *) create_sort_path(root, rel,
+														sorted_path,
+														pathkeys, -1.0);
+			add_path(grouped_rel, (Path *)
+					 create_agg_path(root, grouped_rel, sorted_path,
+									 grouped_rel->reltarget,
+									 AGG_SORTED, AGGSPLIT_INITIAL_SERIAL,
+									 groupClause, NIL, &agg_costs,
+									 grouped_rel->rows));
+		}
+	}
+
+	if (grouped_rel->pathlist == NIL)
+		return;
+
+	set_cheapest(grouped_rel);
+	rel->grouped_rel = grouped_rel;
+}
+
 /*
  * set_rel_size
  *	  Set size estimates for a base relation
@@ -3362,7 +3500,8 @@ make_rel_from_joinlist(PlannerInfo *root, List *joinlist)
 	{
 		/*
 		 * Consider the different orders in which we could join the rels,
-		 * using a plugin, GEQO, or the regular join search code.
+		 * using a plugin, greedy search, GEQO, or the regular join search
+		 * code.
 		 *
 		 * We put the initial_rels list into a PlannerInfo field because
 		 * has_legal_joinclause() needs to look at it (ugly :-().
@@ -3371,6 +3510,8 @@ make_rel_from_joinlist(PlannerInfo *root, List *joinlist)
 
 		if (join_search_hook)
 			return (*join_search_hook) (root, levels_needed, initial_rels);
+		else if (enable_goo_join_search && levels_needed >= geqo_threshold)
+			return goo_join_search(root, levels_needed, initial_rels);
 		else if (enable_geqo && levels_needed >= geqo_threshold)
 			return geqo(root, levels_needed, initial_rels);
 		else
@@ -3473,6 +3614,7 @@ standard_join_search(PlannerInfo *root, int levels_needed, List *initial_rels)
 
 			/* Find and save the cheapest paths for this rel */
 			set_cheapest(rel);
+			set_grouped_rel_cheapest(rel);
 
 #ifdef OPTIMIZER_DEBUG
 			pprint(rel);
@@ -4360,3 +4502,27 @@ generate_partitionwise_join_paths(PlannerInfo *root, RelOptInfo *rel)
 	add_paths_to_append_rel(root, rel, live_children);
 	list_free(live_children);
 }
+
+/*
+ * set_grouped_rel_cheapest
+ *		Finish the grouped rel of a join relation, if it has one, once all
+ *		paths have been added to it.
+ *
+ * A grouped rel that didn't get any paths is forgotten.
+ */
+void
+set_grouped_rel_cheapest(RelOptInfo *rel)
+{
+	RelOptInfo *grouped_rel = rel->grouped_rel;
+
+	if (grouped_rel == NULL)
+		return;
+
+	if (grouped_rel->pathlist == NIL)
+	{
+		rel->grouped_rel = NULL;
+		return;
+	}
+
+	set_cheapest(grouped_rel);
+}
@@ -81,6 +81,7 @@
 #include "executor/nodeAgg.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeMemoize.h"
+#include "executor/nodeRepartition.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
@@ -147,11 +148,13 @@ bool		enable_hashjoin = true;
 bool		enable_gathermerge = true;
 bool		enable_partitionwise_join = false;
 bool		enable_partitionwise_aggregate = false;
+bool		enable_eager_aggregate = false;
 bool		enable_parallel_append = true;
 bool		enable_parallel_hash = true;
 bool		enable_partition_pruning = true;
 bool		enable_presorted_aggregate = true;
 bool		enable_async_append = true;
+bool		enable_repartition = false;
 
 typedef struct
 {
@@ -2492,6 +2495,95 @@ cost_material(Path *path,
 	path->total_cost = startup_cost + run_cost;
 }
 
+/*
+ * cost_repartition
+ *	  Determines and returns the cost of redistributing the tuples of a
+ *	  partial path among the parallel participants, including the cost of
+ *	  reading the input data.
+ *
+ * 'tuples' is the number of tuples per participant, and we assume each
+ * participant reads back about as many as it writes.  The tuples always go
+ * through temporary files, and nothing can be returned before all of the
+ * input has been written, so the whole input and write cost is startup cost.
+ */
+void
+cost_repartition(Path *path, Cost input_total_cost,
+				 double tuples, int width, int numCols)
+{
+	Cost		startup_cost = input_total_cost;
+	Cost		run_cost = 0;
+	double		npages = ceil(relation_byte_size(tuples, width) / BLCKSZ);
+
+	path->rows = tuples;
+
+	/* Hash each tuple and write it out */
+	startup_cost += (cpu_operator_cost * numCols + cpu_tuple_cost) * tuples;
+	startup_cost += seq_page_cost * npages;
+
+	/* Read the tuples back */
+	run_cost += cpu_tuple_cost * tuples;
+	run_cost += seq_page_cost * npages;
+
+	path->startup_cost = startup_cost;
+	path->total_cost = startup_cost + run_cost;
+}
+
+/*
+ * cost_range_repartition
+ *	  Determines and returns the cost of redistributing the tuples of a
+ *	  partial path among the parallel participants by ranges of the leading
+ *	  pathkey, and sorting each range.
+ *
+ * 'nbounds' is the number of range bounds available, and 'nparticipants'
+ * the number of planned participants.  Each participant is assumed to sort
+ * about an equal share of the ranges.  Since the ranges are sorted
+ * separately, the sorts are smaller, and more likely to fit into work_mem,
+ * than a sort of the whole input of each participant.  All ranges must be
+ * sorted, and written out, before any tuple can be returned.  A single
+ * participant then reads back and returns the tuples of all participants.
+ */
+void
+cost_range_repartition(Path *path, PlannerInfo *root, List *pathkeys,
+					   Cost input_total_cost, double tuples, int width,
+					   int nbounds, int nparticipants)
+{
+	Path		sort_path;		/* dummy for result of cost_sort */
+	int			nranges;
+	double		nsorts;
+	double		sort_tuples;
+	double		npages = ceil(relation_byte_size(tuples, width) / BLCKSZ);
+	Cost		startup_cost;
+	Cost		run_cost;
+
+	/* this must agree with ExecRepartitionNumParts() */
+	nranges = Min(nbounds + 1,
+				  nparticipants * REPARTITION_RANGES_PER_PARTICIPANT);
+	nsorts = Max(1.0, (double) nranges / nparticipants);
+	sort_tuples = clamp_row_est(tuples / nsorts);
+
+	/* The tuples are read back into the sorts before any is returned */
+	cost_repartition(path, input_total_cost, tuples, width, 0);
+	startup_cost = path->total_cost;
+
+	/* Find each tuple's range by binary search over the bounds */
+	if (nranges > 1)
+		startup_cost += cpu_operator_cost * LOG2(nranges) * tuples;
+
+	cost_sort(&sort_path, root, pathkeys, 0.0, sort_tuples, width,
+			  0.0, work_mem, -1.0);
+	startup_cost += sort_path.total_cost * nsorts;
+
+	/* The sorted ranges are always written out */
+	startup_cost += seq_page_cost * npages;
+
+	/* The elected participant reads back the tuples of all participants */
+	run_cost = (cpu_operator_cost * tuples + seq_page_cost * npages) *
+		nparticipants;
+
+	path->startup_cost = startup_cost;
+	path->total_cost = startup_cost + run_cost;
+}
+
 /*
  * cost_memoize_rescan
  *	  Determines the estimated cost of rescanning a Memoize node.
@@ -2529,6 +2621,17 @@ cost_memoize_rescan(PlannerInfo *root, MemoizePath *mpath,
 	/* available cache space */
 	hash_mem_bytes = get_hash_memory_limit();
 
+	/*
+	 * If this is the inner side of a partial join, the participants may share
+	 * their cache entries, in which case half of the memory goes to the shared
+	 * cache (see nodeMemoize.c).  We don't try to estimate how many extra hits
+	 * that gives us, as that depends on how the outer rows are spread among
+	 * the participants.  Outside of a parallel plan, the executor doesn't set
+	 * up the shared cache, so the local cache gets all the memory.
+	 */
+	if (enable_shared_memoize && mpath->below_gather)
+		hash_mem_bytes /= 2;
+
 	/*
 	 * Set the number of bytes each cache entry should consume in the cache.
 	 * To provide us with better estimations on how many cache entries we can
@@ -5781,6 +5884,26 @@ get_foreign_key_join_selectivity(PlannerInfo *root,
 	return fkselec;
 }
 
+/*
+ * set_grouped_rel_size_estimates
+ *		Set the size estimates for the grouped rel of a base relation, whose
+ *		rows are partially aggregated by groupExprs.
+ *
+ * We set only the rows field; the width was computed along with the grouped
+ * rel's reltarget (see build_grouped_rel).
+ */
+void
+set_grouped_rel_size_estimates(PlannerInfo *root, RelOptInfo *grouped_rel,
+							   RelOptInfo *rel, List *groupExprs)
+{
+	double		numGroups;
+
+	numGroups = estimate_num_groups(root, groupExprs, rel->rows, NULL, NULL);
+
+	/* Can't have more groups than rows */
+	grouped_rel->rows = clamp_row_est(Min(numGroups, rel->rows));
+}
+
 /*
  * set_subquery_size_estimates
  *		Set the size estimates for a base relation that is a subquery.
@@ -6376,9 +6499,12 @@ get_parallel_divisor(Path *path)
 	 * the time we reach 4 workers, the leader no longer makes a meaningful
 	 * contribution.  Thus, for now, estimate that the leader spends 30% of
 	 * its time servicing each worker, and the remainder executing the
-	 * parallel plan.
+	 * parallel plan.  With more than parallel_leader_max_workers workers, it
+	 * doesn't execute the plan at all.
 	 */
-	if (parallel_leader_participation)
+	if (parallel_leader_participation &&
+		(parallel_leader_max_workers < 0 ||
+		 path->parallel_workers <= parallel_leader_max_workers))
 	{
 		double		leader_contribution;
 
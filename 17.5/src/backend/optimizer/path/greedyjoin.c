@@ -0,0 +1,233 @@
+/*-------------------------------------------------------------------------
+ *
+ * greedyjoin.c
+ *	  Greedy join order search for queries with many relations
+ *
+ * This implements Greedy Operator Ordering (GOO): starting from the base
+ * relations, repeatedly join the pair of relations whose join result is
+ * estimated to be the smallest, until only a single relation is left.
+ * Unlike the exhaustive search of standard_join_search(), the number of
+ * joins considered grows only quadratically with the number of input
+ * relations, and unlike GEQO the result is deterministic.  It is used in
+ * place of GEQO for large join problems when enable_goo_join_search is set.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/optimizer/path/greedyjoin.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "optimizer/joininfo.h"
+#include "optimizer/pathnode.h"
+#include "optimizer/paths.h"
+#include "utils/memutils.h"
+
+
+/* Markers stored in the pair estimate matrix */
+#define GOO_NOT_EVALUATED	(-2.0)
+#define GOO_ILLEGAL_JOIN	(-1.0)
+
+/* GUC parameter */
+bool		enable_goo_join_search = false;
+
+static double goo_eval_join(PlannerInfo *root, MemoryContext evalcxt,
+							RelOptInfo *rel1, RelOptInfo *rel2);
+static RelOptInfo *goo_build_join(PlannerInfo *root,
+								  RelOptInfo *rel1, RelOptInfo *rel2);
+
+
+/*
+ * goo_join_search
+ *	  Find a join order for the given relations by greedily joining the
+ *	  pair with the smallest estimated result first.
+ *
+ * The signature matches join_search_hook_type, so that extensions can also
+ * install this as their join search strategy.
+ *
+ * To keep the search cheap, each candidate pair is evaluated in a scratch
+ * memory context (in the same way geqo_eval() does it), and only its row
+ * estimate is remembered.  A pair's estimate does not change until one of
+ * its members is merged with some other relation, so each pair needs to be
+ * evaluated only once.  Only the chosen joins are built for real.
+ *
+ * Pairs without a join clause or join order restriction between them are
+ * only considered once no such "desirable" pair is left, so cartesian
+ * products are postponed as long as possible.
+ */
+RelOptInfo *
+goo_join_search(PlannerInfo *root, int levels_needed, List *initial_rels)
+{
+	int			nrels = list_length(initial_rels);
+	int			nremaining = nrels;
+	RelOptInfo **rels;
+	double	   *estimates;
+	MemoryContext evalcxt;
+	int			i;
+
+	Assert(levels_needed == nrels);
+	Assert(root->join_rel_level == NULL);
+
+	rels = palloc(nrels * sizeof(RelOptInfo *));
+	i = 0;
+	foreach_ptr(RelOptInfo, rel, initial_rels)
+		rels[i++] = rel;
+
+	estimates = palloc(nrels * nrels * sizeof(double));
+	for (i = 0; i < nrels * nrels; i++)
+		estimates[i] = GOO_NOT_EVALUATED;
+
+	evalcxt = AllocSetContextCreate(CurrentMemoryContext,
+									"GOO",
+									ALLOCSET_DEFAULT_SIZES);
+
+	while (nremaining > 1)
+	{
+		int			best_i = -1;
+		int			best_j = -1;
+		double		best_rows = 0;
+		RelOptInfo *joinrel;
+
+		for (int pass = 0; pass < 2 && best_i < 0; pass++)
+		{
+			bool		force = (pass == 1);
+
+			for (i = 0; i < nrels; i++)
+			{
+				if (rels[i] == NULL)
+					continue;
+
+				for (int j = i + 1; j < nrels; j++)
+				{
+					double	   *est = &estimates[i * nrels + j];
+
+					if (rels[j] == NULL)
+						continue;
+
+					if (!force &&
+						!have_relevant_joinclause(root, rels[i], rels[j]) &&
+						!have_join_order_restriction(root, rels[i], rels[j]))
+						continue;
+
+					if (*est == GOO_NOT_EVALUATED)
+						*est = goo_eval_join(root, evalcxt, rels[i], rels[j]);
+
+					if (*est == GOO_ILLEGAL_JOIN)
+						continue;
+
+					if (best_i < 0 || *est < best_rows)
+					{
+						best_i = i;
+						best_j = j;
+						best_rows = *est;
+					}
+				}
+			}
+		}
+
+		if (best_i < 0)
+			elog(ERROR, "failed to build any %d-way joins",
+				 nrels - nremaining + 2);
+
+		joinrel = goo_build_join(root, rels[best_i], rels[best_j]);
+		if (joinrel == NULL)
+			elog(ERROR, "failed to build join of relations %d and %d",
+				 best_i, best_j);
+
+		/*
+		 * The merged relation takes the first slot; the estimates of all
+		 * pairs involving it are now stale.
+		 */
+		rels[best_i] = joinrel;
+		rels[best_j] = NULL;
+		for (i = 0; i < nrels; i++)
+		{
+			estimates[best_i * nrels + i] = GOO_NOT_EVALUATED;
+			estimates[i * nrels + best_i] = GOO_NOT_EVALUATED;
+		}
+		nremaining--;
+	}
+
+	MemoryContextDelete(evalcxt);
+
+	for (i = 0; i < nrels; i++)
+	{
+		if (rels[i] != NULL)
+			return rels[i];
+	}
+
+	elog(ERROR, "failed to join all relations together");
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * goo_eval_join
+ *	  Estimate the number of rows produced by joining rel1 and rel2, or
+ *	  return GOO_ILLEGAL_JOIN if they cannot be joined directly.
+ *
+ * The join relation is built in evalcxt and thrown away again afterwards,
+ * restoring root->join_rel_list and root->join_rel_hash as geqo_eval() does.
+ */
+static double
+goo_eval_join(PlannerInfo *root, MemoryContext evalcxt,
+			  RelOptInfo *rel1, RelOptInfo *rel2)
+{
+	MemoryContext oldcxt;
+	RelOptInfo *joinrel;
+	int			savelength;
+	struct HTAB *savehash;
+	double		rows;
+
+	oldcxt = MemoryContextSwitchTo(evalcxt);
+
+	savelength = list_length(root->join_rel_list);
+	savehash = root->join_rel_hash;
+	root->join_rel_hash = NULL;
+
+	joinrel = make_join_rel(root, rel1, rel2);
+	rows = joinrel ? joinrel->rows : GOO_ILLEGAL_JOIN;
+
+	root->join_rel_list = list_truncate(root->join_rel_list, savelength);
+	root->join_rel_hash = savehash;
+
+	MemoryContextSwitchTo(oldcxt);
+	MemoryContextReset(evalcxt);
+
+	return rows;
+}
+
+/*
+ * goo_build_join
+ *	  Build the join of rel1 and rel2 for real, including the paths that
+ *	  standard_join_search() would add to it.
+ */
+static RelOptInfo *
+goo_build_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2)
+{
+	RelOptInfo *joinrel;
+
+	joinrel = make_join_rel(root, rel1, rel2);
+	if (joinrel == NULL)
+		return NULL;
+
+	/* Create paths for partitionwise joins. */
+	generate_partitionwise_join_paths(root, joinrel);
+
+	/*
+	 * Except for the topmost scan/join rel, consider gathering partial
+	 * paths.  We'll do the same for the topmost scan/join rel once we know
+	 * the final targetlist (see grouping_planner).
+	 */
+	if (!bms_equal(joinrel->relids, root->all_query_rels))
+		generate_useful_gather_paths(root, joinrel, false);
+
+	/* Find and save the cheapest paths for this joinrel */
+	set_cheapest(joinrel);
+	set_grouped_rel_cheapest(joinrel);
+
+	return joinrel;
+}
@@ -706,7 +706,8 @@ get_memoize_path(PlannerInfo *root, RelOptInfo *innerrel,
 											hash_operators,
 											extra->inner_unique,
 											binary_mode,
-											outer_path->rows);
+											outer_path->rows,
+											outer_path->parallel_workers > 0);
 	}
 
 	return NULL;
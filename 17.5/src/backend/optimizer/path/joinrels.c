@@ -16,6 +16,7 @@
 
 #include "miscadmin.h"
 #include "optimizer/appendinfo.h"
+#include "optimizer/cost.h"
 #include "optimizer/joininfo.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
@@ -38,6 +39,9 @@ static bool restriction_is_constant_false(List *restrictlist,
 static void populate_joinrel_with_paths(PlannerInfo *root, RelOptInfo *rel1,
 										RelOptInfo *rel2, RelOptInfo *joinrel,
 										SpecialJoinInfo *sjinfo, List *restrictlist);
+static void make_grouped_join_rel(PlannerInfo *root, RelOptInfo *rel1,
+								  RelOptInfo *rel2, RelOptInfo *joinrel,
+								  SpecialJoinInfo *sjinfo, List *restrictlist);
 static void try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1,
 								   RelOptInfo *rel2, RelOptInfo *joinrel,
 								   SpecialJoinInfo *parent_sjinfo,
@@ -776,6 +780,9 @@ make_join_rel(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2)
 	populate_joinrel_with_paths(root, rel1, rel2, joinrel, sjinfo,
 								restrictlist);
 
+	/* Likewise for its grouped rel, if eager aggregation applies. */
+	make_grouped_join_rel(root, rel1, rel2, joinrel, sjinfo, restrictlist);
+
 	bms_free(joinrelids);
 
 	return joinrel;
@@ -883,6 +890,49 @@ add_outer_joins_to_relids(PlannerInfo *root, Relids input_relids,
 	return input_relids;
 }
 
+/*
+ * make_grouped_join_rel
+ *	  Add paths to the grouped rel of joinrel that join the partially
+ *	  aggregated rows of one of the given relations to the rows of the other.
+ *
+ * This only applies if one of the relations contains the relation chosen for
+ * eager aggregation and has a grouped rel.  The grouped joinrel is built
+ * the first time we get here for the joinrel.
+ */
+static void
+make_grouped_join_rel(PlannerInfo *root, RelOptInfo *rel1,
+					  RelOptInfo *rel2, RelOptInfo *joinrel,
+					  SpecialJoinInfo *sjinfo, List *restrictlist)
+{
+	RelOptInfo *grouped_rel;
+
+	/* Only one of the relations can contain the aggregated relation */
+	Assert(rel1->grouped_rel == NULL || rel2->grouped_rel == NULL);
+	if (rel1->grouped_rel != NULL)
+		rel1 = rel1->grouped_rel;
+	else if (rel2->grouped_rel != NULL)
+		rel2 = rel2->grouped_rel;
+	else
+		return;
+
+	/* setup_eager_aggregation doesn't allow any other kind of join */
+	Assert(sjinfo->jointype == JOIN_INNER);
+
+	grouped_rel = joinrel->grouped_rel;
+	if (grouped_rel == NULL)
+	{
+		grouped_rel = build_grouped_rel(root, joinrel);
+		set_joinrel_size_estimates(root, grouped_rel, rel1, rel2,
+								   sjinfo, restrictlist);
+		/* The grouped rel can't produce more rows than the plain one */
+		grouped_rel->rows = Min(grouped_rel->rows, joinrel->rows);
+		joinrel->grouped_rel = grouped_rel;
+	}
+
+	populate_joinrel_with_paths(root, rel1, rel2, grouped_rel, sjinfo,
+								restrictlist);
+}
+
 /*
  * populate_joinrel_with_paths
  *	  Add paths to the given joinrel for given pair of joining relations. The
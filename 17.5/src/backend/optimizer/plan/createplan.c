@@ -19,12 +19,14 @@
 #include <math.h>
 
 #include "access/sysattr.h"
+#include "catalog/pg_am.h"
 #include "catalog/pg_class.h"
 #include "foreign/fdwapi.h"
 #include "miscadmin.h"
 #include "nodes/extensible.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
+#include "optimizer/appendinfo.h"
 #include "optimizer/clauses.h"
 #include "optimizer/cost.h"
 #include "optimizer/optimizer.h"
@@ -95,6 +97,9 @@ static Material *create_material_plan(PlannerInfo *root, MaterialPath *best_path
 									  int flags);
 static Memoize *create_memoize_plan(PlannerInfo *root, MemoizePath *best_path,
 									int flags);
+static Repartition *create_repartition_plan(PlannerInfo *root,
+											RepartitionPath *best_path,
+											int flags);
 static Plan *create_unique_plan(PlannerInfo *root, UniquePath *best_path,
 								int flags);
 static Gather *create_gather_plan(PlannerInfo *root, GatherPath *best_path);
@@ -163,6 +168,20 @@ static CustomScan *create_customscan_plan(PlannerInfo *root,
 static NestLoop *create_nestloop_plan(PlannerInfo *root, NestPath *best_path);
 static MergeJoin *create_mergejoin_plan(PlannerInfo *root, MergePath *best_path);
 static HashJoin *create_hashjoin_plan(PlannerInfo *root, HashPath *best_path);
+static void add_hashjoin_runtime_filter(PlannerInfo *root, HashPath *best_path,
+										HashJoin *join_plan, Hash *hash_plan);
+static bool prune_info_uses_params(PartitionPruneInfo *pinfo,
+								   Param *minparam, Param *maxparam);
+static bool add_brin_runtime_filter(PlannerInfo *root, HashJoin *join_plan,
+									RelOptInfo *rel, OpExpr *hclause,
+									Oid geop, Oid leop,
+									Param *minparam, Param *maxparam);
+static Plan *make_brin_filtered_scan(PlannerInfo *root, SeqScan *scan,
+									 Var *key, OpExpr *hclause,
+									 Oid geop, Oid leop,
+									 Param *minparam, Param *maxparam);
+static List *get_append_prunequal(PlannerInfo *root, RelOptInfo *rel,
+								  Path *best_path);
 static Node *replace_nestloop_params(PlannerInfo *root, Node *expr);
 static Node *replace_nestloop_params_mutator(Node *node, PlannerInfo *root);
 static void fix_indexqual_references(PlannerInfo *root, IndexPath *index_path,
@@ -283,6 +302,16 @@ static Memoize *make_memoize(Plan *lefttree, Oid *hashoperators,
 							 Oid *collations, List *param_exprs,
 							 bool singlerow, bool binary_mode,
 							 uint32 est_entries, Bitmapset *keyparamids);
+static Repartition *make_repartition(Plan *lefttree, int numCols,
+									 AttrNumber *hashColIdx,
+									 Oid *hashOperators,
+									 Oid *hashCollations,
+									 int numSortCols,
+									 AttrNumber *sortColIdx,
+									 Oid *sortOperators,
+									 Oid *collations,
+									 bool *nullsFirst,
+									 List *rangeBounds);
 static WindowAgg *make_windowagg(List *tlist, Index winref,
 								 int partNumCols, AttrNumber *partColIdx, Oid *partOperators, Oid *partCollations,
 								 int ordNumCols, AttrNumber *ordColIdx, Oid *ordOperators, Oid *ordCollations,
@@ -467,6 +496,11 @@ create_plan_recurse(PlannerInfo *root, Path *best_path, int flags)
 												(MemoizePath *) best_path,
 												flags);
 			break;
+		case T_Repartition:
+			plan = (Plan *) create_repartition_plan(root,
+													(RepartitionPath *) best_path,
+													flags);
+			break;
 		case T_Unique:
 			if (IsA(best_path, UpperUniquePath))
 			{
@@ -1385,18 +1419,7 @@ create_append_plan(PlannerInfo *root, AppendPath *best_path, int flags)
 	{
 		List	   *prunequal;
 
-		prunequal = extract_actual_clauses(rel->baserestrictinfo, false);
-
-		if (best_path->path.param_info)
-		{
-			List	   *prmquals = best_path->path.param_info->ppi_clauses;
-
-			prmquals = extract_actual_clauses(prmquals, false);
-			prmquals = (List *) replace_nestloop_params(root,
-														(Node *) prmquals);
-
-			prunequal = list_concat(prunequal, prmquals);
-		}
+		prunequal = get_append_prunequal(root, rel, &best_path->path);
 
 		if (prunequal != NIL)
 			partpruneinfo =
@@ -1710,6 +1733,85 @@ create_memoize_plan(PlannerInfo *root, MemoizePath *best_path, int flags)
 	return plan;
 }
 
+/*
+ * create_repartition_plan
+ *	  Create a Repartition plan for 'best_path' and (recursively) plans for
+ *	  its subpaths.
+ *
+ *	  Returns a Plan node.
+ */
+static Repartition *
+create_repartition_plan(PlannerInfo *root, RepartitionPath *best_path,
+						int flags)
+{
+	Repartition *plan;
+	Plan	   *subplan;
+
+	if (best_path->hashClause == NIL)
+	{
+		int			numsortkeys;
+		AttrNumber *sortColIdx;
+		Oid		   *sortOperators;
+		Oid		   *collations;
+		bool	   *nullsFirst;
+		List	   *rangeBounds = best_path->rangeBounds;
+		TargetEntry *tle;
+
+		/* Distributing by range and sorting; see create_sort_plan */
+		subplan = create_plan_recurse(root, best_path->subpath,
+									  flags | CP_SMALL_TLIST);
+		subplan = prepare_sort_from_pathkeys(subplan,
+											 best_path->path.pathkeys,
+											 IS_OTHER_REL(best_path->subpath->parent) ?
+											 best_path->path.parent->relids : NULL,
+											 NULL,
+											 false,
+											 &numsortkeys,
+											 &sortColIdx,
+											 &sortOperators,
+											 &collations,
+											 &nullsFirst);
+
+		/*
+		 * The bounds come from the statistics of some member of the leading
+		 * pathkey's equivalence class.  If the member we ended up sorting by
+		 * is of another type, just do without them; all rows then go to a
+		 * single range, which is slow but still correct.
+		 */
+		tle = get_tle_by_resno(subplan->targetlist, sortColIdx[0]);
+		if (rangeBounds != NIL &&
+			exprType((Node *) tle->expr) !=
+			linitial_node(Const, rangeBounds)->consttype)
+			rangeBounds = NIL;
+
+		plan = make_repartition(subplan, 0, NULL, NULL, NULL,
+								numsortkeys, sortColIdx, sortOperators,
+								collations, nullsFirst, rangeBounds);
+	}
+	else
+	{
+		/*
+		 * Repartition doesn't project, so tlist requirements pass through;
+		 * but we need the hash key columns to be labeled.
+		 */
+		subplan = create_plan_recurse(root, best_path->subpath,
+									  flags | CP_LABEL_TLIST);
+
+		plan = make_repartition(subplan,
+								list_length(best_path->hashClause),
+								extract_grouping_cols(best_path->hashClause,
+													  subplan->targetlist),
+								extract_grouping_ops(best_path->hashClause),
+								extract_grouping_collations(best_path->hashClause,
+															subplan->targetlist),
+								0, NULL, NULL, NULL, NULL, NIL);
+	}
+
+	copy_generic_path_info(&plan->plan, (Path *) best_path);
+
+	return plan;
+}
+
 /*
  * create_unique_plan
  *	  Create a Unique plan for 'best_path' and (recursively) plans
@@ -4913,9 +5015,397 @@ create_hashjoin_plan(PlannerInfo *root,
 
 	copy_generic_path_info(&join_plan->join.plan, &best_path->jpath.path);
 
+	add_hashjoin_runtime_filter(root, best_path, join_plan, hash_plan);
+
 	return join_plan;
 }
 
+/*
+ * add_hashjoin_runtime_filter
+ *	  Let the outer side of a hash join skip tuples that can't have a match,
+ *	  using summaries of the inner join keys made while building the hash
+ *	  table.
+ *
+ * There are two kinds of summary.  If the hash join is expected to need more
+ * than one batch, the Hash node builds a bloom filter of the hash values of
+ * the inner tuples, and the join discards outer tuples whose hash value isn't
+ * in it, before they are probed for or written to a batch file.
+ *
+ * Also, the Hash node can track the smallest and largest value of one inner
+ * join key, which the join publishes as PARAM_EXEC params $min and $max once
+ * it has built its hash table, before it fetches the first outer tuple.  We
+ * do that if "key >= $min AND key <= $max", where key is the outer side of a
+ * hash clause, lets the outer side skip some of its input:
+ *
+ * - If the outer side is an Append over a partitioned relation and key is a
+ *	 partition key, run-time pruning skips the partitions whose bounds don't
+ *	 overlap the range.
+ * - If the outer side is a sequential scan, or an Append of them, of a table
+ *	 with a BRIN minmax index on key, the scan becomes a bitmap heap scan of
+ *	 the block ranges that the index says may hold keys in the range.
+ *
+ * All of this is only valid if outer tuples without a match can be thrown
+ * away, so not for left, full or anti joins.  Also, each participant of a
+ * parallel hash join sees only part of the inner relation while building the
+ * shared hash table, so we don't do this for parallel-aware joins.
+ */
+static void
+add_hashjoin_runtime_filter(PlannerInfo *root, HashPath *best_path,
+							HashJoin *join_plan, Hash *hash_plan)
+{
+	Path	   *outer_path = best_path->jpath.outerjoinpath;
+	Plan	   *outer_plan = join_plan->join.plan.lefttree;
+	RelOptInfo *rel = outer_path->parent;
+	bool		can_prune;
+	List	   *prunequal = NIL;
+	int			keyno = 0;
+	ListCell   *lc;
+
+	if (best_path->jpath.path.parallel_aware)
+		return;
+
+	switch (best_path->jpath.jointype)
+	{
+		case JOIN_INNER:
+		case JOIN_SEMI:
+		case JOIN_RIGHT:
+		case JOIN_RIGHT_ANTI:
+			break;
+		default:
+			return;
+	}
+
+	if (best_path->num_batches > 1)
+		hash_plan->filterBloom = true;
+
+	can_prune = enable_partition_pruning &&
+		IsA(outer_path, AppendPath) && IsA(outer_plan, Append) &&
+		rel->part_scheme != NULL;
+	if (can_prune)
+		prunequal = get_append_prunequal(root, rel, outer_path);
+	else if (!enable_bitmapscan || !IS_SIMPLE_REL(rel))
+		return;
+
+	foreach(lc, join_plan->hashclauses)
+	{
+		OpExpr	   *hclause = lfirst_node(OpExpr, lc);
+		Expr	   *outerkey = (Expr *) linitial(hclause->args);
+		Expr	   *innerkey = (Expr *) lsecond(hclause->args);
+		Expr	   *key = outerkey;
+		bool		ispartkey = false;
+		Oid			lefttype = exprType((Node *) outerkey);
+		Oid			righttype = exprType((Node *) innerkey);
+		ListCell   *lc2;
+
+		/* Quickly check whether the outer side is a partition key at all */
+		if (IsA(key, RelabelType))
+			key = ((RelabelType *) key)->arg;
+		for (int i = 0; can_prune && i < rel->part_scheme->partnatts &&
+			 !ispartkey; i++)
+		{
+			foreach(lc2, rel->partexprs[i])
+			{
+				if (equal(lfirst(lc2), key))
+				{
+					ispartkey = true;
+					break;
+				}
+			}
+		}
+
+		/* Otherwise, only a plain column can be looked up in a BRIN index */
+		if (!ispartkey && (!enable_bitmapscan || !IsA(outerkey, Var)))
+		{
+			keyno++;
+			continue;
+		}
+
+		foreach(lc2, get_mergejoin_opfamilies(hclause->opno))
+		{
+			Oid			opfamily = lfirst_oid(lc2);
+			Oid			geop;
+			Oid			leop;
+			Oid			sortop;
+			Param	   *minparam;
+			Param	   *maxparam;
+			int			nparams;
+			bool		used = false;
+
+			geop = get_opfamily_member(opfamily, lefttype, righttype,
+									   BTGreaterEqualStrategyNumber);
+			leop = get_opfamily_member(opfamily, lefttype, righttype,
+									   BTLessEqualStrategyNumber);
+			sortop = get_opfamily_member(opfamily, righttype, righttype,
+										 BTLessStrategyNumber);
+			if (!OidIsValid(geop) || !OidIsValid(leop) ||
+				!OidIsValid(sortop))
+				continue;
+
+			nparams = list_length(root->glob->paramExecTypes);
+			minparam = generate_new_exec_param(root, righttype,
+											   exprTypmod((Node *) innerkey),
+											   exprCollation((Node *) innerkey));
+			maxparam = generate_new_exec_param(root, righttype,
+											   exprTypmod((Node *) innerkey),
+											   exprCollation((Node *) innerkey));
+
+			if (ispartkey)
+			{
+				List	   *filterquals;
+				PartitionPruneInfo *pinfo;
+
+				filterquals =
+					list_make2(make_opclause(geop, BOOLOID, false,
+											 copyObject(outerkey),
+											 (Expr *) minparam,
+											 InvalidOid, hclause->inputcollid),
+							   make_opclause(leop, BOOLOID, false,
+											 copyObject(outerkey),
+											 (Expr *) maxparam,
+											 InvalidOid, hclause->inputcollid));
+
+				pinfo = make_partition_pruneinfo(root, rel,
+												 ((AppendPath *) outer_path)->subpaths,
+												 list_concat_copy(prunequal,
+																  filterquals));
+
+				/* Make sure that pruning actually depends on the new params */
+				if (pinfo != NULL &&
+					prune_info_uses_params(pinfo, minparam, maxparam))
+				{
+					((Append *) outer_plan)->part_prune_info = pinfo;
+					used = true;
+				}
+			}
+
+			if (enable_bitmapscan && IsA(outerkey, Var) &&
+				add_brin_runtime_filter(root, join_plan, rel, hclause,
+										geop, leop, minparam, maxparam))
+				used = true;
+
+			if (used)
+			{
+				hash_plan->filterKeyNo = keyno;
+				hash_plan->filterSortOp = sortop;
+				hash_plan->filterCollation = hclause->inputcollid;
+				join_plan->filterMinParam = minparam->paramid;
+				join_plan->filterMaxParam = maxparam->paramid;
+				return;
+			}
+
+			/*
+			 * The params are of no use after all.  Nothing else can have been
+			 * assigned since, so just give their slots back.
+			 */
+			root->glob->paramExecTypes =
+				list_truncate(root->glob->paramExecTypes, nparams);
+		}
+
+		keyno++;
+	}
+}
+
+/*
+ * prune_info_uses_params
+ *	  Does run-time pruning with this PartitionPruneInfo look at either param?
+ */
+static bool
+prune_info_uses_params(PartitionPruneInfo *pinfo, Param *minparam,
+					   Param *maxparam)
+{
+	foreach_node(List, prune_infos, pinfo->prune_infos)
+	{
+		foreach_node(PartitionedRelPruneInfo, prelinfo, prune_infos)
+		{
+			if (bms_is_member(minparam->paramid, prelinfo->execparamids) ||
+				bms_is_member(maxparam->paramid, prelinfo->execparamids))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * add_brin_runtime_filter
+ *	  Turn the sequential scans on the outer side of a hash join into bitmap
+ *	  heap scans that read only the block ranges a BRIN index says may hold
+ *	  outer keys between $min and $max.
+ *
+ * The outer plan may be a SeqScan of rel or an Append whose children include
+ * SeqScans of rel's children.  Returns true if any scan was changed.
+ */
+static bool
+add_brin_runtime_filter(PlannerInfo *root, HashJoin *join_plan,
+						RelOptInfo *rel, OpExpr *hclause, Oid geop, Oid leop,
+						Param *minparam, Param *maxparam)
+{
+	Plan	   *outer_plan = join_plan->join.plan.lefttree;
+	Var		   *outerkey = linitial_node(Var, hclause->args);
+	Plan	   *newplan;
+	bool		found = false;
+	ListCell   *lc;
+
+	if (!IS_SIMPLE_REL(rel))
+		return false;
+
+	if (IsA(outer_plan, SeqScan))
+	{
+		newplan = make_brin_filtered_scan(root, (SeqScan *) outer_plan,
+										  outerkey, hclause, geop, leop,
+										  minparam, maxparam);
+		if (newplan == NULL)
+			return false;
+		join_plan->join.plan.lefttree = newplan;
+		return true;
+	}
+
+	if (!IsA(outer_plan, Append))
+		return false;
+
+	foreach(lc, ((Append *) outer_plan)->appendplans)
+	{
+		SeqScan    *subplan = (SeqScan *) lfirst(lc);
+		RelOptInfo *childrel;
+		Node	   *childkey;
+
+		if (!IsA(subplan, SeqScan))
+			continue;
+
+		childrel = root->simple_rel_array[subplan->scan.scanrelid];
+		if (childrel == NULL || !IS_OTHER_REL(childrel))
+			continue;
+		childkey = adjust_appendrel_attrs_multilevel(root, (Node *) outerkey,
+													 childrel, rel);
+		if (!IsA(childkey, Var))
+			continue;
+
+		newplan = make_brin_filtered_scan(root, subplan, (Var *) childkey,
+										  hclause, geop, leop,
+										  minparam, maxparam);
+		if (newplan != NULL)
+		{
+			lfirst(lc) = newplan;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+/*
+ * make_brin_filtered_scan
+ *	  Build a bitmap heap scan to replace a SeqScan, using a BRIN minmax index
+ *	  on the column of key to skip block ranges with no values between $min
+ *	  and $max.  Returns NULL if there is no suitable index.
+ *
+ * The bitmap is lossy, so the range quals are rechecked for every tuple,
+ * which also discards the outer tuples in the remaining ranges that fall
+ * outside it.  All other quals of the SeqScan are kept as they are.
+ */
+static Plan *
+make_brin_filtered_scan(PlannerInfo *root, SeqScan *scan, Var *key,
+						OpExpr *hclause, Oid geop, Oid leop,
+						Param *minparam, Param *maxparam)
+{
+	Plan	   *plan = &scan->scan.plan;
+	Index		scanrelid = scan->scan.scanrelid;
+	RelOptInfo *rel = find_base_rel(root, scanrelid);
+
+	if (plan->parallel_aware || key->varno != scanrelid ||
+		key->varlevelsup != 0 || key->varattno <= 0)
+		return NULL;
+
+	foreach_node(IndexOptInfo, index, rel->indexlist)
+	{
+		if (index->relam != BRIN_AM_OID || index->indpred != NIL)
+			continue;
+
+		for (int indexcol = 0; indexcol < index->nkeycolumns; indexcol++)
+		{
+			Var		   *indexkey;
+			List	   *indexqual;
+			List	   *indexqualorig;
+			BitmapIndexScan *iscan;
+			BitmapHeapScan *hscan;
+
+			/* The index must compare the same way as the range quals */
+			if (index->indexkeys[indexcol] != key->varattno ||
+				index->indexcollations[indexcol] != hclause->inputcollid ||
+				get_op_opfamily_strategy(geop, index->opfamily[indexcol]) !=
+				BTGreaterEqualStrategyNumber ||
+				get_op_opfamily_strategy(leop, index->opfamily[indexcol]) !=
+				BTLessEqualStrategyNumber)
+				continue;
+
+			indexkey = makeVar(INDEX_VAR, indexcol + 1, key->vartype,
+							   key->vartypmod, key->varcollid, 0);
+			indexqual =
+				list_make2(make_opclause(geop, BOOLOID, false,
+										 (Expr *) indexkey,
+										 (Expr *) minparam,
+										 InvalidOid, hclause->inputcollid),
+						   make_opclause(leop, BOOLOID, false,
+										 (Expr *) copyObject(indexkey),
+										 (Expr *) maxparam,
+										 InvalidOid, hclause->inputcollid));
+			indexqualorig =
+				list_make2(make_opclause(geop, BOOLOID, false,
+										 (Expr *) copyObject(key),
+										 (Expr *) minparam,
+										 InvalidOid, hclause->inputcollid),
+						   make_opclause(leop, BOOLOID, false,
+										 (Expr *) copyObject(key),
+										 (Expr *) maxparam,
+										 InvalidOid, hclause->inputcollid));
+
+			iscan = make_bitmap_indexscan(scanrelid, index->indexoid,
+										  indexqual, indexqualorig);
+			iscan->scan.plan.startup_cost = 0;
+			iscan->scan.plan.total_cost = plan->startup_cost;
+			iscan->scan.plan.plan_rows = plan->plan_rows;
+			iscan->scan.plan.plan_width = 0;
+			iscan->scan.plan.parallel_safe = plan->parallel_safe;
+
+			hscan = make_bitmap_heapscan(plan->targetlist, plan->qual,
+										 (Plan *) iscan,
+										 copyObject(indexqualorig),
+										 scanrelid);
+			copy_plan_costsize(&hscan->scan.plan, plan);
+
+			return (Plan *) hscan;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * get_append_prunequal
+ *	  Get the quals that run-time partition pruning can use for an Append
+ *	  of the given partitioned relation.
+ */
+static List *
+get_append_prunequal(PlannerInfo *root, RelOptInfo *rel, Path *best_path)
+{
+	List	   *prunequal;
+
+	prunequal = extract_actual_clauses(rel->baserestrictinfo, false);
+
+	if (best_path->param_info)
+	{
+		List	   *prmquals = best_path->param_info->ppi_clauses;
+
+		prmquals = extract_actual_clauses(prmquals, false);
+		prmquals = (List *) replace_nestloop_params(root,
+													(Node *) prmquals);
+
+		prunequal = list_concat(prunequal, prmquals);
+	}
+
+	return prunequal;
+}
+
 
 /*****************************************************************************
  *
@@ -5994,6 +6484,8 @@ make_hashjoin(List *tlist,
 	node->hashoperators = hashoperators;
 	node->hashcollations = hashcollations;
 	node->hashkeys = hashkeys;
+	node->filterMinParam = -1;
+	node->filterMaxParam = -1;
 	node->join.jointype = jointype;
 	node->join.inner_unique = inner_unique;
 	node->join.joinqual = joinclauses;
@@ -6020,6 +6512,10 @@ make_hash(Plan *lefttree,
 	node->skewTable = skewTable;
 	node->skewColumn = skewColumn;
 	node->skewInherit = skewInherit;
+	node->filterKeyNo = -1;
+	node->filterSortOp = InvalidOid;
+	node->filterCollation = InvalidOid;
+	node->filterBloom = false;
 
 	return node;
 }
@@ -6590,6 +7086,35 @@ make_memoize(Plan *lefttree, Oid *hashoperators, Oid *collations,
 	return node;
 }
 
+static Repartition *
+make_repartition(Plan *lefttree, int numCols, AttrNumber *hashColIdx,
+				 Oid *hashOperators, Oid *hashCollations,
+				 int numSortCols, AttrNumber *sortColIdx,
+				 Oid *sortOperators, Oid *collations, bool *nullsFirst,
+				 List *rangeBounds)
+{
+	Repartition *node = makeNode(Repartition);
+	Plan	   *plan = &node->plan;
+
+	plan->targetlist = lefttree->targetlist;
+	plan->qual = NIL;
+	plan->lefttree = lefttree;
+	plan->righttree = NULL;
+
+	node->numCols = numCols;
+	node->hashColIdx = hashColIdx;
+	node->hashOperators = hashOperators;
+	node->hashCollations = hashCollations;
+	node->numSortCols = numSortCols;
+	node->sortColIdx = sortColIdx;
+	node->sortOperators = sortOperators;
+	node->collations = collations;
+	node->nullsFirst = nullsFirst;
+	node->rangeBounds = rangeBounds;
+
+	return node;
+}
+
 Agg *
 make_agg(List *tlist, List *qual,
 		 AggStrategy aggstrategy, AggSplit aggsplit,
@@ -7225,6 +7750,7 @@ is_projection_capable_path(Path *path)
 		case T_Hash:
 		case T_Material:
 		case T_Memoize:
+		case T_Repartition:
 		case T_Sort:
 		case T_IncrementalSort:
 		case T_Unique:
@@ -7275,6 +7801,7 @@ is_projection_capable_plan(Plan *plan)
 		case T_Hash:
 		case T_Material:
 		case T_Memoize:
+		case T_Repartition:
 		case T_Sort:
 		case T_Unique:
 		case T_SetOp:
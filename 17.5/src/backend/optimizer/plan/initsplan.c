@@ -14,7 +14,11 @@
  */
 #include "postgres.h"
 
+#include "access/nbtree.h"
+#include "access/sysattr.h"
+#include "catalog/pg_am.h"
 #include "catalog/pg_type.h"
+#include "commands/defrem.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/clauses.h"
@@ -29,6 +33,7 @@
 #include "optimizer/planner.h"
 #include "optimizer/restrictinfo.h"
 #include "parser/analyze.h"
+#include "parser/parse_oper.h"
 #include "rewrite/rewriteManip.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
@@ -130,6 +135,7 @@ static Relids get_join_domain_min_rels(PlannerInfo *root, Relids domain_relids);
 static void check_mergejoinable(RestrictInfo *restrictinfo);
 static void check_hashjoinable(RestrictInfo *restrictinfo);
 static void check_memoizable(RestrictInfo *restrictinfo);
+static bool grouping_is_equalimage(Oid typid, Oid collation);
 
 
 /*****************************************************************************
@@ -3355,6 +3361,205 @@ match_foreign_keys_to_quals(PlannerInfo *root)
 }
 
 
+/*
+ * setup_eager_aggregation
+ *		Check whether the query's aggregates can be partially computed before
+ *		the joins, and if so, save what's needed to do that in root.
+ *
+ * We handle only the simple but common case where all joins are inner
+ * joins and every aggregate reads from one and the same base relation.  The
+ * rows of that relation can then be partially aggregated, grouped by each of
+ * its Vars that is needed above it for something other than an aggregate
+ * argument, and the (hopefully much smaller) result joined to the other
+ * relations.  Each partially aggregated row stands for a set of input rows
+ * that behave identically in the joins and in the upper plan levels, so
+ * combining the partial aggregates of the joined rows yields the same result
+ * as aggregating the join of the original rows.  For that, the grouping
+ * equality must imply that the values are indistinguishable, which is what
+ * the btree "equalimage" support function tells us.
+ *
+ * Whether it is actually worth doing is decided in the usual cost-based way:
+ * make_one_rel() builds grouped versions of the relations that contain the
+ * aggregated one, and create_ordinary_grouping_paths() finalizes their paths
+ * alongside the normal ones.
+ */
+void
+setup_eager_aggregation(PlannerInfo *root)
+{
+	Query	   *parse = root->parse;
+	List	   *tlist_exprs;
+	List	   *nonagg_vars = NIL;
+	List	   *partial_aggs = NIL;
+	Bitmapset  *nonagg_attrs = NULL;
+	Bitmapset  *aggonly_attrs = NULL;
+	List	   *groupClause = NIL;
+	Index		relid = 0;
+	RelOptInfo *rel;
+	ListCell   *lc;
+
+	root->eager_agg_relid = 0;
+	root->eager_agg_groupClause = NIL;
+	root->eager_agg_aggonly_attrs = NULL;
+	root->eager_agg_partial_aggs = NIL;
+
+	if (!enable_eager_aggregate)
+		return;
+
+	/* There must be aggregates, and joins to push them below */
+	if (!parse->hasAggs ||
+		bms_membership(root->all_baserels) != BMS_MULTIPLE)
+		return;
+
+	/*
+	 * The aggregates must support partial aggregation, and there must not be
+	 * anything that makes it hard to tell what the grouped rows have to look
+	 * like.
+	 */
+	if (parse->groupingSets || parse->hasWindowFuncs ||
+		root->hasNonPartialAggs || root->hasNonSerialAggs ||
+		root->join_info_list != NIL || root->placeholder_list != NIL ||
+		root->hasLateralRTEs)
+		return;
+
+	/*
+	 * Sort the contents of the tlist and HAVING into Aggrefs and Vars used
+	 * outside of Aggrefs.
+	 */
+	tlist_exprs = pull_var_clause((Node *) root->processed_tlist,
+								  PVC_INCLUDE_AGGREGATES |
+								  PVC_INCLUDE_PLACEHOLDERS);
+	tlist_exprs = list_concat(tlist_exprs,
+							  pull_var_clause(parse->havingQual,
+											  PVC_INCLUDE_AGGREGATES |
+											  PVC_INCLUDE_PLACEHOLDERS));
+	foreach(lc, tlist_exprs)
+	{
+		Node	   *expr = (Node *) lfirst(lc);
+		Aggref	   *aggref;
+		Relids		aggrelids;
+
+		if (IsA(expr, Var))
+		{
+			nonagg_vars = lappend(nonagg_vars, expr);
+			continue;
+		}
+		if (!IsA(expr, Aggref))
+			return;
+
+		aggref = (Aggref *) expr;
+		if (contain_volatile_functions((Node *) aggref))
+			return;
+
+		/* All the aggregates must read from the same base relation */
+		aggrelids = pull_varnos(root, (Node *) aggref);
+		if (!bms_is_empty(aggrelids))
+		{
+			int			aggrelid;
+
+			if (!bms_get_singleton_member(aggrelids, &aggrelid))
+				return;
+			if (relid != 0 && relid != aggrelid)
+				return;
+			relid = aggrelid;
+		}
+
+		/* Remember the partial version of the aggregate */
+		aggref = makeNode(Aggref);
+		memcpy(aggref, expr, sizeof(Aggref));
+		mark_partial_aggref(aggref, AGGSPLIT_INITIAL_SERIAL);
+		partial_aggs = list_append_unique(partial_aggs, aggref);
+	}
+
+	/* Nothing to do if no aggregate reads from any relation */
+	if (relid == 0)
+		return;
+	rel = find_base_rel(root, relid);
+	if (rel->reloptkind != RELOPT_BASEREL)
+		return;
+
+	/*
+	 * Now find the rel's Vars that are needed above it.  Those needed by a
+	 * join clause, or outside of aggregates in the upper plan levels, become
+	 * grouping columns; the others are used only in aggregates, so the
+	 * grouped rel doesn't need to emit them.
+	 */
+	pull_varattnos((Node *) nonagg_vars, relid, &nonagg_attrs);
+	foreach(lc, rel->reltarget->exprs)
+	{
+		Var		   *var = (Var *) lfirst(lc);
+		int			attno;
+		Relids		needed;
+		Oid			sortop;
+		Oid			eqop;
+		bool		hashable;
+		SortGroupClause *sgc;
+
+		if (!IsA(var, Var) || var->varno != relid)
+			return;
+
+		attno = var->varattno - FirstLowInvalidHeapAttributeNumber;
+		needed = bms_del_member(bms_copy(rel->attr_needed[var->varattno -
+														  rel->min_attr]),
+								relid);
+		needed = bms_del_member(needed, 0);
+		if (bms_is_empty(needed) && !bms_is_member(attno, nonagg_attrs))
+		{
+			aggonly_attrs = bms_add_member(aggonly_attrs, attno);
+			continue;
+		}
+
+		get_sort_group_operators(var->vartype,
+								 false, false, false,
+								 &sortop, &eqop, NULL,
+								 &hashable);
+		if (!OidIsValid(eqop) ||
+			!grouping_is_equalimage(var->vartype, var->varcollid))
+			return;
+
+		sgc = makeNode(SortGroupClause);
+		sgc->tleSortGroupRef = list_length(groupClause) + 1;
+		sgc->eqop = eqop;
+		sgc->sortop = sortop;
+		sgc->nulls_first = false;
+		sgc->hashable = hashable;
+		groupClause = lappend(groupClause, sgc);
+	}
+
+	root->eager_agg_relid = relid;
+	root->eager_agg_groupClause = groupClause;
+	root->eager_agg_aggonly_attrs = aggonly_attrs;
+	root->eager_agg_partial_aggs = partial_aggs;
+}
+
+/*
+ * grouping_is_equalimage
+ *		Can values of the type that are equal according to its default btree
+ *		opclass be treated as interchangeable?
+ */
+static bool
+grouping_is_equalimage(Oid typid, Oid collation)
+{
+	Oid			opclass;
+	Oid			opfamily;
+	Oid			opcintype;
+	Oid			equalimageproc;
+
+	opclass = GetDefaultOpClass(typid, BTREE_AM_OID);
+	if (!OidIsValid(opclass))
+		return false;
+
+	opfamily = get_opclass_family(opclass);
+	opcintype = get_opclass_input_type(opclass);
+	equalimageproc = get_opfamily_proc(opfamily, opcintype, opcintype,
+									   BTEQUALIMAGE_PROC);
+	if (!OidIsValid(equalimageproc))
+		return false;
+
+	return DatumGetBool(OidFunctionCall1Coll(equalimageproc, collation,
+											 ObjectIdGetDatum(opcintype)));
+}
+
+
 /*****************************************************************************
  *
  *	 CHECKS FOR MERGEJOINABLE AND HASHJOINABLE CLAUSES
@@ -274,6 +274,12 @@ query_planner(PlannerInfo *root,
 	 */
 	distribute_row_identity_vars(root);
 
+	/*
+	 * See whether the aggregates could be partially computed before the
+	 * joins.  This needs the final set of Vars each baserel must emit.
+	 */
+	setup_eager_aggregation(root);
+
 	/*
 	 * Ready to do the primary planning.
 	 */
@@ -19,13 +19,16 @@
 #include <math.h>
 
 #include "access/genam.h"
+#include "access/htup_details.h"
 #include "access/parallel.h"
+#include "access/stratnum.h"
 #include "access/sysattr.h"
 #include "access/table.h"
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_constraint.h"
 #include "catalog/pg_inherits.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_statistic.h"
 #include "catalog/pg_type.h"
 #include "executor/executor.h"
 #include "foreign/fdwapi.h"
@@ -58,6 +61,7 @@
 #include "parser/parse_relation.h"
 #include "parser/parsetree.h"
 #include "partitioning/partdesc.h"
+#include "utils/datum.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "utils/selfuncs.h"
@@ -66,6 +70,7 @@
 double		cursor_tuple_fraction = DEFAULT_CURSOR_TUPLE_FRACTION;
 int			debug_parallel_query = DEBUG_PARALLEL_OFF;
 bool		parallel_leader_participation = true;
+int			parallel_leader_max_workers = -1;
 
 /* Hook for plugins to get control in planner() */
 planner_hook_type planner_hook = NULL;
@@ -179,13 +184,14 @@ static RelOptInfo *create_window_paths(PlannerInfo *root,
 									   bool output_target_parallel_safe,
 									   WindowFuncLists *wflists,
 									   List *activeWindows);
-static void create_one_window_path(PlannerInfo *root,
-								   RelOptInfo *window_rel,
-								   Path *path,
-								   PathTarget *input_target,
-								   PathTarget *output_target,
-								   WindowFuncLists *wflists,
-								   List *activeWindows);
+static Path *create_one_window_path(PlannerInfo *root,
+									RelOptInfo *window_rel,
+									Path *path,
+									PathTarget *input_target,
+									PathTarget *output_target,
+									WindowFuncLists *wflists,
+									List *activeWindows);
+static List *get_common_window_partition_clauses(List *activeWindows);
 static RelOptInfo *create_distinct_paths(PlannerInfo *root,
 										 RelOptInfo *input_rel,
 										 PathTarget *target);
@@ -196,6 +202,11 @@ static void create_partial_distinct_paths(PlannerInfo *root,
 static RelOptInfo *create_final_distinct_paths(PlannerInfo *root,
 											   RelOptInfo *input_rel,
 											   RelOptInfo *distinct_rel);
+static void create_repartitioned_distinct_paths(PlannerInfo *root,
+												RelOptInfo *input_rel,
+												RelOptInfo *distinct_rel);
+static List *get_range_repartition_bounds(PlannerInfo *root,
+										  PathKey *pathkey);
 static RelOptInfo *create_ordered_paths(PlannerInfo *root,
 										RelOptInfo *input_rel,
 										PathTarget *target,
@@ -227,6 +238,15 @@ static void add_paths_to_grouping_rel(PlannerInfo *root, RelOptInfo *input_rel,
 									  grouping_sets_data *gd,
 									  double dNumGroups,
 									  GroupPathExtraData *extra);
+static void add_repartitioned_grouping_paths(PlannerInfo *root,
+											 RelOptInfo *input_rel,
+											 RelOptInfo *grouped_rel,
+											 const AggClauseCosts *agg_costs,
+											 double dNumGroups,
+											 GroupPathExtraData *extra);
+static void add_eager_aggregate_paths(PlannerInfo *root,
+									  RelOptInfo *input_grouped_rel,
+									  RelOptInfo *partially_grouped_rel);
 static RelOptInfo *create_partial_grouping_paths(PlannerInfo *root,
 												 RelOptInfo *grouped_rel,
 												 RelOptInfo *input_rel,
@@ -560,9 +580,17 @@ standard_planner(Query *parse, const char *query_string, int cursorOptions,
 	result->stmt_location = parse->stmt_location;
 	result->stmt_len = parse->stmt_len;
 
+	/*
+	 * With deferred compilation, only expressions that turn out to be
+	 * evaluated often are compiled, so JIT is allowed regardless of the
+	 * estimated cost.  A query whose row estimates are far too low thus still
+	 * gets its hot expressions compiled.  Note that compilation then happens
+	 * synchronously, stalling execution of the query at the evaluation that
+	 * reaches the threshold.
+	 */
 	result->jitFlags = PGJIT_NONE;
 	if (jit_enabled && jit_above_cost >= 0 &&
-		top_plan->total_cost > jit_above_cost)
+		(top_plan->total_cost > jit_above_cost || jit_defer_evaluations > 0))
 	{
 		result->jitFlags |= PGJIT_PERFORM;
 
@@ -4089,11 +4117,13 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 		bool		force_rel_creation;
 
 		/*
-		 * If we're doing partitionwise aggregation at this level, force
-		 * creation of a partially_grouped_rel so we can add partitionwise
-		 * paths to it.
+		 * If we're doing partitionwise aggregation at this level, or eager
+		 * aggregation has produced partially aggregated joins, force
+		 * creation of a partially_grouped_rel so we can add those paths to
+		 * it.
 		 */
-		force_rel_creation = (patype == PARTITIONWISE_AGGREGATE_PARTIAL);
+		force_rel_creation = (patype == PARTITIONWISE_AGGREGATE_PARTIAL ||
+							  input_rel->grouped_rel != NULL);
 
 		partially_grouped_rel =
 			create_partial_grouping_paths(root,
@@ -4102,6 +4132,10 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 										  gd,
 										  extra,
 										  force_rel_creation);
+
+		if (input_rel->grouped_rel != NULL)
+			add_eager_aggregate_paths(root, input_rel->grouped_rel,
+									  partially_grouped_rel);
 	}
 
 	/* Set out parameter. */
@@ -4126,10 +4160,9 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 
 	/* Gather any partially grouped partial paths. */
 	if (partially_grouped_rel && partially_grouped_rel->partial_pathlist)
-	{
 		gather_grouping_paths(root, partially_grouped_rel);
+	if (partially_grouped_rel && partially_grouped_rel->pathlist)
 		set_cheapest(partially_grouped_rel);
-	}
 
 	/*
 	 * Estimate number of groups.
@@ -4582,13 +4615,49 @@ create_window_paths(PlannerInfo *root,
 			pathkeys_count_contained_in(root->window_pathkeys, path->pathkeys,
 										&presorted_keys) ||
 			presorted_keys > 0)
-			create_one_window_path(root,
-								   window_rel,
-								   path,
-								   input_target,
-								   output_target,
-								   wflists,
-								   activeWindows);
+			add_path(window_rel,
+					 create_one_window_path(root,
+											window_rel,
+											path,
+											input_target,
+											output_target,
+											wflists,
+											activeWindows));
+	}
+
+	/*
+	 * Consider computing the window functions in parallel.  If all the
+	 * windows share some hashable PARTITION BY columns, redistribute the rows
+	 * of the cheapest partial path among the workers by those columns, so
+	 * that each worker sees all the rows of the window partitions it is
+	 * given, and gather the results on top.
+	 */
+	if (enable_repartition && window_rel->consider_parallel &&
+		input_rel->partial_pathlist != NIL)
+	{
+		List	   *hashClause;
+
+		hashClause = get_common_window_partition_clauses(activeWindows);
+		if (hashClause != NIL)
+		{
+			Path	   *path = (Path *) linitial(input_rel->partial_pathlist);
+			double		total_groups;
+
+			path = (Path *) create_repartition_path(root, window_rel, path,
+													hashClause);
+			path = create_one_window_path(root,
+										  window_rel,
+										  path,
+										  input_target,
+										  output_target,
+										  wflists,
+										  activeWindows);
+			total_groups = path->rows * path->parallel_workers;
+			path = (Path *) create_gather_path(root, window_rel, path,
+											   path->pathtarget, NULL,
+											   &total_groups);
+			add_path(window_rel, path);
+		}
 	}
 
 	/*
@@ -4614,7 +4683,7 @@ create_window_paths(PlannerInfo *root,
 
 /*
  * Stack window-function implementation steps atop the given Path, and
- * add the result to window_rel.
+ * return the resulting Path, which the caller should add to window_rel.
  *
  * window_rel: upperrel to contain result
  * path: input Path to use (must return input_target)
@@ -4623,7 +4692,7 @@ create_window_paths(PlannerInfo *root,
  * wflists: result of find_window_functions
  * activeWindows: result of select_active_windows
  */
-static void
+static Path *
 create_one_window_path(PlannerInfo *root,
 					   RelOptInfo *window_rel,
 					   Path *path,
@@ -4779,7 +4848,54 @@ create_one_window_path(PlannerInfo *root,
 								  topwindow ? topqual : NIL, topwindow);
 	}
 
-	add_path(window_rel, path);
+	return path;
+}
+
+/*
+ * get_common_window_partition_clauses
+ *		Return the hashable PARTITION BY clauses that all of the given
+ *		windows have in common.
+ *
+ * Rows that agree on these columns belong to the same partition of every
+ * window, so they can be used to redistribute the rows of a parallel plan
+ * without splitting any window partition.  Returns NIL if there are none.
+ */
+static List *
+get_common_window_partition_clauses(List *activeWindows)
+{
+	WindowClause *firstwc = linitial_node(WindowClause, activeWindows);
+	List	   *result = NIL;
+
+	foreach_node(SortGroupClause, sgc, firstwc->partitionClause)
+	{
+		bool		common = sgc->hashable;
+		ListCell   *lc;
+
+		for_each_from(lc, activeWindows, 1)
+		{
+			WindowClause *wc = lfirst_node(WindowClause, lc);
+			bool		found = false;
+
+			if (!common)
+				break;
+
+			foreach_node(SortGroupClause, othersgc, wc->partitionClause)
+			{
+				if (othersgc->tleSortGroupRef == sgc->tleSortGroupRef &&
+					othersgc->eqop == sgc->eqop)
+				{
+					found = true;
+					break;
+				}
+			}
+			common = found;
+		}
+
+		if (common)
+			result = lappend(result, sgc);
+	}
+
+	return result;
 }
 
 /*
@@ -4825,6 +4941,9 @@ create_distinct_paths(PlannerInfo *root, RelOptInfo *input_rel,
 	/* now build distinct paths based on input_rel's partial_pathlist */
 	create_partial_distinct_paths(root, input_rel, distinct_rel, target);
 
+	/* and consider redistributing the partial paths by the DISTINCT keys */
+	create_repartitioned_distinct_paths(root, input_rel, distinct_rel);
+
 	/* Give a helpful error if we failed to create any paths */
 	if (distinct_rel->pathlist == NIL)
 		ereport(ERROR,
@@ -5055,6 +5174,89 @@ create_partial_distinct_paths(PlannerInfo *root, RelOptInfo *input_rel,
 	}
 }
 
+/*
+ * create_repartitioned_distinct_paths
+ *
+ * Consider redistributing the rows of input_rel's cheapest partial path
+ * among the workers by the DISTINCT keys.  Each worker then sees all the
+ * duplicates of the rows it gets, so it can remove them on its own, and the
+ * rows coming out of the Gather or Gather Merge on top need no further
+ * processing.  The paths are added to distinct_rel.
+ */
+static void
+create_repartitioned_distinct_paths(PlannerInfo *root, RelOptInfo *input_rel,
+									RelOptInfo *distinct_rel)
+{
+	Query	   *parse = root->parse;
+	Path	   *cheapest_partial_path;
+	Path	   *path;
+	List	   *distinctExprs;
+	double		numDistinctRows;
+	double		numWorkerRows;
+
+	if (!enable_repartition || !distinct_rel->consider_parallel ||
+		input_rel->partial_pathlist == NIL)
+		return;
+
+	/* DISTINCT ON would need the full sort order; just do plain DISTINCT */
+	if (parse->hasDistinctOn || root->processed_distinctClause == NIL ||
+		!grouping_is_hashable(root->processed_distinctClause))
+		return;
+
+	cheapest_partial_path = linitial(input_rel->partial_pathlist);
+
+	distinctExprs = get_sortgrouplist_exprs(root->processed_distinctClause,
+											parse->targetList);
+
+	/* estimate the total number of distinct rows, and each worker's share */
+	numDistinctRows = estimate_num_groups(root, distinctExprs,
+										  cheapest_partial_path->rows *
+										  cheapest_partial_path->parallel_workers,
+										  NULL, NULL);
+	numWorkerRows = clamp_row_est(numDistinctRows /
+								  cheapest_partial_path->parallel_workers);
+
+	path = (Path *) create_repartition_path(root, distinct_rel,
+											cheapest_partial_path,
+											root->processed_distinctClause);
+
+	/* Sort and Unique in each worker, and merge the sorted results */
+	if (root->distinct_pathkeys != NIL &&
+		grouping_is_sortable(root->processed_distinctClause))
+	{
+		Path	   *sorted_path;
+
+		sorted_path = (Path *) create_sort_path(root, distinct_rel, path,
+												root->distinct_pathkeys,
+												-1.0);
+		sorted_path = (Path *)
+			create_upper_unique_path(root, distinct_rel, sorted_path,
+									 list_length(root->distinct_pathkeys),
+									 numWorkerRows);
+		add_path(distinct_rel, (Path *)
+				 create_gather_merge_path(root, distinct_rel, sorted_path,
+										  sorted_path->pathtarget,
+										  root->distinct_pathkeys, NULL,
+										  &numDistinctRows));
+	}
+
+	/* HashAgg in each worker, and gather the results in any order */
+	if (enable_hashagg)
+	{
+		Path	   *hashed_path;
+
+		hashed_path = (Path *)
+			create_agg_path(root, distinct_rel, path, path->pathtarget,
+							AGG_HASHED, AGGSPLIT_SIMPLE,
+							root->processed_distinctClause,
+							NIL, NULL, numWorkerRows);
+		add_path(distinct_rel, (Path *)
+				 create_gather_path(root, distinct_rel, hashed_path,
+									hashed_path->pathtarget, NULL,
+									&numDistinctRows));
+	}
+}
+
 /*
  * create_final_distinct_paths
  *		Create distinct paths in 'distinct_rel' based on 'input_rel' pathlist
@@ -5252,6 +5454,84 @@ create_final_distinct_paths(PlannerInfo *root, RelOptInfo *input_rel,
 	return distinct_rel;
 }
 
+/*
+ * get_range_repartition_bounds
+ *		Find bounds to distribute rows by ranges of the given pathkey.
+ *
+ * We use the histogram of some member of the pathkey's equivalence class, if
+ * it was built with the pathkey's ordering and collation.  Returns a list of
+ * Consts in the pathkey's sort order, or NIL if there's no such histogram.
+ */
+static List *
+get_range_repartition_bounds(PlannerInfo *root, PathKey *pathkey)
+{
+	EquivalenceClass *ec = pathkey->pk_eclass;
+
+	if (ec->ec_has_volatile)
+		return NIL;
+
+	foreach_node(EquivalenceMember, em, ec->ec_members)
+	{
+		VariableStatData vardata;
+		AttStatsSlot sslot;
+		Oid			ltop;
+		List	   *result = NIL;
+
+		if (em->em_is_const || em->em_is_child)
+			continue;
+
+		ltop = get_opfamily_member(pathkey->pk_opfamily,
+								   em->em_datatype, em->em_datatype,
+								   BTLessStrategyNumber);
+		if (!OidIsValid(ltop))
+			continue;
+
+		examine_variable(root, (Node *) em->em_expr, 0, &vardata);
+
+		/*
+		 * The bounds will be compared to the data with the ordering
+		 * operator, so make sure it's OK to use it on the statistics.
+		 */
+		if (HeapTupleIsValid(vardata.statsTuple) &&
+			statistic_proc_security_check(&vardata, get_opcode(ltop)) &&
+			get_attstatsslot(&sslot, vardata.statsTuple,
+							 STATISTIC_KIND_HISTOGRAM, ltop,
+							 ATTSTATSSLOT_VALUES))
+		{
+			if (sslot.nvalues >= 2 && sslot.stacoll == ec->ec_collation)
+			{
+				int16		typlen;
+				bool		typbyval;
+
+				get_typlenbyval(sslot.valuetype, &typlen, &typbyval);
+				for (int i = 0; i < sslot.nvalues; i++)
+				{
+					Const	   *bound;
+
+					bound = makeConst(sslot.valuetype, -1, sslot.stacoll,
+									  typlen,
+									  datumCopy(sslot.values[i],
+												typbyval, typlen),
+									  false, typbyval);
+
+					/* the histogram is in ascending order */
+					if (pathkey->pk_strategy == BTLessStrategyNumber)
+						result = lappend(result, bound);
+					else
+						result = lcons(bound, result);
+				}
+			}
+			free_attstatsslot(&sslot);
+		}
+		ReleaseVariableStats(vardata);
+
+		if (result != NIL)
+			return result;
+	}
+
+	return NIL;
+}
+
 /*
  * create_ordered_paths
  *
@@ -5430,6 +5710,48 @@ create_ordered_paths(PlannerInfo *root,
 
 			add_path(ordered_rel, sorted_path);
 		}
+
+		/*
+		 * Also consider distributing the rows of the cheapest partial path by
+		 * ranges of the leading sort key, so that each worker sorts disjoint
+		 * ranges.  As the Repartition node returns all the ranges in order
+		 * from a single participant, a plain Gather preserves their order,
+		 * and there's no need to merge anything.
+		 */
+		if (enable_repartition)
+		{
+			List	   *rangeBounds;
+
+			rangeBounds = get_range_repartition_bounds(root,
+													   linitial_node(PathKey,
+																	 root->sort_pathkeys));
+			if (rangeBounds != NIL)
+			{
+				Path	   *sorted_path;
+				double		total_groups;
+
+				sorted_path = (Path *)
+					create_range_repartition_path(root, ordered_rel,
+												  cheapest_partial_path,
+												  root->sort_pathkeys,
+												  rangeBounds);
+				total_groups = cheapest_partial_path->rows *
+					cheapest_partial_path->parallel_workers;
+				sorted_path = (Path *)
+					create_gather_path(root, ordered_rel,
+									   sorted_path,
+									   sorted_path->pathtarget,
+									   NULL, &total_groups);
+				sorted_path->pathkeys = root->sort_pathkeys;
+
+				/* Add projection step if needed */
+				if (sorted_path->pathtarget != target)
+					sorted_path = apply_projection_to_path(root, ordered_rel,
+														   sorted_path, target);
+
+				add_path(ordered_rel, sorted_path);
+			}
+		}
 	}
 
 	/*
@@ -7216,16 +7538,118 @@ add_paths_to_grouping_rel(PlannerInfo *root, RelOptInfo *input_rel,
 		}
 	}
 
+	/*
+	 * Consider fully aggregating the input in each worker, after
+	 * redistributing its rows by the grouping keys.
+	 */
+	add_repartitioned_grouping_paths(root, input_rel, grouped_rel, agg_costs,
+									 dNumGroups, extra);
+
 	/*
 	 * When partitionwise aggregate is used, we might have fully aggregated
 	 * paths in the partial pathlist, because add_paths_to_append_rel() will
 	 * consider a path for grouped_rel consisting of a Parallel Append of
-	 * non-partial paths from each child.
+	 * non-partial paths from each child.  The same goes for repartitioned
+	 * aggregation.
 	 */
 	if (grouped_rel->partial_pathlist != NIL)
 		gather_grouping_paths(root, grouped_rel);
 }
 
+/*
+ * add_repartitioned_grouping_paths
+ *
+ * Add partial paths to grouped_rel that redistribute the rows of the cheapest
+ * partial input path among the workers by the GROUP BY keys, and then do the
+ * whole aggregation in each worker.  Since each group is then formed in a
+ * single worker, the results need only be gathered; unlike with partial
+ * aggregation, there's no finalization step in the leader, and aggregates
+ * that lack a combine function or have ORDER BY / DISTINCT can be used, too.
+ *
+ * Only grouping and DISTINCT are redistributed this way; joins below still
+ * use the usual parallel join strategies (see nodeRepartition.c).
+ */
+static void
+add_repartitioned_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
+								 RelOptInfo *grouped_rel,
+								 const AggClauseCosts *agg_costs,
+								 double dNumGroups,
+								 GroupPathExtraData *extra)
+{
+	Query	   *parse = root->parse;
+	List	   *havingQual = (List *) extra->havingQual;
+	Path	   *path;
+	double		dNumWorkerGroups;
+
+	if (!enable_repartition || !grouped_rel->consider_parallel ||
+		input_rel->partial_pathlist == NIL)
+		return;
+
+	/* We need some grouping keys to redistribute by */
+	if (parse->groupingSets || root->processed_groupClause == NIL ||
+		!grouping_is_hashable(root->processed_groupClause))
+		return;
+
+	path = (Path *) linitial(input_rel->partial_pathlist);
+	dNumWorkerGroups = clamp_row_est(dNumGroups / path->parallel_workers);
+
+	path = (Path *) create_repartition_path(root, grouped_rel, path,
+											root->processed_groupClause);
+
+	if ((extra->flags & GROUPING_CAN_USE_SORT) != 0)
+	{
+		Path	   *sorted_path;
+
+		sorted_path = (Path *) create_sort_path(root, grouped_rel, path,
+												root->group_pathkeys,
+												-1.0);
+		if (parse->hasAggs)
+			sorted_path = (Path *)
+				create_agg_path(root, grouped_rel, sorted_path,
+								grouped_rel->reltarget,
+								AGG_SORTED, AGGSPLIT_SIMPLE,
+								root->processed_groupClause,
+								havingQual, agg_costs, dNumWorkerGroups);
+		else
+			sorted_path = (Path *)
+				create_group_path(root, grouped_rel, sorted_path,
+								  root->processed_groupClause,
+								  havingQual, dNumWorkerGroups);
+		add_partial_path(grouped_rel, sorted_path);
+	}
+
+	if ((extra->flags & GROUPING_CAN_USE_HASH) != 0)
+		add_partial_path(grouped_rel, (Path *)
+						 create_agg_path(root, grouped_rel, path,
+										 grouped_rel->reltarget,
+										 AGG_HASHED, AGGSPLIT_SIMPLE,
+										 root->processed_groupClause,
+										 havingQual, agg_costs,
+										 dNumWorkerGroups));
+}
+
+/*
+ * add_eager_aggregate_paths
+ *
+ * Add the paths of the scan/join rel's grouped rel, which joined partially
+ * aggregated rows (see setup_eager_aggregation), to partially_grouped_rel.
+ * They just need to be projected to emit what the Finalize Aggregate step
+ * expects.
+ */
+static void
+add_eager_aggregate_paths(PlannerInfo *root, RelOptInfo *input_grouped_rel,
+						  RelOptInfo *partially_grouped_rel)
+{
+	foreach_ptr(Path, path, input_grouped_rel->pathlist)
+	{
+		add_path(partially_grouped_rel, (Path *)
+				 create_projection_path(root,
+										partially_grouped_rel,
+										path,
+										partially_grouped_rel->reltarget));
+	}
+}
+
 /*
  * create_partial_grouping_paths
  *
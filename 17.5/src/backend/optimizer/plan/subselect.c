@@ -2297,6 +2297,7 @@ finalize_plan(PlannerInfo *root, Plan *plan,
 	finalize_primnode_context context;
 	int			locally_added_param;
 	Bitmapset  *nestloop_params;
+	Bitmapset  *hashjoin_params;
 	Bitmapset  *initExtParam;
 	Bitmapset  *initSetParam;
 	Bitmapset  *child_params;
@@ -2309,6 +2310,7 @@ finalize_plan(PlannerInfo *root, Plan *plan,
 	context.paramids = NULL;	/* initialize set to empty */
 	locally_added_param = -1;	/* there isn't one */
 	nestloop_params = NULL;		/* there aren't any */
+	hashjoin_params = NULL;		/* there aren't any */
 
 	/*
 	 * Examine any initPlans to determine the set of external params they
@@ -2609,6 +2611,8 @@ finalize_plan(PlannerInfo *root, Plan *plan,
 
 		case T_Append:
 			{
+				PartitionPruneInfo *pinfo = ((Append *) plan)->part_prune_info;
+
 				foreach(l, ((Append *) plan)->appendplans)
 				{
 					context.paramids =
@@ -2619,6 +2623,22 @@ finalize_plan(PlannerInfo *root, Plan *plan,
 													  valid_params,
 													  scan_params));
 				}
+
+				/*
+				 * Run-time pruning has to be redone when the params it uses
+				 * change, so they count as used by the Append.
+				 */
+				if (pinfo)
+				{
+					foreach_node(List, prune_infos, pinfo->prune_infos)
+					{
+						foreach_node(PartitionedRelPruneInfo, prelinfo,
+									 prune_infos)
+							context.paramids =
+								bms_add_members(context.paramids,
+												prelinfo->execparamids);
+					}
+				}
 			}
 			break;
 
@@ -2690,10 +2710,22 @@ finalize_plan(PlannerInfo *root, Plan *plan,
 			break;
 
 		case T_HashJoin:
-			finalize_primnode((Node *) ((Join *) plan)->joinqual,
-							  &context);
-			finalize_primnode((Node *) ((HashJoin *) plan)->hashclauses,
-							  &context);
+			{
+				HashJoin   *hjplan = (HashJoin *) plan;
+
+				finalize_primnode((Node *) hjplan->join.joinqual,
+								  &context);
+				finalize_primnode((Node *) hjplan->hashclauses,
+								  &context);
+				/* collect set of params that will be passed to left child */
+				if (hjplan->filterMinParam >= 0)
+				{
+					hashjoin_params = bms_add_member(hashjoin_params,
+													 hjplan->filterMinParam);
+					hashjoin_params = bms_add_member(hashjoin_params,
+													 hjplan->filterMaxParam);
+				}
+			}
 			break;
 
 		case T_Hash:
@@ -2802,6 +2834,7 @@ finalize_plan(PlannerInfo *root, Plan *plan,
 
 		case T_ProjectSet:
 		case T_Material:
+		case T_Repartition:
 		case T_Sort:
 		case T_IncrementalSort:
 		case T_Unique:
@@ -2816,11 +2849,27 @@ finalize_plan(PlannerInfo *root, Plan *plan,
 	}
 
 	/* Process left and right child plans, if any */
-	child_params = finalize_plan(root,
-								 plan->lefttree,
-								 gather_param,
-								 valid_params,
-								 scan_params);
+	if (hashjoin_params)
+	{
+		/* left child can reference hashjoin_params as well as valid_params */
+		child_params = finalize_plan(root,
+									 plan->lefttree,
+									 gather_param,
+									 bms_union(hashjoin_params, valid_params),
+									 scan_params);
+		/* ... and they don't count as parameters used at my level */
+		child_params = bms_difference(child_params, hashjoin_params);
+		bms_free(hashjoin_params);
+	}
+	else
+	{
+		/* easy case */
+		child_params = finalize_plan(root,
+									 plan->lefttree,
+									 gather_param,
+									 valid_params,
+									 scan_params);
+	}
 	context.paramids = bms_add_members(context.paramids, child_params);
 
 	if (nestloop_params)
@@ -1293,10 +1293,8 @@ choose_hashed_setop(PlannerInfo *root, List *groupClauses,
 					const char *construct)
 {
 	int			numGroupCols = list_length(groupClauses);
-	Size		hash_mem_limit = get_hash_memory_limit();
 	bool		can_sort;
 	bool		can_hash;
-	Size		hashentrysize;
 	Path		hashed_p;
 	Path		sorted_p;
 	double		tuple_fraction;
@@ -1324,16 +1322,9 @@ choose_hashed_setop(PlannerInfo *root, List *groupClauses,
 		return false;
 
 	/*
-	 * Don't do it if it doesn't look like the hashtable will fit into
-	 * hash_mem.
-	 */
-	hashentrysize = MAXALIGN(input_path->pathtarget->width) + MAXALIGN(SizeofMinimalTupleHeader);
-
-	if (hashentrysize * dNumGroups > hash_mem_limit)
-		return false;
-
-	/*
-	 * See if the estimated cost is no more than doing it the other way.
+	 * See if the estimated cost is no more than doing it the other way.  The
+	 * hashtable need not fit into hash_mem, since both Agg and SetOp can
+	 * spill to disk; cost_agg() accounts for that.
 	 *
 	 * We need to consider input_plan + hashagg versus input_plan + sort +
 	 * group.  Note that the actual result plan might involve a SetOp or
@@ -1593,11 +1593,15 @@ create_material_path(RelOptInfo *rel, Path *subpath)
 /*
  * create_memoize_path
  *	  Creates a path corresponding to a Memoize plan, returning the pathnode.
+ *
+ * 'below_gather' is true if the path is the inner side of a partial join,
+ * so that the parallel participants may share their cache entries.
  */
 MemoizePath *
 create_memoize_path(PlannerInfo *root, RelOptInfo *rel, Path *subpath,
 					List *param_exprs, List *hash_operators,
-					bool singlerow, bool binary_mode, double calls)
+					bool singlerow, bool binary_mode, double calls,
+					bool below_gather)
 {
 	MemoizePath *pathnode = makeNode(MemoizePath);
 
@@ -1619,6 +1623,7 @@ create_memoize_path(PlannerInfo *root, RelOptInfo *rel, Path *subpath,
 	pathnode->singlerow = singlerow;
 	pathnode->binary_mode = binary_mode;
 	pathnode->calls = clamp_row_est(calls);
+	pathnode->below_gather = below_gather;
 
 	/*
 	 * For now we set est_entries to 0.  cost_memoize_rescan() does all the
@@ -1639,6 +1644,95 @@ create_memoize_path(PlannerInfo *root, RelOptInfo *rel, Path *subpath,
 	return pathnode;
 }
 
+/*
+ * create_repartition_path
+ *	  Creates a path corresponding to a Repartition plan, returning the
+ *	  pathnode.
+ *
+ * 'subpath' must be a partial path, and 'hashClause' is a list of hashable
+ * SortGroupClauses identifying the columns to redistribute by.
+ */
+RepartitionPath *
+create_repartition_path(PlannerInfo *root, RelOptInfo *rel, Path *subpath,
+						List *hashClause)
+{
+	RepartitionPath *pathnode = makeNode(RepartitionPath);
+
+	Assert(hashClause != NIL);
+	Assert(subpath->parallel_workers > 0);
+
+	pathnode->path.pathtype = T_Repartition;
+	pathnode->path.parent = rel;
+	/* Repartition doesn't project, so use source path's pathtarget */
+	pathnode->path.pathtarget = subpath->pathtarget;
+	/* For now, assume we are above any joins, so no parameterization */
+	pathnode->path.param_info = NULL;
+	pathnode->path.parallel_aware = true;
+	pathnode->path.parallel_safe = rel->consider_parallel &&
+		subpath->parallel_safe;
+	pathnode->path.parallel_workers = subpath->parallel_workers;
+	/* The output order is arbitrary */
+	pathnode->path.pathkeys = NIL;
+
+	pathnode->subpath = subpath;
+	pathnode->hashClause = hashClause;
+	pathnode->rangeBounds = NIL;
+
+	cost_repartition(&pathnode->path,
+					 subpath->total_cost,
+					 subpath->rows,
+					 subpath->pathtarget->width,
+					 list_length(hashClause));
+
+	return pathnode;
+}
+
+/*
+ * create_range_repartition_path
+ *	  Creates a path corresponding to a Repartition plan in range mode,
+ *	  returning the pathnode.
+ *
+ * 'subpath' must be a partial path.  The tuples are distributed by ranges of
+ * the first of 'pathkeys', delimited by 'rangeBounds' (a list of Consts in
+ * the pathkey's sort order), and each range is sorted by 'pathkeys'.
+ */
+RepartitionPath *
+create_range_repartition_path(PlannerInfo *root, RelOptInfo *rel,
+							  Path *subpath, List *pathkeys,
+							  List *rangeBounds)
+{
+	RepartitionPath *pathnode = makeNode(RepartitionPath);
+
+	Assert(pathkeys != NIL && rangeBounds != NIL);
+	Assert(subpath->parallel_workers > 0);
+
+	pathnode->path.pathtype = T_Repartition;
+	pathnode->path.parent = rel;
+	/* Repartition doesn't project, so use source path's pathtarget */
+	pathnode->path.pathtarget = subpath->pathtarget;
+	/* For now, assume we are above any joins, so no parameterization */
+	pathnode->path.param_info = NULL;
+	pathnode->path.parallel_aware = true;
+	pathnode->path.parallel_safe = rel->consider_parallel &&
+		subpath->parallel_safe;
+	pathnode->path.parallel_workers = subpath->parallel_workers;
+	/* A single participant returns all the tuples, in sort order */
+	pathnode->path.pathkeys = pathkeys;
+
+	pathnode->subpath = subpath;
+	pathnode->hashClause = NIL;
+	pathnode->rangeBounds = rangeBounds;
+
+	cost_range_repartition(&pathnode->path, root, pathkeys,
+						   subpath->total_cost,
+						   subpath->rows,
+						   subpath->pathtarget->width,
+						   list_length(rangeBounds),
+						   subpath->parallel_workers + 1);
+
+	return pathnode;
+}
+
 /*
  * create_unique_path
  *	  Creates a path representing elimination of distinct rows from the
@@ -4079,7 +4173,8 @@ reparameterize_path(PlannerInfo *root, Path *path,
 													mpath->hash_operators,
 													mpath->singlerow,
 													mpath->binary_mode,
-													mpath->calls);
+													mpath->calls,
+													mpath->below_gather);
 			}
 		default:
 			break;
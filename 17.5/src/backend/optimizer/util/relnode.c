@@ -16,6 +16,7 @@
 
 #include <limits.h>
 
+#include "access/sysattr.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/appendinfo.h"
@@ -286,6 +287,7 @@ build_simple_rel(PlannerInfo *root, int relid, RelOptInfo *parent)
 	rel->all_partrels = NULL;
 	rel->partexprs = NULL;
 	rel->nullable_partexprs = NULL;
+	rel->grouped_rel = NULL;
 
 	/*
 	 * Pass assorted information down the inheritance hierarchy.
@@ -768,6 +770,7 @@ build_join_rel(PlannerInfo *root,
 	joinrel->all_partrels = NULL;
 	joinrel->partexprs = NULL;
 	joinrel->nullable_partexprs = NULL;
+	joinrel->grouped_rel = NULL;
 
 	/* Compute information relevant to the foreign relations. */
 	set_foreign_rel_properties(joinrel, outer_rel, inner_rel);
@@ -962,6 +965,7 @@ build_child_join_rel(PlannerInfo *root, RelOptInfo *outer_rel,
 	joinrel->all_partrels = NULL;
 	joinrel->partexprs = NULL;
 	joinrel->nullable_partexprs = NULL;
+	joinrel->grouped_rel = NULL;
 
 	/* Compute information relevant to foreign relations. */
 	set_foreign_rel_properties(joinrel, outer_rel, inner_rel);
@@ -1509,6 +1513,76 @@ fetch_upper_rel(PlannerInfo *root, UpperRelationKind kind, Relids relids)
 }
 
 
+/*
+ * build_grouped_rel
+ *	  Build the grouped rel for a base or join relation that contains the
+ *	  relation chosen for eager aggregation (root->eager_agg_relid).
+ *
+ * The grouped rel represents the same set of relations, but its rows come
+ * from partially aggregating the rows of the aggregated relation before
+ * joining them.  So instead of that relation's Vars that are used only in
+ * aggregates, its target list has the partial Aggrefs.  We copy everything
+ * else from rel, except for what must not be shared between the two or does
+ * not apply to the grouped rel; the caller is responsible for its size
+ * estimates and paths.
+ */
+RelOptInfo *
+build_grouped_rel(PlannerInfo *root, RelOptInfo *rel)
+{
+	RelOptInfo *grouped_rel;
+	PathTarget *target;
+	ListCell   *lc;
+
+	Assert(root->eager_agg_relid != 0);
+	Assert(bms_is_member(root->eager_agg_relid, rel->relids));
+
+	grouped_rel = makeNode(RelOptInfo);
+	memcpy(grouped_rel, rel, sizeof(RelOptInfo));
+
+	target = create_empty_pathtarget();
+	foreach(lc, rel->reltarget->exprs)
+	{
+		Var		   *var = (Var *) lfirst(lc);
+
+		if (IsA(var, Var) &&
+			var->varno == root->eager_agg_relid &&
+			bms_is_member(var->varattno - FirstLowInvalidHeapAttributeNumber,
+						  root->eager_agg_aggonly_attrs))
+			continue;
+		add_column_to_pathtarget(target, (Expr *) var, 0);
+	}
+	add_new_columns_to_pathtarget(target, root->eager_agg_partial_aggs);
+	grouped_rel->reltarget = set_pathtarget_cost_width(root, target);
+
+	grouped_rel->rows = 0;
+	grouped_rel->consider_parallel = false;
+	grouped_rel->pathlist = NIL;
+	grouped_rel->ppilist = NIL;
+	grouped_rel->partial_pathlist = NIL;
+	grouped_rel->cheapest_startup_path = NULL;
+	grouped_rel->cheapest_total_path = NULL;
+	grouped_rel->cheapest_unique_path = NULL;
+	grouped_rel->cheapest_parameterized_paths = NIL;
+	grouped_rel->serverid = InvalidOid;
+	grouped_rel->fdwroutine = NULL;
+	grouped_rel->fdw_private = NULL;
+	grouped_rel->unique_for_rels = NIL;
+	grouped_rel->non_unique_for_rels = NIL;
+	grouped_rel->consider_partitionwise_join = false;
+	grouped_rel->part_scheme = NULL;
+	grouped_rel->nparts = 0;
+	grouped_rel->boundinfo = NULL;
+	grouped_rel->part_rels = NULL;
+	grouped_rel->live_parts = NULL;
+	grouped_rel->all_partrels = NULL;
+	grouped_rel->partexprs = NULL;
+	grouped_rel->nullable_partexprs = NULL;
+	grouped_rel->grouped_rel = NULL;
+
+	return grouped_rel;
+}
+
+
 /*
  * find_childrel_parents
  *		Compute the set of parent relids of an appendrel child rel.
@@ -40,12 +40,27 @@
  * when the corresponding files need to be survived across the transaction and
  * need to be opened and closed multiple times.  Such files need to be created
  * as a member of a FileSet.
+ *
+ * A BufFile made with BufFileCreateCompressTemp() compresses its contents
+ * with the method selected by temp_file_compression.  Each bufferload is
+ * written as a frame consisting of a BufFileFrameHeader followed by the
+ * compressed bytes, or the raw bytes if they did not compress.  Such a file
+ * must be written sequentially.  It can then be read back sequentially from
+ * the start, or from a position previously returned by BufFileTell().
  *-------------------------------------------------------------------------
  */
 
 #include "postgres.h"
 
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
 #include "commands/tablespace.h"
+#include "common/pg_lzcompress.h"
 #include "executor/instrument.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -62,6 +77,27 @@
 #define MAX_PHYSICAL_FILESIZE	0x40000000 /// 2^30 = 1GB
 #define BUFFILE_SEG_SIZE		(MAX_PHYSICAL_FILESIZE / BLCKSZ)
 
+/*
+ * Header of a frame of a compressed BufFile.  storedlen equals rawlen if the
+ * frame's data is stored uncompressed.
+ */
+typedef struct BufFileFrameHeader
+{
+	int32		rawlen;			/* number of bytes in the bufferload */
+	int32		storedlen;		/* number of bytes following the header */
+} BufFileFrameHeader;
+
+/*
+ * The position of a compressed BufFile, as seen by BufFileTell() and
+ * BufFileSeek(), combines the physical offset of a frame with the logical
+ * offset within it.
+ */
+#define BUFFILE_FRAME_POS(frameoffset, pos) \
+	((off_t) (frameoffset) * (BLCKSZ + 1) + (pos))
+
+/* GUC variable */
+int			temp_file_compression = TEMP_FILE_COMPRESSION_NONE;
+
 /*
  * This data structure represents a buffered file that consists of one or
  * more physical files (each accessed through a virtual file descriptor
@@ -96,6 +132,19 @@ struct BufFile
 	int			pos;			/* next read/write position in buffer */
 	int			nbytes;			/* total # of valid bytes in buffer */
 
+	/*
+	 * For a compressed file, curOffset is the physical position of the next
+	 * frame, and frameFile/frameOffset is that of the frame in the buffer.
+	 * rawBytesWritten and storedBytesWritten count the bytes written before
+	 * and after compression.
+	 */
+	TempFileCompression compress;	/* compression method, or none */
+	char	   *cBuffer;		/* scratch space for a compressed frame */
+	int			frameFile;
+	off_t		frameOffset;
+	int64		rawBytesWritten;
+	int64		storedBytesWritten;
+
 	/*
 	 * XXX Should ideally us PGIOAlignedBlock, but might need a way to avoid
 	 * wasting per-file alignment padding when some users create many files.
@@ -109,6 +158,9 @@ static void extendBufFile(BufFile *file);
 static void BufFileLoadBuffer(BufFile *file);
 static void BufFileDumpBuffer(BufFile *file);
 static void BufFileFlush(BufFile *file);
+static void BufFileLoadFrame(BufFile *file);
+static size_t BufFileReadFrameData(BufFile *file, void *ptr, size_t size);
+static int	BufFileSeekFrame(BufFile *file, int fileno, off_t offset);
 static File MakeNewFileSetSegment(BufFile *buffile, int segment);
 
 /*
@@ -127,6 +179,12 @@ makeBufFileCommon(int nfiles)
 	file->curOffset = 0;
 	file->pos = 0;
 	file->nbytes = 0;
+	file->compress = TEMP_FILE_COMPRESSION_NONE;
+	file->cBuffer = NULL;
+	file->frameFile = 0;
+	file->frameOffset = 0;
+	file->rawBytesWritten = 0;
+	file->storedBytesWritten = 0;
 
 	return file;
 }
@@ -215,6 +273,28 @@ BufFileCreateTemp(bool interXact)
 	return file;
 }
 
+/*
+ * Like BufFileCreateTemp(), but the file's contents are compressed if
+ * temp_file_compression is set.
+ *
+ * The caller must write the file sequentially, and may only seek to the
+ * start or to positions returned by BufFileTell() once all data is written.
+ */
+BufFile *
+BufFileCreateCompressTemp(bool interXact)
+{
+	BufFile    *file = BufFileCreateTemp(interXact);
+
+	if (temp_file_compression != TEMP_FILE_COMPRESSION_NONE)
+	{
+		file->compress = (TempFileCompression) temp_file_compression;
+		file->cBuffer = palloc(sizeof(BufFileFrameHeader) +
+							   BufFileCompressBound(BLCKSZ));
+	}
+
+	return file;
+}
+
 /*
  * Build the name for a given segment of a given BufFile.
  */
@@ -420,6 +500,8 @@ BufFileClose(BufFile *file)
 		FileClose(file->files[i]);
 	/* release the buffer space */
 	pfree(file->files);
+	if (file->cBuffer)
+		pfree(file->cBuffer);
 	pfree(file);
 }
 
@@ -437,6 +519,12 @@ BufFileLoadBuffer(BufFile *file)
 	instr_time	io_start;
 	instr_time	io_time;
 
+	if (file->compress != TEMP_FILE_COMPRESSION_NONE)
+	{
+		BufFileLoadFrame(file);
+		return;
+	}
+
 	/*
 	 * Advance to next component file if necessary and possible.
 	 */
@@ -480,7 +568,134 @@ BufFileLoadBuffer(BufFile *file)
 	/* we choose not to advance curOffset here */
 
 	if (file->nbytes > 0)
+	{
+		pgstat_count_io_op_time(IOOBJECT_TEMP_FILE, IOCONTEXT_NORMAL,
+								IOOP_READ, io_start, 1);
 		pgBufferUsage.temp_blks_read++;
+	}
+}
+
+/*
+ * BufFileLoadFrame
+ *
+ * Load the frame starting at curOffset of a compressed file into the
+ * buffer, and advance curOffset past it.  At call, must have dirty = false,
+ * pos and nbytes = 0.  On exit, nbytes is 0 if there was no frame left.
+ */
+static void
+BufFileLoadFrame(BufFile *file)
+{
+	BufFileFrameHeader hdr;
+	size_t		nread;
+	int32		len;
+	instr_time	io_start;
+	instr_time	io_time;
+
+	/* Normalize the position, so that BufFileTell() reports it uniquely */
+	if (file->curOffset >= MAX_PHYSICAL_FILESIZE &&
+		file->curFile + 1 < file->numFiles)
+	{
+		file->curFile++;
+		file->curOffset = 0;
+	}
+	file->frameFile = file->curFile;
+	file->frameOffset = file->curOffset;
+
+	if (track_io_timing)
+		INSTR_TIME_SET_CURRENT(io_start);
+	else
+		INSTR_TIME_SET_ZERO(io_start);
+
+	nread = BufFileReadFrameData(file, &hdr, sizeof(hdr));
+	if (nread == 0)
+		return;					/* end of file */
+	if (nread != sizeof(hdr) ||
+		hdr.rawlen <= 0 || hdr.rawlen > BLCKSZ ||
+		hdr.storedlen <= 0 || hdr.storedlen > hdr.rawlen)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("invalid frame header in temporary file \"%s\"",
+								 FilePathName(file->files[file->frameFile]))));
+
+	if (hdr.storedlen == hdr.rawlen)
+	{
+		/* stored uncompressed */
+		nread = BufFileReadFrameData(file, file->buffer.data, hdr.storedlen);
+		len = hdr.rawlen;
+	}
+	else
+	{
+		nread = BufFileReadFrameData(file, file->cBuffer, hdr.storedlen);
+		len = BufFileDecompressData(file->compress, file->cBuffer,
+									hdr.storedlen, file->buffer.data,
+									hdr.rawlen);
+	}
+	if (nread != hdr.storedlen || len != hdr.rawlen)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("could not decompress frame of temporary file \"%s\"",
+								 FilePathName(file->files[file->frameFile]))));
+
+	if (track_io_timing)
+	{
+		INSTR_TIME_SET_CURRENT(io_time);
+		INSTR_TIME_ACCUM_DIFF(pgBufferUsage.temp_blk_read_time, io_time, io_start);
+	}
+
+	pgstat_count_io_op_time(IOOBJECT_TEMP_FILE, IOCONTEXT_NORMAL,
+							IOOP_READ, io_start, 1);
+	pgBufferUsage.temp_blks_read++;
+
+	file->nbytes = hdr.rawlen;
+}
+
+/*
+ * BufFileReadFrameData
+ *
+ * Read up to 'size' bytes of a compressed file at curOffset, crossing into
+ * the next component file as needed, and advance curOffset.  Returns the
+ * number of bytes read, which is less than 'size' only at end of file.
+ */
+static size_t
+BufFileReadFrameData(BufFile *file, void *ptr, size_t size)
+{
+	size_t		nread = 0;
+
+	while (size > 0)
+	{
+		File		thisfile;
+		off_t		availbytes;
+		int			bytestoread;
+
+		if (file->curOffset >= MAX_PHYSICAL_FILESIZE)
+		{
+			if (file->curFile + 1 >= file->numFiles)
+				break;
+			file->curFile++;
+			file->curOffset = 0;
+		}
+
+		thisfile = file->files[file->curFile];
+		availbytes = MAX_PHYSICAL_FILESIZE - file->curOffset;
+		bytestoread = (int) Min((off_t) size, availbytes);
+
+		bytestoread = FileRead(thisfile, ptr, bytestoread, file->curOffset,
+							   WAIT_EVENT_BUFFILE_READ);
+		if (bytestoread < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read file \"%s\": %m",
+							FilePathName(thisfile))));
+		if (bytestoread == 0)
+			break;
+
+		file->curOffset += bytestoread;
+		ptr = (char *) ptr + bytestoread;
+		size -= bytestoread;
+		nread += bytestoread;
+	}
+
+	return nread;
 }
 
 /*
@@ -493,15 +708,49 @@ BufFileLoadBuffer(BufFile *file)
 static void
 BufFileDumpBuffer(BufFile *file)
 {
+	const char *data = file->buffer.data;
+	int			datalen = file->nbytes;
 	int			wpos = 0;
 	int			bytestowrite;
 	File		thisfile;
 
+	/*
+	 * A compressed file is written as frames, see BufFileLoadFrame().  As it
+	 * is written sequentially, the whole buffer is always part of the frame.
+	 */
+	if (file->compress != TEMP_FILE_COMPRESSION_NONE)
+	{
+		BufFileFrameHeader hdr;
+		int32		len;
+
+		Assert(file->pos == file->nbytes);
+
+		len = BufFileCompressData(file->compress, file->buffer.data,
+								  file->nbytes,
+								  file->cBuffer + sizeof(hdr));
+		if (len <= 0 || len >= file->nbytes)
+		{
+			/* didn't compress, so store the data as-is */
+			memcpy(file->cBuffer + sizeof(hdr), file->buffer.data,
+				   file->nbytes);
+			len = file->nbytes;
+		}
+		hdr.rawlen = file->nbytes;
+		hdr.storedlen = len;
+		memcpy(file->cBuffer, &hdr, sizeof(hdr));
+
+		data = file->cBuffer;
+		datalen = sizeof(hdr) + len;
+
+		file->rawBytesWritten += file->nbytes;
+		file->storedBytesWritten += datalen;
+	}
+
 	/*
 	 * Unlike BufFileLoadBuffer, we must dump the whole buffer even if it
 	 * crosses a component-file boundary; so we need a loop.
 	 */
-	while (wpos < file->nbytes)
+	while (wpos < datalen)
 	{
 		off_t		availbytes;
 		instr_time	io_start;
@@ -521,7 +770,7 @@ BufFileDumpBuffer(BufFile *file)
 		/*
 		 * Determine how much we need to write into this file.
 		 */
-		bytestowrite = file->nbytes - wpos;
+		bytestowrite = datalen - wpos;
 		availbytes = MAX_PHYSICAL_FILESIZE - file->curOffset;
 
 		if ((off_t) bytestowrite > availbytes)
@@ -535,7 +784,7 @@ BufFileDumpBuffer(BufFile *file)
 			INSTR_TIME_SET_ZERO(io_start);
 
 		bytestowrite = FileWrite(thisfile,
-								 file->buffer.data + wpos,
+								 data + wpos,
 								 bytestowrite,
 								 file->curOffset,
 								 WAIT_EVENT_BUFFILE_WRITE);
@@ -554,6 +803,8 @@ BufFileDumpBuffer(BufFile *file)
 		file->curOffset += bytestowrite;
 		wpos += bytestowrite;
 
+		pgstat_count_io_op_time(IOOBJECT_TEMP_FILE, IOCONTEXT_NORMAL,
+								IOOP_WRITE, io_start, 1);
 		pgBufferUsage.temp_blks_written++;
 	}
 	file->dirty = false;
@@ -563,8 +814,11 @@ BufFileDumpBuffer(BufFile *file)
 	 * ie, its original value + nbytes.  We need to make it point to the
 	 * logical file position, ie, original value + pos, in case that is less
 	 * (as could happen due to a small backwards seek in a dirty buffer!)
+	 * A compressed file has no such logical positions; there curOffset just
+	 * stays at the end of the frame.
 	 */
-	file->curOffset -= (file->nbytes - file->pos);
+	if (file->compress == TEMP_FILE_COMPRESSION_NONE)
+		file->curOffset -= (file->nbytes - file->pos);
 	if (file->curOffset < 0)	/* handle possible segment crossing */
 	{
 		file->curFile--;
@@ -603,7 +857,8 @@ BufFileReadCommon(BufFile *file, void *ptr, size_t size, bool exact, bool eofOK)
 		if (file->pos >= file->nbytes)
 		{
 			/* Try to load more data into buffer. */
-			file->curOffset += file->pos;
+			if (file->compress == TEMP_FILE_COMPRESSION_NONE)
+				file->curOffset += file->pos;
 			file->pos = 0;
 			file->nbytes = 0;
 			BufFileLoadBuffer(file);
@@ -689,6 +944,7 @@ BufFileWrite(BufFile *file, const void *ptr, size_t size)
 			else
 			{
 				/* Hmm, went directly from reading to writing? */
+				Assert(file->compress == TEMP_FILE_COMPRESSION_NONE);
 				file->curOffset += file->pos;
 				file->pos = 0;
 				file->nbytes = 0;
@@ -742,6 +998,13 @@ BufFileSeek(BufFile *file, int fileno, off_t offset, int whence)
 	int			newFile;
 	off_t		newOffset;
 
+	if (file->compress != TEMP_FILE_COMPRESSION_NONE)
+	{
+		if (whence != SEEK_SET)
+			elog(ERROR, "compressed temporary files only support absolute seeks");
+		return BufFileSeekFrame(file, fileno, offset);
+	}
+
 	switch (whence)
 	{
 		case SEEK_SET:
@@ -829,9 +1092,58 @@ BufFileSeek(BufFile *file, int fileno, off_t offset, int whence)
 	return 0;
 }
 
+/*
+ * BufFileSeekFrame
+ *
+ * BufFileSeek() for a compressed file: load the frame at the given position
+ * and move to the given offset within it.
+ */
+static int
+BufFileSeekFrame(BufFile *file, int fileno, off_t offset)
+{
+	off_t		frameOffset = offset / (BLCKSZ + 1);
+	int			pos = (int) (offset % (BLCKSZ + 1));
+
+	if (fileno < 0 || fileno >= file->numFiles || offset < 0)
+		return EOF;
+
+	BufFileFlush(file);
+
+	file->curFile = fileno;
+	file->curOffset = frameOffset;
+	file->pos = 0;
+	file->nbytes = 0;
+
+	if (pos > 0)
+	{
+		BufFileLoadBuffer(file);
+		if (pos > file->nbytes)
+			return EOF;
+		file->pos = pos;
+	}
+
+	return 0;
+}
+
 void
 BufFileTell(BufFile *file, int *fileno, off_t *offset)
 {
+	if (file->compress != TEMP_FILE_COMPRESSION_NONE)
+	{
+		Assert(!file->dirty);
+		if (file->nbytes > 0)
+		{
+			*fileno = file->frameFile;
+			*offset = BUFFILE_FRAME_POS(file->frameOffset, file->pos);
+		}
+		else
+		{
+			*fileno = file->curFile;
+			*offset = BUFFILE_FRAME_POS(file->curOffset, 0);
+		}
+		return;
+	}
+
 	*fileno = file->curFile;
 	*offset = file->curOffset + file->pos;
 }
@@ -856,6 +1168,30 @@ BufFileSeekBlock(BufFile *file, int64 blknum)
 					   SEEK_SET);
 }
 
+/*
+ * BufFilePrefetchBlock --- initiate read-ahead of BLCKSZ-sized blocks
+ *
+ * Asks the kernel to start reading nblocks blocks, starting at the n'th
+ * block of the file, so that a later read of them is less likely to block.
+ * This is only a hint: blocks past the end of the file are ignored, and so
+ * is the part of the range that falls into the next segment file.
+ */
+void
+BufFilePrefetchBlock(BufFile *file, int64 blknum, int nblocks)
+{
+#ifdef USE_PREFETCH
+	int			fileno = (int) (blknum / BUFFILE_SEG_SIZE);
+	int64		segblock = blknum % BUFFILE_SEG_SIZE;
+
+	if (blknum < 0 || nblocks <= 0 || fileno >= file->numFiles)
+		return;
+
+	nblocks = (int) Min(nblocks, BUFFILE_SEG_SIZE - segblock);
+	(void) FilePrefetch(file->files[fileno], (off_t) segblock * BLCKSZ,
+						(off_t) nblocks * BLCKSZ, WAIT_EVENT_BUFFILE_READ);
+#endif
+}
+
 /*
  * Return the current fileset based BufFile size.
  *
@@ -1019,3 +1355,129 @@ BufFileTruncateFileSet(BufFile *file, int fileno, off_t offset)
 	}
 	/* Nothing to do, if the truncate point is beyond current file. */
 }
+
+/*
+ * Return how many bytes have been written to a compressed file, before and
+ * after compression.  Both are zero for a file that is not compressed.
+ */
+void
+BufFileCompressionStats(BufFile *file, int64 *rawBytes, int64 *storedBytes)
+{
+	*rawBytes = file->rawBytesWritten;
+	*storedBytes = file->storedBytesWritten;
+}
+
+/*
+ * Return the size of the buffer BufFileCompressData() needs to compress
+ * srclen bytes with any of the supported methods.
+ */
+Size
+BufFileCompressBound(int32 srclen)
+{
+	Size		bound = PGLZ_MAX_OUTPUT(srclen);
+
+#ifdef USE_LZ4
+	bound = Max(bound, LZ4_COMPRESSBOUND(srclen));
+#endif
+#ifdef USE_ZSTD
+	bound = Max(bound, ZSTD_COMPRESSBOUND(srclen));
+#endif
+
+	return bound;
+}
+
+/*
+ * Compress srclen bytes at src into dst, which must have room for
+ * BufFileCompressBound(srclen) bytes.  Returns the compressed length, or -1
+ * if the data could not be compressed.
+ */
+int32
+BufFileCompressData(TempFileCompression method, const char *src,
+					int32 srclen, char *dst)
+{
+	int32		len = -1;
+
+	switch (method)
+	{
+		case TEMP_FILE_COMPRESSION_PGLZ:
+			len = pglz_compress(src, srclen, dst, PGLZ_strategy_default);
+			break;
+
+		case TEMP_FILE_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			len = LZ4_compress_default(src, dst, srclen,
+									   LZ4_COMPRESSBOUND(srclen));
+			if (len <= 0)
+				len = -1;		/* failure */
+#else
+			elog(ERROR, "LZ4 is not supported by this build");
+#endif
+			break;
+
+		case TEMP_FILE_COMPRESSION_ZSTD:
+#ifdef USE_ZSTD
+			{
+				size_t		comp_result;
+
+				/* favor speed over ratio, as the data is short-lived */
+				comp_result = ZSTD_compress(dst, ZSTD_COMPRESSBOUND(srclen),
+											src, srclen, 1);
+				if (!ZSTD_isError(comp_result))
+					len = (int32) comp_result;
+			}
+#else
+			elog(ERROR, "zstd is not supported by this build");
+#endif
+			break;
+
+		case TEMP_FILE_COMPRESSION_NONE:
+			Assert(false);		/* cannot happen */
+			break;
+			/* no default case, so that compiler will warn */
+	}
+
+	return len;
+}
+
+/*
+ * Decompress srclen bytes at src into dst, which must have room for rawlen
+ * bytes.  Returns the decompressed length, or -1 if the data is corrupt.
+ */
+int32
+BufFileDecompressData(TempFileCompression method, const char *src,
+					  int32 srclen, char *dst, int32 rawlen)
+{
+	int32		len = -1;
+
+	switch (method)
+	{
+		case TEMP_FILE_COMPRESSION_PGLZ:
+			len = pglz_decompress(src, srclen, dst, rawlen, true);
+			break;
+
+		case TEMP_FILE_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			len = LZ4_decompress_safe(src, dst, srclen, rawlen);
+#endif
+			break;
+
+		case TEMP_FILE_COMPRESSION_ZSTD:
+#ifdef USE_ZSTD
+			{
+				size_t		decomp_result;
+
+				decomp_result = ZSTD_decompress(dst, rawlen, src, srclen);
+				if (!ZSTD_isError(decomp_result))
+					len = (int32) decomp_result;
+			}
+#endif
+			break;
+
+		case TEMP_FILE_COMPRESSION_NONE:
+			Assert(false);		/* cannot happen */
+			break;
+			/* no default case, so that compiler will warn */
+	}
+
+	return len;
+}
@@ -169,6 +169,7 @@ static const char *const BuiltinTrancheNames[] = {
 	[LWTRANCHE_SUBTRANS_SLRU] = "SubtransSLRU",
 	[LWTRANCHE_XACT_SLRU] = "XactSLRU",
 	[LWTRANCHE_PARALLEL_VACUUM_DSA] = "ParallelVacuumDSA",
+	[LWTRANCHE_PARALLEL_MEMOIZE] = "ParallelMemoize",
 };
 
 StaticAssertDecl(lengthof(BuiltinTrancheNames) ==
@@ -129,7 +129,11 @@ pgstat_count_io_op_time(IOObject io_object, IOContext io_context, IOOp io_op,
 		INSTR_TIME_SET_CURRENT(io_time);
 		INSTR_TIME_SUBTRACT(io_time, start_time);
 
-		if (io_op == IOOP_WRITE || io_op == IOOP_EXTEND)
+		if (io_object == IOOBJECT_TEMP_FILE)
+		{
+			/* buffile.c accounts for the time of temporary file IO itself */
+		}
+		else if (io_op == IOOP_WRITE || io_op == IOOP_EXTEND)
 		{
 			pgstat_count_buffer_write_time(INSTR_TIME_GET_MICROSEC(io_time));
 			if (io_object == IOOBJECT_RELATION)
@@ -245,6 +249,8 @@ pgstat_get_io_object_name(IOObject io_object)
 			return "relation";
 		case IOOBJECT_TEMP_RELATION:
 			return "temp relation";
+		case IOOBJECT_TEMP_FILE:
+			return "temp file";
 	}
 
 	elog(ERROR, "unrecognized IOObject value: %d", io_object);
@@ -391,6 +397,17 @@ pgstat_tracks_io_object(BackendType bktype, IOObject io_object,
 		io_object == IOOBJECT_TEMP_RELATION)
 		return false;
 
+	/*
+	 * Temporary files are only used by query execution (sorts, hashing and
+	 * the like), which does not happen in the auxiliary processes.  Their IO
+	 * always happens in the IOCONTEXT_NORMAL IOContext.
+	 */
+	if (io_object == IOOBJECT_TEMP_FILE &&
+		(io_context != IOCONTEXT_NORMAL ||
+		 bktype == B_AUTOVAC_LAUNCHER || bktype == B_BG_WRITER ||
+		 bktype == B_CHECKPOINTER || bktype == B_STARTUP))
+		return false;
+
 	/*
 	 * Some BackendTypes do not currently perform any IO in certain
 	 * IOContexts, and, while it may not be inherently incorrect for them to
@@ -449,6 +466,14 @@ pgstat_tracks_io_op(BackendType bktype, IOObject io_object,
 		(io_op == IOOP_FSYNC || io_op == IOOP_WRITEBACK))
 		return false;
 
+	/*
+	 * Temporary files are not buffered in shared or local buffers, so they
+	 * are only read and written.
+	 */
+	if (io_object == IOOBJECT_TEMP_FILE &&
+		io_op != IOOP_READ && io_op != IOOP_WRITE)
+		return false;
+
 	/*
 	 * Some IOOps are not valid in certain IOContexts and some IOOps are only
 	 * valid in certain contexts.
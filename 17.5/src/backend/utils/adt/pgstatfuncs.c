@@ -1412,9 +1412,9 @@ pg_stat_get_io(PG_FUNCTION_ARGS)
 
 				/*
 				 * Hard-code this to the value of BLCKSZ for now. Future
-				 * values could include XLOG_BLCKSZ, once WAL IO is tracked,
-				 * and constant multipliers, once non-block-oriented IO (e.g.
-				 * temporary file IO) is tracked.
+				 * values could include XLOG_BLCKSZ, once WAL IO is tracked.
+				 * Temporary file IO is done in bufferloads of up to BLCKSZ
+				 * bytes, fewer if temp_file_compression is in use.
 				 */
 				values[IO_COL_CONVERSION] = Int64GetDatum(BLCKSZ);
 
@@ -35,6 +35,7 @@
 #include "access/xlogprefetcher.h"
 #include "access/xlogrecovery.h"
 #include "archive/archive_module.h"
+#include "catalog/index.h"
 #include "catalog/namespace.h"
 #include "catalog/storage.h"
 #include "commands/async.h"
@@ -45,6 +46,7 @@
 #include "commands/vacuum.h"
 #include "common/file_utils.h"
 #include "common/scram-common.h"
+#include "executor/nodeMemoize.h"
 #include "jit/jit.h"
 #include "libpq/auth.h"
 #include "libpq/libpq.h"
@@ -70,6 +72,7 @@
 #include "replication/slot.h"
 #include "replication/slotsync.h"
 #include "replication/syncrep.h"
+#include "storage/buffile.h"
 #include "storage/bufmgr.h"
 #include "storage/large_object.h"
 #include "storage/pg_shmem.h"
@@ -464,6 +467,21 @@ static const struct config_enum_entry default_toast_compression_options[] = {
 	{NULL, 0, false}
 };
 
+static const struct config_enum_entry temp_file_compression_options[] = {
+	{"pglz", TEMP_FILE_COMPRESSION_PGLZ, false},
+#ifdef USE_LZ4
+	{"lz4", TEMP_FILE_COMPRESSION_LZ4, false},
+#endif
+#ifdef USE_ZSTD
+	{"zstd", TEMP_FILE_COMPRESSION_ZSTD, false},
+#endif
+	{"off", TEMP_FILE_COMPRESSION_NONE, false},
+	{"false", TEMP_FILE_COMPRESSION_NONE, true},
+	{"no", TEMP_FILE_COMPRESSION_NONE, true},
+	{"0", TEMP_FILE_COMPRESSION_NONE, true},
+	{NULL, 0, false}
+};
+
 static const struct config_enum_entry wal_compression_options[] = {
 	{"pglz", WAL_COMPRESSION_PGLZ, false},
 #ifdef USE_LZ4
@@ -870,6 +888,16 @@ struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_shared_memoize", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables sharing of memoized results between parallel workers."),
+			NULL,
+			GUC_EXPLAIN
+		},
+		&enable_shared_memoize,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_nestloop", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of nested-loop join plans."),
@@ -930,6 +958,18 @@ struct config_bool ConfigureNamesBool[] =
 		false,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_eager_aggregate", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables eager aggregation."),
+			gettext_noop("Allows the query planner to partially aggregate "
+						 "the rows of a relation before joining them to "
+						 "the other relations of the query."),
+			GUC_EXPLAIN
+		},
+		&enable_eager_aggregate,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_parallel_append", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of parallel append plans."),
@@ -987,6 +1027,19 @@ struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_repartition", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of repartitioning plans."),
+			gettext_noop("Allows the query planner to redistribute the rows of "
+						 "a parallel plan among the workers by the PARTITION BY "
+						 "key of window functions, so that they can be computed "
+						 "in parallel."),
+			GUC_EXPLAIN
+		},
+		&enable_repartition,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_group_by_reordering", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables reordering of GROUP BY keys."),
@@ -1008,6 +1061,18 @@ struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_goo_join_search", PGC_USERSET, QUERY_TUNING_GEQO,
+			gettext_noop("Enables greedy join order search for large join problems."),
+			gettext_noop("When enabled, queries with at least geqo_threshold "
+						 "FROM items are planned with greedy operator ordering "
+						 "instead of the genetic query optimizer."),
+			GUC_EXPLAIN
+		},
+		&enable_goo_join_search,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		/*
 		 * Not for general use --- used by SET SESSION AUTHORIZATION and SET
@@ -2093,6 +2158,31 @@ struct config_int ConfigureNamesInt[] =
 		8, 1, INT_MAX,
 		NULL, NULL, NULL
 	},
+	{
+		{"jit_deform_cache_size", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the maximum number of JIT-compiled tuple deforming "
+						 "functions kept for reuse by later queries."),
+			gettext_noop("0 disables caching.")
+		},
+		&jit_deform_cache_size,
+		256, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+	{
+		{"jit_defer_evaluations", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the number of evaluations after which an "
+						 "expression is JIT compiled."),
+			gettext_noop("Expressions are interpreted until then, and then "
+						 "compiled by the executing backend, whatever the "
+						 "plan's cost.  0 compiles expressions before "
+						 "execution starts, if the plan's cost exceeds "
+						 "jit_above_cost."),
+			GUC_EXPLAIN
+		},
+		&jit_defer_evaluations,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
 	{
 		{"geqo_threshold", PGC_USERSET, QUERY_TUNING_GEQO,
 			gettext_noop("Sets the threshold of FROM items beyond which GEQO is used."),
@@ -2542,6 +2632,16 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"concurrent_index_cost_limit", PGC_USERSET, RESOURCES_VACUUM_DELAY,
+			gettext_noop("Cost amount available before napping, for concurrent index builds."),
+			gettext_noop("-1 means use vacuum_cost_limit.")
+		},
+		&concurrent_index_cost_limit,
+		-1, -1, 10000,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"autovacuum_vacuum_cost_limit", PGC_SIGHUP, AUTOVACUUM,
 			gettext_noop("Vacuum cost amount available before napping, for autovacuum."),
@@ -3417,6 +3517,18 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"parallel_leader_max_workers", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Sets the maximum number of workers with which Gather and Gather Merge also run subplans."),
+			gettext_noop("With more workers launched than this, the leader only gathers tuples. "
+						 "-1 means no limit."),
+			GUC_EXPLAIN
+		},
+		&parallel_leader_max_workers,
+		-1, -1, MAX_PARALLEL_WORKER_LIMIT,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"max_parallel_workers", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
 			gettext_noop("Sets the maximum number of parallel workers that can be active at one time."),
@@ -3862,6 +3974,17 @@ struct config_real ConfigureNamesReal[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"concurrent_index_cost_delay", PGC_USERSET, RESOURCES_VACUUM_DELAY,
+			gettext_noop("Cost delay in milliseconds, for concurrent index builds."),
+			gettext_noop("Applies to CREATE INDEX CONCURRENTLY and REINDEX CONCURRENTLY."),
+			GUC_UNIT_MS
+		},
+		&concurrent_index_cost_delay,
+		0, 0, 100,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"autovacuum_vacuum_cost_delay", PGC_SIGHUP, AUTOVACUUM,
 			gettext_noop("Vacuum cost delay in milliseconds, for autovacuum."),
@@ -4991,6 +5114,16 @@ struct config_enum ConfigureNamesEnum[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"temp_file_compression", PGC_USERSET, RESOURCES_DISK,
+			gettext_noop("Compresses the blocks of temporary files used by sorts, hash aggregation and hash joins with specified method."),
+			NULL
+		},
+		&temp_file_compression,
+		TEMP_FILE_COMPRESSION_NONE, temp_file_compression_options,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_sync_method", PGC_SIGHUP, WAL_SETTINGS,
 			gettext_noop("Selects the method used for forcing WAL updates to disk."),
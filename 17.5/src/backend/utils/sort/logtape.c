@@ -66,6 +66,16 @@
  * There will always be the same number of runs as input tapes, and the same
  * number of input tapes as participants (worker Tuplesortstates).
  *
+ * If temp_file_compression is set, the blocks of a serial tape set are
+ * compressed before they are written.  A compressed block is still stored in
+ * its own BLCKSZ slot of the underlying file, so that block numbers and
+ * space recycling work as before, but only the compressed bytes are written.
+ * This reduces the I/O volume, and on most filesystems also the disk space
+ * used, since the unwritten tail of a slot is never allocated.  Blocks that
+ * do not compress well enough are stored as-is; a bitmap tells us which
+ * blocks are compressed.  Tape sets shared with a parallel leader are never
+ * compressed, as the bitmap is private to the process that wrote them.
+ *
  * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -124,6 +134,13 @@ typedef struct TapeBlockTrailer
 #define TAPE_WRITE_PREALLOC_MIN 8
 #define TAPE_WRITE_PREALLOC_MAX 128
 
+/*
+ * Buffer size required to compress a block with any of the supported
+ * methods.  A compressed block is stored as a uint32 length word followed
+ * by the compressed data.
+ */
+#define COMPRESS_BUFSIZE	BufFileCompressBound(BLCKSZ)
+
 /*
  * This data structure represents a single "logical tape" within the set
  * of logical tapes stored in the same file.
@@ -217,11 +234,30 @@ struct LogicalTapeSet
 	int64		nFreeBlocks;	/* # of currently free blocks */
 	Size		freeBlocksLen;	/* current allocated length of freeBlocks[] */
 	bool		enable_prealloc;	/* preallocate write blocks? */
+
+	/*
+	 * Block compression.  compressedBlocks is a bitmap, indexed by block
+	 * number, of the blocks that are stored compressed.  rawBytesWritten and
+	 * storedBytesWritten count the bytes of all blocks written so far, before
+	 * and after compression.
+	 */
+	TempFileCompression compression;
+	uint8	   *compressedBlocks;	/* bitmap of compressed blocks */
+	Size		compressedBlocksLen;	/* allocated length of the bitmap */
+	char	   *compressBuf;	/* scratch space for (de)compression */
+	int64		rawBytesWritten;
+	int64		storedBytesWritten;
 };
 
 static LogicalTape *ltsCreateTape(LogicalTapeSet *lts);
 static void ltsWriteBlock(LogicalTapeSet *lts, int64 blocknum, const void *buffer);
 static void ltsReadBlock(LogicalTapeSet *lts, int64 blocknum, void *buffer);
+static bool ltsWriteCompressedBlock(LogicalTapeSet *lts, const void *buffer);
+static void ltsReadCompressedBlock(LogicalTapeSet *lts, int64 blocknum,
+								   void *buffer);
+static void ltsSetBlockCompressed(LogicalTapeSet *lts, int64 blocknum,
+								  bool compressed);
+static bool ltsBlockIsCompressed(LogicalTapeSet *lts, int64 blocknum);
 static int64 ltsGetBlock(LogicalTapeSet *lts, LogicalTape *lt);
 static int64 ltsGetFreeBlock(LogicalTapeSet *lts);
 static int64 ltsGetPreallocBlock(LogicalTapeSet *lts, LogicalTape *lt);
@@ -265,7 +301,20 @@ ltsWriteBlock(LogicalTapeSet *lts, int64 blocknum, const void *buffer)
 				(errcode_for_file_access(),
 				 errmsg("could not seek to block %lld of temporary file",
 						(long long) blocknum)));
-	BufFileWrite(lts->pfile, buffer, BLCKSZ);
+	if (lts->compression != TEMP_FILE_COMPRESSION_NONE)
+	{
+		bool		compressed = ltsWriteCompressedBlock(lts, buffer);
+
+		ltsSetBlockCompressed(lts, blocknum, compressed);
+		if (!compressed)
+		{
+			BufFileWrite(lts->pfile, buffer, BLCKSZ);
+			lts->storedBytesWritten += BLCKSZ;
+		}
+		lts->rawBytesWritten += BLCKSZ;
+	}
+	else
+		BufFileWrite(lts->pfile, buffer, BLCKSZ);
 
 	/* Update nBlocksWritten, if we extended the file */
 	if (blocknum == lts->nBlocksWritten)
@@ -286,7 +335,100 @@ ltsReadBlock(LogicalTapeSet *lts, int64 blocknum, void *buffer)
 				(errcode_for_file_access(),
 				 errmsg("could not seek to block %lld of temporary file",
 						(long long) blocknum)));
-	BufFileReadExact(lts->pfile, buffer, BLCKSZ);
+	if (ltsBlockIsCompressed(lts, blocknum))
+		ltsReadCompressedBlock(lts, blocknum, buffer);
+	else
+		BufFileReadExact(lts->pfile, buffer, BLCKSZ);
+}
+
+/*
+ * Try to compress a block and write it at the current position of the
+ * underlying file.
+ *
+ * Returns false without writing anything if the block does not compress
+ * well enough to be worth it; the caller must write it uncompressed then.
+ */
+static bool
+ltsWriteCompressedBlock(LogicalTapeSet *lts, const void *buffer)
+{
+	char	   *dest = lts->compressBuf + sizeof(uint32);
+	int32		len;
+	uint32		stored_len;
+
+	len = BufFileCompressData(lts->compression, buffer, BLCKSZ, dest);
+
+	if (len < 0 || len + sizeof(uint32) >= BLCKSZ)
+		return false;
+
+	stored_len = (uint32) len;
+	memcpy(lts->compressBuf, &stored_len, sizeof(uint32));
+	BufFileWrite(lts->pfile, lts->compressBuf, sizeof(uint32) + len);
+	lts->storedBytesWritten += sizeof(uint32) + len;
+
+	return true;
+}
+
+/*
+ * Read a compressed block from the current position of the underlying file,
+ * and decompress it into a block-sized buffer.
+ */
+static void
+ltsReadCompressedBlock(LogicalTapeSet *lts, int64 blocknum, void *buffer)
+{
+	uint32		stored_len;
+	int32		len;
+
+	BufFileReadExact(lts->pfile, &stored_len, sizeof(uint32));
+	if (stored_len > COMPRESS_BUFSIZE)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("invalid compressed length %u in block %lld of temporary file",
+								 stored_len, (long long) blocknum)));
+	BufFileReadExact(lts->pfile, lts->compressBuf, stored_len);
+	len = BufFileDecompressData(lts->compression, lts->compressBuf,
+								stored_len, buffer, BLCKSZ);
+
+	if (len != BLCKSZ)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("could not decompress block %lld of temporary file",
+								 (long long) blocknum)));
+}
+
+/*
+ * Remember whether the given block is stored compressed.
+ */
+static void
+ltsSetBlockCompressed(LogicalTapeSet *lts, int64 blocknum, bool compressed)
+{
+	Size		byteno = blocknum / BITS_PER_BYTE;
+	uint8		mask = 1 << (blocknum % BITS_PER_BYTE);
+
+	if (byteno >= lts->compressedBlocksLen)
+	{
+		Size		newlen = Max(lts->compressedBlocksLen * 2, byteno + 1);
+
+		lts->compressedBlocks = repalloc0(lts->compressedBlocks,
+										  lts->compressedBlocksLen, newlen);
+		lts->compressedBlocksLen = newlen;
+	}
+
+	if (compressed)
+		lts->compressedBlocks[byteno] |= mask;
+	else
+		lts->compressedBlocks[byteno] &= ~mask;
+}
+
+static bool
+ltsBlockIsCompressed(LogicalTapeSet *lts, int64 blocknum)
+{
+	Size		byteno = blocknum / BITS_PER_BYTE;
+
+	if (lts->compression == TEMP_FILE_COMPRESSION_NONE ||
+		byteno >= lts->compressedBlocksLen)
+		return false;
+
+	return (lts->compressedBlocks[byteno] & (1 << (blocknum % BITS_PER_BYTE))) != 0;
 }
 
 /*
@@ -330,6 +472,17 @@ ltsReadFillBuffer(LogicalTape *lt)
 		/* Advance to next block, if we have buffer space left */
 	} while (lt->buffer_size - lt->nbytes > BLCKSZ);
 
+	/*
+	 * Let the kernel start reading the blocks for the next refill while the
+	 * caller consumes this one.  We only know the next block number, but
+	 * blocks are mostly allocated to a tape in runs, so the blocks following
+	 * it are a good guess.
+	 */
+	if (lt->nextBlockNumber != -1L)
+		BufFilePrefetchBlock(lt->tapeSet->pfile,
+							 lt->nextBlockNumber + lt->offsetBlockNumber,
+							 lt->buffer_size / BLCKSZ);
+
 	return (lt->nbytes > 0);
 }
 
@@ -573,6 +726,24 @@ LogicalTapeSetCreate(bool preallocate, SharedFileSet *fileset, int worker)
 	lts->fileset = fileset;
 	lts->worker = worker;
 
+	/*
+	 * Blocks of shared tape sets are read by the leader, which would not
+	 * know which of them are compressed.
+	 */
+	lts->compression = fileset ? TEMP_FILE_COMPRESSION_NONE :
+		(TempFileCompression) temp_file_compression;
+	lts->compressedBlocks = NULL;
+	lts->compressedBlocksLen = 0;
+	lts->compressBuf = NULL;
+	if (lts->compression != TEMP_FILE_COMPRESSION_NONE)
+	{
+		lts->compressedBlocksLen = 64;	/* reasonable initial guess */
+		lts->compressedBlocks = palloc0(lts->compressedBlocksLen);
+		lts->compressBuf = palloc(sizeof(uint32) + COMPRESS_BUFSIZE);
+	}
+	lts->rawBytesWritten = 0;
+	lts->storedBytesWritten = 0;
+
 	/*
 	 * Create temp BufFile storage as required.
 	 *
@@ -668,6 +839,10 @@ LogicalTapeSetClose(LogicalTapeSet *lts)
 {
 	BufFileClose(lts->pfile);
 	pfree(lts->freeBlocks);
+	if (lts->compressedBlocks)
+		pfree(lts->compressedBlocks);
+	if (lts->compressBuf)
+		pfree(lts->compressBuf);
 	pfree(lts);
 }
 
@@ -1182,3 +1357,16 @@ LogicalTapeSetBlocks(LogicalTapeSet *lts)
 {
 	return lts->nBlocksWritten - lts->nHoleBlocks;
 }
+
+/*
+ * Obtain the number of bytes of all blocks written to a LogicalTapeSet so
+ * far, before and after compression.  Both are zero if the tape set does not
+ * use compression.
+ */
+void
+LogicalTapeSetCompressionStats(LogicalTapeSet *lts, int64 *rawBytes,
+							   int64 *storedBytes)
+{
+	*rawBytes = lts->rawBytesWritten;
+	*storedBytes = lts->storedBytesWritten;
+}
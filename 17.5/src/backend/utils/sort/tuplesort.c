@@ -207,6 +207,9 @@ struct Tuplesortstate
 								 * space */
 	TupSortStatus maxSpaceStatus;	/* sort status when maxSpace was reached */
 	LogicalTapeSet *tapeset;	/* logtape.c object for tapes in a temp file */
+	int64		tempWritten;	/* bytes written to the tape sets of earlier
+								 * batches, before and after compression */
+	int64		tempWrittenCompressed;
 
 	/*
 	 * This array holds the tuples now in sort memory.  If we are in state
@@ -491,6 +494,8 @@ static void tuplesort_updatemax(Tuplesortstate *state);
  * authoritative and we don't even need to fall back to a callback at all (that
  * would be true for types like int4/int8/timestamp/date, but not true for
  * abbreviations of text or multi-key sorts.  There could be!  Is it worth it?
+ * Large sorts on these comparators use radix_sort_memtuples() instead, which
+ * only calls them for small partitions and ties.
  */
 
 /* Used if first key's comparator is ssup_datum_unsigned_cmp */
@@ -622,6 +627,265 @@ qsort_tuple_int32_compare(SortTuple *a, SortTuple *b, Tuplesortstate *state)
 #define ST_DEFINE
 #include "lib/sort_template.h"
 
+/*
+ * Radix sort for SortTuples whose datum1 is ordered by one of the
+ * specialized comparators above.
+ *
+ * datum1 is first mapped to an unsigned integer key that sorts in the same
+ * order as the comparator (flipping the sign bit for signed keys, and all
+ * bits for descending sorts).  The tuples are then sorted with an in-place
+ * most-significant-digit radix sort ("American flag sort") one byte at a
+ * time.  Bytes that are the same in all keys of a partition are skipped
+ * without moving any tuples, so a narrow value range costs only a counting
+ * pass per skipped byte.  Partitions that become small enough to fit in
+ * cache are finished with the specialized quicksort, which is also used
+ * to order tuples with equal datum1 by the remaining keys (or the full
+ * value, if datum1 is an abbreviation).
+ */
+typedef enum
+{
+	RADIX_KEY_UNSIGNED,
+	RADIX_KEY_SIGNED,
+	RADIX_KEY_INT32,
+} RadixKeyKind;
+
+/* Below this many tuples, a partition is sorted with quicksort instead */
+#define RADIX_SORT_THRESHOLD	1024
+
+static pg_attribute_always_inline uint64
+radix_sort_key(Datum datum, RadixKeyKind kind, bool reverse)
+{
+	uint64		key;
+
+	switch (kind)
+	{
+		case RADIX_KEY_SIGNED:
+			key = (uint64) datum ^ (UINT64CONST(1) << 63);
+			break;
+		case RADIX_KEY_INT32:
+			key = (uint32) DatumGetInt32(datum) ^ ((uint32) 1 << 31);
+			break;
+		default:
+			key = (uint64) datum;
+			break;
+	}
+
+	if (reverse)
+		key = ~key;
+
+	return key;
+}
+
+/* Sort a partition with the quicksort specialization for its key kind */
+static void
+radix_sort_fallback(SortTuple *tuples, size_t n, RadixKeyKind kind,
+					Tuplesortstate *state)
+{
+	switch (kind)
+	{
+#if SIZEOF_DATUM >= 8
+		case RADIX_KEY_SIGNED:
+			qsort_tuple_signed(tuples, n, state);
+			break;
+#endif
+		case RADIX_KEY_INT32:
+			qsort_tuple_int32(tuples, n, state);
+			break;
+		default:
+			qsort_tuple_unsigned(tuples, n, state);
+			break;
+	}
+}
+
+static void radix_sort_tuple(SortTuple *tuples, size_t n, int level,
+							 int nbytes, RadixKeyKind kind, bool reverse,
+							 Tuplesortstate *state);
+
+/*
+ * Sort n non-NULL tuples on the bytes of their keys from 'level' onwards,
+ * counting from the most significant of the key's 'nbytes' bytes.
+ *
+ * This is inlined into radix_sort_tuple() with constant 'kind' and
+ * 'reverse', so that the per-tuple loops don't branch on them.
+ */
+static pg_attribute_always_inline void
+radix_sort_tuple_impl(SortTuple *tuples, size_t n, int level, int nbytes,
+					  RadixKeyKind kind, bool reverse, Tuplesortstate *state)
+{
+	size_t		counts[256];
+	size_t		offsets[256];
+	size_t		ends[256];
+	int			shift;
+	size_t		pos;
+
+	CHECK_FOR_INTERRUPTS();
+
+	if (n < RADIX_SORT_THRESHOLD)
+	{
+		radix_sort_fallback(tuples, n, kind, state);
+		return;
+	}
+
+	/* Find the next byte on which the keys differ */
+	for (;;)
+	{
+		bool		common = false;
+
+		if (level >= nbytes)
+		{
+			/* All keys are equal; only the tiebreak can tell them apart */
+			if (state->base.onlyKey == NULL)
+				radix_sort_fallback(tuples, n, kind, state);
+			return;
+		}
+
+		shift = (nbytes - 1 - level) * BITS_PER_BYTE;
+		memset(counts, 0, sizeof(counts));
+		for (size_t i = 0; i < n; i++)
+			counts[(radix_sort_key(tuples[i].datum1, kind, reverse) >> shift) & 0xFF]++;
+
+		for (int b = 0; b < 256; b++)
+		{
+			if (counts[b] == n)
+			{
+				common = true;
+				break;
+			}
+			if (counts[b] != 0)
+				break;
+		}
+		if (!common)
+			break;
+		level++;
+	}
+
+	pos = 0;
+	for (int b = 0; b < 256; b++)
+	{
+		offsets[b] = pos;
+		pos += counts[b];
+		ends[b] = pos;
+	}
+
+	/* Move every tuple into its bucket, following cycles of displacement */
+	for (int b = 0; b < 256; b++)
+	{
+		while (offsets[b] < ends[b])
+		{
+			SortTuple	tup = tuples[offsets[b]];
+			int			tb;
+
+			tb = (radix_sort_key(tup.datum1, kind, reverse) >> shift) & 0xFF;
+			while (tb != b)
+			{
+				SortTuple	displaced = tuples[offsets[tb]];
+
+				tuples[offsets[tb]++] = tup;
+				tup = displaced;
+				tb = (radix_sort_key(tup.datum1, kind, reverse) >> shift) & 0xFF;
+			}
+			tuples[offsets[b]++] = tup;
+		}
+	}
+
+	/* Now sort each bucket on the following bytes */
+	for (int b = 0; b < 256; b++)
+	{
+		if (counts[b] > 1)
+			radix_sort_tuple(tuples + ends[b] - counts[b], counts[b],
+							 level + 1, nbytes, kind, reverse, state);
+	}
+}
+
+static void
+radix_sort_tuple(SortTuple *tuples, size_t n, int level, int nbytes,
+				 RadixKeyKind kind, bool reverse, Tuplesortstate *state)
+{
+	switch (kind)
+	{
+		case RADIX_KEY_SIGNED:
+			if (reverse)
+				radix_sort_tuple_impl(tuples, n, level, nbytes,
+									  RADIX_KEY_SIGNED, true, state);
+			else
+				radix_sort_tuple_impl(tuples, n, level, nbytes,
+									  RADIX_KEY_SIGNED, false, state);
+			break;
+		case RADIX_KEY_INT32:
+			if (reverse)
+				radix_sort_tuple_impl(tuples, n, level, nbytes,
+									  RADIX_KEY_INT32, true, state);
+			else
+				radix_sort_tuple_impl(tuples, n, level, nbytes,
+									  RADIX_KEY_INT32, false, state);
+			break;
+		default:
+			if (reverse)
+				radix_sort_tuple_impl(tuples, n, level, nbytes,
+									  RADIX_KEY_UNSIGNED, true, state);
+			else
+				radix_sort_tuple_impl(tuples, n, level, nbytes,
+									  RADIX_KEY_UNSIGNED, false, state);
+			break;
+	}
+}
+
+/*
+ * Sort all memtuples by radix sort.  NULLs are moved to the front or the
+ * back first, according to the leading key's NULLS FIRST/LAST.
+ */
+static void
+radix_sort_memtuples(Tuplesortstate *state, RadixKeyKind kind)
+{
+	SortSupport sortKey = &state->base.sortKeys[0];
+	SortTuple  *tuples = state->memtuples;
+	size_t		n = state->memtupcount;
+	size_t		nnulls = 0;
+	SortTuple  *nonnulls;
+	SortTuple  *nulls;
+	int			nbytes;
+
+	if (sortKey->ssup_nulls_first)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			if (tuples[i].isnull1)
+			{
+				SortTuple	tmp = tuples[i];
+
+				tuples[i] = tuples[nnulls];
+				tuples[nnulls++] = tmp;
+			}
+		}
+		nulls = tuples;
+		nonnulls = tuples + nnulls;
+	}
+	else
+	{
+		for (size_t i = n; i > 0; i--)
+		{
+			if (tuples[i - 1].isnull1)
+			{
+				SortTuple	tmp = tuples[i - 1];
+
+				tuples[i - 1] = tuples[n - 1 - nnulls];
+				tuples[n - 1 - nnulls++] = tmp;
+			}
+		}
+		nonnulls = tuples;
+		nulls = tuples + n - nnulls;
+	}
+
+	/* NULLs compare equal on the leading key */
+	if (nnulls > 1 && state->base.onlyKey == NULL)
+		radix_sort_fallback(nulls, nnulls, kind, state);
+
+	nbytes = (kind == RADIX_KEY_INT32) ? sizeof(int32) : SIZEOF_DATUM;
+	if (n - nnulls > 1)
+		radix_sort_tuple(nonnulls, n - nnulls, 0, nbytes, kind,
+						 sortKey->ssup_reverse, state);
+}
+
 /*
  *		tuplesort_begin_xxx
  *
@@ -924,7 +1188,16 @@ tuplesort_free(Tuplesortstate *state)
 	 * finished tapes already.)
 	 */
 	if (state->tapeset)
+	{
+		int64		rawBytes;
+		int64		storedBytes;
+
+		LogicalTapeSetCompressionStats(state->tapeset, &rawBytes, &storedBytes);
+		state->tempWritten += rawBytes;
+		state->tempWrittenCompressed += storedBytes;
+
 		LogicalTapeSetClose(state->tapeset);
+	}
 
 #ifdef TRACE_SORT
 	if (trace_sort)
@@ -2554,6 +2827,20 @@ tuplesort_get_stats(Tuplesortstate *state,
 		stats->spaceType = SORT_SPACE_TYPE_MEMORY;
 	stats->spaceUsed = (state->maxSpace + 1023) / 1024;
 
+	stats->tempWritten = state->tempWritten;
+	stats->tempWrittenCompressed = state->tempWrittenCompressed;
+	if (state->tapeset)
+	{
+		int64		rawBytes;
+		int64		storedBytes;
+
+		LogicalTapeSetCompressionStats(state->tapeset, &rawBytes, &storedBytes);
+		stats->tempWritten += rawBytes;
+		stats->tempWrittenCompressed += storedBytes;
+	}
+	stats->tempWritten = (stats->tempWritten + 1023) / 1024;
+	stats->tempWrittenCompressed = (stats->tempWrittenCompressed + 1023) / 1024;
+
 	switch (state->maxSpaceStatus)
 	{
 		case TSS_SORTEDINMEM:
@@ -2706,9 +2993,9 @@ sort_bounded_heap(Tuplesortstate *state)
 }
 
 /*
- * Sort all memtuples using specialized qsort() routines.
+ * Sort all memtuples using radix sort or specialized qsort() routines.
  *
- * Quicksort is used for small in-memory sorts, and external sort runs.
+ * This is used for in-memory sorts, and external sort runs.
  */
 static void
 tuplesort_sort_memtuples(Tuplesortstate *state)
@@ -2723,6 +3010,31 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 		 */
 		if (state->base.haveDatum1 && state->base.sortKeys)
 		{
+			/*
+			 * Large inputs are sorted faster by radix sort on datum1, with
+			 * quicksort taking over for small partitions.
+			 */
+			if (state->memtupcount >= RADIX_SORT_THRESHOLD)
+			{
+				if (state->base.sortKeys[0].comparator == ssup_datum_unsigned_cmp)
+				{
+					radix_sort_memtuples(state, RADIX_KEY_UNSIGNED);
+					return;
+				}
+#if SIZEOF_DATUM >= 8
+				else if (state->base.sortKeys[0].comparator == ssup_datum_signed_cmp)
+				{
+					radix_sort_memtuples(state, RADIX_KEY_SIGNED);
+					return;
+				}
+#endif
+				else if (state->base.sortKeys[0].comparator == ssup_datum_int32_cmp)
+				{
+					radix_sort_memtuples(state, RADIX_KEY_INT32);
+					return;
+				}
+			}
+
 			if (state->base.sortKeys[0].comparator == ssup_datum_unsigned_cmp)
 			{
 				qsort_tuple_unsigned(state->memtuples,
@@ -2990,6 +3302,27 @@ tuplesort_initialize_shared(Sharedsort *shared, int nWorkers, dsm_segment *seg)
 	}
 }
 
+/*
+ * tuplesort_reset_shared - reset shared tuplesort state for another sort
+ *
+ * Removes the files of the previous sort, so that the shared state can be
+ * used by a new set of worker tuplesortstates.  Must only be called from
+ * leader process, while no participant is using the shared state.
+ */
+void
+tuplesort_reset_shared(Sharedsort *shared)
+{
+	int			i;
+
+	SharedFileSetDeleteAll(&shared->fileset);
+	shared->currentWorker = 0;
+	shared->workersFinished = 0;
+	for (i = 0; i < shared->nTapes; i++)
+	{
+		shared->tapes[i].firstblocknumber = 0L;
+	}
+}
+
 /*
  * tuplesort_attach_shared - attach to shared tuplesort state
  *
@@ -0,0 +1,61 @@
+/*--------------------------------------------------------------------------
+ * gin_tuple.h
+ *	  Declarations for the tuples passed between the participants of a
+ *	  parallel GIN index build.
+ *
+ *	Copyright (c) 2006-2024, PostgreSQL Global Development Group
+ *
+ *	src/include/access/gin_tuple.h
+ *--------------------------------------------------------------------------
+ */
+#ifndef GIN_TUPLE_H
+#define GIN_TUPLE_H
+
+#include "access/gin_private.h"
+#include "storage/itemptr.h"
+
+/*
+ * A GinTuple holds one index key together with a sorted list of heap TIDs
+ * for it, as accumulated by one participant of a parallel build.  The key
+ * data follows the fixed-size header, and the TIDs start at the next
+ * MAXALIGN'd offset.  Pass-by-value keys are stored as a whole Datum.
+ */
+typedef struct GinTuple
+{
+	int			tuplen;			/* length of the whole tuple */
+	OffsetNumber attrnum;		/* attnum of index key */
+	int16		typlen;			/* typlen of the key */
+	bool		typbyval;		/* typbyval of the key */
+	signed char category;		/* category: normal or NULL? */
+	int			keylen;			/* bytes in data for key value */
+	int			nitems;			/* number of TIDs in the data */
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} GinTuple;
+
+static inline Datum
+_gin_parse_tuple_key(GinTuple *a)
+{
+	Datum		key;
+
+	if (a->category != GIN_CAT_NORM_KEY)
+		return (Datum) 0;
+
+	if (a->typbyval)
+	{
+		memcpy(&key, a->data, a->keylen);
+		return key;
+	}
+
+	return PointerGetDatum(a->data);
+}
+
+static inline ItemPointer
+_gin_parse_tuple_items(GinTuple *a)
+{
+	return (ItemPointer) ((char *) a +
+						  MAXALIGN(offsetof(GinTuple, data) + a->keylen));
+}
+
+extern int	_gin_compare_tuples(GinTuple *a, GinTuple *b, GinState *ginstate);
+
+#endif							/* GIN_TUPLE_H */
@@ -1123,10 +1123,27 @@ typedef struct BTReadPageState
  */
 #define SK_BT_REQFWD	0x00010000	/* required to continue forward scan */
 #define SK_BT_REQBKWD	0x00020000	/* required to continue backward scan */
+#define SK_BT_FASTCMP_SHIFT	18	/* see below */
+#define SK_BT_FASTCMP_MASK	(0x07 << SK_BT_FASTCMP_SHIFT)
 #define SK_BT_INDOPTION_SHIFT  24	/* must clear the above bits */
 #define SK_BT_DESC			(INDOPTION_DESC << SK_BT_INDOPTION_SHIFT)
 #define SK_BT_NULLS_FIRST	(INDOPTION_NULLS_FIRST << SK_BT_INDOPTION_SHIFT)
 
+/*
+ * Insertion scan keys whose 3-way comparison support function is known to
+ * be a plain comparison of fixed-width values record its kind in the
+ * SK_BT_FASTCMP_MASK bits of sk_flags.  _bt_compare() then compares such
+ * attributes inline, rather than through the fmgr interface.  Scan keys
+ * without these bits (cross-type comparisons, row comparison members, and
+ * every other opclass) are always compared by calling sk_func.
+ */
+#define BT_FASTCMP_NONE		0
+#define BT_FASTCMP_INT16	1	/* int2 */
+#define BT_FASTCMP_INT32	2	/* int4, date */
+#define BT_FASTCMP_INT64	3	/* int8, time, timestamp, timestamptz */
+#define BT_FASTCMP_UINT32	4	/* oid */
+#define BT_FASTCMP_UUID		5	/* uuid */
+
 typedef struct BTOptions
 {
 	int32		varlena_header_;	/* varlena header (do not touch directly!) */
@@ -1285,6 +1302,7 @@ extern Buffer _bt_get_endpoint(Relation rel, uint32 level, bool rightmost);
  * prototypes for functions in nbtutils.c
  */
 extern BTScanInsert _bt_mkscankey(Relation rel, IndexTuple itup);
+extern int	_bt_fastcmp_flags(Oid cmpproc);
 extern void _bt_freestack(BTStack stack);
 extern bool _bt_start_prim_scan(IndexScanDesc scan, ScanDirection dir);
 extern void _bt_start_array_keys(IndexScanDesc scan, ScanDirection dir);
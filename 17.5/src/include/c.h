@@ -311,6 +311,18 @@
 #define unlikely(x) ((x) != 0)
 #endif
 
+/*
+ * Hint to the CPU that the memory at the given address will be read soon, so
+ * that a cache miss can overlap with other work.  This is only useful when
+ * the address is known well ahead of the access, e.g. when processing a batch
+ * of independent lookups into a large hash table.
+ */
+#if __GNUC__ >= 3
+#define pg_prefetch_mem(addr)	__builtin_prefetch(addr)
+#else
+#define pg_prefetch_mem(addr)	((void) (addr))
+#endif
+
 /*
  * CppAsString
  *		Convert the argument to a string, using the C preprocessor.
@@ -16,6 +16,7 @@
 
 #include "catalog/objectaddress.h"
 #include "nodes/execnodes.h"
+#include "storage/shm_toc.h"
 
 
 #define DEFAULT_INDEX_TYPE	"btree"
@@ -47,12 +48,27 @@ typedef struct ReindexParams
 typedef struct ValidateIndexState
 {
 	Tuplesortstate *tuplesort;	/* for sorting the index TIDs */
+
+	/*
+	 * During a parallel validate_index(), each participant reads the already
+	 * sorted TIDs from tidfile instead of from tuplesort, and only the heap
+	 * blocks in [startblock, startblock + numblocks) are scanned.  numblocks
+	 * is InvalidBlockNumber when the whole table is to be scanned.
+	 */
+	struct BufFile *tidfile;
+	BlockNumber startblock;
+	BlockNumber numblocks;
+
 	/* statistics (for debug purposes only): */
 	double		htups,
 				itups,
 				tups_inserted;
 } ValidateIndexState;
 
+/* GUC parameters */
+extern PGDLLIMPORT double concurrent_index_cost_delay;
+extern PGDLLIMPORT int concurrent_index_cost_limit;
+
 extern void index_check_primary_key(Relation heapRel,
 									const IndexInfo *indexInfo,
 									bool is_alter_table,
@@ -145,6 +161,11 @@ extern void index_build(Relation heapRelation,
 						bool parallel);
 
 extern void validate_index(Oid heapId, Oid indexId, Snapshot snapshot);
+extern bool validate_index_next_tid(ValidateIndexState *state,
+									ItemPointer tid);
+extern void validate_index_parallel_main(dsm_segment *seg, shm_toc *toc);
+extern void index_concurrent_cost_delay_begin(void);
+extern void index_concurrent_cost_delay_end(void);
 
 extern void index_set_state_flags(Oid indexId, IndexStateFlagsAction action);
 
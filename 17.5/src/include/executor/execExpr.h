@@ -113,6 +113,17 @@ typedef enum ExprEvalOp
 	EEOP_FUNCEXPR_FUSAGE,
 	EEOP_FUNCEXPR_STRICT_FUSAGE,
 
+	/*
+	 * Compute a combined 32-bit hash over a list of datums, as used by
+	 * execGrouping.c.  SET_INITVAL starts the hash from a seed value, FIRST
+	 * hashes the first datum (when there is no seed), and NEXT32 rotates the
+	 * hash computed so far left by one bit and XORs the next datum's hash
+	 * into it.  NULL datums contribute a hash of zero.
+	 */
+	EEOP_HASHDATUM_SET_INITVAL,
+	EEOP_HASHDATUM_FIRST,
+	EEOP_HASHDATUM_NEXT32,
+
 	/*
 	 * Evaluate boolean AND expression, one step per subexpression. FIRST/LAST
 	 * subexpressions are special-cased for performance.  Since AND always has
@@ -359,6 +370,21 @@ typedef struct ExprEvalStep
 			bool		make_ro;	/* make arg0 R/O (used only for NULLIF) */
 		}			func;
 
+		/* for EEOP_HASHDATUM_FIRST / EEOP_HASHDATUM_NEXT32 */
+		struct
+		{
+			FmgrInfo   *finfo;	/* hash function's lookup data */
+			FunctionCallInfo fcinfo_data;	/* datum to hash is arg 0 */
+			/* faster to access without additional indirection: */
+			PGFunction	fn_addr;	/* actual call address */
+		}			hashdatum;
+
+		/* for EEOP_HASHDATUM_SET_INITVAL */
+		struct
+		{
+			Datum		init_value;
+		}			hashdatum_initvalue;
+
 		/* for EEOP_BOOL_*_STEP */
 		struct
 		{
@@ -785,6 +811,7 @@ extern void ExprEvalPushStep(ExprState *es, const ExprEvalStep *s);
 
 /* functions in execExprInterp.c */
 extern void ExecReadyInterpretedExpr(ExprState *state);
+extern void ExecReadyDeferredJitExpr(ExprState *state);
 extern ExprEvalOp ExecEvalStepOp(ExprState *state, ExprEvalStep *op);
 
 extern Datum ExecInterpExprStillValid(ExprState *state, ExprContext *econtext, bool *isNull);
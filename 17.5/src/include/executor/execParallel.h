@@ -29,6 +29,8 @@ typedef struct ParallelExecutorInfo
 	WalUsage   *wal_usage;		/* walusage area in DSM */
 	SharedExecutorInstrumentation *instrumentation; /* optional */
 	struct SharedJitInstrumentation *jit_instrumentation;	/* optional */
+	TupleQueueInstrumentation *tqueue_instrumentation;	/* optional */
+	TupleQueueInstrumentation tqueue_totals;	/* sums over finished workers */
 	dsa_area   *area;			/* points to DSA area in DSM */
 	dsa_pointer param_exec;		/* serialized PARAM_EXEC parameters */
 	bool		finished;		/* set true by ExecParallelFinish */
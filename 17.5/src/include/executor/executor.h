@@ -292,6 +292,14 @@ extern ExprState *ExecBuildGroupingEqual(TupleDesc ldesc, TupleDesc rdesc,
 										 const Oid *eqfunctions,
 										 const Oid *collations,
 										 PlanState *parent);
+extern ExprState *ExecBuildHash32FromAttrs(TupleDesc desc,
+										   const TupleTableSlotOps *ops,
+										   FmgrInfo *hashfunctions,
+										   Oid *collations,
+										   int numCols,
+										   AttrNumber *keyColIdx,
+										   PlanState *parent,
+										   uint32 init_value);
 extern ExprState *ExecBuildParamSetEqual(TupleDesc desc,
 										 const TupleTableSlotOps *lops,
 										 const TupleTableSlotOps *rops,
@@ -633,6 +641,11 @@ extern List *ExecInsertIndexTuples(ResultRelInfo *resultRelInfo,
 								   bool noDupErr,
 								   bool *specConflict, List *arbiterIndexes,
 								   bool onlySummarizing);
+extern bool ExecInsertIndexTuplesBatch(ResultRelInfo *resultRelInfo,
+									   TupleTableSlot **slots, int nslots,
+									   EState *estate,
+									   const uint64 *rownos,
+									   uint64 *currowno);
 extern bool ExecCheckIndexConstraints(ResultRelInfo *resultRelInfo,
 									  TupleTableSlot *slot,
 									  EState *estate, ItemPointer conflictTid,
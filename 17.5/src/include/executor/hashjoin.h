@@ -91,6 +91,29 @@ typedef struct HashJoinTupleData
 #define HJTUPLE_MINTUPLE(hjtup)  \
 	((MinimalTuple) ((char *) (hjtup) + HJTUPLE_OVERHEAD))
 
+/*
+ * Each bucket of a private (non-parallel) hash table also has a one-byte tag
+ * in a separate array, which acts as a tiny Bloom filter over the hash values
+ * of the tuples in the bucket: for each tuple, the bit selected by three bits
+ * of its hash value is set.  A probe whose bit is not set can skip the bucket
+ * without touching the bucket array or any tuple in it.  The tag array is 1/8
+ * the size of the bucket array, so it's much more likely to stay in cache
+ * when the hash table is large.
+ *
+ * All the tuples in a bucket of the current batch have the same bucket and
+ * batch bits, so the tag is taken from the three bits above those, at
+ * bucketTagShift (see ExecHashGetBucketAndBatch).  If there are fewer than
+ * three bits left, the tag overlaps the batch bits; it's then less selective,
+ * but still correct.  The tags are rebuilt whenever nbuckets or nbatch
+ * changes.
+ */
+#define HJ_BUCKET_TAG_MAX_SHIFT		(32 - 3)
+#define HJ_BUCKET_TAG(hashtable, hashvalue) \
+	((uint8) (1 << (((hashvalue) >> (hashtable)->bucketTagShift) & 7)))
+
+/* Space used by each bucket of a private hash table, including its tag */
+#define HJ_PRIVATE_BUCKET_SIZE	(sizeof(HashJoinTuple) + sizeof(uint8))
+
 /*
  * If the outer relation's distribution is sufficiently nonuniform, we attempt
  * to optimize the join by treating the hash values corresponding to the outer
@@ -313,6 +336,10 @@ typedef struct HashJoinTableData
 		dsa_pointer_atomic *shared;
 	}			buckets;
 
+	/* bucketTags[i] is the tag of the i'th bucket; see HJ_BUCKET_TAG */
+	uint8	   *bucketTags;		/* only used for unshared hash tables */
+	int			bucketTagShift; /* position of the tag bits in hash values */
+
 	bool		keepNulls;		/* true to store unmatchable NULL tuples */
 
 	bool		skewEnabled;	/* are we using skew optimization? */
@@ -337,11 +364,34 @@ typedef struct HashJoinTableData
 	 * These arrays are allocated for the life of the hash join, but only if
 	 * nbatch > 1.  A file is opened only when we first write a tuple into it
 	 * (otherwise its pointer remains NULL).  Note that the zero'th array
-	 * elements never get used, since we will process rather than dump out any
+	 * elements are used only if batch zero has to be processed in chunks
+	 * (see below), since otherwise we process rather than dump out any
 	 * tuples of batch zero.
 	 */
 	BufFile   **innerBatchFile; /* buffered virtual temp file per batch */
 	BufFile   **outerBatchFile; /* buffered virtual temp file per batch */
+	int64		tempWritten;	/* bytes written to the closed batch files, */
+	int64		tempWrittenCompressed;	/* ... before and after compression */
+
+	/*
+	 * Once nbatch increases have been disabled, a batch whose inner tuples
+	 * still don't fit in spaceAllowed is joined in chunks: we load as many
+	 * inner tuples as fit, join the whole outer batch against them, and
+	 * repeat with the next chunk of the inner batch file, rescanning the
+	 * outer batch file each time.  Outer tuples of a chunked batch are
+	 * numbered in the order they are read from the batch, and outerMatched
+	 * remembers which of them found a match in any chunk, so that semi, anti
+	 * and outer joins can be handled correctly across chunks.
+	 */
+	bool		chunked;		/* is the current batch processed in chunks? */
+	bool		morechunks;		/* are there inner chunks left to load? */
+	int			curchunk;		/* current chunk #; 0 for the first chunk */
+	off_t		chunkOffset;	/* start of next chunk in inner batch file */
+	int			chunkFileno;	/* ... (file number part of the position) */
+	uint8	   *outerMatched;	/* bitmap of matched outer tuples */
+	Size		outerMatchedLen;	/* allocated size of outerMatched, bytes */
+	uint64		nextOuterTupleNo;	/* # outer tuples read in current chunk */
+	int			nbatch_chunked; /* # batches that were processed in chunks */
 
 	/*
 	 * Info about the datatype-specific hash functions for the datatypes being
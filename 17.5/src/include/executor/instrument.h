@@ -98,6 +98,20 @@ typedef struct WorkerInstrumentation
 	Instrumentation instrument[FLEXIBLE_ARRAY_MEMBER];
 } WorkerInstrumentation;
 
+/*
+ * Statistics about a tuple queue.  The sender counts the messages and tuples
+ * it sent and the times it had to wait because the queue was full; Gather
+ * and Gather Merge count the times they had to wait because all queues were
+ * empty.
+ */
+typedef struct TupleQueueInstrumentation
+{
+	int64		ntuples;		/* number of tuples sent */
+	int64		nmessages;		/* number of shm_mq messages sent */
+	int64		nwaits;			/* number of times we had to wait */
+	instr_time	wait_time;		/* total time spent waiting */
+} TupleQueueInstrumentation;
+
 extern PGDLLIMPORT BufferUsage pgBufferUsage;
 extern PGDLLIMPORT WalUsage pgWalUsage;
 
@@ -116,5 +130,7 @@ extern void BufferUsageAccumDiff(BufferUsage *dst,
 								 const BufferUsage *add, const BufferUsage *sub);
 extern void WalUsageAccumDiff(WalUsage *dst, const WalUsage *add,
 							  const WalUsage *sub);
+extern void TupleQueueInstrAdd(TupleQueueInstrumentation *dst,
+							   const TupleQueueInstrumentation *add);
 
 #endif							/* INSTRUMENT_H */
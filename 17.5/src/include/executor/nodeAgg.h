@@ -331,6 +331,12 @@ extern Size hash_agg_entry_size(int numTrans, Size tupleWidth,
 extern void hash_agg_set_limits(double hashentrysize, double input_groups,
 								int used_bits, Size *mem_limit,
 								uint64 *ngroups_limit, int *num_partitions);
+extern long hash_choose_num_buckets(double hashentrysize, long ngroups,
+									Size memory);
+extern int	hash_choose_num_partitions(double input_groups,
+									   double hashentrysize,
+									   int used_bits,
+									   int *log2_npartitions);
 
 /* parallel instrumentation support */
 extern void ExecAggEstimate(AggState *node, ParallelContext *pcxt);
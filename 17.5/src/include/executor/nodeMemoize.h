@@ -17,6 +17,9 @@
 #include "access/parallel.h"
 #include "nodes/execnodes.h"
 
+/* GUC parameter */
+extern PGDLLIMPORT bool enable_shared_memoize;
+
 extern MemoizeState *ExecInitMemoize(Memoize *node, EState *estate, int eflags);
 extern void ExecEndMemoize(MemoizeState *node);
 extern void ExecReScanMemoize(MemoizeState *node);
@@ -25,8 +28,11 @@ extern void ExecMemoizeEstimate(MemoizeState *node,
 								ParallelContext *pcxt);
 extern void ExecMemoizeInitializeDSM(MemoizeState *node,
 									 ParallelContext *pcxt);
+extern void ExecMemoizeReInitializeDSM(MemoizeState *node,
+									   ParallelContext *pcxt);
 extern void ExecMemoizeInitializeWorker(MemoizeState *node,
 										ParallelWorkerContext *pwcxt);
+extern void ExecShutdownMemoize(MemoizeState *node);
 extern void ExecMemoizeRetrieveInstrumentation(MemoizeState *node);
 
 #endif							/* NODEMEMOIZE_H */
@@ -14,6 +14,7 @@
 #ifndef TQUEUE_H
 #define TQUEUE_H
 
+#include "executor/instrument.h"
 #include "storage/shm_mq.h"
 #include "tcop/dest.h"
 
@@ -21,7 +22,8 @@
 typedef struct TupleQueueReader TupleQueueReader;
 
 /* Use this to send tuples to a shm_mq. */
-extern DestReceiver *CreateTupleQueueDestReceiver(shm_mq_handle *handle);
+extern DestReceiver *CreateTupleQueueDestReceiver(shm_mq_handle *handle,
+												  TupleQueueInstrumentation *instr);
 
 /* Use these to receive tuples from a shm_mq. */
 extern TupleQueueReader *CreateTupleQueueReader(shm_mq_handle *handle);
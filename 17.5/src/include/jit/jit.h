@@ -29,6 +29,9 @@ typedef struct JitInstrumentation
 	/* number of emitted functions */
 	size_t		created_functions;
 
+	/* number of deform functions reused from earlier queries */
+	size_t		cached_deform_functions;
+
 	/* accumulated time to generate code */
 	instr_time	generation_counter;
 
@@ -87,6 +90,8 @@ extern PGDLLIMPORT bool jit_dump_bitcode;
 extern PGDLLIMPORT bool jit_expressions;
 extern PGDLLIMPORT bool jit_profiling_support;
 extern PGDLLIMPORT bool jit_tuple_deforming;
+extern PGDLLIMPORT int jit_deform_cache_size;
+extern PGDLLIMPORT int jit_defer_evaluations;
 extern PGDLLIMPORT double jit_above_cost;
 extern PGDLLIMPORT double jit_inline_above_cost;
 extern PGDLLIMPORT double jit_optimize_above_cost;
@@ -100,6 +105,7 @@ extern void jit_release_context(JitContext *context);
  * not be able to perform JIT (i.e. return false).
  */
 extern bool jit_compile_expr(struct ExprState *state);
+extern bool jit_defer_compile_expr(struct ExprState *state);
 extern void InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add);
 
 
@@ -106,6 +106,8 @@ extern void llvm_reset_after_error(void);
 extern void llvm_assert_in_fatal_section(void);
 
 extern LLVMJitContext *llvm_create_context(int jitFlags);
+extern LLVMJitContext *llvm_create_persistent_context(int jitFlags);
+extern void llvm_reset_persistent_context(LLVMJitContext *context);
 extern LLVMModuleRef llvm_mutable_module(LLVMJitContext *context);
 extern char *llvm_expand_funcname(LLVMJitContext *context, const char *basename);
 extern void *llvm_get_function(LLVMJitContext *context, const char *funcname);
@@ -131,6 +133,11 @@ extern bool llvm_compile_expr(struct ExprState *state);
 struct TupleTableSlotOps;
 extern LLVMValueRef slot_compile_deform(struct LLVMJitContext *context, TupleDesc desc,
 										const struct TupleTableSlotOps *ops, int natts);
+extern void *llvm_deform_cache_lookup(struct LLVMJitContext *context,
+									  TupleDesc desc,
+									  const struct TupleTableSlotOps *ops,
+									  int natts);
+extern void llvm_deform_cache_maintain(void);
 
 /*
  ****************************************************************************
@@ -50,6 +50,9 @@
  *	  - SH_HASH_KEY(table, key) - generate hash for the key
  *	  - SH_STORE_HASH - if defined the hash is stored in the elements
  *	  - SH_GET_HASH(tb, a) - return the field to store the hash in
+ *	  - SH_USE_TAGS - if defined, keep a one-byte tag per bucket and use SIMD
+ *		to search them (see below).  Must be defined for both SH_DECLARE and
+ *		SH_DEFINE, as it changes the hash table type.
  *
  *	  The element type is required to contain a "status" member that can store
  *	  the range of values defined in the SH_STATUS enum.
@@ -87,6 +90,19 @@
  *	  looking or is done - buckets following a deleted element are shifted
  *	  backwards, unless they're empty or already at their optimal position.
  *
+ *	  With SH_USE_TAGS, a separate array holds one byte per bucket: zero if
+ *	  the bucket is empty, or else seven bits of the element's hash with the
+ *	  high bit set.  Lookups compare a whole vector of consecutive tags to the
+ *	  wanted one at a time (in the manner of "SwissTable"), and only look at
+ *	  elements whose tag matches, which avoids touching most of the colliding
+ *	  elements and calling SH_EQUAL on them.  Insertions, which have to walk
+ *	  the buckets one by one to find the robin hood insert position anyway,
+ *	  only check the tag of each bucket before comparing keys.  The tags are
+ *	  maintained alongside the elements when those are moved, so the robin
+ *	  hood placement is unchanged.  This costs one byte per bucket,
+ *	  and is worthwhile mostly if SH_EQUAL is expensive or the elements are
+ *	  large.
+ *
  * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -95,6 +111,56 @@
 
 #include "port/pg_bitutils.h"
 
+/*
+ * Helpers for SH_USE_TAGS.  These have their own include guard, since they
+ * aren't needed unless some hash table uses tags.
+ */
+#if defined(SH_USE_TAGS) && !defined(SIMPLEHASH_TAGS_H)
+#define SIMPLEHASH_TAGS_H
+
+#include "port/simd.h"
+
+/* number of tags compared at once */
+#define SH_TAG_GROUP_SIZE ((uint32) sizeof(Vector8))
+
+/* tag of an element with the given hash; never zero, which means empty */
+static inline uint8
+sh_hash_tag(uint32 hash)
+{
+	return (uint8) (0x80 | (hash >> 25));
+}
+
+/*
+ * Compare SH_TAG_GROUP_SIZE tags, starting at 'tags', to 'tag'.  Returns a
+ * bitmask of the positions that hold it, and sets *empty to a bitmask of the
+ * positions of empty buckets.
+ */
+static inline uint32
+sh_match_tags(const uint8 *tags, uint8 tag, uint32 *empty)
+{
+#ifndef USE_NO_SIMD
+	Vector8		chunk;
+
+	vector8_load(&chunk, tags);
+	*empty = vector8_highbit_mask(vector8_eq(chunk, vector8_broadcast(0)));
+	return vector8_highbit_mask(vector8_eq(chunk, vector8_broadcast(tag)));
+#else
+	uint32		match = 0;
+
+	*empty = 0;
+	for (uint32 i = 0; i < SH_TAG_GROUP_SIZE; i++)
+	{
+		if (tags[i] == tag)
+			match |= UINT32_C(1) << i;
+		else if (tags[i] == 0)
+			*empty |= UINT32_C(1) << i;
+	}
+	return match;
+#endif
+}
+
+#endif							/* SH_USE_TAGS && !SIMPLEHASH_TAGS_H */
+
 /* helpers */
 #define SH_MAKE_PREFIX(a) CppConcat(a,_)
 #define SH_MAKE_NAME(name) SH_MAKE_NAME_(SH_MAKE_PREFIX(SH_PREFIX),name)
@@ -137,6 +203,7 @@
 #define SH_ENTRY_HASH SH_MAKE_NAME(entry_hash)
 #define SH_INSERT_HASH_INTERNAL SH_MAKE_NAME(insert_hash_internal)
 #define SH_LOOKUP_HASH_INTERNAL SH_MAKE_NAME(lookup_hash_internal)
+#define SH_SET_TAG SH_MAKE_NAME(set_tag)
 
 /* generate forward declarations necessary to use the hash table */
 #ifdef SH_DECLARE
@@ -163,6 +230,11 @@ typedef struct SH_TYPE
 	/* hash buckets */
 	SH_ELEMENT_TYPE *data;
 
+#ifdef SH_USE_TAGS
+	/* tags of the buckets, followed by copies of the first few of them */
+	uint8	   *tags;
+#endif
+
 #ifndef SH_RAW_ALLOCATOR
 	/* memory context to use for allocations */
 	MemoryContext ctx;
@@ -315,6 +387,11 @@ SH_COMPUTE_SIZE(uint64 newsize)
 	/* supporting zero sized hashes would complicate matters */
 	size = Max(newsize, 2);
 
+#ifdef SH_USE_TAGS
+	/* a group of tags must not cover any bucket twice */
+	size = Max(size, SH_TAG_GROUP_SIZE);
+#endif
+
 	/* round up size to the next power of 2, that's how bucketing works */
 	size = pg_nextpower2_64(size);
 	Assert(size <= SH_MAX_SIZE);
@@ -401,6 +478,21 @@ SH_ENTRY_HASH(SH_TYPE * tb, SH_ELEMENT_TYPE * entry)
 #endif
 }
 
+#ifdef SH_USE_TAGS
+/*
+ * Set the tag of a bucket, zero meaning empty.  The tags of the first
+ * SH_TAG_GROUP_SIZE - 1 buckets are repeated after the last one, so that a
+ * group of tags can be loaded starting at any bucket.
+ */
+static inline void
+SH_SET_TAG(SH_TYPE * tb, uint32 elem, uint8 tag)
+{
+	tb->tags[elem] = tag;
+	if (elem < SH_TAG_GROUP_SIZE - 1)
+		tb->tags[tb->size + elem] = tag;
+}
+#endif
+
 /* default memory allocator function */
 static inline void *SH_ALLOCATE(SH_TYPE * type, Size size);
 static inline void SH_FREE(SH_TYPE * type, void *pointer);
@@ -462,6 +554,9 @@ SH_CREATE(MemoryContext ctx, uint32 nelements, void *private_data)
 	size = SH_COMPUTE_SIZE(size);
 
 	tb->data = (SH_ELEMENT_TYPE *) SH_ALLOCATE(tb, sizeof(SH_ELEMENT_TYPE) * size);
+#ifdef SH_USE_TAGS
+	tb->tags = (uint8 *) SH_ALLOCATE(tb, size + SH_TAG_GROUP_SIZE - 1);
+#endif
 
 	SH_UPDATE_PARAMETERS(tb, size);
 	return tb;
@@ -472,6 +567,9 @@ SH_SCOPE void
 SH_DESTROY(SH_TYPE * tb)
 {
 	SH_FREE(tb, tb->data);
+#ifdef SH_USE_TAGS
+	SH_FREE(tb, tb->tags);
+#endif
 	pfree(tb);
 }
 
@@ -480,6 +578,9 @@ SH_SCOPE void
 SH_RESET(SH_TYPE * tb)
 {
 	memset(tb->data, 0, sizeof(SH_ELEMENT_TYPE) * tb->size);
+#ifdef SH_USE_TAGS
+	memset(tb->tags, 0, tb->size + SH_TAG_GROUP_SIZE - 1);
+#endif
 	tb->members = 0;
 }
 
@@ -496,6 +597,9 @@ SH_GROW(SH_TYPE * tb, uint64 newsize)
 	uint64		oldsize = tb->size;
 	SH_ELEMENT_TYPE *olddata = tb->data;
 	SH_ELEMENT_TYPE *newdata;
+#ifdef SH_USE_TAGS
+	uint8	   *oldtags = tb->tags;
+#endif
 	uint32		i;
 	uint32		startelem = 0;
 	uint32		copyelem;
@@ -507,6 +611,9 @@ SH_GROW(SH_TYPE * tb, uint64 newsize)
 	newsize = SH_COMPUTE_SIZE(newsize);
 
 	tb->data = (SH_ELEMENT_TYPE *) SH_ALLOCATE(tb, sizeof(SH_ELEMENT_TYPE) * newsize);
+#ifdef SH_USE_TAGS
+	tb->tags = (uint8 *) SH_ALLOCATE(tb, newsize + SH_TAG_GROUP_SIZE - 1);
+#endif
 
 	/*
 	 * Update parameters for new table after allocation succeeds to avoid
@@ -588,6 +695,9 @@ SH_GROW(SH_TYPE * tb, uint64 newsize)
 
 			/* copy entry to new slot */
 			memcpy(newentry, oldentry, sizeof(SH_ELEMENT_TYPE));
+#ifdef SH_USE_TAGS
+			SH_SET_TAG(tb, curelem, sh_hash_tag(hash));
+#endif
 		}
 
 		/* can't use SH_NEXT here, would use new size */
@@ -599,6 +709,9 @@ SH_GROW(SH_TYPE * tb, uint64 newsize)
 	}
 
 	SH_FREE(tb, olddata);
+#ifdef SH_USE_TAGS
+	SH_FREE(tb, oldtags);
+#endif
 }
 
 /*
@@ -612,6 +725,9 @@ SH_INSERT_HASH_INTERNAL(SH_TYPE * tb, SH_KEY_TYPE key, uint32 hash, bool *found)
 	uint32		curelem;
 	SH_ELEMENT_TYPE *data;
 	uint32		insertdist;
+#ifdef SH_USE_TAGS
+	const uint8 tag = sh_hash_tag(hash);
+#endif
 
 restart:
 	insertdist = 0;
@@ -657,6 +773,9 @@ restart:
 			SH_GET_HASH(tb, entry) = hash;
 #endif
 			entry->status = SH_STATUS_IN_USE;
+#ifdef SH_USE_TAGS
+			SH_SET_TAG(tb, curelem, tag);
+#endif
 			*found = false;
 			return entry;
 		}
@@ -669,7 +788,12 @@ restart:
 		 * shift the colliding entry (and its followers) forward by one.
 		 */
 
+#ifdef SH_USE_TAGS
+		if (tb->tags[curelem] == tag &&
+			SH_COMPARE_KEYS(tb, hash, key, entry))
+#else
 		if (SH_COMPARE_KEYS(tb, hash, key, entry))
+#endif
 		{
 			Assert(entry->status == SH_STATUS_IN_USE);
 			*found = true;
@@ -734,6 +858,9 @@ restart:
 				moveentry = &data[moveelem];
 
 				memcpy(lastentry, moveentry, sizeof(SH_ELEMENT_TYPE));
+#ifdef SH_USE_TAGS
+				SH_SET_TAG(tb, lastentry - data, tb->tags[moveelem]);
+#endif
 				lastentry = moveentry;
 			}
 
@@ -745,6 +872,9 @@ restart:
 			SH_GET_HASH(tb, entry) = hash;
 #endif
 			entry->status = SH_STATUS_IN_USE;
+#ifdef SH_USE_TAGS
+			SH_SET_TAG(tb, curelem, tag);
+#endif
 			*found = false;
 			return entry;
 		}
@@ -802,6 +932,41 @@ SH_LOOKUP_HASH_INTERNAL(SH_TYPE * tb, SH_KEY_TYPE key, uint32 hash)
 	const uint32 startelem = SH_INITIAL_BUCKET(tb, hash);
 	uint32		curelem = startelem;
 
+#ifdef SH_USE_TAGS
+	const uint8 tag = sh_hash_tag(hash);
+
+	while (true)
+	{
+		uint32		empty;
+		uint32		match;
+
+		match = sh_match_tags(&tb->tags[curelem], tag, &empty);
+
+		/* buckets after the first empty one don't belong to this chain */
+		if (empty != 0)
+			match &= (empty & (~empty + 1)) - 1;
+
+		while (match != 0)
+		{
+			uint32		elem;
+			SH_ELEMENT_TYPE *entry;
+
+			elem = (curelem + pg_rightmost_one_pos32(match)) & tb->sizemask;
+			entry = &tb->data[elem];
+			Assert(entry->status == SH_STATUS_IN_USE);
+
+			if (SH_COMPARE_KEYS(tb, hash, key, entry))
+				return entry;
+
+			match &= match - 1;
+		}
+
+		if (empty != 0)
+			return NULL;
+
+		curelem = (curelem + SH_TAG_GROUP_SIZE) & tb->sizemask;
+	}
+#else
 	while (true)
 	{
 		SH_ELEMENT_TYPE *entry = &tb->data[curelem];
@@ -825,6 +990,7 @@ SH_LOOKUP_HASH_INTERNAL(SH_TYPE * tb, SH_KEY_TYPE key, uint32 hash)
 
 		curelem = SH_NEXT(tb, curelem, startelem);
 	}
+#endif
 }
 
 /*
@@ -893,6 +1059,9 @@ SH_DELETE(SH_TYPE * tb, SH_KEY_TYPE key)
 				if (curentry->status != SH_STATUS_IN_USE)
 				{
 					lastentry->status = SH_STATUS_EMPTY;
+#ifdef SH_USE_TAGS
+					SH_SET_TAG(tb, lastentry - tb->data, 0);
+#endif
 					break;
 				}
 
@@ -903,11 +1072,17 @@ SH_DELETE(SH_TYPE * tb, SH_KEY_TYPE key)
 				if (curoptimal == curelem)
 				{
 					lastentry->status = SH_STATUS_EMPTY;
+#ifdef SH_USE_TAGS
+					SH_SET_TAG(tb, lastentry - tb->data, 0);
+#endif
 					break;
 				}
 
 				/* shift */
 				memcpy(lastentry, curentry, sizeof(SH_ELEMENT_TYPE));
+#ifdef SH_USE_TAGS
+				SH_SET_TAG(tb, lastentry - tb->data, tb->tags[curelem]);
+#endif
 
 				lastentry = curentry;
 			}
@@ -956,6 +1131,9 @@ SH_DELETE_ITEM(SH_TYPE * tb, SH_ELEMENT_TYPE * entry)
 		if (curentry->status != SH_STATUS_IN_USE)
 		{
 			lastentry->status = SH_STATUS_EMPTY;
+#ifdef SH_USE_TAGS
+			SH_SET_TAG(tb, lastentry - tb->data, 0);
+#endif
 			break;
 		}
 
@@ -966,11 +1144,17 @@ SH_DELETE_ITEM(SH_TYPE * tb, SH_ELEMENT_TYPE * entry)
 		if (curoptimal == curelem)
 		{
 			lastentry->status = SH_STATUS_EMPTY;
+#ifdef SH_USE_TAGS
+			SH_SET_TAG(tb, lastentry - tb->data, 0);
+#endif
 			break;
 		}
 
 		/* shift */
 		memcpy(lastentry, curentry, sizeof(SH_ELEMENT_TYPE));
+#ifdef SH_USE_TAGS
+		SH_SET_TAG(tb, lastentry - tb->data, tb->tags[curelem]);
+#endif
 
 		lastentry = curentry;
 	}
@@ -1154,6 +1338,7 @@ SH_STAT(SH_TYPE * tb)
 #undef SH_DEFINE
 #undef SH_GET_HASH
 #undef SH_STORE_HASH
+#undef SH_USE_TAGS
 #undef SH_USE_NONDEFAULT_ALLOCATOR
 #undef SH_EQUAL
 
@@ -1204,3 +1389,4 @@ SH_STAT(SH_TYPE * tb)
 #undef SH_ENTRY_HASH
 #undef SH_INSERT_HASH_INTERNAL
 #undef SH_LOOKUP_HASH_INTERNAL
+#undef SH_SET_TAG
@@ -58,6 +58,7 @@ struct RangeTblEntry;			/* avoid including parsenodes.h here */
 struct ExprEvalStep;			/* avoid including execExpr.h everywhere */
 struct CopyMultiInsertBuffer;
 struct LogicalTapeSet;
+struct bloom_filter;
 
 
 /* ----------------
@@ -138,6 +139,12 @@ typedef struct ExprState
 	 * ExecInitExprRec().
 	 */
 	ErrorSaveContext *escontext;
+
+	/*
+	 * Number of evaluations left until JIT compilation of the expression is
+	 * attempted, if that has been deferred (see ExecReadyDeferredJitExpr()).
+	 */
+	int			jit_countdown;
 } ExprState;
 
 
@@ -716,10 +723,17 @@ typedef struct EState
 	 * es_jit_worker_instr is the combined, on demand allocated,
 	 * instrumentation from all workers. The leader's instrumentation is kept
 	 * separate, and is combined on demand by ExplainPrintJITSummary().
+	 *
+	 * es_jit_deferred lists the ExprStates whose compilation has been
+	 * deferred and not yet performed, see ExecReadyDeferredJitExpr().
+	 * es_jit_owner is the resource owner at executor startup, which es_jit
+	 * is tied to even if it's only created once execution is underway.
 	 */
 	int			es_jit_flags;
 	struct JitContext *es_jit;
 	struct JitInstrumentation *es_jit_worker_instr;
+	List	   *es_jit_deferred;
+	struct ResourceOwnerData *es_jit_owner;
 
 	/*
 	 * Lists of ResultRelInfos for foreign tables on which batch-inserts are
@@ -814,6 +828,7 @@ typedef struct TupleHashEntryData
 #define SH_ELEMENT_TYPE TupleHashEntryData
 #define SH_KEY_TYPE MinimalTuple
 #define SH_SCOPE extern
+#define SH_USE_TAGS
 #define SH_DECLARE
 #include "lib/simplehash.h"
 
@@ -824,6 +839,7 @@ typedef struct TupleHashTableData
 	AttrNumber *keyColIdx;		/* attr numbers of key columns */
 	FmgrInfo   *tab_hash_funcs; /* hash functions for table datatype(s) */
 	ExprState  *tab_eq_func;	/* comparator for table datatype(s) */
+	ExprState  *tab_hash_expr;	/* hash calculation for table datatype(s) */
 	Oid		   *tab_collations; /* collations for hash and comparison */
 	MemoryContext tablecxt;		/* memory context containing table */
 	MemoryContext tempcxt;		/* context for function evaluations */
@@ -977,6 +993,7 @@ typedef struct SubPlanState
 	TupleHashTable hashnulls;	/* hash table for rows with null(s) */
 	bool		havehashrows;	/* true if hashtable is not empty */
 	bool		havenullrows;	/* true if hashnulls is not empty */
+	bool		hashfallback;	/* hash table outgrew hash_mem; rescan */
 	MemoryContext hashtablecxt; /* memory context containing hash tables */
 	MemoryContext hashtempcxt;	/* temp memory context for hash tables */
 	ExprContext *innerecontext; /* econtext for computing inner tuples */
@@ -1505,6 +1522,12 @@ typedef struct MergeAppendState
  *		intermediate_empty	T if intermediate_table is currently empty
  *		working_table		working table (to be scanned by recursive term)
  *		intermediate_table	current recursive output (next generation of WT)
+ *
+ *		Once the hash table reaches hash_mem, it stops taking new tuples, and
+ *		tuples it doesn't hold are set aside in hash_pending by partition.
+ *		At the end of each generation they are checked against hash_seen,
+ *		the tuples of the same partition admitted earlier, and the new ones
+ *		are returned from spill_output.
  * ----------------
  */
 typedef struct RecursiveUnionState
@@ -1520,6 +1543,21 @@ typedef struct RecursiveUnionState
 	MemoryContext tempContext;	/* short-term context for comparisons */
 	TupleHashTable hashtable;	/* hash table for tuples already seen */
 	MemoryContext tableContext; /* memory context containing hash table */
+	Size		hash_mem_limit; /* limit before spilling hash table */
+	uint64		hash_ngroups_limit; /* limit before spilling hash table */
+	uint64		hash_ngroups_current;	/* number of groups in hash table */
+	bool		hash_spill_mode;	/* hash table full, new tuples deferred? */
+	int			hash_npartitions;	/* number of spill partitions */
+	int			hash_spill_shift;	/* shift hash value to get partition */
+	int			hash_spill_partitions;	/* partitions used, for EXPLAIN */
+	Tuplestorestate **hash_seen;	/* admitted tuples, per partition */
+	Tuplestorestate **hash_pending; /* deferred tuples, per partition */
+	TupleHashTable spilltable;	/* for checking one partition's tuples */
+	MemoryContext spillContext; /* memory context containing spilltable */
+	Tuplestorestate *spill_output;	/* admitted deferred tuples to return */
+	TupleTableSlot *spill_slot; /* for reading the partition tuplestores */
+	bool		spill_returning;	/* returning tuples from spill_output? */
+	bool		inner_done;		/* recursive term done for this generation */
 } RecursiveUnionState;
 
 /* ----------------
@@ -2181,6 +2219,20 @@ typedef struct MergeJoinState
  *		hj_JoinState			current state of ExecHashJoin state machine
  *		hj_MatchedOuter			true if found a join match for current outer
  *		hj_OuterNotEmpty		true if outer relation known not empty
+ *		hj_OuterChunked			true if current outer tuple belongs to a batch
+ *								that is processed in chunks
+ *		hj_CurOuterTupleNo		number of current outer tuple within its
+ *								chunked batch (valid if hj_OuterChunked)
+ *		hj_ProbeBatched			true if probing the hash table with batches
+ *								of outer tuples
+ *		hj_ProbeSlots			slots holding the current batch of outer
+ *								tuples (NULL in a parallel-aware join)
+ *		hj_ProbeHashValues		hash values of those tuples
+ *		hj_ProbeCount			number of tuples in the current batch
+ *		hj_ProbeNext			index of next tuple to return from it
+ *		hj_ProbeDone			true if no more outer tuples for this batch
+ *		hj_BloomFiltered		number of outer tuples discarded by the Hash
+ *								node's bloom filter
  * ----------------
  */
 
@@ -2208,6 +2260,15 @@ typedef struct HashJoinState
 	int			hj_JoinState;
 	bool		hj_MatchedOuter;
 	bool		hj_OuterNotEmpty;
+	bool		hj_OuterChunked;
+	uint64		hj_CurOuterTupleNo;
+	bool		hj_ProbeBatched;
+	TupleTableSlot **hj_ProbeSlots;
+	uint32	   *hj_ProbeHashValues;
+	int			hj_ProbeCount;
+	int			hj_ProbeNext;
+	bool		hj_ProbeDone;
+	double		hj_BloomFiltered;
 } HashJoinState;
 
 
@@ -2241,6 +2302,9 @@ typedef struct MemoizeInstrumentation
 {
 	uint64		cache_hits;		/* number of rescans where we've found the
 								 * scan parameter values to be cached */
+	uint64		shared_hits;	/* number of rescans where we've found them
+								 * in the cache shared with other parallel
+								 * participants instead */
 	uint64		cache_misses;	/* number of rescans where we've not found the
 								 * scan parameter values to be cached. */
 	uint64		cache_evictions;	/* number of cache entries removed due to
@@ -2301,8 +2365,50 @@ typedef struct MemoizeState
 	SharedMemoizeInfo *shared_info; /* statistics for parallel workers */
 	Bitmapset  *keyparamids;	/* Param->paramids of expressions belonging to
 								 * param_exprs */
+	struct SharedMemoizeCache *shared_cache;	/* cache shared with other
+												 * parallel participants, or
+												 * NULL */
+	struct dshash_table *shared_hash;	/* hash table of the shared cache */
+	struct dsa_area *shared_area;	/* DSA area holding the shared cache */
+	bool		shared_cache_used;	/* did we use the shared cache? */
+	struct SharedMemoizeEntry *shared_entry;	/* pinned shared entry whose
+												 * tuples we're returning, or
+												 * NULL */
+	char	   *shared_next_tuple;	/* next tuple of shared_entry */
+	uint32		shared_ntuples; /* number of tuples left in shared_entry */
 } MemoizeState;
 
+/* ----------------
+ *	 RepartitionState information
+ *
+ *		Repartition nodes are used to redistribute the tuples of a
+ *		parallel plan by a hash key, or by ranges of a sort key.  See
+ *		nodeRepartition.c.
+ * ----------------
+ */
+struct RepartitionShared;
+struct SharedTuplestoreAccessor;
+struct SortSupportData;
+
+typedef struct RepartitionState
+{
+	pg_node_attr(nodetag_number(477))
+
+	PlanState	ps;				/* its first field is NodeTag */
+	ExprState  *hash_expr;		/* computes the hash value of a tuple */
+	struct RepartitionShared *shared;	/* shared state, or NULL if not
+										 * running in parallel */
+	struct SharedTuplestoreAccessor **accessors;	/* one per partition */
+	MemoryContext accessor_cxt; /* holds the accessors and their buffers */
+	int			nparts;			/* number of partitions */
+	int			curpart;		/* partition being read, or -1 if none */
+	bool		written;		/* have we written out the subplan yet? */
+	struct SortSupportData *range_sortkey;	/* compares range bounds */
+	Datum	   *range_bounds;	/* upper bounds of all but the last range */
+	void	   *tuplesortstate; /* sorts or returns the current range */
+	int			next_range;		/* next range to return, in range mode */
+} RepartitionState;
+
 /* ----------------
  *	 When performing sorting by multiple keys, it's possible that the input
  *	 dataset is already sorted on a prefix of those keys. We call these
@@ -2431,6 +2537,8 @@ typedef struct AggregateInstrumentation
 	Size		hash_mem_peak;	/* peak hash table memory usage */
 	uint64		hash_disk_used; /* kB of disk space used */
 	int			hash_batches_used;	/* batches used during entire execution */
+	uint64		hash_temp_written;	/* kB written to disk, if compressed */
+	uint64		hash_temp_written_compressed;	/* same after compression */
 } AggregateInstrumentation;
 
 /* ----------------
@@ -2526,6 +2634,8 @@ typedef struct AggState
 										 * memory in all hash tables */
 	uint64		hash_disk_used; /* kB of disk space used */
 	int			hash_batches_used;	/* batches used during entire execution */
+	uint64		hash_temp_written;	/* kB written to disk, if compressed */
+	uint64		hash_temp_written_compressed;	/* same after compression */
 
 	AggStatePerHash perhash;	/* array of per-hashtable data */
 	AggStatePerGroup *hash_pergroup;	/* grouping set indexed array of
@@ -2682,6 +2792,9 @@ typedef struct GatherState
 	int			nreaders;		/* number of still-active workers */
 	int			nextreader;		/* next one to try to read from */
 	struct TupleQueueReader **reader;	/* array with nreaders active entries */
+	/* tuple queue statistics for EXPLAIN ANALYZE, summed over rescans: */
+	TupleQueueInstrumentation worker_queue_instr;	/* sent by workers */
+	TupleQueueInstrumentation leader_queue_instr;	/* leader's waits */
 } GatherState;
 
 /* ----------------
@@ -2714,6 +2827,9 @@ typedef struct GatherMergeState
 	struct TupleQueueReader **reader;	/* array with nreaders active entries */
 	struct GMReaderTupleBuffer *gm_tuple_buffers;	/* nreaders tuple buffers */
 	struct binaryheap *gm_heap; /* binary heap of slot indices */
+	/* tuple queue statistics for EXPLAIN ANALYZE, summed over rescans: */
+	TupleQueueInstrumentation worker_queue_instr;	/* sent by workers */
+	TupleQueueInstrumentation leader_queue_instr;	/* leader's waits */
 } GatherMergeState;
 
 /* ----------------
@@ -2727,6 +2843,9 @@ typedef struct HashInstrumentation
 	int			nbatch;			/* number of batches at end of execution */
 	int			nbatch_original;	/* planned number of batches */
 	Size		space_peak;		/* peak memory usage in bytes */
+	int			nbatch_chunked; /* number of batches joined in chunks */
+	int64		temp_written;	/* bytes written to batch files, before */
+	int64		temp_written_compressed;	/* ... and after compression */
 } HashInstrumentation;
 
 /* ----------------
@@ -2766,6 +2885,26 @@ typedef struct HashState
 
 	/* Parallel hash state. */
 	struct ParallelHashJoinState *parallel_state;
+
+	/*
+	 * Smallest and largest value of one hash key seen while building the hash
+	 * table, for the parent HashJoin's runtime filter.  filterKey is NULL if
+	 * there is none.  By-reference values live in the hashtable's hashCxt.
+	 */
+	ExprState  *filterKey;
+	SortSupportData filterSortSupport;
+	int16		filterTypLen;
+	bool		filterTypByVal;
+	bool		filterHasValues;
+	Datum		filterMin;
+	Datum		filterMax;
+
+	/*
+	 * Bloom filter of the hash values of all inner tuples, built if the plan
+	 * asks for it, so that the parent HashJoin can discard outer tuples that
+	 * can't have a match cheaply.  Lives in the hashtable's hashCxt.
+	 */
+	struct bloom_filter *filterBloom;
 } HashState;
 
 /* ----------------
@@ -2796,6 +2935,23 @@ typedef struct SetOpState
 	MemoryContext tableContext; /* memory context containing hash table */
 	bool		table_filled;	/* hash table filled yet? */
 	TupleHashIterator hashiter; /* for iterating through hash table */
+	struct LogicalTapeSet *hash_tapeset;	/* tape set for hash spill tapes */
+	struct SetOpSpill *hash_spill;	/* spill partitions of the current pass */
+	TupleTableSlot *hash_spill_rslot;	/* for reading spill files */
+	List	   *hash_batches;	/* hash batches remaining to be processed */
+	bool		hash_ever_spilled;	/* ever spilled during this execution? */
+	bool		hash_spill_mode;	/* we hit a limit during the current batch
+									 * and we must not create new groups */
+	Size		hash_mem_limit; /* limit before spilling hash table */
+	uint64		hash_ngroups_limit; /* limit before spilling hash table */
+	double		hashentrysize;	/* estimated size of a hash table entry */
+	uint64		hash_ngroups_current;	/* number of groups currently in
+										 * memory */
+	Size		hash_mem_peak;	/* peak hash table memory usage */
+	uint64		hash_disk_used; /* kB of disk space used */
+	int			hash_batches_used;	/* batches used during entire execution */
+	uint64		hash_temp_written;	/* kB written to disk, if compressed */
+	uint64		hash_temp_written_compressed;	/* same after compression */
 } SetOpState;
 
 /* ----------------
@@ -523,6 +523,20 @@ struct PlannerInfo
 	/* is any partial agg non-serializable? */
 	bool		hasNonSerialAggs;
 
+	/*
+	 * Information about eager aggregation.  Filled by
+	 * setup_eager_aggregation() if the aggregates can be partially computed
+	 * below the joins.
+	 */
+	/* the base rel that all aggregates read from, or 0 if none */
+	Index		eager_agg_relid;
+	/* SortGroupClauses for partially grouping that rel */
+	List	   *eager_agg_groupClause;
+	/* its Vars used only in aggregates, as for pull_varattnos() */
+	Bitmapset  *eager_agg_aggonly_attrs;
+	/* the query's Aggrefs, marked for partial aggregation */
+	List	   *eager_agg_partial_aggs;
+
 	/*
 	 * These fields are used only when hasRecursion is true:
 	 */
@@ -808,6 +822,11 @@ typedef struct PartitionSchemeData *PartitionScheme;
  * corresponding to COALESCE expressions of the left and right join columns,
  * to simplify matching join clauses to those lists.
  *
+ * If eager aggregation is possible (see setup_eager_aggregation), each base
+ * or join relation that contains the aggregated relation can have a
+ * grouped_rel, a copy of it whose paths emit partially aggregated rows
+ * rather than the rows of the aggregated relation.
+ *
  * Not all fields are printed.  (In some cases, there is no print support for
  * the field type.)
  *----------
@@ -1043,6 +1062,12 @@ typedef struct RelOptInfo
 	List	  **partexprs pg_node_attr(read_write_ignore);
 	/* Nullable partition key expressions */
 	List	  **nullable_partexprs pg_node_attr(read_write_ignore);
+
+	/*
+	 * used for eager aggregation:
+	 */
+	/* the same rel, but with the eager_agg_relid rows partially aggregated */
+	struct RelOptInfo *grouped_rel pg_node_attr(read_write_ignore);
 } RelOptInfo;
 
 /*
@@ -2000,11 +2025,33 @@ typedef struct MemoizePath
 	bool		binary_mode;	/* true when cache key should be compared bit
 								 * by bit, false when using hash equality ops */
 	Cardinality calls;			/* expected number of rescans */
+	bool		below_gather;	/* true if the rescans are spread among
+								 * parallel participants */
 	uint32		est_entries;	/* The maximum number of entries that the
 								 * planner expects will fit in the cache, or 0
 								 * if unknown */
 } MemoizePath;
 
+/*
+ * RepartitionPath represents redistributing the tuples of a partial path
+ * among the parallel participants, so that each participant gets all the
+ * rows for the distinct values of the hash key it is assigned.  hashClause
+ * is a list of hashable SortGroupClauses identifying the key columns.
+ *
+ * Alternatively, if hashClause is NIL, the tuples are distributed by ranges
+ * of the leading path key, delimited by rangeBounds (a list of Consts in
+ * sort order), and each range is sorted by the path's pathkeys.
+ */
+typedef struct RepartitionPath
+{
+	pg_node_attr(nodetag_number(476))
+
+	Path		path;
+	Path	   *subpath;
+	List	   *hashClause;
+	List	   *rangeBounds;
+} RepartitionPath;
+
 /*
  * UniquePath represents elimination of distinct rows from the output of
  * its subpath.
@@ -871,6 +871,16 @@ typedef struct HashJoin
 	 * perform lookups in the hashtable over the inner plan.
 	 */
 	List	   *hashkeys;
+
+	/*
+	 * If filterMinParam is not -1, then once the hash table has been built,
+	 * the join sets these PARAM_EXEC params to the smallest and largest
+	 * value of the Hash node's filterKeyNo'th hash key.  An Append on the
+	 * outer side uses them to prune partitions that can't have a match, and
+	 * bitmap scans of BRIN indexes on the outer side to skip block ranges.
+	 */
+	int			filterMinParam;
+	int			filterMaxParam;
 } HashJoin;
 
 /* ----------------
@@ -924,6 +934,56 @@ typedef struct Memoize
 	Bitmapset  *keyparamids;
 } Memoize;
 
+/* ----------------
+ *		repartition node
+ *
+ * Redistributes the tuples produced by the participants of a parallel plan,
+ * so that all tuples with equal hash key values are returned by the same
+ * participant.
+ *
+ * If numSortCols > 0, the tuples are instead distributed among ranges of the
+ * first sort column, delimited by rangeBounds, and each range is sorted.
+ * A single participant then returns the tuples of all ranges in order, so
+ * that a plain Gather above preserves the sort order.
+ * ----------------
+ */
+typedef struct Repartition
+{
+	pg_node_attr(nodetag_number(475))
+
+	Plan		plan;
+
+	/* number of columns in hash key */
+	int			numCols;
+
+	/* their indexes in the target list */
+	AttrNumber *hashColIdx pg_node_attr(array_size(numCols));
+
+	/* equality operators to hash with */
+	Oid		   *hashOperators pg_node_attr(array_size(numCols));
+
+	/* collations to hash with */
+	Oid		   *hashCollations pg_node_attr(array_size(numCols));
+
+	/* number of sort-key columns, or 0 if distributing by hash */
+	int			numSortCols;
+
+	/* their indexes in the target list */
+	AttrNumber *sortColIdx pg_node_attr(array_size(numSortCols));
+
+	/* OIDs of operators to sort them by */
+	Oid		   *sortOperators pg_node_attr(array_size(numSortCols));
+
+	/* OIDs of collations */
+	Oid		   *collations pg_node_attr(array_size(numSortCols));
+
+	/* NULLS FIRST/LAST directions */
+	bool	   *nullsFirst pg_node_attr(array_size(numSortCols));
+
+	/* Consts of the first sort column delimiting ranges, in sort order */
+	List	   *rangeBounds;
+} Repartition;
+
 /* ----------------
  *		sort node
  * ----------------
@@ -1206,6 +1266,10 @@ typedef struct Hash
 	Oid			skewTable;		/* outer join key's table OID, or InvalidOid */
 	AttrNumber	skewColumn;		/* outer join key's column #, or zero */
 	bool		skewInherit;	/* is outer join rel an inheritance tree? */
+	int			filterKeyNo;	/* hash key to track min/max of, or -1 */
+	Oid			filterSortOp;	/* "<" operator for that key, if any */
+	Oid			filterCollation;	/* collation the range is computed in */
+	bool		filterBloom;	/* build a bloom filter of hash values? */
 	/* all other info is in the parent HashJoin node */
 	Cardinality rows_total;		/* estimate total rows if parallel_aware */
 } Hash;
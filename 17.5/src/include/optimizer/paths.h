@@ -63,6 +63,7 @@ extern void create_partial_bitmap_paths(PlannerInfo *root, RelOptInfo *rel,
 										Path *bitmapqual);
 extern void generate_partitionwise_join_paths(PlannerInfo *root,
 											  RelOptInfo *rel);
+extern void set_grouped_rel_cheapest(RelOptInfo *rel);
 
 /*
  * indxpath.c
@@ -94,6 +95,15 @@ extern void add_paths_to_joinrel(PlannerInfo *root, RelOptInfo *joinrel,
 								 JoinType jointype, SpecialJoinInfo *sjinfo,
 								 List *restrictlist);
 
+/*
+ * greedyjoin.c
+ *	  greedy join order search for large join problems
+ */
+extern PGDLLIMPORT bool enable_goo_join_search;
+
+extern RelOptInfo *goo_join_search(PlannerInfo *root, int levels_needed,
+								   List *initial_rels);
+
 /*
  * joinrels.c
  *	  routines to determine which relations to join
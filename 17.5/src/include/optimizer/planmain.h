@@ -97,6 +97,7 @@ extern RestrictInfo *build_implied_join_equality(PlannerInfo *root,
 												 Relids qualscope,
 												 Index security_level);
 extern void match_foreign_keys_to_quals(PlannerInfo *root);
+extern void setup_eager_aggregation(PlannerInfo *root);
 
 /*
  * prototypes for plan/analyzejoins.c
@@ -32,11 +32,24 @@
 
 typedef struct BufFile BufFile;
 
+/* Compression methods for temp_file_compression */
+typedef enum TempFileCompression
+{
+	TEMP_FILE_COMPRESSION_NONE = 0,
+	TEMP_FILE_COMPRESSION_PGLZ,
+	TEMP_FILE_COMPRESSION_LZ4,
+	TEMP_FILE_COMPRESSION_ZSTD,
+} TempFileCompression;
+
+/* GUC variable */
+extern PGDLLIMPORT int temp_file_compression;
+
 /*
  * prototypes for functions in buffile.c
  */
 
 extern BufFile *BufFileCreateTemp(bool interXact);
+extern BufFile *BufFileCreateCompressTemp(bool interXact);
 extern void BufFileClose(BufFile *file);
 extern pg_nodiscard size_t BufFileRead(BufFile *file, void *ptr, size_t size);
 extern void BufFileReadExact(BufFile *file, void *ptr, size_t size);
@@ -45,8 +58,18 @@ extern void BufFileWrite(BufFile *file, const void *ptr, size_t size);
 extern int	BufFileSeek(BufFile *file, int fileno, off_t offset, int whence);
 extern void BufFileTell(BufFile *file, int *fileno, off_t *offset);
 extern int	BufFileSeekBlock(BufFile *file, int64 blknum);
+extern void BufFilePrefetchBlock(BufFile *file, int64 blknum, int nblocks);
 extern int64 BufFileSize(BufFile *file);
 extern int64 BufFileAppend(BufFile *target, BufFile *source);
+extern void BufFileCompressionStats(BufFile *file, int64 *rawBytes,
+									int64 *storedBytes);
+
+extern Size BufFileCompressBound(int32 srclen);
+extern int32 BufFileCompressData(TempFileCompression method, const char *src,
+								 int32 srclen, char *dst);
+extern int32 BufFileDecompressData(TempFileCompression method,
+								   const char *src, int32 srclen,
+								   char *dst, int32 rawlen);
 
 extern BufFile *BufFileCreateFileSet(FileSet *fileset, const char *name);
 extern void BufFileExportFileSet(BufFile *file);
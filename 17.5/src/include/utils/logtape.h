@@ -73,5 +73,8 @@ extern size_t LogicalTapeBackspace(LogicalTape *lt, size_t size);
 extern void LogicalTapeSeek(LogicalTape *lt, int64 blocknum, int offset);
 extern void LogicalTapeTell(LogicalTape *lt, int64 *blocknum, int *offset);
 extern int64 LogicalTapeSetBlocks(LogicalTapeSet *lts);
+extern void LogicalTapeSetCompressionStats(LogicalTapeSet *lts,
+										   int64 *rawBytes,
+										   int64 *storedBytes);
 
 #endif							/* LOGTAPE_H */
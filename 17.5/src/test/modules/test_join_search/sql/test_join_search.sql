@@ -0,0 +1,41 @@
+CREATE EXTENSION test_join_search;
+
+SELECT join_search_create_star(10);
+
+SELECT join_search_star_query(4);
+
+-- Every strategy must plan the query; the plans must give the same answer.
+SET geqo_threshold = 2;
+SET enable_goo_join_search = on;
+SELECT count(*) FROM js_fact f
+  JOIN js_dim1 d1 ON d1.id = f.d1 JOIN js_dim2 d2 ON d2.id = f.d2
+  JOIN js_dim3 d3 ON d3.id = f.d3 JOIN js_dim4 d4 ON d4.id = f.d4
+  WHERE d1.attr = 1 AND d4.attr = 1;
+SET enable_goo_join_search = off;
+SELECT count(*) FROM js_fact f
+  JOIN js_dim1 d1 ON d1.id = f.d1 JOIN js_dim2 d2 ON d2.id = f.d2
+  JOIN js_dim3 d3 ON d3.id = f.d3 JOIN js_dim4 d4 ON d4.id = f.d4
+  WHERE d1.attr = 1 AND d4.attr = 1;
+RESET enable_goo_join_search;
+RESET geqo_threshold;
+
+-- Planning times vary from run to run, so only check that each strategy
+-- reports one, and how each plan's estimated cost compares with that of
+-- the exhaustive search.
+SELECT strategy, planning_ms > 0 AS planned,
+       total_cost <= 1.5 * min(total_cost) FILTER (WHERE strategy = 'dp')
+                                OVER () AS near_optimal
+FROM join_search_compare(join_search_star_query(10), 1)
+ORDER BY strategy;
+
+-- The exhaustive search can be left out, for joins too big for it.
+SELECT strategy FROM join_search_compare(join_search_star_query(10), 1, false)
+ORDER BY strategy;
+
+SELECT join_search_drop_star(10);
+
+-- Larger comparisons take too long for routine testing; see README.
+--
+-- SELECT join_search_create_star(40);
+-- SELECT * FROM join_search_compare(join_search_star_query(40), 10, false);
+-- SELECT join_search_drop_star(40);
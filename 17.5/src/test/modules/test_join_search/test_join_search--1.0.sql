@@ -0,0 +1,140 @@
+/* src/test/modules/test_join_search/test_join_search--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_join_search" to load this file. \quit
+
+-- Create a star schema: a fact table with a foreign key column for each of
+-- ndims dimension tables of growing size.
+CREATE FUNCTION join_search_create_star(ndims integer,
+    fact_rows integer DEFAULT 10000)
+RETURNS void
+LANGUAGE plpgsql AS
+$$
+BEGIN
+    EXECUTE format('CREATE TABLE js_fact (id int, %s)',
+                   (SELECT string_agg(format('d%s int', i), ', ')
+                    FROM generate_series(1, ndims) i));
+    FOR i IN 1..ndims LOOP
+        EXECUTE format('CREATE TABLE js_dim%s (id int PRIMARY KEY, attr int)',
+                       i);
+        EXECUTE format('INSERT INTO js_dim%s SELECT g, g %% 10 '
+                       'FROM generate_series(1, %s) g', i, 10 * i);
+    END LOOP;
+    EXECUTE format('INSERT INTO js_fact SELECT g, %s '
+                   'FROM generate_series(1, %s) g',
+                   (SELECT string_agg(format('g %% %s + 1', 10 * i), ', ')
+                    FROM generate_series(1, ndims) i),
+                   fact_rows);
+    ANALYZE;
+END
+$$;
+
+-- Drop the tables made by join_search_create_star().
+CREATE FUNCTION join_search_drop_star(ndims integer)
+RETURNS void
+LANGUAGE plpgsql AS
+$$
+BEGIN
+    DROP TABLE js_fact;
+    FOR i IN 1..ndims LOOP
+        EXECUTE format('DROP TABLE js_dim%s', i);
+    END LOOP;
+END
+$$;
+
+-- A query joining the fact table to every dimension, with a filter on every
+-- third one, so that the join order matters.
+CREATE FUNCTION join_search_star_query(ndims integer)
+RETURNS text
+LANGUAGE sql IMMUTABLE STRICT AS
+$$
+SELECT 'SELECT count(*) FROM js_fact f'
+    || string_agg(format(' JOIN js_dim%1$s d%1$s ON d%1$s.id = f.d%1$s', i),
+                  '' ORDER BY i)
+    || coalesce(' WHERE ' || string_agg(format('d%s.attr = 1', i), ' AND '
+                                         ORDER BY i)
+                                FILTER (WHERE i % 3 = 1), '')
+FROM generate_series(1, ndims) i
+$$;
+
+-- EXPLAIN a query with each join search strategy.  The settings only last
+-- for the duration of the call.
+CREATE FUNCTION join_search_explain_dp(query text)
+RETURNS jsonb
+LANGUAGE plpgsql
+SET geqo = off
+SET join_collapse_limit = 100
+SET from_collapse_limit = 100 AS
+$$
+DECLARE
+    plan jsonb;
+BEGIN
+    EXECUTE 'EXPLAIN (SUMMARY, FORMAT JSON) ' || query INTO plan;
+    RETURN plan;
+END
+$$;
+
+CREATE FUNCTION join_search_explain_geqo(query text)
+RETURNS jsonb
+LANGUAGE plpgsql
+SET geqo = on
+SET geqo_threshold = 2
+SET enable_goo_join_search = off
+SET join_collapse_limit = 100
+SET from_collapse_limit = 100 AS
+$$
+DECLARE
+    plan jsonb;
+BEGIN
+    EXECUTE 'EXPLAIN (SUMMARY, FORMAT JSON) ' || query INTO plan;
+    RETURN plan;
+END
+$$;
+
+CREATE FUNCTION join_search_explain_goo(query text)
+RETURNS jsonb
+LANGUAGE plpgsql
+SET geqo = on
+SET geqo_threshold = 2
+SET enable_goo_join_search = on
+SET join_collapse_limit = 100
+SET from_collapse_limit = 100 AS
+$$
+DECLARE
+    plan jsonb;
+BEGIN
+    EXECUTE 'EXPLAIN (SUMMARY, FORMAT JSON) ' || query INTO plan;
+    RETURN plan;
+END
+$$;
+
+-- Plan a query loops times with each strategy, and report the fastest
+-- planning time and the estimated cost of the plan found.  The exhaustive
+-- search ("dp") is skipped unless include_dp is true, since it takes too
+-- long for large joins.
+CREATE FUNCTION join_search_compare(query text,
+    loops integer DEFAULT 10,
+    include_dp boolean DEFAULT true,
+    OUT strategy text,
+    OUT planning_ms float8,
+    OUT total_cost float8)
+RETURNS SETOF record
+LANGUAGE plpgsql AS
+$$
+DECLARE
+    plan jsonb;
+BEGIN
+    FOREACH strategy IN ARRAY ARRAY['dp', 'geqo', 'goo'] LOOP
+        CONTINUE WHEN strategy = 'dp' AND NOT include_dp;
+        planning_ms := NULL;
+        FOR i IN 1..loops LOOP
+            EXECUTE format('SELECT join_search_explain_%s($1)', strategy)
+                INTO plan USING query;
+            planning_ms := least(planning_ms,
+                                 (plan #>> '{0,Planning Time}')::float8);
+        END LOOP;
+        total_cost := (plan #>> '{0,Plan,Total Cost}')::float8;
+        RETURN NEXT;
+    END LOOP;
+END
+$$;
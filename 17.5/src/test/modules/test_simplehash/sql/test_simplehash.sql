@@ -0,0 +1,27 @@
+CREATE EXTENSION test_simplehash;
+
+--
+-- bench_simplehash() raises an error if any insertion, lookup or deletion
+-- gives a wrong result.  The sizes cover tables smaller than a group of
+-- tags as well as ones that have to grow many times.
+--
+SELECT n, tagged, payload, bench_simplehash(n, tagged, payload) >= 0 AS ok
+  FROM unnest(ARRAY[0, 1, 15, 17, 1000, 100000]) n,
+       unnest(ARRAY[false, true]) tagged,
+       unnest(ARRAY[0, 16]) payload
+  ORDER BY n, tagged, payload;
+
+-- Invalid input
+SELECT bench_simplehash(-1);
+SELECT bench_simplehash(100, true, 2000);
+
+--
+-- Hashed grouping and set operations use simplehash with tags
+--
+SELECT count(*), sum(c) FROM
+  (SELECT i % 5003 AS g, count(*) AS c
+   FROM generate_series(1, 100000) i GROUP BY 1) s;
+SELECT count(*) FROM
+  (SELECT i % 7919 FROM generate_series(1, 50000) i
+   INTERSECT
+   SELECT i % 3001 FROM generate_series(1, 50000) i) s;
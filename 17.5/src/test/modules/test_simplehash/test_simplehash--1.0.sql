@@ -0,0 +1,10 @@
+/* src/test/modules/test_simplehash/test_simplehash--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_simplehash" to load this file. \quit
+
+CREATE FUNCTION bench_simplehash(nkeys int8,
+    tagged bool DEFAULT true,
+    payload int4 DEFAULT 0)
+RETURNS float8 STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
@@ -0,0 +1,194 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_simplehash.c
+ *		Test and benchmark the hash table template in simplehash.h.
+ *
+ * Copyright (c) 2024, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_simplehash/test_simplehash.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "common/hashfn.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "portability/instr_time.h"
+#include "utils/memutils.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(bench_simplehash);
+
+typedef struct bench_entry
+{
+	uint64		key;
+	uint32		hash;
+	char		status;
+} bench_entry;
+
+/*
+ * Extra bytes compared along with each key.  Key i's payload is stored at
+ * payload[i * payload_len].  All payloads are zero, so every comparison has
+ * to read all of them, as comparing keys with a long common prefix would.
+ */
+typedef struct bench_state
+{
+	char	   *payload;
+	int			payload_len;
+} bench_state;
+
+static inline bool
+bench_equal(void *private_data, uint64 a, uint64 b)
+{
+	bench_state *state = (bench_state *) private_data;
+
+	/* compare the payload first, so that unequal keys pay for it too */
+	if (state->payload_len > 0 &&
+		memcmp(&state->payload[a * state->payload_len],
+			   &state->payload[b * state->payload_len],
+			   state->payload_len) != 0)
+		return false;
+
+	return a == b;
+}
+
+/* hash table without tags */
+#define SH_PREFIX plainhash
+#define SH_ELEMENT_TYPE bench_entry
+#define SH_KEY_TYPE uint64
+#define SH_KEY key
+#define SH_HASH_KEY(tb, key) ((uint32) murmurhash64(key))
+#define SH_EQUAL(tb, a, b) bench_equal((tb)->private_data, a, b)
+#define SH_STORE_HASH
+#define SH_GET_HASH(tb, a) a->hash
+#define SH_SCOPE static inline
+#define SH_DECLARE
+#define SH_DEFINE
+#include "lib/simplehash.h"
+
+/* the same, with tags */
+#define SH_PREFIX taghash
+#define SH_ELEMENT_TYPE bench_entry
+#define SH_KEY_TYPE uint64
+#define SH_KEY key
+#define SH_HASH_KEY(tb, key) ((uint32) murmurhash64(key))
+#define SH_EQUAL(tb, a, b) bench_equal((tb)->private_data, a, b)
+#define SH_STORE_HASH
+#define SH_GET_HASH(tb, a) a->hash
+#define SH_USE_TAGS
+#define SH_SCOPE static inline
+#define SH_DECLARE
+#define SH_DEFINE
+#include "lib/simplehash.h"
+
+/*
+ * Run the benchmark on a table of the given prefix.  Even keys below
+ * 2 * nkeys are inserted, odd ones are used for lookups that must fail.
+ * Returns the time spent inserting and looking up keys.
+ */
+#define BENCH_SIMPLEHASH(prefix, nkeys, state, duration) \
+do { \
+	prefix##_hash *tb; \
+	instr_time	start_time; \
+	bool		found; \
+	\
+	tb = prefix##_create(CurrentMemoryContext, 256, (state)); \
+	\
+	INSTR_TIME_SET_CURRENT(start_time); \
+	\
+	for (int64 i = 0; i < (nkeys); i++) \
+	{ \
+		(void) prefix##_insert(tb, 2 * i, &found); \
+		if (found) \
+			elog(ERROR, "key " INT64_FORMAT " found before insertion", 2 * i); \
+		CHECK_FOR_INTERRUPTS(); \
+	} \
+	for (int64 i = 0; i < (nkeys); i++) \
+	{ \
+		bench_entry *entry; \
+		\
+		entry = prefix##_insert(tb, 2 * i, &found); \
+		if (!found || entry->key != 2 * i) \
+			elog(ERROR, "key " INT64_FORMAT " not found on reinsertion", 2 * i); \
+		entry = prefix##_lookup(tb, 2 * i); \
+		if (entry == NULL || entry->key != 2 * i) \
+			elog(ERROR, "key " INT64_FORMAT " not found", 2 * i); \
+		if (prefix##_lookup(tb, 2 * i + 1) != NULL) \
+			elog(ERROR, "absent key " INT64_FORMAT " found", 2 * i + 1); \
+		CHECK_FOR_INTERRUPTS(); \
+	} \
+	\
+	INSTR_TIME_SET_CURRENT(duration); \
+	INSTR_TIME_SUBTRACT(duration, start_time); \
+	\
+	/* delete every other key, then the rest, checking the remaining ones */ \
+	for (int64 i = 0; i < (nkeys); i += 2) \
+	{ \
+		if (!prefix##_delete(tb, 2 * i)) \
+			elog(ERROR, "key " INT64_FORMAT " not found for deletion", 2 * i); \
+	} \
+	for (int64 i = 0; i < (nkeys); i++) \
+	{ \
+		bench_entry *entry = prefix##_lookup(tb, 2 * i); \
+		\
+		if ((entry != NULL) != (i % 2 == 1)) \
+			elog(ERROR, "key " INT64_FORMAT " in wrong state after deletion", 2 * i); \
+		if (entry != NULL) \
+			prefix##_delete_item(tb, entry); \
+	} \
+	if (tb->members != 0) \
+		elog(ERROR, "hash table has " UINT64_FORMAT " members after deleting all", \
+			 (uint64) tb->members); \
+	\
+	prefix##_destroy(tb); \
+} while (0)
+
+/*
+ * Insert, look up and delete nkeys keys, checking the results, and return
+ * the time the insertions and lookups took in milliseconds.
+ */
+Datum
+bench_simplehash(PG_FUNCTION_ARGS)
+{
+	int64		nkeys = PG_GETARG_INT64(0);
+	bool		tagged = PG_GETARG_BOOL(1);
+	int32		payload_len = PG_GETARG_INT32(2);
+	bench_state state;
+	MemoryContext cxt;
+	MemoryContext oldcxt;
+	instr_time	duration;
+
+	if (nkeys < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of keys must not be negative")));
+	if (payload_len < 0 || payload_len > 1024)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("payload must be between 0 and 1024 bytes")));
+
+	cxt = AllocSetContextCreate(CurrentMemoryContext,
+								"bench_simplehash",
+								ALLOCSET_DEFAULT_SIZES);
+	oldcxt = MemoryContextSwitchTo(cxt);
+
+	state.payload_len = payload_len;
+	state.payload = NULL;
+	if (payload_len > 0)
+		state.payload = MemoryContextAllocExtended(cxt,
+												   (Size) (2 * nkeys + 1) * payload_len,
+												   MCXT_ALLOC_HUGE | MCXT_ALLOC_ZERO);
+
+	if (tagged)
+		BENCH_SIMPLEHASH(taghash, nkeys, &state, duration);
+	else
+		BENCH_SIMPLEHASH(plainhash, nkeys, &state, duration);
+
+	MemoryContextSwitchTo(oldcxt);
+	MemoryContextDelete(cxt);
+
+	PG_RETURN_FLOAT8(INSTR_TIME_GET_MILLISEC(duration));
+}
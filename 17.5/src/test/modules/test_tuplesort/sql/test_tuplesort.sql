@@ -0,0 +1,20 @@
+CREATE EXTENSION test_tuplesort;
+
+--
+-- These are large enough to be sorted by radix sort, with the leading
+-- bytes of the keys shared or not.  bench_tuplesort() raises an error if the
+-- output is out of order.
+--
+SELECT dist, typ, descending, bench_tuplesort(50000, dist, typ, descending) >= 0 AS ok
+  FROM unnest(ARRAY['random', 'sorted', 'reverse', 'duplicates', 'nulls']) dist,
+       unnest(ARRAY['int4', 'int8', 'text']::regtype[]) typ,
+       unnest(ARRAY[false, true]) descending
+  ORDER BY dist, typ, descending;
+
+-- Below the radix sort threshold
+SELECT bench_tuplesort(100, 'random', 'int8') >= 0 AS ok;
+
+-- Unsupported input
+SELECT bench_tuplesort(100, 'zipf', 'int8');
+SELECT bench_tuplesort(100, 'random', 'float8');
+
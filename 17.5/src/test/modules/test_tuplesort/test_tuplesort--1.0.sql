@@ -0,0 +1,11 @@
+/* src/test/modules/test_tuplesort/test_tuplesort--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_tuplesort" to load this file. \quit
+
+CREATE FUNCTION bench_tuplesort(ntuples int8,
+    distribution text DEFAULT 'random',
+    keytype regtype DEFAULT 'int8',
+    descending bool DEFAULT false)
+RETURNS float8 STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
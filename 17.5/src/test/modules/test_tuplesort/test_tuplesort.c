@@ -0,0 +1,202 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_tuplesort.c
+ *		Test and benchmark in-memory sorting in tuplesort.c.
+ *
+ * Copyright (c) 2024, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_tuplesort/test_tuplesort.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/pg_collation.h"
+#include "catalog/pg_type.h"
+#include "common/pg_prng.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "portability/instr_time.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+#include "utils/sortsupport.h"
+#include "utils/tuplesort.h"
+#include "utils/typcache.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(bench_tuplesort);
+
+typedef enum
+{
+	DIST_RANDOM,
+	DIST_SORTED,
+	DIST_REVERSE,
+	DIST_DUPLICATES,
+	DIST_NULLS,
+} test_distribution;
+
+/* Number of distinct values in the 'duplicates' distribution */
+#define NUM_DUPLICATE_VALUES	100
+
+static test_distribution
+parse_distribution(const char *name)
+{
+	if (strcmp(name, "random") == 0)
+		return DIST_RANDOM;
+	if (strcmp(name, "sorted") == 0)
+		return DIST_SORTED;
+	if (strcmp(name, "reverse") == 0)
+		return DIST_REVERSE;
+	if (strcmp(name, "duplicates") == 0)
+		return DIST_DUPLICATES;
+	if (strcmp(name, "nulls") == 0)
+		return DIST_NULLS;
+
+	ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			 errmsg("unrecognized distribution \"%s\"", name)));
+	return DIST_RANDOM;			/* keep compiler quiet */
+}
+
+/*
+ * Make the i'th of n values of the given distribution.
+ */
+static Datum
+make_value(Oid typid, test_distribution dist, int64 i, int64 n,
+		   pg_prng_state *prng, bool *isnull)
+{
+	int64		v;
+
+	*isnull = false;
+	switch (dist)
+	{
+		case DIST_SORTED:
+			v = i;
+			break;
+		case DIST_REVERSE:
+			v = n - i;
+			break;
+		case DIST_DUPLICATES:
+			v = pg_prng_uint64_range(prng, 1, NUM_DUPLICATE_VALUES);
+			break;
+		case DIST_NULLS:
+			*isnull = pg_prng_bool(prng);
+			v = (int64) pg_prng_uint64(prng);
+			break;
+		default:
+			v = (int64) pg_prng_uint64(prng);
+			break;
+	}
+
+	switch (typid)
+	{
+		case INT4OID:
+			/* keep sorted and reversed inputs in order */
+			if (dist == DIST_SORTED || dist == DIST_REVERSE)
+				return Int32GetDatum((int32) (v - n / 2));
+			return Int32GetDatum((int32) v);
+		case INT8OID:
+			return Int64GetDatum(v);
+		default:
+			return PointerGetDatum(cstring_to_text(psprintf(INT64_FORMAT, v)));
+	}
+}
+
+/*
+ * Sort ntuples values of the given distribution and key type, check that
+ * they come out in order, and return the time it took in milliseconds.
+ */
+Datum
+bench_tuplesort(PG_FUNCTION_ARGS)
+{
+	int64		ntuples = PG_GETARG_INT64(0);
+	test_distribution dist = parse_distribution(text_to_cstring(PG_GETARG_TEXT_PP(1)));
+	Oid			typid = PG_GETARG_OID(2);
+	bool		descending = PG_GETARG_BOOL(3);
+	Oid			collation;
+	TypeCacheEntry *typentry;
+	Oid			sortop;
+	SortSupportData ssup = {0};
+	MemoryContext cxt;
+	MemoryContext oldcxt;
+	Tuplesortstate *sortstate;
+	pg_prng_state prng;
+	instr_time	start_time;
+	instr_time	duration;
+	Datum		prev = (Datum) 0;
+	bool		prevnull = false;
+	Datum		val;
+	bool		isnull;
+	int64		nread;
+
+	if (typid != INT4OID && typid != INT8OID && typid != TEXTOID)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("unsupported key type %s", format_type_be(typid))));
+	if (ntuples < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of tuples must not be negative")));
+
+	collation = (typid == TEXTOID) ? C_COLLATION_OID : InvalidOid;
+	typentry = lookup_type_cache(typid, TYPECACHE_LT_OPR | TYPECACHE_GT_OPR);
+	sortop = descending ? typentry->gt_opr : typentry->lt_opr;
+
+	/* Comparator used to check the output, without abbreviation */
+	ssup.ssup_cxt = CurrentMemoryContext;
+	ssup.ssup_collation = collation;
+	ssup.ssup_nulls_first = descending;
+	PrepareSortSupportFromOrderingOp(sortop, &ssup);
+
+	cxt = AllocSetContextCreate(CurrentMemoryContext,
+								"bench_tuplesort",
+								ALLOCSET_DEFAULT_SIZES);
+	oldcxt = MemoryContextSwitchTo(cxt);
+
+	pg_prng_seed(&prng, 0x5eed);
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	sortstate = tuplesort_begin_datum(typid, sortop, collation, descending,
+									  work_mem, NULL, TUPLESORT_NONE);
+	for (int64 i = 0; i < ntuples; i++)
+	{
+		val = make_value(typid, dist, i, ntuples, &prng, &isnull);
+		tuplesort_putdatum(sortstate, val, isnull);
+		if (typid == TEXTOID)
+			pfree(DatumGetPointer(val));
+
+		CHECK_FOR_INTERRUPTS();
+	}
+	tuplesort_performsort(sortstate);
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start_time);
+
+	nread = 0;
+	while (tuplesort_getdatum(sortstate, true, typid == TEXTOID,
+							  &val, &isnull, NULL))
+	{
+		if (nread > 0 &&
+			ApplySortComparator(prev, prevnull, val, isnull, &ssup) > 0)
+			elog(ERROR, "tuple " INT64_FORMAT " is out of order", nread);
+
+		if (nread > 0 && typid == TEXTOID && !prevnull)
+			pfree(DatumGetPointer(prev));
+		prev = val;
+		prevnull = isnull;
+		nread++;
+	}
+	if (nread != ntuples)
+		elog(ERROR, "sort returned " INT64_FORMAT " tuples, expected " INT64_FORMAT,
+			 nread, ntuples);
+
+	tuplesort_end(sortstate);
+
+	MemoryContextSwitchTo(oldcxt);
+	MemoryContextDelete(cxt);
+
+	PG_RETURN_FLOAT8(INSTR_TIME_GET_MILLISEC(duration));
+}
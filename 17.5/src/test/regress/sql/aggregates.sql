@@ -1597,3 +1597,160 @@ drop table agg_hash_1;
 drop table agg_hash_2;
 drop table agg_hash_3;
 drop table agg_hash_4;
+
+-- Deferred JIT compilation switches from interpretation mid-query
+set jit_above_cost = 0;
+set jit_optimize_above_cost = -1;
+set jit_inline_above_cost = -1;
+-- nothing is evaluated often enough to be compiled
+set jit_defer_evaluations = 1000000;
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select g%10, sum(g::numeric) from generate_series(0, 9999) g group by g%10')
+    #>> '{0,JIT,Functions}')::int, 0) = 0 as not_compiled;
+-- the query's expressions are compiled once they are hot
+set jit_defer_evaluations = 100;
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select g%10, sum(g::numeric) from generate_series(0, 9999) g group by g%10')
+    #>> '{0,JIT,Functions}')::int, 0) > 0 as compiled;
+-- ... whatever the plan's cost
+set jit_above_cost = 1e9;
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select g%10, sum(g::numeric) from generate_series(0, 9999) g group by g%10')
+    #>> '{0,JIT,Functions}')::int, 0) > 0 as compiled;
+set jit_above_cost = 0;
+select g%10 as c1, sum(g::numeric) as c2, count(*) filter (where g > 5000) as c3
+  from generate_series(0, 9999) g group by g%10 order by 1;
+reset jit_defer_evaluations;
+reset jit_inline_above_cost;
+reset jit_optimize_above_cost;
+reset jit_above_cost;
+
+-- Tuple hash tables hash their keys with expressions that can be JIT
+-- compiled; the compiled hashing must group exactly like the interpreted one
+create temp view jit_hash_queries as
+select 'agg' as q, g % 7 as a, (g % 5)::text as b, nullif(g % 3, 0) as c,
+       count(*) as n
+  from generate_series(1, 2000) g group by 2, 3, 4
+union all
+select 'setop', a, b, null, null
+  from (select g % 7 as a, (g % 5)::text as b from generate_series(1, 2000) g
+        intersect
+        select g % 11, (g % 3)::text from generate_series(1, 2000) g) s
+union all
+select 'recursive', n, null, null, null
+  from (with recursive t(n) as (select 1 union select (n * 7) % 1000 from t)
+        select n from t) r
+union all
+select 'subplan', g, null, null, null
+  from generate_series(1, 200) g
+  where (g % 7, (g % 5)::text) not in
+        (select g % 11, (g % 3)::text from generate_series(1, 50) g)
+union all
+select 'subplan_crosstype', g, null, null, null
+  from generate_series(1, 200) g
+  where (g % 7)::int8 in (select g::int2 from generate_series(1, 3) g);
+set enable_sort = off;
+set jit_above_cost = 0;
+set jit_optimize_above_cost = -1;
+set jit_inline_above_cost = -1;
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select * from jit_hash_queries')
+    #>> '{0,JIT,Functions}')::int, 0) > 0 as compiled;
+create temp table jit_hashed as select * from jit_hash_queries;
+set jit = off;
+create temp table jit_interpreted as select * from jit_hash_queries;
+select q, count(*) from jit_hashed group by q order by q;
+select count(*) from
+  ((table jit_hashed except all table jit_interpreted)
+   union all
+   (table jit_interpreted except all table jit_hashed)) d;
+reset jit;
+reset jit_inline_above_cost;
+reset jit_optimize_above_cost;
+reset jit_above_cost;
+reset enable_sort;
+drop table jit_hashed, jit_interpreted;
+drop view jit_hash_queries;
+
+--
+-- Eager aggregation: partially aggregate the relation the aggregates read
+-- from before joining it
+--
+create table eager_fact (dim_id int, x int, y numeric);
+create table eager_dim (id int primary key, grp text);
+create table eager_dim2 (id int primary key, cat int);
+insert into eager_fact
+  select i % 100, i % 7, i / 3.0 from generate_series(1, 20000) i;
+insert into eager_dim select i, 'g' || (i % 5) from generate_series(0, 99) i;
+insert into eager_dim2 select i, i % 3 from generate_series(0, 99) i;
+analyze eager_fact, eager_dim, eager_dim2;
+
+set enable_eager_aggregate = on;
+
+explain (costs off)
+select d.grp, sum(f.x), count(*), avg(f.y)
+  from eager_fact f join eager_dim d on f.dim_id = d.id
+  group by d.grp order by d.grp;
+select d.grp, sum(f.x), count(*), avg(f.y)
+  from eager_fact f join eager_dim d on f.dim_id = d.id
+  group by d.grp order by d.grp;
+
+-- three-way join, with HAVING and an aggregate only in ORDER BY
+select d.grp, d2.cat, max(f.x), min(f.y)
+  from eager_fact f join eager_dim d on f.dim_id = d.id
+    join eager_dim2 d2 on d2.id = d.id
+  group by d.grp, d2.cat having count(*) > 100
+  order by d.grp, d2.cat, sum(f.y);
+
+-- a fact column used outside of aggregates becomes a grouping column
+select f.x, d.grp, count(*)
+  from eager_fact f join eager_dim d on f.dim_id = d.id
+  where f.x < 2
+  group by f.x, d.grp order by 1, 2;
+
+-- not applicable: aggregate over columns of both relations
+explain (costs off)
+select d.grp, sum(f.x + length(d.grp))
+  from eager_fact f join eager_dim d on f.dim_id = d.id
+  group by d.grp;
+
+-- not applicable: grouping on a column whose equal values may differ
+explain (costs off)
+select d.grp, sum(f.x)
+  from eager_fact f join eager_dim d on f.y = d.id
+  group by d.grp;
+
+-- not applicable: outer join
+explain (costs off)
+select d.grp, sum(f.x)
+  from eager_dim d left join eager_fact f on f.dim_id = d.id
+  group by d.grp;
+
+-- not applicable: no grouping columns in the aggregated relation, but a
+-- GROUP BY on another one; there must be no groups when f is empty
+explain (costs off)
+select d.grp, sum(f.x)
+  from eager_fact f, eager_dim d where f.x < 0
+  group by d.grp;
+select d.grp, sum(f.x)
+  from eager_fact f, eager_dim d where f.x < 0
+  group by d.grp;
+
+-- results must match those without eager aggregation
+create temp table eager_on as
+  select d.grp, d2.cat, sum(f.x) as s, count(*) as c
+    from eager_fact f join eager_dim d on f.dim_id = d.id
+      join eager_dim2 d2 on d2.id = f.dim_id
+    group by d.grp, d2.cat;
+reset enable_eager_aggregate;
+create temp table eager_off as
+  select d.grp, d2.cat, sum(f.x) as s, count(*) as c
+    from eager_fact f join eager_dim d on f.dim_id = d.id
+      join eager_dim2 d2 on d2.id = f.dim_id
+    group by d.grp, d2.cat;
+(select * from eager_on except select * from eager_off)
+  union all
+(select * from eager_off except select * from eager_on);
+
+drop table eager_on, eager_off;
+drop table eager_fact, eager_dim, eager_dim2;
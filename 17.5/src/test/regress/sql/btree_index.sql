@@ -282,3 +282,93 @@ CREATE TABLE btree_part (id int4) PARTITION BY RANGE (id);
 CREATE INDEX btree_part_idx ON btree_part(id);
 ALTER INDEX btree_part_idx ALTER COLUMN id SET (n_distinct=100);
 DROP TABLE btree_part;
+
+--
+-- Test inline comparisons of fixed-width keys (int2, int4, int8, oid, uuid,
+-- date, timestamp), including a DESC column, a NULL key, and a cross-type
+-- comparison that must still use the support function.
+--
+CREATE TABLE btree_fastcmp (a int2, b int4, c int8, d oid, e uuid, f date,
+  g timestamp);
+INSERT INTO btree_fastcmp
+  SELECT i % 100, i, i * 1000000000::int8, i::oid,
+         md5(i::text)::uuid, '2000-01-01'::date + i,
+         '2000-01-01'::timestamp + i * interval '1 hour'
+  FROM generate_series(1, 10000) i;
+INSERT INTO btree_fastcmp VALUES (NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+CREATE INDEX btree_fastcmp_abc ON btree_fastcmp (a, b DESC, c);
+CREATE INDEX btree_fastcmp_d ON btree_fastcmp (d);
+CREATE INDEX btree_fastcmp_e ON btree_fastcmp (e);
+CREATE INDEX btree_fastcmp_fg ON btree_fastcmp (f, g);
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*) FROM btree_fastcmp WHERE a = 42 AND b > 5000;
+SELECT b FROM btree_fastcmp WHERE a = 7 AND b < 500 ORDER BY a, b DESC;
+SELECT count(*) FROM btree_fastcmp WHERE a = 1 AND b = 101 AND c >= 101000000000;
+SELECT count(*) FROM btree_fastcmp WHERE a IS NULL;
+SELECT b FROM btree_fastcmp WHERE d BETWEEN 9995 AND 10010;
+SELECT b FROM btree_fastcmp WHERE e = md5('1234')::uuid;
+SELECT count(*) FROM btree_fastcmp WHERE e > md5('1234')::uuid;
+SELECT b FROM btree_fastcmp WHERE f = '2000-01-11' AND g > '2000-01-01 09:00';
+SELECT count(*) FROM btree_fastcmp WHERE b > 9990::int8;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+DROP TABLE btree_fastcmp;
+
+--
+-- Test binary searches that skip the key attributes known to be equal to
+-- the scankey.  The leading attributes are shared by long runs of tuples, so
+-- the known-equal prefix grows from none at the root to all but the last
+-- attribute on the leaf pages.  Check searches at the edges of those runs,
+-- backward scans, row comparisons that cross from one run to the next, and
+-- unique checks on insertion.
+--
+CREATE TABLE btree_prefix (a int4, b text, c int4, d int4);
+INSERT INTO btree_prefix
+  SELECT i / 8000, lpad(((i / 2000) % 4)::text, 48, 'x'), i % 2000, i
+  FROM generate_series(0, 23999) i;
+CREATE UNIQUE INDEX btree_prefix_abc ON btree_prefix (a, b, c)
+  WITH (fillfactor = 10);
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+-- first, last, and past the last tuple of a run
+SELECT d FROM btree_prefix WHERE a = 1 AND b = lpad('2', 48, 'x') AND c = 0;
+SELECT d FROM btree_prefix WHERE a = 1 AND b = lpad('2', 48, 'x') AND c = 1999;
+SELECT d FROM btree_prefix WHERE a = 1 AND b = lpad('2', 48, 'x') AND c = 2000;
+-- between two runs, and before and after all of them
+SELECT d FROM btree_prefix WHERE a = 1 AND b = lpad('2', 48, 'x') || 'a' AND c = 0;
+SELECT d FROM btree_prefix WHERE a = 1 AND b = lpad('', 48, 'x') AND c = 0;
+SELECT d FROM btree_prefix WHERE a = 2 AND b = lpad('4', 48, 'x') AND c = 0;
+SELECT count(*) FROM btree_prefix WHERE a = 2 AND b >= lpad('3', 48, 'x');
+SELECT count(*) FROM btree_prefix WHERE a = 0 AND b < lpad('1', 48, 'x');
+-- forward and backward scans from within a run
+SELECT d FROM btree_prefix
+  WHERE a = 1 AND b = lpad('2', 48, 'x') AND c > 1997 ORDER BY a, b, c;
+SELECT d FROM btree_prefix
+  WHERE a = 1 AND b = lpad('2', 48, 'x') AND c < 2
+  ORDER BY a DESC, b DESC, c DESC;
+-- from the end of one run into the next
+SELECT d FROM btree_prefix
+  WHERE (a, b, c) > (0, lpad('3', 48, 'x'), 1997) ORDER BY a, b, c LIMIT 4;
+SELECT d FROM btree_prefix
+  WHERE (a, b, c) < (1, lpad('0', 48, 'x'), 1)
+  ORDER BY a DESC, b DESC, c DESC LIMIT 3;
+SELECT d FROM btree_prefix
+  WHERE (a, b, c) >= (1, lpad('1', 48, 'x'), 1999) ORDER BY a, b, c LIMIT 2;
+-- unique checks in the middle and at the edges of a run
+INSERT INTO btree_prefix VALUES (1, lpad('2', 48, 'x'), 1000, -1);
+INSERT INTO btree_prefix VALUES (1, lpad('2', 48, 'x'), 0, -1);
+INSERT INTO btree_prefix VALUES (1, lpad('2', 48, 'x'), 1999, -1);
+INSERT INTO btree_prefix VALUES (1, lpad('2', 48, 'x'), 2000, -1);
+INSERT INTO btree_prefix VALUES (1, lpad('2', 48, 'x'), -1, -2);
+INSERT INTO btree_prefix VALUES (1, lpad('2', 48, 'x'), NULL, -3);
+INSERT INTO btree_prefix VALUES (1, NULL, 0, -4);
+SELECT d FROM btree_prefix
+  WHERE a = 1 AND b = lpad('2', 48, 'x') AND (c < 1 OR c > 1998)
+  ORDER BY a, b, c;
+SELECT d FROM btree_prefix
+  WHERE a = 1 AND b = lpad('2', 48, 'x') AND c IS NULL;
+SELECT d FROM btree_prefix WHERE a = 1 AND b IS NULL;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+DROP TABLE btree_prefix;
@@ -320,3 +320,42 @@ COPY parted_si(id, data) FROM :'filename';
 SELECT tableoid::regclass, id % 2 = 0 is_even, count(*) from parted_si GROUP BY 1, 2 ORDER BY 1;
 
 DROP TABLE parted_si;
+
+-- Index entries for a batch of copied rows are inserted in key order;
+-- check the result for several kinds of indexes.
+CREATE TABLE copy_batch_idx (a int, b text, c int);
+CREATE UNIQUE INDEX copy_batch_idx_a ON copy_batch_idx (a DESC NULLS LAST);
+CREATE INDEX copy_batch_idx_b ON copy_batch_idx (b COLLATE "C", c);
+CREATE INDEX copy_batch_idx_expr ON copy_batch_idx ((a % 3)) WHERE c > 0;
+CREATE INDEX copy_batch_idx_hash ON copy_batch_idx USING hash (c);
+COPY copy_batch_idx FROM stdin;
+5	e	1
+3	c	0
+\N	z	2
+1	a	-1
+4	d	2
+2	b	1
+\.
+SET enable_seqscan = off;
+SELECT a FROM copy_batch_idx ORDER BY a DESC NULLS LAST;
+SELECT b, c FROM copy_batch_idx WHERE b > 'a' ORDER BY b;
+SELECT a FROM copy_batch_idx WHERE a % 3 = 2 AND c > 0 ORDER BY a;
+SELECT a FROM copy_batch_idx WHERE c = 2 ORDER BY a;
+RESET enable_seqscan;
+-- unique violation within a batch reports the later row
+COPY copy_batch_idx FROM stdin;
+7	g	1
+6	f	1
+7	h	1
+\.
+DROP TABLE copy_batch_idx;
+-- unique indexes are checked row by row, so the first violation in the
+-- batch is reported, even if it's for a later index
+CREATE TABLE copy_batch_uniq (a int UNIQUE, b int UNIQUE, c int);
+CREATE INDEX copy_batch_uniq_c ON copy_batch_uniq (c);
+COPY copy_batch_uniq FROM stdin;
+1	1	3
+2	1	2
+1	3	1
+\.
+DROP TABLE copy_batch_uniq;
@@ -932,6 +932,29 @@ WHERE classid = 'pg_class'::regclass AND
 	    'concur_reindex_ind4'::regclass,
 	    'concur_reindex_matview'::regclass)
   ORDER BY 1, 2;
+-- Parallel validation and throttling with REINDEX CONCURRENTLY
+CREATE TABLE concur_reindex_par (c1 int, c2 text) WITH (parallel_workers = 2);
+INSERT INTO concur_reindex_par SELECT g, g::text FROM generate_series(1, 20000) g;
+CREATE UNIQUE INDEX concur_reindex_par_c1 ON concur_reindex_par (c1);
+-- only btree validation runs in parallel; BRIN stays serial
+CREATE INDEX concur_reindex_par_brin ON concur_reindex_par USING brin (c1);
+SET max_parallel_maintenance_workers = 2;
+SET concurrent_index_cost_delay = 1;
+SET concurrent_index_cost_limit = 10000;
+REINDEX INDEX CONCURRENTLY concur_reindex_par_c1;
+REINDEX INDEX CONCURRENTLY concur_reindex_par_brin;
+RESET concurrent_index_cost_limit;
+RESET concurrent_index_cost_delay;
+RESET max_parallel_maintenance_workers;
+SELECT indexrelid::regclass, indisvalid FROM pg_index
+  WHERE indrelid = 'concur_reindex_par'::regclass ORDER BY 1;
+SET enable_seqscan = off;
+SELECT count(*) FROM concur_reindex_par WHERE c1 BETWEEN 1 AND 20000;
+SET enable_indexscan = off;
+SELECT count(*) FROM concur_reindex_par WHERE c1 BETWEEN 100 AND 199;
+RESET enable_indexscan;
+RESET enable_seqscan;
+DROP TABLE concur_reindex_par;
 -- Check that comments are preserved
 CREATE TABLE testcomment (i int);
 CREATE INDEX testcomment_idx1 ON testcomment (i);
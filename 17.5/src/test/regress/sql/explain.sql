@@ -169,3 +169,50 @@ select explain_filter('explain (analyze,serialize text,buffers,timing off) selec
 select explain_filter('explain (analyze,serialize binary,buffers,timing) select * from int8_tbl i8');
 -- this tests an edge case where we have no data to return
 select explain_filter('explain (analyze,serialize) create temp table explain_temp as select * from int8_tbl i8');
+
+-- Test reuse of JIT-compiled deform functions by later queries
+create temp table jit_deform (a int8, b int2, c text, d int4 not null);
+insert into jit_deform values (1, 2, 'three', 4);
+set jit = on;
+set jit_above_cost = 0;
+set jit_optimize_above_cost = -1;
+set jit_inline_above_cost = -1;
+-- the first query compiles the deform function, the second one reuses it
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select d from jit_deform')
+    #>> '{0,JIT,Cached Deform Functions}')::int, 0) = 0 as compiled;
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select d from jit_deform')
+    #>> '{0,JIT,Cached Deform Functions}')::int, 0) > 0 as reused;
+-- optimized queries use their own, optimized, cached functions
+set jit_optimize_above_cost = 0;
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select d from jit_deform')
+    #>> '{0,JIT,Cached Deform Functions}')::int, 0) = 0 as compiled;
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select d from jit_deform')
+    #>> '{0,JIT,Cached Deform Functions}')::int, 0) > 0 as reused;
+set jit_optimize_above_cost = -1;
+-- with room for one function, the least recently used one is evicted
+set jit_deform_cache_size = 1;
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select d from jit_deform')
+    #>> '{0,JIT,Cached Deform Functions}')::int, 0) = 0 as compiled;
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select a from jit_deform')
+    #>> '{0,JIT,Cached Deform Functions}')::int, 0) = 0 as compiled;
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select a from jit_deform')
+    #>> '{0,JIT,Cached Deform Functions}')::int, 0) > 0 as reused;
+reset jit_deform_cache_size;
+-- a changed tuple descriptor needs a new deform function
+alter table jit_deform add column e int4 default 5;
+select not pg_jit_available() or
+  coalesce((explain_analyze_json('select d from jit_deform')
+    #>> '{0,JIT,Cached Deform Functions}')::int, 0) = 0 as compiled;
+select d, e from jit_deform;
+reset jit_inline_above_cost;
+reset jit_optimize_above_cost;
+reset jit_above_cost;
+set jit = off;
+drop table jit_deform;
@@ -181,3 +181,22 @@ values
   ('{}',    null),
   ('{1}',   '{2,3}');
 drop table t_gin_test_tbl;
+
+-- test parallel build, comparing the result with a serial build
+create table t_gin_test_tbl(i int4[], t text[]) with (parallel_workers = 2);
+insert into t_gin_test_tbl
+  select array[g % 100, g % 7, g], array[(g % 13)::text, null]
+  from generate_series(1, 20000) g;
+insert into t_gin_test_tbl values (null, null), ('{}', '{}');
+set max_parallel_maintenance_workers = 2;
+set min_parallel_table_scan_size = 0;
+create index t_gin_test_tbl_par on t_gin_test_tbl using gin (i, t);
+reset max_parallel_maintenance_workers;
+reset min_parallel_table_scan_size;
+set enable_seqscan = off;
+select count(*) from t_gin_test_tbl where i @> array[50];
+select count(*) from t_gin_test_tbl where i @> array[3, 5];
+select count(*) from t_gin_test_tbl where t @> array['7'];
+select count(*) from t_gin_test_tbl where i = '{}';
+reset enable_seqscan;
+drop table t_gin_test_tbl;
@@ -186,3 +186,47 @@ create index gist_tbl_box_index on gist_tbl using gist (b);
 insert into gist_tbl
   select box(point(0.05*i, 0.05*i)) from generate_series(0,10) as i;
 drop table gist_tbl;
+
+-- test parallel sorted build, and a buffering build requested with the same
+-- settings, which stays serial; index scans must find what a seqscan finds
+create table gist_tbl (p point) with (parallel_workers = 2);
+insert into gist_tbl
+  select point(g % 100, g / 100) from generate_series(1, 20000) g;
+create temp view gist_tbl_scans as
+  select 'box' as q, p::text as v from gist_tbl
+    where p <@ box(point(10, 10), point(20, 20))
+  union all
+  select 'knn', (p <-> point(50.3, 100.7))::text
+    from (select p from gist_tbl order by p <-> point(50.3, 100.7) limit 100) s;
+set enable_indexscan = off;
+set enable_bitmapscan = off;
+create temp table gist_tbl_seq as select * from gist_tbl_scans;
+reset enable_indexscan;
+reset enable_bitmapscan;
+
+set max_parallel_maintenance_workers = 2;
+set min_parallel_table_scan_size = 0;
+create index gist_tbl_point_index on gist_tbl using gist (p);
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+explain (costs off)
+  select p from gist_tbl where p <@ box(point(10, 10), point(20, 20));
+select q, count(*) from gist_tbl_scans group by q order by q;
+select count(*) from
+  ((select * from gist_tbl_scans except all table gist_tbl_seq)
+   union all
+   (table gist_tbl_seq except all select * from gist_tbl_scans)) d;
+drop index gist_tbl_point_index;
+
+create index gist_tbl_point_index on gist_tbl using gist (p)
+  with (buffering = on);
+select count(*) from
+  ((select * from gist_tbl_scans except all table gist_tbl_seq)
+   union all
+   (table gist_tbl_seq except all select * from gist_tbl_scans)) d;
+reset enable_seqscan;
+reset enable_bitmapscan;
+reset max_parallel_maintenance_workers;
+reset min_parallel_table_scan_size;
+drop view gist_tbl_scans;
+drop table gist_tbl, gist_tbl_seq;
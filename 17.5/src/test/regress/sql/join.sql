@@ -2965,3 +2965,30 @@ SELECT 1 FROM group_tbl t1
 GROUP BY s.c1, s.c2;
 
 DROP TABLE group_tbl;
+
+--
+-- Test greedy join order search
+--
+begin;
+set local enable_goo_join_search = on;
+set local geqo_threshold = 2;
+
+explain (costs off)
+select count(*) from tenk1 t1
+  join tenk1 t2 on t1.unique1 = t2.unique2
+  join int4_tbl i4 on t2.unique1 = i4.f1
+  left join onek o on o.unique1 = t1.ten
+  join int8_tbl i8 on i8.q1 = t1.hundred;
+
+select count(*) from tenk1 t1
+  join tenk1 t2 on t1.unique1 = t2.unique2
+  join int4_tbl i4 on t2.unique1 = i4.f1
+  left join onek o on o.unique1 = t1.ten
+  join int8_tbl i8 on i8.q1 = t1.hundred;
+
+-- clauseless joins must be postponed, but still be performed
+explain (costs off)
+select count(*) from int4_tbl a, int4_tbl b, tenk1 t
+  where t.unique1 = a.f1;
+
+rollback;
@@ -623,3 +623,177 @@ lateral (select t1.fivethous, i4.f1 from tenk1 t1 join int4_tbl i4
          on t1.fivethous = i4.f1+i8.q2 order by 1,2) ss;
 
 rollback;
+
+-- A batch dominated by a single key cannot be split by increasing the
+-- number of batches, so it has to be joined in chunks that each fit in
+-- work_mem, rescanning the outer side for each chunk.  Check that all join
+-- types produce the same results as they would with enough memory.
+begin;
+set local max_parallel_workers_per_gather = 0;
+set local enable_hashjoin = on;
+set local enable_mergejoin = off;
+set local enable_nestloop = off;
+set local hash_mem_multiplier = 1.0;
+
+create temp table hjchunk_inner as
+  select case when g % 10 = 0 then g else 1 end as id, repeat('x', 50) as t
+  from generate_series(1, 20000) g;
+create temp table hjchunk_outer as
+  select g as id from generate_series(0, 49999) g
+  union all
+  select 1 from generate_series(1, 3);
+analyze hjchunk_inner, hjchunk_outer;
+
+create function pg_temp.hash_join_batches(query text,
+  out original_batches int, out final_batches int, out chunked_batches int)
+language plpgsql
+as
+$$
+declare
+  whole_plan json;
+begin
+  execute 'explain (analyze, format ''json'') ' || query into whole_plan;
+  original_batches := (regexp_match(whole_plan::text,
+                       '"Original Hash Batches": (\d+)'))[1]::int;
+  final_batches := (regexp_match(whole_plan::text,
+                    '"Hash Batches": (\d+)'))[1]::int;
+  chunked_batches := (regexp_match(whole_plan::text,
+                      '"Chunked Batches": (\d+)'))[1]::int;
+end;
+$$;
+
+set local work_mem = '64kB';
+explain (costs off)
+  select count(*) from hjchunk_outer o join hjchunk_inner i using (id);
+-- The batch holding key 1 is 90% that key, so the number of batches is
+-- doubled only once before that batch is chunked, rather than until no other
+-- key is left in it.
+select final_batches <= 2 * original_batches as doubled_once,
+       chunked_batches > 0 as chunked
+  from pg_temp.hash_join_batches($$
+    select count(*) from hjchunk_outer o join hjchunk_inner i using (id)
+  $$);
+select count(*) from hjchunk_outer o join hjchunk_inner i using (id);
+select count(*), count(i.id) from hjchunk_outer o
+  left join hjchunk_inner i using (id);
+select count(*), count(o.id), count(i.id) from hjchunk_outer o
+  full join hjchunk_inner i on o.id = i.id;
+select count(*) from hjchunk_outer o
+  where exists (select 1 from hjchunk_inner i where i.id = o.id);
+select count(*) from hjchunk_outer o
+  where not exists (select 1 from hjchunk_inner i where i.id = o.id);
+
+-- the same, with enough memory to avoid chunking
+set local work_mem = '64MB';
+select chunked_batches > 0 as chunked from pg_temp.hash_join_batches($$
+  select count(*) from hjchunk_outer o join hjchunk_inner i using (id)
+$$);
+select count(*) from hjchunk_outer o join hjchunk_inner i using (id);
+select count(*), count(i.id) from hjchunk_outer o
+  left join hjchunk_inner i using (id);
+select count(*), count(o.id), count(i.id) from hjchunk_outer o
+  full join hjchunk_inner i on o.id = i.id;
+select count(*) from hjchunk_outer o
+  where exists (select 1 from hjchunk_inner i where i.id = o.id);
+select count(*) from hjchunk_outer o
+  where not exists (select 1 from hjchunk_inner i where i.id = o.id);
+
+-- If the inner side is badly underestimated, the join starts with a single
+-- batch, and batch 0 itself has to be joined in chunks.  The later chunks of
+-- batch 0 are reloaded from its own temp file.
+create temp table hjchunk_skew as
+  select 1 as id, repeat('x', 50) as t from generate_series(1, 20000) g;
+analyze hjchunk_skew;
+
+set local work_mem = '64kB';
+explain (costs off)
+  select count(*) from hjchunk_outer o
+    join (select * from hjchunk_skew where (id + 0) * 0 = 0) i using (id);
+select original_batches, chunked_batches > 0 as chunked
+  from pg_temp.hash_join_batches($$
+    select count(*) from hjchunk_outer o
+      join (select * from hjchunk_skew where (id + 0) * 0 = 0) i using (id)
+  $$);
+select count(*), count(distinct i.t) from hjchunk_outer o
+  join (select * from hjchunk_skew where (id + 0) * 0 = 0) i using (id);
+select count(*), count(i.id) from hjchunk_outer o
+  left join (select * from hjchunk_skew where (id + 0) * 0 = 0) i using (id);
+
+-- The same with compressed batch files, which the chunks are reread from by
+-- position
+set local temp_file_compression = pglz;
+select chunked_batches > 0 as chunked
+  from pg_temp.hash_join_batches($$
+    select count(*) from hjchunk_outer o join hjchunk_inner i using (id)
+  $$);
+select count(*) from hjchunk_outer o join hjchunk_inner i using (id);
+select count(*), count(i.id) from hjchunk_outer o
+  left join hjchunk_inner i using (id);
+select count(*), count(o.id), count(i.id) from hjchunk_outer o
+  full join hjchunk_inner i on o.id = i.id;
+select count(*) from hjchunk_outer o
+  where not exists (select 1 from hjchunk_inner i where i.id = o.id);
+select count(*), count(distinct i.t) from hjchunk_outer o
+  join (select * from hjchunk_skew where (id + 0) * 0 = 0) i using (id);
+
+-- EXPLAIN ANALYZE shows the size of the batch files before and after
+-- compression, but only if they were compressed
+create function pg_temp.hash_join_temp_written(query text,
+  out written int, out compressed int)
+language plpgsql
+as
+$$
+declare
+  whole_plan json;
+begin
+  execute 'explain (analyze, format ''json'') ' || query into whole_plan;
+  written := (regexp_match(whole_plan::text,
+              '"Temp Written": (\d+)'))[1]::int;
+  compressed := (regexp_match(whole_plan::text,
+                 '"Temp Written Compressed": (\d+)'))[1]::int;
+end;
+$$;
+select compressed < written as smaller
+  from pg_temp.hash_join_temp_written($$
+    select count(*) from hjchunk_outer o join hjchunk_inner i using (id)
+  $$);
+set local temp_file_compression = off;
+select written is null as not_shown
+  from pg_temp.hash_join_temp_written($$
+    select count(*) from hjchunk_outer o join hjchunk_inner i using (id)
+  $$);
+rollback;
+
+-- Hash tables too large to stay in CPU cache are probed with batches of
+-- outer tuples, with prefetching.  Check that it gives the same results in
+-- one batch and in many, where the bucket tags sit above the batch bits,
+-- and across rescans.
+begin;
+set local max_parallel_workers_per_gather = 0;
+set local enable_hashjoin = on;
+set local enable_mergejoin = off;
+set local enable_nestloop = off;
+set local hash_mem_multiplier = 1.0;
+
+create temp table hjprobe_inner as
+  select g * 2 as id, g as v from generate_series(1, 40000) g;
+create temp table hjprobe_outer as
+  select g as id from generate_series(-10, 80010) g;
+analyze hjprobe_inner, hjprobe_outer;
+
+set local work_mem = '64MB';
+select count(*), sum(v) from hjprobe_outer o join hjprobe_inner i using (id);
+select count(*), count(o.id), count(i.id) from hjprobe_outer o
+  full join hjprobe_inner i on o.id = i.id + 1;
+
+set local work_mem = '1MB';
+select count(*), sum(v) from hjprobe_outer o join hjprobe_inner i using (id);
+select count(*) from hjprobe_outer o
+  where not exists (select 1 from hjprobe_inner i where i.id = o.id);
+
+-- rescans reuse the single-batch hash table
+set local work_mem = '64MB';
+select x, (select count(*) from hjprobe_outer o join hjprobe_inner i
+           on o.id = i.id where o.id % 2 = x)
+  from generate_series(0, 1) x;
+rollback;
@@ -215,6 +215,57 @@ SELECT COUNT(*),AVG(t2.unique1) FROM tenk1 t1,
 LATERAL (SELECT t2.unique1 FROM tenk1 t2 WHERE t1.twenty = t2.unique1) t2
 WHERE t1.unique1 < 1000;
 
+-- Ensure sharing the cache between the workers gives the same results.
+SET enable_shared_memoize TO on;
+SELECT COUNT(*),AVG(t2.unique1) FROM tenk1 t1,
+LATERAL (SELECT t2.unique1 FROM tenk1 t2 WHERE t1.twenty = t2.unique1) t2
+WHERE t1.unique1 < 1000;
+
+-- The number of hits in the shared cache is shown separately.  Which
+-- participant gets which hits varies, so just check that every lookup is
+-- counted exactly once as a hit, a shared hit or a miss.
+CREATE FUNCTION explain_memoize_lookups(query text)
+RETURNS TABLE (shared_hits_shown bool, lookups_counted bool)
+LANGUAGE plpgsql AS
+$$
+DECLARE
+    plan jsonb;
+    node jsonb;
+    counts jsonb[];
+    total bigint := 0;
+BEGIN
+    plan := explain_analyze_json(query);
+    node := jsonb_path_query_first(plan,
+        'strict $.** ? (@."Node Type" == "Memoize")');
+    counts := array_append(ARRAY(SELECT jsonb_array_elements(node->'Workers')),
+                           node);
+    FOR i IN 1 .. array_length(counts, 1) LOOP
+        total := total + coalesce((counts[i]->>'Cache Hits')::bigint, 0) +
+            coalesce((counts[i]->>'Shared Cache Hits')::bigint, 0) +
+            coalesce((counts[i]->>'Cache Misses')::bigint, 0);
+    END LOOP;
+    shared_hits_shown := EXISTS (SELECT FROM unnest(counts) c
+                                 WHERE c ? 'Shared Cache Hits');
+    lookups_counted := total = (node->>'Actual Loops')::bigint;
+    RETURN NEXT;
+END;
+$$;
+SELECT * FROM explain_memoize_lookups('
+SELECT COUNT(*),AVG(t2.unique1) FROM tenk1 t1,
+LATERAL (SELECT t2.unique1 FROM tenk1 t2 WHERE t1.twenty = t2.unique1) t2
+WHERE t1.unique1 < 1000');
+DROP FUNCTION explain_memoize_lookups(text);
+
+-- Including with a cache small enough to require evictions.
+SET work_mem TO '64kB';
+SET hash_mem_multiplier TO 1.0;
+SELECT COUNT(*),AVG(t2.unique1) FROM tenk1 t1,
+LATERAL (SELECT t2.unique1 FROM tenk1 t2 WHERE t1.thousand = t2.unique1) t2
+WHERE t1.unique1 < 5000;
+RESET hash_mem_multiplier;
+RESET work_mem;
+RESET enable_shared_memoize;
+
 RESET max_parallel_workers_per_gather;
 RESET parallel_tuple_cost;
 RESET parallel_setup_cost;
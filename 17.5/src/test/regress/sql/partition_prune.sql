@@ -1333,3 +1333,107 @@ explain (costs off) select * from hp_contradict_test where a === 1 and b === 1 a
 drop table hp_contradict_test;
 drop operator class part_test_int4_ops2 using hash;
 drop operator ===(int4, int4);
+
+--
+-- Check run-time pruning of the outer side of a hash join using the range
+-- of join key values found in the inner side
+--
+create table hjprune_fact (a int, b text) partition by range (a);
+create table hjprune_fact_1 partition of hjprune_fact for values from (0) to (100);
+create table hjprune_fact_2 partition of hjprune_fact for values from (100) to (200);
+create table hjprune_fact_3 partition of hjprune_fact for values from (200) to (300);
+insert into hjprune_fact select i, i::text from generate_series(0, 299) i;
+create table hjprune_dim (a int, c text);
+insert into hjprune_dim select i, 'x' || i from generate_series(0, 299) i;
+analyze hjprune_fact, hjprune_dim;
+
+set enable_nestloop = off;
+set enable_mergejoin = off;
+
+-- only hjprune_fact_2 can match
+explain (analyze, costs off, summary off, timing off)
+select count(*) from hjprune_fact f join hjprune_dim d on f.a = d.a
+where d.c in ('x120', 'x150');
+select f.* from hjprune_fact f join hjprune_dim d on f.a = d.a
+where d.c in ('x120', 'x150') order by f.a;
+select * from hjprune_fact f where f.a in
+  (select a from hjprune_dim d where d.c in ('x99', 'x100')) order by f.a;
+
+-- no inner rows, so no partitions are scanned
+explain (analyze, costs off, summary off, timing off)
+select count(*) from hjprune_fact f join hjprune_dim d on f.a = d.a
+where d.c = 'nonexistent';
+
+-- inner rows, but only null keys, so no partitions are scanned either
+insert into hjprune_dim values (null, 'xnull');
+explain (analyze, costs off, summary off, timing off)
+select f.a, d.c from hjprune_fact f right join hjprune_dim d on f.a = d.a
+where d.c = 'xnull';
+select f.a, d.c from hjprune_fact f right join hjprune_dim d on f.a = d.a
+where d.c = 'xnull';
+delete from hjprune_dim where a is null;
+
+-- left joins must scan all partitions
+select count(*) from hjprune_fact f left join hjprune_dim d
+  on f.a = d.a and d.c = 'x5';
+
+-- a new inner range on rescan prunes differently
+select s.i, (select count(*) from hjprune_fact f join hjprune_dim d on f.a = d.a
+             where d.c in ('x' || s.i, 'x' || (s.i + 1))
+             and f.b is not null)
+from (values (10), (150), (299)) s(i);
+
+reset enable_nestloop;
+reset enable_mergejoin;
+drop table hjprune_fact, hjprune_dim;
+
+--
+-- Check that the outer scan of a hash join reads only the BRIN block ranges
+-- that may hold keys in the range of inner key values, and that a hash join
+-- expected to need several batches drops outer tuples using a bloom filter
+-- of the inner hash values
+--
+create table hjbrin_fact (a int, b int) with (autovacuum_enabled = off);
+insert into hjbrin_fact select i, i % 10 from generate_series(1, 20000) i;
+create index hjbrin_fact_a_idx on hjbrin_fact using brin (a)
+  with (pages_per_range = 1);
+create table hjbrin_dim (a int, c text);
+insert into hjbrin_dim select 2 * i, 'x' || i from generate_series(1, 5000) i;
+analyze hjbrin_fact, hjbrin_dim;
+
+set enable_nestloop = off;
+set enable_mergejoin = off;
+
+explain (costs off)
+select count(*) from hjbrin_fact f join hjbrin_dim d on f.a = d.a;
+select count(*) from hjbrin_fact f join hjbrin_dim d on f.a = d.a;
+
+-- only about half of the table is read
+select (plan ->> 'Lossy Heap Blocks')::int <
+       (select relpages from pg_class where relname = 'hjbrin_fact') as skipped
+from jsonb_path_query(explain_analyze_json(
+  'select count(*) from hjbrin_fact f join hjbrin_dim d on f.a = d.a'),
+  'strict $.** ? (@."Node Type" == "Bitmap Heap Scan")') plan;
+
+-- no inner rows, so nothing is read
+select plan ->> 'Lossy Heap Blocks' as lossy
+from jsonb_path_query(explain_analyze_json(
+  'select count(*) from hjbrin_fact f join hjbrin_dim d on f.a = d.a where d.c = ''nonexistent'''),
+  'strict $.** ? (@."Node Type" == "Bitmap Heap Scan")') plan;
+
+-- the outer tuples with odd keys can't match and are dropped by the filter
+set work_mem = '64kB';
+set hash_mem_multiplier = 1;
+select (plan ->> 'Rows Removed by Bloom Filter')::float8 > 4500 as bloom_removed
+from jsonb_path_query(explain_analyze_json(
+  'select count(*) from hjbrin_fact f join hjbrin_dim d on f.a = d.a'),
+  'strict $.** ? (@."Node Type" == "Hash Join")') plan;
+select count(*), sum(f.b) from hjbrin_fact f join hjbrin_dim d on f.a = d.a;
+select count(*) from hjbrin_fact f
+  where f.a in (select a from hjbrin_dim where c like 'x1%');
+reset hash_mem_multiplier;
+reset work_mem;
+
+reset enable_nestloop;
+reset enable_mergejoin;
+drop table hjbrin_fact, hjbrin_dim;
@@ -78,6 +78,17 @@ select count(*) from tenk1 where stringu1 = 'GRAAAA';
 reset max_parallel_workers;
 reset parallel_leader_participation;
 
+-- test with more workers than the leader participates with
+set parallel_leader_max_workers = 1;
+select count(*) from tenk1 where stringu1 = 'GRAAAA';
+reset parallel_leader_max_workers;
+
+-- tuples are sent in batches, except for those too big to batch, such as
+-- these partial aggregate states
+explain (costs off)
+  select count(*), length(string_agg(stringu1::text, ',')) from tenk1;
+select count(*), length(string_agg(stringu1::text, ',')) from tenk1;
+
 -- test that parallel_restricted function doesn't run in worker
 alter table tenk1 set (parallel_workers = 4);
 explain (verbose, costs off)
@@ -550,3 +561,64 @@ SET debug_parallel_query = on;
 DELETE FROM parallel_hang WHERE 380 <= i AND i <= 420;
 
 ROLLBACK;
+
+-- Aggregation and DISTINCT after redistributing rows among the workers
+BEGIN;
+SET LOCAL parallel_setup_cost = 0;
+SET LOCAL parallel_tuple_cost = 0;
+SET LOCAL min_parallel_table_scan_size = 0;
+SET LOCAL max_parallel_workers_per_gather = 2;
+SET LOCAL enable_repartition = on;
+SET LOCAL enable_partitionwise_aggregate = off;
+
+-- string_agg with ORDER BY can't be partially aggregated
+EXPLAIN (costs off)
+  SELECT ten, count(*), string_agg(four::text, ',' ORDER BY unique1)
+  FROM tenk1 GROUP BY ten;
+SELECT ten, count(*), md5(string_agg(four::text, ',' ORDER BY unique1))
+  FROM tenk1 GROUP BY ten ORDER BY ten;
+
+EXPLAIN (costs off)
+  SELECT DISTINCT hundred, four FROM tenk1;
+SELECT count(*) FROM (SELECT DISTINCT hundred, four FROM tenk1) d;
+
+SET LOCAL enable_hashagg = off;
+SELECT ten, sum(unique2) FROM tenk1 GROUP BY ten HAVING sum(unique2) > 5000000
+  ORDER BY ten;
+ROLLBACK;
+
+-- ORDER BY with each worker sorting whole ranges of the leading sort key,
+-- returned in order through a plain Gather
+BEGIN;
+SET LOCAL parallel_setup_cost = 0;
+SET LOCAL parallel_tuple_cost = 0;
+SET LOCAL min_parallel_table_scan_size = 0;
+SET LOCAL max_parallel_workers_per_gather = 2;
+SET LOCAL enable_repartition = on;
+SET LOCAL enable_sort = off;
+
+EXPLAIN (costs off)
+  SELECT unique1, ten FROM tenk1 ORDER BY unique1 DESC, ten;
+SELECT count(*) AS misplaced
+  FROM (SELECT unique1, row_number() OVER () AS rn
+        FROM (SELECT unique1, ten FROM tenk1 ORDER BY unique1 DESC, ten) s) t
+  WHERE unique1 <> 10000 - rn;
+-- same when a worker has to return the tuples
+SET LOCAL parallel_leader_participation = off;
+SELECT count(*) AS misplaced
+  FROM (SELECT unique1, row_number() OVER () AS rn
+        FROM (SELECT unique1, ten FROM tenk1 ORDER BY unique1 DESC, ten) s) t
+  WHERE unique1 <> 10000 - rn;
+RESET parallel_leader_participation;
+
+-- NULLs must end up in the first or last range
+CREATE TABLE range_sort AS
+  SELECT nullif(hundred, 42) AS h FROM tenk1;
+ANALYZE range_sort;
+EXPLAIN (costs off)
+  SELECT h FROM range_sort ORDER BY h NULLS FIRST;
+SELECT count(*) AS misplaced
+  FROM (SELECT h, lag(h) OVER () AS prev, row_number() OVER () AS rn
+        FROM (SELECT h FROM range_sort ORDER BY h NULLS FIRST) s) t
+  WHERE (h IS NULL AND rn > 100) OR h < prev;
+ROLLBACK;
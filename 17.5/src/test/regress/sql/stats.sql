@@ -716,6 +716,22 @@ SELECT sum(writes) AS io_sum_local_new_tblspc_writes
 SELECT :io_sum_local_new_tblspc_writes > :io_sum_local_after_writes;
 RESET temp_buffers;
 
+-- Test that reads and writes of temporary files, here by an external sort,
+-- are tracked in pg_stat_io.
+SELECT sum(reads) AS reads, sum(writes) AS writes
+  FROM pg_stat_io
+  WHERE context = 'normal' AND object = 'temp file' \gset io_sum_temp_file_before_
+SET work_mem TO '64kB';
+SELECT count(*) FROM (SELECT g FROM generate_series(1, 20000) g
+  ORDER BY g DESC OFFSET 0) s;
+RESET work_mem;
+SELECT pg_stat_force_next_flush();
+SELECT sum(reads) AS reads, sum(writes) AS writes
+  FROM pg_stat_io
+  WHERE context = 'normal' AND object = 'temp file' \gset io_sum_temp_file_after_
+SELECT :io_sum_temp_file_after_reads > :io_sum_temp_file_before_reads,
+       :io_sum_temp_file_after_writes > :io_sum_temp_file_before_writes;
+
 -- Test that reuse of strategy buffers and reads of blocks into these reused
 -- buffers while VACUUMing are tracked in pg_stat_io. If there is sufficient
 -- demand for shared buffers from concurrent queries, some buffers may be
@@ -524,6 +524,30 @@ select row(row(row(1))) = any (select row(row(1)));
 
 select '1'::text in (select '1'::name union all select '1'::name);
 
+--
+-- Test that a hashed subplan whose output outgrows hash_mem falls back to
+-- rescanning the subplan
+--
+
+create function subselect_many_rows(n int) returns setof int
+language plpgsql rows 10 as
+$$ begin return query select generate_series(1, n); end $$;
+
+set work_mem = '64kB';
+
+explain (costs off)
+select count(*) from generate_series(9991, 10010) x
+  where x not in (select subselect_many_rows(10000));
+select count(*) from generate_series(9991, 10010) x
+  where x not in (select subselect_many_rows(10000));
+select x in (select subselect_many_rows(10000)) as found, count(*)
+  from generate_series(9991, 10010) x group by 1 order by 1;
+select count(*) from generate_series(9991, 10010) x
+  where x not in (select subselect_many_rows(10000) union all select null);
+
+reset work_mem;
+drop function subselect_many_rows(int);
+
 --
 -- Test that we don't try to use a hashed subplan if the simplified
 -- testexpr isn't of the right shape
@@ -294,3 +294,21 @@ create function fipshash(text)
     returns text
     strict immutable parallel safe leakproof
     return substr(encode(sha256($1::bytea), 'hex'), 1, 32);
+
+--
+-- Run EXPLAIN ANALYZE on a query and return the plan in JSON format, for
+-- tests that check details of the plan's execution.
+--
+
+create function explain_analyze_json(query text)
+    returns jsonb
+    language plpgsql as
+$$
+declare
+    plan jsonb;
+begin
+    execute 'explain (analyze, verbose, costs off, summary off, timing off, format json) '
+        || query into plan;
+    return plan;
+end;
+$$;
@@ -305,3 +305,160 @@ EXPLAIN (COSTS OFF) :qry;
 :qry;
 
 COMMIT;
+
+----
+-- Radix sort of large in-memory sorts
+----
+
+-- Keys in several distributions, large enough to be sorted by radix sort.
+-- The leading bytes of the keys are shared by all or by none of them.
+CREATE TEMP TABLE radix_sort (dist text, a4 int4, a8 int8, t text COLLATE "C", b int4);
+INSERT INTO radix_sort
+  SELECT 'random', hashint4(g), hashint8(g) * 7919, md5(g::text), g
+  FROM generate_series(1, 20000) g;
+INSERT INTO radix_sort
+  SELECT 'sorted', g - 10000, g, lpad(g::text, 8, '0'), g
+  FROM generate_series(1, 20000) g;
+INSERT INTO radix_sort
+  SELECT 'reverse', 10000 - g, -g, lpad((20000 - g)::text, 8, '0'), g
+  FROM generate_series(1, 20000) g;
+INSERT INTO radix_sort
+  SELECT 'duplicates', g % 100 - 50, (g % 100)::int8 << 40, (g % 100)::text, g
+  FROM generate_series(1, 20000) g;
+INSERT INTO radix_sort
+  SELECT 'nulls', CASE WHEN h % 2 = 0 THEN h END,
+         CASE WHEN h % 2 = 0 THEN hashint8(g) END,
+         CASE WHEN h % 2 = 0 THEN md5(g::text) END, g
+  FROM (SELECT g, hashint4(g) AS h FROM generate_series(1, 20000) g) s;
+INSERT INTO radix_sort
+  SELECT 'small', hashint4(g), hashint8(g), md5(g::text), g
+  FROM generate_series(1, 100) g;
+ANALYZE radix_sort;
+
+-- Count the rows that sort before the previous one, NULLS LAST for ASC and
+-- NULLS FIRST for DESC
+CREATE FUNCTION pg_temp.radix_misplaced(dist text, col text, dir text,
+                                        OUT nrows bigint, OUT misplaced bigint)
+LANGUAGE plpgsql AS
+$$
+BEGIN
+  EXECUTE format($q$
+    SELECT count(*),
+           count(*) FILTER (WHERE v %3$s prev OR
+                                  (v IS %4$s NULL AND prev IS %5$s NULL))
+    FROM (SELECT v, lag(v) OVER () AS prev
+          FROM (SELECT %1$I AS v FROM radix_sort WHERE dist = %2$L
+                ORDER BY %1$I %6$s) s) t$q$,
+    col, dist,
+    CASE dir WHEN 'ASC' THEN '<' ELSE '>' END,
+    CASE dir WHEN 'ASC' THEN 'NOT' ELSE '' END,
+    CASE dir WHEN 'ASC' THEN '' ELSE 'NOT' END,
+    dir)
+  INTO nrows, misplaced;
+END;
+$$;
+
+SET work_mem = '64MB';
+SELECT dist, col, dir, m.*
+  FROM unnest(ARRAY['random', 'sorted', 'reverse', 'duplicates', 'nulls', 'small']) dist,
+       unnest(ARRAY['a4', 'a8', 't']) col,
+       unnest(ARRAY['ASC', 'DESC']) dir,
+       pg_temp.radix_misplaced(dist, col, dir) m
+  ORDER BY dist, col, dir;
+
+-- Ties on the leading key must still be ordered by the remaining keys
+SELECT count(*) AS misplaced
+  FROM (SELECT a, b, lag(a) OVER () AS pa, lag(b) OVER () AS pb
+        FROM (SELECT a8 AS a, b FROM radix_sort WHERE dist = 'duplicates'
+              ORDER BY a, b DESC) o) t
+  WHERE a < pa OR (a = pa AND b > pb);
+SELECT count(*) AS misplaced
+  FROM (SELECT a, b, lag(a) OVER () AS pa, lag(b) OVER () AS pb
+        FROM (SELECT nullif(a4, 3) AS a, -b AS b FROM radix_sort
+              WHERE dist = 'duplicates'
+              ORDER BY a DESC NULLS LAST, b) o) t
+  WHERE a > pa OR (a IS NULL AND pa IS NULL AND b < pb)
+     OR (a IS NOT NULL AND pa IS NULL) OR (a = pa AND b < pb);
+-- text keys with equal abbreviations
+SELECT count(*) AS misplaced
+  FROM (SELECT v, lag(v) OVER () AS prev
+        FROM (SELECT 'prefix' || t AS v FROM radix_sort WHERE dist = 'random'
+              ORDER BY 1) s) t
+  WHERE v < prev;
+RESET work_mem;
+
+DROP TABLE radix_sort;
+
+----
+-- Compressed temp files
+----
+
+BEGIN;
+
+SET LOCAL work_mem = '64kB';
+SET LOCAL temp_file_compression = pglz;
+
+-- external sort, with well and poorly compressible data
+SELECT count(*) AS misplaced
+FROM (SELECT v, lag(v) OVER () AS prev
+      FROM (SELECT g::text || md5(g::text) AS v
+            FROM generate_series(1, 20000) g ORDER BY 1) s) t
+WHERE v < prev;
+
+-- random access to a compressed final tape
+DECLARE c SCROLL CURSOR FOR
+  SELECT g, md5(g::text) FROM generate_series(1, 20000) g ORDER BY g DESC;
+FETCH ABSOLUTE 15000 FROM c;
+FETCH BACKWARD 2 FROM c;
+FETCH LAST FROM c;
+FETCH ABSOLUTE 1 FROM c;
+CLOSE c;
+
+-- hash aggregation spill
+SET LOCAL enable_sort = off;
+SET LOCAL hash_mem_multiplier = 1;
+SELECT count(*), sum(cnt), sum(k)
+FROM (SELECT g % 5000 AS k, count(*) AS cnt
+      FROM generate_series(1, 50000) g GROUP BY 1) s;
+
+-- EXPLAIN ANALYZE shows how much was written, with the sizes masked
+CREATE FUNCTION pg_temp.explain_temp_compression(query text) RETURNS SETOF text
+LANGUAGE plpgsql AS
+$$
+DECLARE
+  ln text;
+BEGIN
+  FOR ln IN EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF) ' || query
+  LOOP
+    ln := regexp_replace(ln, '\m\d+kB', 'NkB', 'g');
+    ln := regexp_replace(ln, '\m\d+\M', 'N', 'g');
+    RETURN NEXT ln;
+  END LOOP;
+END;
+$$;
+
+SET LOCAL enable_sort = on;
+SELECT pg_temp.explain_temp_compression(
+  'SELECT g, repeat(''x'', 100) FROM generate_series(1, 20000) g ORDER BY g DESC');
+SET LOCAL enable_sort = off;
+SELECT pg_temp.explain_temp_compression(
+  'SELECT g % 5000, count(*) FROM generate_series(1, 50000) g GROUP BY 1');
+
+-- well compressible data takes less space
+SET LOCAL enable_sort = on;
+CREATE FUNCTION pg_temp.temp_compressed_smaller(query text) RETURNS bool
+LANGUAGE plpgsql AS
+$$
+DECLARE
+  plan json;
+BEGIN
+  EXECUTE 'EXPLAIN (ANALYZE, FORMAT JSON, COSTS OFF, TIMING OFF, SUMMARY OFF) ' || query
+    INTO plan;
+  RETURN (plan->0->'Plan'->>'Temp Written Compressed')::int8 <
+         (plan->0->'Plan'->>'Temp Written')::int8;
+END;
+$$;
+SELECT pg_temp.temp_compressed_smaller(
+  'SELECT g, repeat(''x'', 100) FROM generate_series(1, 20000) g ORDER BY g DESC');
+
+COMMIT;
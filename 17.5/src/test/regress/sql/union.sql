@@ -158,6 +158,25 @@ select unique1 from tenk1 except select unique2 from tenk1 where unique2 != 10;
 
 reset enable_hashagg;
 
+-- hashed INTERSECT and EXCEPT that must spill to disk
+set enable_hashagg to on;
+set enable_sort to off;
+set work_mem to '64kB';
+
+explain (costs off)
+select count(*) from
+  ( select unique1 from tenk1 intersect all select thousand from tenk1 ) ss;
+select count(*) from
+  ( select unique1 from tenk1 intersect all select thousand from tenk1 ) ss;
+select count(*) from
+  ( select unique1 from tenk1 except select unique2 from tenk1 where unique2 % 7 != 0 ) ss;
+select count(*) from
+  ( select hundred, unique1 from tenk1 intersect select hundred, unique2 from tenk1 ) ss;
+
+reset work_mem;
+reset enable_sort;
+reset enable_hashagg;
+
 -- non-hashable type
 set enable_hashagg to on;
 
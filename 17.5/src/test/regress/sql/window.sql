@@ -1958,3 +1958,78 @@ $$ LANGUAGE SQL STABLE;
 
 EXPLAIN (costs off) SELECT * FROM pg_temp.f(2);
 SELECT * FROM pg_temp.f(2);
+
+-- Aggregates without an inverse transition function use their combine
+-- function over moving frames.  Check them against a plain aggregation of
+-- each frame, including NULL inputs, FILTER and frame ends that don't move
+-- in step with the frame head.
+CREATE TEMP TABLE sliding_agg AS
+SELECT i, CASE WHEN i % 7 = 0 THEN NULL ELSE (i * 37) % 101 END AS v
+FROM generate_series(1, 300) i;
+
+SELECT count(*) AS mismatches
+FROM (SELECT i,
+             max(v) OVER (ORDER BY i ROWS BETWEEN 20 PRECEDING AND CURRENT ROW) AS mx,
+             min(v) OVER (ORDER BY i ROWS BETWEEN 5 PRECEDING AND 10 FOLLOWING) AS mn,
+             bit_or(v) FILTER (WHERE i % 3 <> 0)
+               OVER (ORDER BY i ROWS BETWEEN CURRENT ROW AND UNBOUNDED FOLLOWING) AS bo,
+             max(v) OVER (ORDER BY i / 10 GROUPS BETWEEN 1 PRECEDING AND CURRENT ROW) AS gmx
+      FROM sliding_agg) w
+WHERE mx IS DISTINCT FROM
+        (SELECT max(v) FROM sliding_agg s WHERE s.i BETWEEN w.i - 20 AND w.i)
+   OR mn IS DISTINCT FROM
+        (SELECT min(v) FROM sliding_agg s WHERE s.i BETWEEN w.i - 5 AND w.i + 10)
+   OR bo IS DISTINCT FROM
+        (SELECT bit_or(v) FROM sliding_agg s WHERE s.i >= w.i AND s.i % 3 <> 0)
+   OR gmx IS DISTINCT FROM
+        (SELECT max(v) FROM sliding_agg s
+         WHERE s.i / 10 BETWEEN w.i / 10 - 1 AND w.i / 10);
+
+DROP TABLE sliding_agg;
+
+-- Window functions can be computed in parallel by redistributing the rows
+-- among the workers by their common PARTITION BY columns.
+CREATE TABLE repart_window AS
+SELECT i, i % 17 AS g, i % 5 AS h, (i * 37) % 101 AS v
+FROM generate_series(1, 5000) i;
+ANALYZE repart_window;
+
+BEGIN;
+SET LOCAL parallel_setup_cost = 0;
+SET LOCAL parallel_tuple_cost = 0;
+SET LOCAL min_parallel_table_scan_size = 0;
+SET LOCAL max_parallel_workers_per_gather = 2;
+SET LOCAL enable_repartition = on;
+
+EXPLAIN (costs off)
+SELECT g, h, i,
+       row_number() OVER (PARTITION BY g ORDER BY i),
+       sum(v) OVER (PARTITION BY h, g ORDER BY i)
+FROM repart_window;
+
+CREATE TEMP TABLE repart_window_par AS
+SELECT g, h, i,
+       row_number() OVER (PARTITION BY g ORDER BY i) AS rn,
+       sum(v) OVER (PARTITION BY h, g ORDER BY i) AS s
+FROM repart_window;
+
+SET LOCAL enable_repartition = off;
+SET LOCAL max_parallel_workers_per_gather = 0;
+
+SELECT count(*) AS mismatches
+FROM ((TABLE repart_window_par
+       EXCEPT
+       SELECT g, h, i,
+              row_number() OVER (PARTITION BY g ORDER BY i),
+              sum(v) OVER (PARTITION BY h, g ORDER BY i)
+       FROM repart_window)
+      UNION ALL
+      (SELECT g, h, i,
+              row_number() OVER (PARTITION BY g ORDER BY i),
+              sum(v) OVER (PARTITION BY h, g ORDER BY i)
+       FROM repart_window
+       EXCEPT
+       TABLE repart_window_par)) d;
+ROLLBACK;
+
+DROP TABLE repart_window;
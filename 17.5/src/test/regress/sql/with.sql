@@ -75,6 +75,23 @@ UNION
     SELECT n+1 FROM t)
 SELECT * FROM t LIMIT 10;
 
+-- UNION whose hash table fills up sets new tuples aside by partition and
+-- settles them at the end of each generation
+SET work_mem = '64kB';
+SELECT jsonb_path_query_first(explain_analyze_json($$
+WITH RECURSIVE t(n) AS (
+    SELECT g FROM generate_series(1, 1000) g
+UNION
+    SELECT n + m FROM t, (VALUES (0), (1000)) v(m) WHERE n <= 9000)
+SELECT count(*) FROM t$$),
+  'strict $.** ? (@."Node Type" == "Recursive Union")') ? 'Spill Partitions' AS spilled;
+WITH RECURSIVE t(n) AS (
+    SELECT g FROM generate_series(1, 1000) g
+UNION
+    SELECT n + m FROM t, (VALUES (0), (1000)) v(m) WHERE n <= 9000)
+SELECT count(*), count(DISTINCT n), min(n), max(n) FROM t;
+RESET work_mem;
+
 -- Test behavior with an unknown-type literal in the WITH
 WITH q AS (SELECT 'foo' AS x)
 SELECT x, pg_typeof(x) FROM q;